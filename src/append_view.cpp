@@ -0,0 +1,105 @@
+#include "./append_view.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace fsv {
+	append_view::append_view(std::size_t capacity, filter predicate)
+	: buffer_(std::make_unique<char[]>(capacity))
+	, capacity_(capacity)
+	, predicate_(std::move(predicate))
+	, block_counts_(std::make_unique<std::size_t[]>(capacity / block_size + 1))
+	, tail_count_(0)
+	, length_(0) {}
+
+	auto append_view::append(const char* str, std::size_t count) -> void {
+		auto const old_length = length_.load(std::memory_order_relaxed);
+		if (count > capacity_ - old_length) {
+			throw std::length_error{"append_view::append(" + std::to_string(count) + "): capacity exceeded"};
+		}
+		std::memcpy(buffer_.get() + old_length, str, count);
+
+		// only the new bytes are classified; each completed block gets its cumulative count
+		for (auto i = old_length; i < old_length + count; ++i) {
+			if (predicate_(buffer_[i])) {
+				++tail_count_;
+			}
+			if ((i + 1) % block_size == 0) {
+				auto const block = (i + 1) / block_size;
+				block_counts_[block] = block_counts_[block - 1] + tail_count_;
+				tail_count_ = 0;
+			}
+		}
+		length_.store(old_length + count, std::memory_order_release);
+	}
+
+	auto append_view::append(std::string_view str) -> void {
+		append(str.data(), str.size());
+	}
+
+	auto append_view::find(std::size_t index) const -> const char* {
+		auto const length = length_.load(std::memory_order_acquire);
+		auto const blocks = length / block_size;
+
+		// last block whose preceding count does not exceed index
+		auto const counts = block_counts_.get();
+		auto const block = static_cast<std::size_t>(std::upper_bound(counts, counts + blocks + 1, index) - counts) - 1;
+
+		auto count = counts[block];
+		for (auto i = block * block_size; i < length; ++i) {
+			if (predicate_(buffer_[i])) {
+				if (count == index) {
+					return &buffer_[i];
+				}
+				++count;
+			}
+		}
+		return nullptr;
+	}
+
+	auto append_view::operator[](std::size_t index) const -> const char& {
+		if (auto const ptr = find(index); ptr != nullptr) {
+			return *ptr;
+		}
+		throw std::out_of_range{"append_view::operator[](" + std::to_string(index) + "): invalid index"};
+	}
+
+	auto append_view::at(std::size_t index) const -> const char& {
+		if (auto const ptr = find(index); ptr != nullptr) {
+			return *ptr;
+		}
+		throw std::domain_error{"append_view::at(" + std::to_string(index) + "): invalid index"};
+	}
+
+	auto append_view::size() const -> std::size_t {
+		auto const length = length_.load(std::memory_order_acquire);
+		auto const blocks = length / block_size;
+		auto const tail = buffer_.get() + blocks * block_size;
+		auto const tail_count = std::count_if(tail, buffer_.get() + length, predicate_);
+		return block_counts_[blocks] + static_cast<std::size_t>(tail_count);
+	}
+
+	auto append_view::empty() const -> bool {
+		return size() == 0;
+	}
+
+	auto append_view::length() const -> std::size_t {
+		return length_.load(std::memory_order_acquire);
+	}
+
+	auto append_view::capacity() const -> std::size_t {
+		return capacity_;
+	}
+
+	auto append_view::data() const -> const char* {
+		return buffer_.get();
+	}
+
+	auto append_view::predicate() const -> const filter& {
+		return predicate_;
+	}
+
+	auto append_view::view() const -> filtered_string_view {
+		return filtered_string_view(buffer_.get(), length_.load(std::memory_order_acquire), predicate_);
+	}
+} // namespace fsv
@@ -0,0 +1,61 @@
+#ifndef COMP6771_ASS2_APPEND_VIEW_H
+#define COMP6771_ASS2_APPEND_VIEW_H
+
+#include "./filtered_string_view.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace fsv {
+	// A growing buffer viewed through a filter. The accepted-character index is extended over the newly
+	// appended bytes only, so size() and at() stay cheap however long the buffer gets.
+	//
+	// One writer may call append() while any number of readers call the const members concurrently; the
+	// raw length is published with release semantics once the bytes and index entries below it are written.
+	class append_view {
+	 public:
+		// number of raw bytes summarised by one index entry
+		static constexpr std::size_t block_size = 1024;
+
+		explicit append_view(std::size_t capacity, filter predicate = filtered_string_view::default_predicate);
+
+		append_view(const append_view&) = delete;
+		auto operator=(const append_view&) -> append_view& = delete;
+
+		~append_view() = default;
+
+		// writer
+		auto append(const char* str, std::size_t count) -> void;
+		auto append(std::string_view str) -> void;
+
+		// readers
+		auto operator[](std::size_t index) const -> const char&;
+		auto at(std::size_t index) const -> const char&;
+		auto size() const -> std::size_t;
+		auto empty() const -> bool;
+		auto length() const -> std::size_t;
+		auto capacity() const -> std::size_t;
+		auto data() const -> const char*;
+		auto predicate() const -> const filter&;
+
+		// snapshot of everything published so far
+		auto view() const -> filtered_string_view;
+
+	 private:
+		std::unique_ptr<char[]> buffer_;
+		std::size_t capacity_;
+		filter predicate_;
+
+		// block_counts_[k] is the number of accepted characters in the first k blocks
+		std::unique_ptr<std::size_t[]> block_counts_;
+		// accepted characters in the current (incomplete) block, only touched by the writer
+		std::size_t tail_count_;
+		std::atomic<std::size_t> length_;
+
+		auto find(std::size_t index) const -> const char*;
+	};
+} // namespace fsv
+
+#endif // COMP6771_ASS2_APPEND_VIEW_H
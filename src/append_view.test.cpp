@@ -0,0 +1,71 @@
+#include "./append_view.h"
+
+#include <catch2/catch.hpp>
+#include <string>
+#include <thread>
+
+TEST_CASE("append_view starts empty") {
+	auto av = fsv::append_view(64);
+	REQUIRE(av.size() == 0);
+	REQUIRE(av.empty());
+	REQUIRE(av.length() == 0);
+	REQUIRE(av.capacity() == 64);
+	REQUIRE_THROWS_AS(av.at(0), std::domain_error);
+	// the default filter is the views' own, so their unfiltered fast paths apply
+	av.append("abc");
+	REQUIRE(av.view().unfiltered());
+	REQUIRE(av.view().find("bc") == 1);
+}
+
+TEST_CASE("append_view tracks filtered size across appends") {
+	auto av = fsv::append_view(64, [](const char& c) { return c != ' '; });
+	av.append("hello ");
+	REQUIRE(av.size() == 5);
+	av.append("wor");
+	av.append("ld");
+	REQUIRE(av.size() == 10);
+	REQUIRE(av.length() == 11);
+	REQUIRE(av[5] == 'w');
+	REQUIRE(av.at(9) == 'd');
+	REQUIRE(static_cast<std::string>(av.view()) == "helloworld");
+	REQUIRE_THROWS_AS(av.append(std::string(64, 'x')), std::length_error);
+}
+
+TEST_CASE("append_view index spans many blocks") {
+	auto const is_digit = [](const char& c) { return c >= '0' && c <= '9'; };
+	auto av = fsv::append_view(32 * fsv::append_view::block_size, is_digit);
+	auto expected = std::string();
+	for (auto i = 0; i < 2000; ++i) {
+		auto const line = "line " + std::to_string(i) + " ok\n";
+		av.append(line);
+		expected += std::to_string(i);
+	}
+	REQUIRE(av.size() == expected.size());
+	REQUIRE(av.size() == av.view().size());
+	for (auto i = 0U; i < expected.size(); i += 97) {
+		REQUIRE(av.at(i) == expected[i]);
+	}
+	REQUIRE(av.at(expected.size() - 1) == expected.back());
+	REQUIRE_THROWS_AS(av.at(expected.size()), std::domain_error);
+	REQUIRE_THROWS_AS(av[expected.size()], std::out_of_range);
+}
+
+TEST_CASE("append_view readers see consistent prefixes while appending") {
+	auto av = fsv::append_view(8 * fsv::append_view::block_size, [](const char& c) { return c == 'a'; });
+	// Catch2 assertions are not thread-safe, so the reader only records what it saw
+	auto consistent = true;
+	auto reader = std::thread([&av, &consistent] {
+		auto last = std::size_t{0};
+		while (last < 4 * fsv::append_view::block_size) {
+			auto const size = av.size();
+			consistent = consistent && size >= last && (size == 0 || av.at(size - 1) == 'a');
+			last = size;
+		}
+	});
+	for (auto i = 0U; i < 4 * fsv::append_view::block_size; ++i) {
+		av.append("ab");
+	}
+	reader.join();
+	REQUIRE(consistent);
+	REQUIRE(av.size() == 4 * fsv::append_view::block_size);
+}
@@ -0,0 +1,410 @@
+#include "./async_reader.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace fsv {
+	// Where reads are queued and completions collected. Reads may finish in any order.
+	class async_file_reader::backend {
+	 public:
+		struct completion {
+			std::size_t buffer;
+			// bytes read, or a negated errno
+			std::int64_t result;
+		};
+
+		backend() = default;
+		backend(const backend&) = delete;
+		auto operator=(const backend&) -> backend& = delete;
+		virtual ~backend() = default;
+
+		// queues a read of length bytes at offset into dest, which lies within buffer
+		virtual auto submit(std::size_t buffer, std::size_t offset, char* dest, std::size_t length) -> void = 0;
+		// waits for one queued read to finish
+		virtual auto wait() -> completion = 0;
+	};
+
+	// io_uring driven through its system calls directly, so no liburing is needed.
+	class async_file_reader::uring_backend final : public backend {
+	 public:
+		// nullptr if the kernel does not offer io_uring or it is disabled
+		static auto create(int fd, char* buffers, std::size_t buffer_size, std::size_t depth)
+		    -> std::unique_ptr<backend> {
+			auto params = io_uring_params{};
+			auto const ring_fd =
+			    static_cast<int>(::syscall(__NR_io_uring_setup, static_cast<unsigned>(depth), &params));
+			if (ring_fd < 0) {
+				return nullptr;
+			}
+			auto result = std::unique_ptr<uring_backend>(new uring_backend(fd, ring_fd));
+			if (!result->map(params)) {
+				return nullptr;
+			}
+
+			// registered buffers are pinned once instead of on every read; without them (e.g. under a low
+			// RLIMIT_MEMLOCK) plain reads still work
+			auto iovecs = std::vector<iovec>(depth);
+			for (auto i = std::size_t{0}; i < depth; ++i) {
+				iovecs[i] = iovec{buffers + i * buffer_size, buffer_size};
+			}
+			result->registered_ = ::syscall(__NR_io_uring_register,
+			                                ring_fd,
+			                                IORING_REGISTER_BUFFERS,
+			                                iovecs.data(),
+			                                static_cast<unsigned>(depth))
+			                      == 0;
+			return result;
+		}
+
+		~uring_backend() override {
+			if (sqes_ != nullptr) {
+				::munmap(sqes_, sqes_size_);
+			}
+			if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+				::munmap(cq_ring_, cq_ring_size_);
+			}
+			if (sq_ring_ != nullptr) {
+				::munmap(sq_ring_, sq_ring_size_);
+			}
+			::close(ring_fd_);
+		}
+
+		auto submit(std::size_t buffer, std::size_t offset, char* dest, std::size_t length) -> void override {
+			auto const tail = *sq_tail_;
+			auto const index = tail & *sq_mask_;
+			auto& sqe = sqes_[index];
+			std::memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = registered_ ? IORING_OP_READ_FIXED : IORING_OP_READ;
+			sqe.fd = fd_;
+			sqe.addr = reinterpret_cast<std::uintptr_t>(dest);
+			sqe.len = static_cast<std::uint32_t>(length);
+			sqe.off = offset;
+			sqe.buf_index = static_cast<std::uint16_t>(registered_ ? buffer : 0);
+			sqe.user_data = buffer;
+			sq_array_[index] = index;
+			std::atomic_ref(*sq_tail_).store(tail + 1, std::memory_order_release);
+			enter(1, 0, 0);
+		}
+
+		auto wait() -> completion override {
+			for (;;) {
+				auto const head = *cq_head_;
+				if (head != std::atomic_ref(*cq_tail_).load(std::memory_order_acquire)) {
+					auto const& cqe = cqes_[head & *cq_mask_];
+					auto const result = completion{static_cast<std::size_t>(cqe.user_data), cqe.res};
+					std::atomic_ref(*cq_head_).store(head + 1, std::memory_order_release);
+					return result;
+				}
+				enter(0, 1, IORING_ENTER_GETEVENTS);
+			}
+		}
+
+	 private:
+		int fd_;
+		int ring_fd_;
+		bool registered_ = false;
+
+		void* sq_ring_ = nullptr;
+		std::size_t sq_ring_size_ = 0;
+		void* cq_ring_ = nullptr;
+		std::size_t cq_ring_size_ = 0;
+		io_uring_sqe* sqes_ = nullptr;
+		std::size_t sqes_size_ = 0;
+
+		unsigned* sq_tail_ = nullptr;
+		unsigned* sq_mask_ = nullptr;
+		unsigned* sq_array_ = nullptr;
+		unsigned* cq_head_ = nullptr;
+		unsigned* cq_tail_ = nullptr;
+		unsigned* cq_mask_ = nullptr;
+		io_uring_cqe* cqes_ = nullptr;
+
+		uring_backend(int fd, int ring_fd)
+		: fd_(fd)
+		, ring_fd_(ring_fd) {}
+
+		auto map(const io_uring_params& params) -> bool {
+			auto const flags = MAP_SHARED | MAP_POPULATE;
+			sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+			cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+				sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+			}
+			sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, flags, ring_fd_, IORING_OFF_SQ_RING);
+			if (sq_ring_ == MAP_FAILED) {
+				sq_ring_ = nullptr;
+				return false;
+			}
+			cq_ring_ = sq_ring_;
+			if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0) {
+				cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, flags, ring_fd_, IORING_OFF_CQ_RING);
+				if (cq_ring_ == MAP_FAILED) {
+					cq_ring_ = nullptr;
+					return false;
+				}
+			}
+			sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+			auto const sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, flags, ring_fd_, IORING_OFF_SQES);
+			if (sqes == MAP_FAILED) {
+				return false;
+			}
+			sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+			auto const sq = static_cast<char*>(sq_ring_);
+			auto const cq = static_cast<char*>(cq_ring_);
+			sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+			sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+			sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+			cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+			cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+			cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+			cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+			return true;
+		}
+
+		auto enter(unsigned to_submit, unsigned min_complete, unsigned flags) const -> void {
+			while (::syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, nullptr, 0) < 0) {
+				if (errno != EINTR) {
+					throw std::system_error{errno, std::system_category(), "async_file_reader: io_uring_enter"};
+				}
+			}
+		}
+	};
+
+	// A thread issuing preads in submission order, for kernels without io_uring.
+	class async_file_reader::pread_backend final : public backend {
+	 public:
+		explicit pread_backend(int fd)
+		: fd_(fd)
+		, stopping_(false)
+		, thread_([this] { work(); }) {}
+
+		~pread_backend() override {
+			{
+				auto const lock = std::lock_guard(mutex_);
+				stopping_ = true;
+			}
+			requests_changed_.notify_one();
+			thread_.join();
+		}
+
+		auto submit(std::size_t buffer, std::size_t offset, char* dest, std::size_t length) -> void override {
+			{
+				auto const lock = std::lock_guard(mutex_);
+				requests_.push_back({buffer, offset, dest, length});
+			}
+			requests_changed_.notify_one();
+		}
+
+		auto wait() -> completion override {
+			auto lock = std::unique_lock(mutex_);
+			completions_changed_.wait(lock, [this] { return !completions_.empty(); });
+			auto const result = completions_.front();
+			completions_.pop_front();
+			return result;
+		}
+
+	 private:
+		struct request {
+			std::size_t buffer;
+			std::size_t offset;
+			char* dest;
+			std::size_t length;
+		};
+
+		int fd_;
+		std::mutex mutex_;
+		std::condition_variable requests_changed_;
+		std::condition_variable completions_changed_;
+		std::deque<request> requests_;
+		std::deque<completion> completions_;
+		bool stopping_;
+		std::thread thread_;
+
+		auto work() -> void {
+			for (;;) {
+				auto next = request{};
+				{
+					auto lock = std::unique_lock(mutex_);
+					requests_changed_.wait(lock, [this] { return stopping_ || !requests_.empty(); });
+					if (stopping_) {
+						return;
+					}
+					next = requests_.front();
+					requests_.pop_front();
+				}
+				auto result = ::pread(fd_, next.dest, next.length, static_cast<off_t>(next.offset));
+				if (result < 0) {
+					result = -errno;
+				}
+				{
+					auto const lock = std::lock_guard(mutex_);
+					completions_.push_back({next.buffer, result});
+				}
+				completions_changed_.notify_one();
+			}
+		}
+	};
+
+	async_file_reader::async_file_reader(const std::string& path, async_reader_options options)
+	: fd_(::open(path.c_str(), O_RDONLY | O_CLOEXEC))
+	, options_(options) {
+		if (fd_ < 0) {
+			throw std::system_error{errno, std::system_category(), "async_file_reader(" + path + ")"};
+		}
+		options_.buffer_size = std::max<std::size_t>(options_.buffer_size, 1);
+		options_.queue_depth = std::clamp<std::size_t>(options_.queue_depth, 1, 1024);
+		buffers_ = std::make_unique_for_overwrite<char[]>(options_.buffer_size * options_.queue_depth);
+		if (options_.use_io_uring) {
+			backend_ = uring_backend::create(fd_, buffers_.get(), options_.buffer_size, options_.queue_depth);
+		}
+		if (backend_ == nullptr) {
+			options_.use_io_uring = false;
+			backend_ = std::make_unique<pread_backend>(fd_);
+		}
+	}
+
+	async_file_reader::~async_file_reader() {
+		backend_.reset();
+		::close(fd_);
+	}
+
+	auto async_file_reader::uses_io_uring() const -> bool {
+		return options_.use_io_uring;
+	}
+
+	auto async_file_reader::read(const char_class& cls, const std::function<void(const filtered_string_view&)>& fn)
+	    -> std::size_t {
+		auto const make = [&cls](const char* data, std::size_t length) {
+			return filtered_string_view(data, length, cls);
+		};
+		return read_records(make, fn);
+	}
+
+	auto async_file_reader::read(const filter& predicate, const std::function<void(const filtered_string_view&)>& fn)
+	    -> std::size_t {
+		auto const make = [&predicate](const char* data, std::size_t length) {
+			return filtered_string_view(data, length, predicate);
+		};
+		return read_records(make, fn);
+	}
+
+	auto async_file_reader::read_records(const std::function<filtered_string_view(const char*, std::size_t)>& make,
+	                                     const std::function<void(const filtered_string_view&)>& fn) -> std::size_t {
+		struct stat info = {};
+		if (::fstat(fd_, &info) != 0) {
+			throw std::system_error{errno, std::system_category(), "async_file_reader::read"};
+		}
+		auto const size = static_cast<std::size_t>(info.st_size);
+		auto const buffer_size = options_.buffer_size;
+		auto const depth = options_.queue_depth;
+		auto const buffer = [&](std::size_t b) { return buffers_.get() + b * buffer_size; };
+
+		// the k-th buffer-sized piece of the file is read into buffer k % depth, so pieces complete into
+		// buffers in a fixed rotation and can be delivered in file order
+		struct slot {
+			std::size_t offset;
+			std::size_t length;
+			std::size_t filled;
+			bool done;
+		};
+		auto slots = std::vector<slot>(depth);
+		auto next_offset = std::size_t{0};
+		auto in_flight = std::size_t{0};
+		auto const submit = [&](std::size_t b, std::size_t offset, char* dest, std::size_t length) {
+			backend_->submit(b, offset, dest, length);
+			++in_flight;
+		};
+		auto const submit_next = [&](std::size_t b) {
+			if (next_offset < size) {
+				slots[b] = slot{next_offset, std::min(buffer_size, size - next_offset), 0, false};
+				submit(b, next_offset, buffer(b), slots[b].length);
+				next_offset += slots[b].length;
+			}
+		};
+
+		// bytes of a record cut off by the end of the previous buffer
+		auto carry = std::string();
+		auto const delimiter = options_.delimiter;
+		auto const deliver = [&](const char* data, std::size_t length) {
+			auto const text = std::string_view(data, length);
+			auto const first = text.find(delimiter);
+			if (first == std::string_view::npos) {
+				carry.append(text);
+				return;
+			}
+			auto start = std::size_t{0};
+			if (!carry.empty()) {
+				carry.append(text.substr(0, first + 1));
+				fn(make(carry.data(), carry.size()));
+				carry.clear();
+				start = first + 1;
+			}
+			auto const end = text.rfind(delimiter) + 1;
+			if (end > start) {
+				fn(make(data + start, end - start));
+			}
+			carry.assign(text.substr(end));
+		};
+
+		try {
+			for (auto b = std::size_t{0}; b < depth; ++b) {
+				submit_next(b);
+			}
+			for (auto delivered = std::size_t{0}; delivered < size;) {
+				auto const [b, result] = backend_->wait();
+				--in_flight;
+				if (result < 0) {
+					auto const error = static_cast<int>(-result);
+					throw std::system_error{error, std::system_category(), "async_file_reader::read"};
+				}
+				if (result == 0) {
+					throw std::runtime_error{"async_file_reader::read: file shrank while being read"};
+				}
+				auto& s = slots[b];
+				s.filled += static_cast<std::size_t>(result);
+				if (s.filled < s.length) {
+					submit(b, s.offset + s.filled, buffer(b) + s.filled, s.length - s.filled);
+					continue;
+				}
+				s.done = true;
+				for (auto next = (delivered / buffer_size) % depth; delivered < size && slots[next].done;
+				     next = (delivered / buffer_size) % depth)
+				{
+					deliver(buffer(next), slots[next].length);
+					delivered += slots[next].length;
+					slots[next].done = false;
+					submit_next(next);
+				}
+			}
+		} catch (...) {
+			// reads still in flight would land in the buffers after they are reused or freed
+			for (; in_flight > 0; --in_flight) {
+				backend_->wait();
+			}
+			throw;
+		}
+		if (!carry.empty()) {
+			fn(make(carry.data(), carry.size()));
+		}
+		return size;
+	}
+} // namespace fsv
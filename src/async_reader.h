@@ -0,0 +1,63 @@
+#ifndef COMP6771_ASS2_ASYNC_READER_H
+#define COMP6771_ASS2_ASYNC_READER_H
+
+#include "./filtered_string_view.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace fsv {
+	struct async_reader_options {
+		// bytes per read, and so per buffer
+		std::size_t buffer_size = std::size_t{1} << 20U;
+		// reads kept in flight, each into its own buffer
+		std::size_t queue_depth = 8;
+		// records end with this byte; a record cut by a buffer boundary is reassembled before it is passed on
+		char delimiter = '\n';
+		// false forces the pread fallback
+		bool use_io_uring = true;
+	};
+
+	// Reads a file with several large reads in flight and hands its contents, in order, to a callback as
+	// filtered views that always hold whole records, so filtering one buffer overlaps the reads of the next.
+	// On Linux the reads go through io_uring into registered buffers; where io_uring is unavailable a
+	// background thread issues preads into the same buffer pool instead.
+	//
+	// Views passed to the callback point into the reader's buffers and are only valid during the call. Each
+	// is either a run of complete records from one buffer, or a single record carried over a buffer boundary,
+	// which is the only data that is copied.
+	class async_file_reader {
+	 public:
+		// throws std::system_error if path cannot be opened
+		explicit async_file_reader(const std::string& path, async_reader_options options = {});
+		async_file_reader(const async_file_reader&) = delete;
+		auto operator=(const async_file_reader&) -> async_file_reader& = delete;
+		~async_file_reader();
+
+		// true if reads go through io_uring rather than the pread fallback
+		auto uses_io_uring() const -> bool;
+
+		// reads the whole file, calling fn on views of its records; returns the number of bytes read. Throws
+		// std::system_error if a read fails.
+		auto read(const char_class& cls, const std::function<void(const filtered_string_view&)>& fn) -> std::size_t;
+		auto read(const filter& predicate, const std::function<void(const filtered_string_view&)>& fn)
+		    -> std::size_t;
+
+	 private:
+		class backend;
+		class uring_backend;
+		class pread_backend;
+
+		int fd_;
+		async_reader_options options_;
+		std::unique_ptr<char[]> buffers_;
+		std::unique_ptr<backend> backend_;
+
+		auto read_records(const std::function<filtered_string_view(const char*, std::size_t)>& make,
+		                  const std::function<void(const filtered_string_view&)>& fn) -> std::size_t;
+	};
+} // namespace fsv
+
+#endif // COMP6771_ASS2_ASYNC_READER_H
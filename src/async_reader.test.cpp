@@ -0,0 +1,86 @@
+#include "./async_reader.h"
+#include "./char_class.h"
+#include "./test_text.h"
+
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+namespace {
+	using fsv::test::line_text;
+
+	auto write_file(const std::string& path, const std::string& text) -> void {
+		auto out = std::ofstream(path, std::ios::binary);
+		out << text;
+	}
+} // namespace
+
+TEST_CASE("async_file_reader delivers whole records in file order") {
+	auto const path = std::string("fsv_async_reader_test.txt");
+	auto const text = line_text();
+	auto const digits_of = fsv::char_class::range('0', '9');
+	write_file(path, text);
+
+	for (auto const use_io_uring : {true, false}) {
+		for (auto const buffer_size : {std::size_t{64}, std::size_t{1000}, std::size_t{1} << 16U}) {
+			auto reader = fsv::async_file_reader(path, {buffer_size, 4, '\n', use_io_uring});
+			if (!use_io_uring) {
+				CHECK_FALSE(reader.uses_io_uring());
+			}
+			auto raw = std::string();
+			auto digits = std::string();
+			auto whole = true;
+			auto const bytes = reader.read(digits_of, [&](const fsv::filtered_string_view& v) {
+				raw.append(v.data(), v.length());
+				digits += static_cast<std::string>(v);
+				whole = whole && (v.data()[v.length() - 1] == '\n' || raw.size() == text.size());
+			});
+			CHECK(bytes == text.size());
+			CHECK(raw == text);
+			CHECK(digits == static_cast<std::string>(fsv::filtered_string_view(text, digits_of)));
+			CHECK(whole);
+		}
+	}
+	std::remove(path.c_str());
+}
+
+TEST_CASE("async_file_reader accepts arbitrary predicates and empty files") {
+	auto const path = std::string("fsv_async_reader_empty.txt");
+	write_file(path, "");
+	auto reader = fsv::async_file_reader(path);
+	auto calls = 0;
+	CHECK(reader.read([](const char&) { return true; }, [&](const fsv::filtered_string_view&) { ++calls; }) == 0);
+	CHECK(calls == 0);
+
+	write_file(path, "a,b\nc,d\n");
+	auto fields = std::string();
+	auto other = fsv::async_file_reader(path, {3, 2, '\n', true});
+	auto const append = [&fields](const fsv::filtered_string_view& v) { fields += static_cast<std::string>(v); };
+	other.read([](const char& c) { return c != ','; }, append);
+	CHECK(fields == "ab\ncd\n");
+	std::remove(path.c_str());
+}
+
+TEST_CASE("async_file_reader reports errors and stays usable after a callback throws") {
+	CHECK_THROWS_AS(fsv::async_file_reader("/nonexistent/fsv_async_reader"), std::system_error);
+
+	auto const path = std::string("fsv_async_reader_throw.txt");
+	auto const text = line_text();
+	write_file(path, text);
+	auto reader = fsv::async_file_reader(path, {128, 8, '\n', true});
+	auto calls = 0;
+	CHECK_THROWS_AS(reader.read(fsv::char_class::all(),
+	                            [&](const fsv::filtered_string_view&) {
+		                            if (++calls == 5) {
+			                            throw std::runtime_error{"stop"};
+		                            }
+	                            }),
+	                std::runtime_error);
+	auto raw = std::string();
+	reader.read(fsv::char_class::all(), [&](const fsv::filtered_string_view& v) { raw.append(v.data(), v.length()); });
+	CHECK(raw == text);
+	std::remove(path.c_str());
+}
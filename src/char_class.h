@@ -0,0 +1,108 @@
+#ifndef COMP6771_ASS2_CHAR_CLASS_H
+#define COMP6771_ASS2_CHAR_CLASS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+namespace fsv {
+	// A set of byte values usable as a predicate. Unlike an arbitrary filter its membership is known for
+	// every byte up front, which lets the scan kernels classify many characters per instruction.
+	class char_class {
+	 public:
+		constexpr char_class() = default;
+		constexpr explicit char_class(std::string_view chars) {
+			for (auto c : chars) {
+				insert(c);
+			}
+		}
+
+		// evaluates predicate once per byte value; only meaningful for predicates that look at the value alone
+		static auto from(const std::function<bool(const char&)>& predicate) -> char_class {
+			auto result = char_class();
+			for (auto i = 0; i < 256; ++i) {
+				auto const c = static_cast<char>(i);
+				if (predicate(c)) {
+					result.insert(c);
+				}
+			}
+			return result;
+		}
+
+		static constexpr auto range(char first, char last) -> char_class {
+			auto result = char_class();
+			for (auto i = static_cast<unsigned char>(first); i <= static_cast<unsigned char>(last); ++i) {
+				result.insert(static_cast<char>(i));
+				if (i == 255) {
+					break;
+				}
+			}
+			return result;
+		}
+
+		static constexpr auto all() -> char_class {
+			return ~char_class();
+		}
+
+		constexpr auto insert(char c) -> void {
+			auto const u = static_cast<unsigned char>(c);
+			bits_[u >> 6U] |= std::uint64_t{1} << (u & 63U);
+		}
+
+		constexpr auto contains(char c) const -> bool {
+			auto const u = static_cast<unsigned char>(c);
+			return ((bits_[u >> 6U] >> (u & 63U)) & 1U) != 0;
+		}
+
+		constexpr auto operator()(const char& c) const -> bool {
+			return contains(c);
+		}
+
+		constexpr auto count() const -> std::size_t {
+			auto result = std::size_t{0};
+			for (auto word : bits_) {
+				for (; word != 0; word &= word - 1) {
+					++result;
+				}
+			}
+			return result;
+		}
+
+		constexpr auto words() const -> const std::array<std::uint64_t, 4>& {
+			return bits_;
+		}
+
+		friend constexpr auto operator|(const char_class& lhs, const char_class& rhs) -> char_class {
+			auto result = lhs;
+			for (auto i = 0U; i < 4; ++i) {
+				result.bits_[i] |= rhs.bits_[i];
+			}
+			return result;
+		}
+
+		friend constexpr auto operator&(const char_class& lhs, const char_class& rhs) -> char_class {
+			auto result = lhs;
+			for (auto i = 0U; i < 4; ++i) {
+				result.bits_[i] &= rhs.bits_[i];
+			}
+			return result;
+		}
+
+		friend constexpr auto operator~(const char_class& cls) -> char_class {
+			auto result = cls;
+			for (auto& word : result.bits_) {
+				word = ~word;
+			}
+			return result;
+		}
+
+		friend constexpr auto operator==(const char_class&, const char_class&) -> bool = default;
+
+	 private:
+		std::array<std::uint64_t, 4> bits_ = {};
+	};
+} // namespace fsv
+
+#endif // COMP6771_ASS2_CHAR_CLASS_H
@@ -0,0 +1,69 @@
+#include "./char_class.h"
+#include "./chunker.h"
+#include "./filtered_string_view.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Chunks pretty-printed JSON with whitespace ignored, straight over a char_class view and over a copy with
+// the whitespace removed first, and chunks the raw text for comparison.
+//
+//   chunker_bench [megabytes]
+namespace {
+	using clock = std::chrono::steady_clock;
+
+	auto seconds_since(clock::time_point start) -> double {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	auto sample_json(std::size_t length) -> std::string {
+		auto result = std::string("[\n");
+		result.reserve(length);
+		for (auto i = std::size_t{0}; result.size() < length; ++i) {
+			result += "  {\n    \"id\": " + std::to_string(i) + ",\n    \"name\": \"user " + std::to_string(i * 31)
+			          + "\",\n    \"tags\": [ \"a\", \"c\" ]\n  },\n";
+		}
+		result.resize(length);
+		return result;
+	}
+
+	auto report(const char* name, std::size_t bytes, double seconds, std::size_t chunks) -> void {
+		std::cout << std::left << std::setw(28) << name << std::right << std::setw(10)
+		          << static_cast<double>(bytes) / seconds / 1e6 << " MB/s  (" << chunks << " chunks)\n";
+	}
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+	auto const megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64;
+	auto const text = sample_json(megabytes << 20U);
+	auto const whitespace = ~fsv::char_class(" \t\n\r");
+	std::cout << std::fixed << std::setprecision(1);
+
+	{
+		auto const start = clock::now();
+		auto const ends = fsv::chunk_ends(fsv::filtered_string_view(text, fsv::char_class::all()));
+		report("raw bytes, in place", text.size(), seconds_since(start), ends.size());
+	}
+	{
+		auto const start = clock::now();
+		auto const ends = fsv::chunk_ends(fsv::filtered_string_view(text, whitespace));
+		report("char_class view", text.size(), seconds_since(start), ends.size());
+	}
+	{
+		auto const start = clock::now();
+		auto const copy = static_cast<std::string>(fsv::filtered_string_view(text, whitespace));
+		auto const ends = fsv::chunk_ends(fsv::filtered_string_view(copy, fsv::char_class::all()));
+		report("materialized copy", text.size(), seconds_since(start), ends.size());
+	}
+	{
+		auto const start = clock::now();
+		auto const view = fsv::filtered_string_view(text, [](const char& c) { return c > ' '; });
+		auto const ends = fsv::chunk_ends(view);
+		report("predicate view", text.size(), seconds_since(start), ends.size());
+	}
+	return 0;
+}
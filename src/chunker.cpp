@@ -0,0 +1,224 @@
+#include "./chunker.h"
+#include "./strategy.h"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <string>
+
+namespace fsv {
+	namespace {
+		auto splitmix64(std::uint64_t& state) -> std::uint64_t {
+			state += 0x9E3779B97F4A7C15;
+			auto z = state;
+			z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9;
+			z = (z ^ (z >> 27U)) * 0x94D049BB133111EB;
+			return z ^ (z >> 31U);
+		}
+
+		// A mask of bits bits just below the top one. The high bits are the ones the Gear hash draws from the
+		// most distant bytes of its window, and leaving out the very top lets the mask be tested, shifted
+		// left by one, against twice the hash, which is what the two-byte step has in hand halfway.
+		auto high_bits(int bits) -> std::uint64_t {
+			auto const n = static_cast<unsigned>(std::clamp(bits, 0, 63));
+			return n == 0 ? 0 : (~std::uint64_t{0} >> (64 - n)) << (63 - n);
+		}
+	} // namespace
+
+	gear_hash::gear_hash(std::uint64_t seed)
+	: table_() {
+		for (auto& word : table_) {
+			word = splitmix64(seed);
+		}
+	}
+
+	auto gear_hash::roll(std::uint64_t hash, char c) const -> std::uint64_t {
+		return (hash << 1U) + table_[static_cast<unsigned char>(c)];
+	}
+
+	auto gear_hash::operator()(std::string_view str) const -> std::uint64_t {
+		auto hash = std::uint64_t{0};
+		for (auto const c : str) {
+			hash = roll(hash, c);
+		}
+		return hash;
+	}
+
+	auto gear_hash::table() const -> const std::array<std::uint64_t, 256>& {
+		return table_;
+	}
+
+	rolling_hash_view::iter::iter()
+	: owner_(nullptr)
+	, position_(nullptr)
+	, offset_(0)
+	, hash_(0) {}
+
+	rolling_hash_view::iter::iter(const rolling_hash_view* owner, const char* position)
+	: owner_(owner)
+	, position_(position)
+	, offset_(0)
+	, hash_(0) {
+		auto const end = owner_->fsv_.data() + owner_->fsv_.length();
+		position_ = kernel::next(owner_->fsv_, owner_->strategy_, position_, end);
+		if (position_ != end) {
+			hash_ = owner_->gear_.roll(0, *position_);
+		}
+	}
+
+	auto rolling_hash_view::iter::operator*() const -> reference {
+		return hash_;
+	}
+
+	auto rolling_hash_view::iter::operator++() -> iter& {
+		auto const end = owner_->fsv_.data() + owner_->fsv_.length();
+		position_ = kernel::next(owner_->fsv_, owner_->strategy_, position_ + 1, end);
+		if (position_ != end) {
+			hash_ = owner_->gear_.roll(hash_, *position_);
+			++offset_;
+		}
+		return *this;
+	}
+
+	auto rolling_hash_view::iter::operator++(int) -> iter {
+		auto const copy = *this;
+		++*this;
+		return copy;
+	}
+
+	auto rolling_hash_view::iter::offset() const -> std::size_t {
+		return offset_;
+	}
+
+	auto operator==(const rolling_hash_view::iterator& lhs, const rolling_hash_view::iterator& rhs) -> bool {
+		return lhs.position_ == rhs.position_;
+	}
+
+	auto operator!=(const rolling_hash_view::iterator& lhs, const rolling_hash_view::iterator& rhs) -> bool {
+		return !(lhs == rhs);
+	}
+
+	rolling_hash_view::rolling_hash_view(const filtered_string_view& fsv, std::uint64_t seed)
+	: fsv_(fsv)
+	, strategy_(kernel::sequential(fsv))
+	, gear_(seed) {}
+
+	auto rolling_hash_view::begin() const -> iterator {
+		return iter(this, fsv_.data());
+	}
+
+	auto rolling_hash_view::end() const -> iterator {
+		return iter(this, fsv_.data() + fsv_.length());
+	}
+
+	// Normalised chunking: a chunk shorter than the average needs two more zero bits to end than the
+	// average alone would ask for, and a longer one two fewer, which narrows the spread of chunk sizes.
+	chunker::chunker(chunker_options options)
+	: options_(options)
+	, gear_(options.seed)
+	, doubled_()
+	, small_mask_(0)
+	, large_mask_(0)
+	, hash_(0)
+	, length_(0)
+	, offset_(0) {
+		if (options.min_size == 0 || options.min_size > options.average_size
+		    || options.average_size > options.max_size)
+		{
+			throw std::domain_error{"chunker(" + std::to_string(options.min_size) + ", "
+			                        + std::to_string(options.average_size) + ", "
+			                        + std::to_string(options.max_size) + "): sizes out of order"};
+		}
+		for (auto b = std::size_t{0}; b < doubled_.size(); ++b) {
+			doubled_[b] = gear_.table()[b] << 1U;
+		}
+		auto const bits = static_cast<int>(std::bit_width(options.average_size)) - 1;
+		small_mask_ = high_bits(bits + 2);
+		large_mask_ = high_bits(std::max(bits - 2, 1));
+	}
+
+	auto chunker::update(const filtered_string_view& fsv, std::vector<std::size_t>& ends) -> void {
+		kernel::for_each_block(fsv, [this, &ends](std::string_view accepted) {
+			consume(accepted.data(), accepted.size(), ends);
+			return true;
+		});
+	}
+
+	auto chunker::finish(std::vector<std::size_t>& ends) -> void {
+		if (length_ != 0) {
+			ends.push_back(offset_);
+		}
+		hash_ = 0;
+		length_ = 0;
+		offset_ = 0;
+	}
+
+	auto chunker::offset() const -> std::size_t {
+		return offset_;
+	}
+
+	auto chunker::options() const -> const chunker_options& {
+		return options_;
+	}
+
+	auto chunker::consume(const char* data, std::size_t length, std::vector<std::size_t>& ends) -> void {
+		auto const& table = gear_.table();
+		auto const& doubled = doubled_;
+		auto const end = data + length;
+		while (data != end) {
+			auto const left = static_cast<std::size_t>(end - data);
+			// the start of a chunk is skipped without hashing, since it could not end there anyway
+			if (length_ < options_.min_size) {
+				auto const skip = std::min(options_.min_size - length_, left);
+				data += skip;
+				length_ += skip;
+				offset_ += skip;
+				continue;
+			}
+			auto const small = length_ < options_.average_size;
+			auto const mask = small ? small_mask_ : large_mask_;
+			auto const shifted = mask << 1U;
+			auto const limit = std::min((small ? options_.average_size : options_.max_size) - length_, left);
+			auto hash = hash_;
+			auto i = std::size_t{0};
+			auto cut = false;
+			// two bytes per step, the first through a table shifted ahead of time, which takes one shift off
+			// the chain of dependent instructions for every other byte; halfway, hash is twice the real one
+			for (; i + 2 <= limit; i += 2) {
+				hash = (hash << 2U) + doubled[static_cast<unsigned char>(data[i])];
+				if ((hash & shifted) == 0) {
+					cut = true;
+					i += 1;
+					break;
+				}
+				hash += table[static_cast<unsigned char>(data[i + 1])];
+				if ((hash & mask) == 0) {
+					cut = true;
+					i += 2;
+					break;
+				}
+			}
+			if (!cut && i < limit) {
+				hash = (hash << 1U) + table[static_cast<unsigned char>(data[i])];
+				cut = (hash & mask) == 0;
+				++i;
+			}
+			data += i;
+			length_ += i;
+			offset_ += i;
+			hash_ = hash;
+			if (cut || length_ == options_.max_size) {
+				ends.push_back(offset_);
+				hash_ = 0;
+				length_ = 0;
+			}
+		}
+	}
+
+	auto chunk_ends(const filtered_string_view& fsv, chunker_options options) -> std::vector<std::size_t> {
+		auto c = chunker(options);
+		auto ends = std::vector<std::size_t>();
+		c.update(fsv, ends);
+		c.finish(ends);
+		return ends;
+	}
+} // namespace fsv
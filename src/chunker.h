@@ -0,0 +1,136 @@
+#ifndef COMP6771_ASS2_CHUNKER_H
+#define COMP6771_ASS2_CHUNKER_H
+
+#include "./filtered_string_view.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+namespace fsv {
+	// Gear rolling hash. Each byte shifts the hash left by one bit and adds a random word chosen by the byte,
+	// so a byte has shifted out of the hash 64 bytes after it went in, and the hash depends only on the last
+	// 64 bytes fed. The words are drawn from seed, so the same seed always gives the same hashes.
+	class gear_hash {
+	 public:
+		static constexpr std::size_t window = 64;
+
+		explicit gear_hash(std::uint64_t seed = 0);
+
+		// the hash once c is fed to a hash that was hash
+		auto roll(std::uint64_t hash, char c) const -> std::uint64_t;
+		// the hash once str is fed to a hash that was 0
+		auto operator()(std::string_view str) const -> std::uint64_t;
+		auto table() const -> const std::array<std::uint64_t, 256>&;
+
+	 private:
+		std::array<std::uint64_t, 256> table_;
+	};
+
+	// The Gear hash after each accepted character of a view, hashed from 0 at its first one:
+	//
+	//   for (auto it = hashes.begin(); it != hashes.end(); ++it) {
+	//       if ((*it >> 51U) == 0) { anchors.push_back(it.offset()); }
+	//   }
+	class rolling_hash_view {
+		class iter {
+		 public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = std::uint64_t;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = std::uint64_t;
+
+			iter();
+
+			auto operator*() const -> reference;
+			auto operator++() -> iter&;
+			auto operator++(int) -> iter;
+			// the index among the accepted characters of the character last hashed
+			auto offset() const -> std::size_t;
+
+			friend auto operator==(const iter&, const iter&) -> bool;
+			friend auto operator!=(const iter&, const iter&) -> bool;
+
+		 private:
+			friend class rolling_hash_view;
+			iter(const rolling_hash_view* owner, const char* position);
+
+			const rolling_hash_view* owner_;
+			const char* position_;
+			std::size_t offset_;
+			std::uint64_t hash_;
+		};
+
+	 public:
+		using iterator = iter;
+
+		explicit rolling_hash_view(const filtered_string_view& fsv, std::uint64_t seed = 0);
+
+		auto begin() const -> iterator;
+		auto end() const -> iterator;
+
+	 private:
+		filtered_string_view fsv_;
+		strategy strategy_;
+		gear_hash gear_;
+	};
+
+	struct chunker_options {
+		// no chunk is shorter than this, except the last
+		std::size_t min_size = 2048;
+		// the size chunks are normalised towards; only its highest set bit counts
+		std::size_t average_size = 8192;
+		// no chunk is longer than this
+		std::size_t max_size = 65536;
+		std::uint64_t seed = 0;
+	};
+
+	// Content-defined chunking in the manner of FastCDC, over the accepted characters of views. A chunk
+	// ends where the Gear hash of the bytes before it has enough zero bits near its top, so an insertion or
+	// deletion only moves the boundaries near it. The first min_size bytes of a chunk are not hashed, a
+	// chunk shorter than average_size needs two more zero bits than one past it, and one that reaches
+	// max_size is cut regardless.
+	//
+	// Views may be fed one after another, as if they were one stream. A view that accepts every byte is
+	// hashed in place; any other is compacted a block at a time into a buffer on the stack by the view's
+	// kernels, so no copy of the filtered text is made. Boundaries are offsets into the accepted
+	// characters, counted from the first one fed.
+	class chunker {
+	 public:
+		// throws std::domain_error unless 0 < min_size <= average_size <= max_size
+		explicit chunker(chunker_options options = {});
+
+		// feeds the accepted characters of fsv, appending to ends the offset just past each chunk that ends
+		auto update(const filtered_string_view& fsv, std::vector<std::size_t>& ends) -> void;
+		// ends the last chunk, if it is not empty, and starts again from offset 0
+		auto finish(std::vector<std::size_t>& ends) -> void;
+
+		// accepted characters fed since the last finish()
+		auto offset() const -> std::size_t;
+		auto options() const -> const chunker_options&;
+
+	 private:
+		chunker_options options_;
+		gear_hash gear_;
+		// the words of gear_ shifted left by one
+		std::array<std::uint64_t, 256> doubled_;
+		std::uint64_t small_mask_;
+		std::uint64_t large_mask_;
+		std::uint64_t hash_;
+		// accepted characters in the current chunk
+		std::size_t length_;
+		std::size_t offset_;
+
+		// feeds length accepted characters at data
+		auto consume(const char* data, std::size_t length, std::vector<std::size_t>& ends) -> void;
+	};
+
+	// the offset just past each chunk of the accepted characters, the last being fsv.size() if it is not 0
+	auto chunk_ends(const filtered_string_view& fsv, chunker_options options = {}) -> std::vector<std::size_t>;
+} // namespace fsv
+
+#endif // COMP6771_ASS2_CHUNKER_H
@@ -0,0 +1,148 @@
+#include "./chunker.h"
+#include "./char_class.h"
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+	// words of random letters separated by runs of whitespace of random kinds and lengths, where the words
+	// depend only on seed and the whitespace only on spacing_seed
+	auto random_words(std::size_t words, unsigned seed, unsigned spacing_seed) -> std::string {
+		auto engine = std::mt19937(seed);
+		auto spacing = std::mt19937(spacing_seed);
+		auto letter = std::uniform_int_distribution<int>('a', 'z');
+		auto word = std::uniform_int_distribution<int>(1, 9);
+		auto space = std::uniform_int_distribution<int>(1, 3);
+		auto const blanks = std::string(" \t\n");
+		auto result = std::string();
+		for (auto i = std::size_t{0}; i < words; ++i) {
+			for (auto n = word(engine); n > 0; --n) {
+				result += static_cast<char>(letter(engine));
+			}
+			for (auto n = space(spacing); n > 0; --n) {
+				result += blanks[static_cast<std::size_t>(space(spacing) - 1)];
+			}
+		}
+		return result;
+	}
+
+	auto without_whitespace(const std::string& str) -> std::string {
+		auto result = std::string();
+		for (auto const c : str) {
+			if (c != ' ' && c != '\t' && c != '\n') {
+				result += c;
+			}
+		}
+		return result;
+	}
+
+	auto const whitespace = ~fsv::char_class(" \t\n");
+} // namespace
+
+TEST_CASE("gear_hash depends only on the last 64 bytes") {
+	auto const gear = fsv::gear_hash();
+	auto const text = random_words(40, 1, 2);
+	REQUIRE(gear(text) == gear(text.substr(text.size() - 64)));
+	REQUIRE(gear(text) == gear("prefix" + text));
+	REQUIRE(gear(text.substr(0, 63)) != gear(text.substr(1, 63)));
+	REQUIRE(gear("ab") == gear.roll(gear.roll(0, 'a'), 'b'));
+	REQUIRE(fsv::gear_hash(1)("ab") != gear("ab"));
+	REQUIRE(fsv::gear_hash(1)("ab") == fsv::gear_hash(1)("ab"));
+}
+
+TEST_CASE("rolling_hash_view hashes the accepted characters") {
+	auto const text = std::string(" a b\tc  d ");
+	auto const gear = fsv::gear_hash(3);
+	auto const hashes = fsv::rolling_hash_view(fsv::filtered_string_view(text, whitespace), 3);
+	auto seen = std::vector<std::uint64_t>();
+	auto offsets = std::vector<std::size_t>();
+	for (auto it = hashes.begin(); it != hashes.end(); ++it) {
+		seen.push_back(*it);
+		offsets.push_back(it.offset());
+	}
+	REQUIRE(seen == std::vector<std::uint64_t>{gear("a"), gear("ab"), gear("abc"), gear("abcd")});
+	REQUIRE(offsets == std::vector<std::size_t>{0, 1, 2, 3});
+
+	auto const visible = fsv::filtered_string_view(text, [](const char& c) { return c > ' '; });
+	auto const predicate = fsv::rolling_hash_view(visible, 3);
+	REQUIRE(std::vector<std::uint64_t>(predicate.begin(), predicate.end()) == seen);
+	auto const empty = fsv::rolling_hash_view(fsv::filtered_string_view("   ", whitespace));
+	REQUIRE(empty.begin() == empty.end());
+}
+
+TEST_CASE("chunker cuts between the minimum and maximum sizes") {
+	auto const options = fsv::chunker_options{256, 1024, 4096, 0};
+	auto const text = random_words(200000, 4, 5);
+	auto const view = fsv::filtered_string_view(text, whitespace);
+	auto const ends = fsv::chunk_ends(view, options);
+	REQUIRE(ends.back() == view.size());
+	auto previous = std::size_t{0};
+	auto too_small = 0;
+	auto too_large = 0;
+	for (auto i = std::size_t{0}; i < ends.size(); ++i) {
+		auto const size = ends[i] - previous;
+		too_small += size < options.min_size && i + 1 != ends.size() ? 1 : 0;
+		too_large += size > options.max_size ? 1 : 0;
+		previous = ends[i];
+	}
+	REQUIRE(too_small == 0);
+	REQUIRE(too_large == 0);
+	auto const mean = view.size() / ends.size();
+	REQUIRE(mean > options.average_size / 2);
+	REQUIRE(mean < options.average_size * 2);
+
+	REQUIRE(fsv::chunk_ends(fsv::filtered_string_view("  ", whitespace)).empty());
+	REQUIRE(fsv::chunk_ends(fsv::filtered_string_view("abc")) == std::vector<std::size_t>{3});
+	REQUIRE_THROWS_AS(fsv::chunker(fsv::chunker_options{0, 1024, 4096, 0}), std::domain_error);
+	REQUIRE_THROWS_AS(fsv::chunker(fsv::chunker_options{256, 8192, 4096, 0}), std::domain_error);
+}
+
+TEST_CASE("chunk boundaries do not depend on the rejected characters") {
+	auto const options = fsv::chunker_options{512, 2048, 8192, 7};
+	auto const a = random_words(60000, 8, 9);
+	auto const b = random_words(60000, 8, 10);
+	REQUIRE(a != b);
+	auto const dense = without_whitespace(a);
+	REQUIRE(dense == without_whitespace(b));
+	auto const expected = fsv::chunk_ends(fsv::filtered_string_view(dense, fsv::char_class::all()), options);
+	REQUIRE(expected.size() > 10);
+	REQUIRE(fsv::chunk_ends(fsv::filtered_string_view(a, whitespace), options) == expected);
+	REQUIRE(fsv::chunk_ends(fsv::filtered_string_view(b, whitespace), options) == expected);
+	auto const predicate = [](const char& c) { return c != ' ' && c != '\t' && c != '\n'; };
+	REQUIRE(fsv::chunk_ends(fsv::filtered_string_view(a, predicate), options) == expected);
+
+	// the same text fed in uneven pieces
+	auto c = fsv::chunker(options);
+	auto ends = std::vector<std::size_t>();
+	for (auto offset = std::size_t{0}, piece = std::size_t{1}; offset < a.size(); piece = piece * 3 + 1) {
+		auto const count = std::min(piece, a.size() - offset);
+		c.update(fsv::filtered_string_view(a.data() + offset, count, whitespace), ends);
+		offset += count;
+	}
+	REQUIRE(c.offset() == dense.size());
+	c.finish(ends);
+	REQUIRE(ends == expected);
+	REQUIRE(c.offset() == 0);
+}
+
+TEST_CASE("an insertion only moves the chunk boundaries near it") {
+	auto const options = fsv::chunker_options{512, 2048, 8192, 0};
+	auto const text = without_whitespace(random_words(80000, 11, 12));
+	auto const edited = text.substr(0, 1000) + "inserted" + text.substr(1000);
+	auto const before = fsv::chunk_ends(fsv::filtered_string_view(text, fsv::char_class::all()), options);
+	auto const after = fsv::chunk_ends(fsv::filtered_string_view(edited, fsv::char_class::all()), options);
+	auto shifted = std::vector<std::size_t>();
+	for (auto const end : before) {
+		shifted.push_back(end > 1000 ? end + 8 : end);
+	}
+	// all but the few boundaries right after the edit survive it
+	auto kept = std::size_t{0};
+	for (auto const end : after) {
+		kept += std::binary_search(shifted.begin(), shifted.end(), end) ? 1U : 0U;
+	}
+	REQUIRE(kept + 3 >= before.size());
+}
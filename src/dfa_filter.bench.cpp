@@ -0,0 +1,77 @@
+#include "./char_class.h"
+#include "./dfa_filter.h"
+#include "./filtered_string_view.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Minifies pretty-printed JSON by stepping the automaton one byte at a time and with the bit-parallel quote
+// kernel, counting through a view's predicate and with popcounts, and compares the resulting view with
+// whitespace dropped everywhere, strings included.
+//
+//   dfa_filter_bench [megabytes]
+namespace {
+	using clock = std::chrono::steady_clock;
+
+	auto seconds_since(clock::time_point start) -> double {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	auto sample_json(std::size_t length) -> std::string {
+		auto result = std::string("[\n");
+		result.reserve(length);
+		for (auto i = std::size_t{0}; result.size() < length; ++i) {
+			result += "  {\n    \"id\": " + std::to_string(i) + ",\n    \"name\": \"user \\\"" + std::to_string(i * 31)
+			          + "\\\"\",\n    \"tags\": [ \"a b\", \"c\" ]\n  },\n";
+		}
+		result.resize(length);
+		return result;
+	}
+
+	auto report(const char* name, std::size_t bytes, double seconds, std::size_t checksum) -> void {
+		std::cout << std::left << std::setw(28) << name << std::right << std::setw(10)
+		          << static_cast<double>(bytes) / seconds / 1e6 << " MB/s  (" << checksum << ")\n";
+	}
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+	auto const megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64;
+	auto const text = sample_json(megabytes << 20U);
+	std::cout << std::fixed << std::setprecision(1);
+
+	{
+		auto stepped = fsv::dfa_filter::minify_json();
+		// overriding no transitions makes it forget it came from quoted()
+		stepped.on(0, fsv::char_class(), 0, false);
+		auto const start = clock::now();
+		auto const kept = stepped.view(text).size();
+		report("stepped automaton", text.size(), seconds_since(start), kept);
+	}
+	{
+		auto bits = std::vector<std::uint64_t>((text.size() + 63) / 64);
+		auto const start = clock::now();
+		fsv::dfa_filter::minify_json().classify(text.data(), text.size(), bits.data());
+		report("quote kernel, classify only", text.size(), seconds_since(start), bits.back());
+	}
+	{
+		auto const start = clock::now();
+		auto const kept = fsv::dfa_filter::minify_json().view(text).size();
+		report("quote kernel", text.size(), seconds_since(start), kept);
+	}
+	{
+		auto const start = clock::now();
+		auto const kept = fsv::dfa_filter::minify_json().apply(text).size();
+		report("quote kernel, popcount", text.size(), seconds_since(start), kept);
+	}
+	{
+		auto const start = clock::now();
+		auto const kept = fsv::filtered_string_view(text, ~fsv::char_class(" \t\n\r")).size();
+		report("stateless char_class", text.size(), seconds_since(start), kept);
+	}
+	return 0;
+}
@@ -0,0 +1,330 @@
+#include "./dfa_filter.h"
+#include "./scan.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <memory>
+#include <stdexcept>
+
+#if defined(__x86_64__)
+#	include <immintrin.h>
+#endif
+
+namespace fsv {
+	namespace {
+		constexpr auto keep_flag = std::uint8_t{1};
+		constexpr auto drop_previous_flag = std::uint8_t{2};
+		// bytes classified per round of the quoted kernel
+		constexpr auto block_words = std::size_t{64};
+
+		auto single(char c) -> char_class {
+			auto result = char_class();
+			result.insert(c);
+			return result;
+		}
+
+		auto shift_prefix_xor(std::uint64_t bits) -> std::uint64_t {
+			for (auto shift = 1U; shift < 64; shift <<= 1U) {
+				bits ^= bits << shift;
+			}
+			return bits;
+		}
+
+#if defined(__x86_64__)
+		// multiplying by all ones without carries XORs every bit into all the bits above it
+		[[gnu::target("pclmul")]] auto clmul_prefix_xor(std::uint64_t bits) -> std::uint64_t {
+			auto const product = _mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<long long>(bits)),
+			                                          _mm_set1_epi8(-1),
+			                                          0);
+			return static_cast<std::uint64_t>(_mm_cvtsi128_si64(product));
+		}
+
+		auto has_clmul() -> bool {
+			static auto const supported = __builtin_cpu_supports("pclmul") != 0;
+			return supported;
+		}
+#endif
+
+		// Characters escaped by an odd-length run of escapes, as simdjson finds them: runs are told apart by
+		// whether they start on an even or odd bit, and the carry out of the addition that walks each run to
+		// its end says whether the first character of the next word is escaped.
+		auto escaped_bits(std::uint64_t escapes, std::uint64_t& carry) -> std::uint64_t {
+			constexpr auto even = std::uint64_t{0x5555555555555555};
+			escapes &= ~carry;
+			auto const follows_escape = (escapes << 1U) | carry;
+			auto const odd_starts = escapes & ~even & ~follows_escape;
+			auto even_starts = std::uint64_t{0};
+			carry = __builtin_add_overflow(odd_starts, escapes, &even_starts) ? 1 : 0;
+			return (even ^ (even_starts << 1U)) & follows_escape;
+		}
+	} // namespace
+
+	dfa_filter::dfa_filter()
+	: table_(256, transition{0, 0}) {}
+
+	auto dfa_filter::add_state() -> std::size_t {
+		auto const s = states();
+		if (s == max_states) {
+			throw std::length_error{"dfa_filter::add_state(): more than " + std::to_string(max_states) + " states"};
+		}
+		table_.resize(table_.size() + 256, transition{static_cast<std::uint8_t>(s), 0});
+		quoted_.reset();
+		return s;
+	}
+
+	auto dfa_filter::on(std::size_t from, const char_class& cls, std::size_t to, bool keep, bool drop_previous)
+	    -> dfa_filter& {
+		if (from >= states() || to >= states()) {
+			throw std::out_of_range{"dfa_filter::on(" + std::to_string(from) + ", " + std::to_string(to)
+			                        + "): invalid state"};
+		}
+		auto const flags = static_cast<std::uint8_t>((keep ? keep_flag : 0) | (drop_previous ? drop_previous_flag : 0));
+		for (auto b = 0U; b < 256; ++b) {
+			if (cls.contains(static_cast<char>(b))) {
+				table_[from * 256 + b] = transition{static_cast<std::uint8_t>(to), flags};
+			}
+		}
+		quoted_.reset();
+		return *this;
+	}
+
+	auto dfa_filter::states() const -> std::size_t {
+		return table_.size() / 256;
+	}
+
+	auto dfa_filter::classify(const char* data, std::size_t length, std::uint64_t* out) const -> void {
+		if (quoted_) {
+			classify_quoted(data, length, out);
+			return;
+		}
+		std::fill_n(out, (length + 63) / 64, std::uint64_t{0});
+		auto state = std::size_t{0};
+		for (auto i = std::size_t{0}; i < length; ++i) {
+			auto const t = table_[state * 256 + static_cast<unsigned char>(data[i])];
+			out[i / 64] |= static_cast<std::uint64_t>(t.flags & keep_flag) << (i % 64);
+			if ((t.flags & drop_previous_flag) != 0 && i > 0) {
+				out[(i - 1) / 64] &= ~(std::uint64_t{1} << ((i - 1) % 64));
+			}
+			state = t.next;
+		}
+	}
+
+	auto dfa_filter::classify_quoted(const char* data, std::size_t length, std::uint64_t* out) const -> void {
+		auto const& rule = *quoted_;
+		auto const prefix_xor = [](std::uint64_t bits) {
+#if defined(__x86_64__)
+			if (has_clmul()) {
+				return clmul_prefix_xor(bits);
+			}
+#endif
+			return shift_prefix_xor(bits);
+		};
+		auto quotes = std::array<std::uint64_t, block_words>();
+		auto escapes = std::array<std::uint64_t, block_words>();
+		auto escape_carry = std::uint64_t{0};
+		// all ones while inside quotes at the end of the previous word
+		auto inside = std::uint64_t{0};
+		for (auto first = std::size_t{0}; first < length; first += block_words * 64) {
+			auto const count = std::min(block_words * 64, length - first);
+			auto const words = (count + 63) / 64;
+			auto* const kept = out + first / 64;
+			scan::classify(data + first, count, rule.keep, kept);
+			scan::classify(data + first, count, single(rule.quote), quotes.data());
+			if (rule.escape) {
+				scan::classify(data + first, count, single(*rule.escape), escapes.data());
+			}
+			for (auto w = std::size_t{0}; w < words; ++w) {
+				auto q = quotes[w];
+				if (rule.escape) {
+					q &= ~escaped_bits(escapes[w], escape_carry);
+				}
+				// the opening quote and what follows it up to, not including, the closing one
+				auto const quoted = prefix_xor(q) ^ inside;
+				inside = static_cast<std::uint64_t>(static_cast<std::int64_t>(quoted) >> 63U);
+				kept[w] |= quoted | q;
+			}
+		}
+		if (length % 64 != 0) {
+			out[length / 64] &= (std::uint64_t{1} << (length % 64)) - 1;
+		}
+	}
+
+	auto dfa_filter::apply(const char* data, std::size_t length) const -> dfa_view {
+		auto bits = std::make_shared<std::vector<std::uint64_t>>((length + 63) / 64);
+		classify(data, length, bits->data());
+		return dfa_view(data, length, std::move(bits));
+	}
+
+	auto dfa_filter::apply(const std::string& str) const -> dfa_view {
+		return apply(str.data(), str.size());
+	}
+
+	auto dfa_filter::view(const char* data, std::size_t length) const -> filtered_string_view {
+		return apply(data, length).view();
+	}
+
+	auto dfa_filter::view(const std::string& str) const -> filtered_string_view {
+		return view(str.data(), str.size());
+	}
+
+	auto dfa_filter::quoted(char quote, std::optional<char> escape, const char_class& keep) -> dfa_filter {
+		// outside, escaped outside, inside, escaped inside
+		auto result = dfa_filter();
+		auto const outside = std::size_t{0};
+		auto const outside_escaped = result.add_state();
+		auto const inside = result.add_state();
+		auto const inside_escaped = result.add_state();
+		auto const all = char_class::all();
+		result.on(outside, keep, outside, true).on(outside, ~keep, outside, false);
+		result.on(outside, single(quote), inside, true);
+		result.on(outside_escaped, keep, outside, true).on(outside_escaped, ~keep, outside, false);
+		result.on(inside, all, inside, true).on(inside, single(quote), outside, true);
+		result.on(inside_escaped, all, inside, true);
+		if (escape) {
+			result.on(outside, single(*escape), outside_escaped, keep.contains(*escape));
+			result.on(inside, single(*escape), inside_escaped, true);
+		}
+		result.quoted_ = quote_rule{quote, escape, keep};
+		return result;
+	}
+
+	auto dfa_filter::minify_json() -> dfa_filter {
+		return quoted('"', '\\', ~char_class(" \t\n\r"));
+	}
+
+	auto dfa_filter::strip_sql_comments() -> dfa_filter {
+		auto result = dfa_filter();
+		auto const code = std::size_t{0};
+		auto const dash = result.add_state();
+		auto const slash = result.add_state();
+		auto const line = result.add_state();
+		auto const block = result.add_state();
+		auto const star = result.add_state();
+		auto const literal = result.add_state();
+		auto const all = char_class::all();
+		// what code does with a character, from any state where it is code
+		for (auto const s : {code, dash, slash}) {
+			result.on(s, all, code, true);
+			result.on(s, single('-'), dash, true);
+			result.on(s, single('/'), slash, true);
+			result.on(s, single('\''), literal, true);
+		}
+		result.on(dash, single('-'), line, false, true);
+		result.on(slash, single('*'), block, false, true);
+		result.on(line, all, line, false).on(line, single('\n'), code, true);
+		result.on(block, all, block, false).on(block, single('*'), star, false);
+		result.on(star, all, block, false).on(star, single('*'), star, false).on(star, single('/'), code, false);
+		result.on(literal, all, literal, true).on(literal, single('\''), code, true);
+		return result;
+	}
+
+	dfa_view::dfa_view(const char* data, std::size_t length, std::shared_ptr<const std::vector<std::uint64_t>> bits)
+	: data_(data)
+	, length_(length)
+	, bits_(std::move(bits)) {}
+
+	auto dfa_view::size() const -> std::size_t {
+		auto result = std::size_t{0};
+		for (auto const word : *bits_) {
+			result += static_cast<std::size_t>(std::popcount(word));
+		}
+		return result;
+	}
+
+	auto dfa_view::empty() const -> bool {
+		return next(0) == length_;
+	}
+
+	auto dfa_view::begin() const -> iterator {
+		return iter(this, next(0));
+	}
+
+	auto dfa_view::end() const -> iterator {
+		return iter(this, length_);
+	}
+
+	// whole words of kept bytes are copied at once, and the rest a set bit at a time
+	dfa_view::operator std::string() const {
+		auto result = std::string();
+		result.reserve(size());
+		auto const& words = *bits_;
+		for (auto w = std::size_t{0}; w < words.size(); ++w) {
+			auto const base = data_ + w * 64;
+			if (words[w] == ~std::uint64_t{0}) {
+				result.append(base, 64);
+				continue;
+			}
+			for (auto word = words[w]; word != 0; word &= word - 1) {
+				result += base[std::countr_zero(word)];
+			}
+		}
+		return result;
+	}
+
+	auto dfa_view::view() const -> filtered_string_view {
+		return filtered_string_view(data_, length_, [bits = bits_, data = data_, length = length_](const char& c) {
+			// compared as integers, so a byte from outside the buffer is rejected rather than undefined
+			auto const i = reinterpret_cast<std::uintptr_t>(&c) - reinterpret_cast<std::uintptr_t>(data);
+			return i < length && (((*bits)[i / 64] >> (i % 64)) & 1U) != 0;
+		});
+	}
+
+	auto dfa_view::data() const -> const char* {
+		return data_;
+	}
+
+	auto dfa_view::length() const -> std::size_t {
+		return length_;
+	}
+
+	auto dfa_view::bits() const -> const std::vector<std::uint64_t>& {
+		return *bits_;
+	}
+
+	auto dfa_view::next(std::size_t from) const -> std::size_t {
+		auto const& words = *bits_;
+		auto w = from / 64;
+		if (w >= words.size()) {
+			return length_;
+		}
+		auto word = words[w] & (~std::uint64_t{0} << (from % 64));
+		while (word == 0) {
+			if (++w == words.size()) {
+				return length_;
+			}
+			word = words[w];
+		}
+		return w * 64 + static_cast<std::size_t>(std::countr_zero(word));
+	}
+
+	dfa_view::iter::iter()
+	: view_(nullptr)
+	, index_(0) {}
+
+	dfa_view::iter::iter(const dfa_view* view, std::size_t index)
+	: view_(view)
+	, index_(index) {}
+
+	auto dfa_view::iter::operator*() const -> reference {
+		return view_->data_[index_];
+	}
+
+	auto dfa_view::iter::operator++() -> iter& {
+		index_ = view_->next(index_ + 1);
+		return *this;
+	}
+
+	auto dfa_view::iter::operator++(int) -> iter {
+		auto const copy = *this;
+		++*this;
+		return copy;
+	}
+
+	auto operator==(const dfa_view::iterator& lhs, const dfa_view::iterator& rhs) -> bool {
+		return lhs.view_ == rhs.view_ && lhs.index_ == rhs.index_;
+	}
+
+	auto operator!=(const dfa_view::iterator& lhs, const dfa_view::iterator& rhs) -> bool {
+		return !(lhs == rhs);
+	}
+} // namespace fsv
@@ -0,0 +1,142 @@
+#ifndef COMP6771_ASS2_DFA_FILTER_H
+#define COMP6771_ASS2_DFA_FILTER_H
+
+#include "./char_class.h"
+#include "./filtered_string_view.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fsv {
+	// The characters an automaton kept from a buffer, along with the bit per byte it recorded for them.
+	// size() takes a popcount per 64 bytes and iteration finds the next kept byte a word at a time, where a
+	// filtered_string_view over the same bits calls its predicate on every byte. view() gives one anyway,
+	// for split() and the other functions that take views.
+	class dfa_view {
+		class iter {
+		 public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = char;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = const char&;
+
+			iter();
+			iter(const dfa_view* view, std::size_t index);
+
+			auto operator*() const -> reference;
+
+			auto operator++() -> iter&;
+			auto operator++(int) -> iter;
+
+			friend auto operator==(const iter&, const iter&) -> bool;
+			friend auto operator!=(const iter&, const iter&) -> bool;
+
+		 private:
+			const dfa_view* view_;
+			// raw offset of the current character, or the buffer's length at the end
+			std::size_t index_;
+		};
+
+	 public:
+		using iterator = iter;
+		using const_iterator = iter;
+
+		dfa_view(const char* data, std::size_t length, std::shared_ptr<const std::vector<std::uint64_t>> bits);
+
+		auto size() const -> std::size_t;
+		auto empty() const -> bool;
+		auto begin() const -> iterator;
+		auto end() const -> iterator;
+		explicit operator std::string() const;
+		// a filtered_string_view whose predicate looks characters up in the same bits, by their address
+		auto view() const -> filtered_string_view;
+		auto data() const -> const char*;
+		auto length() const -> std::size_t;
+		// one bit per byte, in the layout of scan::classify()
+		auto bits() const -> const std::vector<std::uint64_t>&;
+
+	 private:
+		const char* data_;
+		std::size_t length_;
+		std::shared_ptr<const std::vector<std::uint64_t>> bits_;
+
+		// raw offset of the first kept byte at or after from, or length_ if there is none
+		auto next(std::size_t from) const -> std::size_t;
+	};
+
+	// A filter whose decision for a character may depend on the characters before it, such as "whitespace
+	// outside string literals" or "anything inside a comment". It is a deterministic automaton of up to 256
+	// states that starts in state 0 at the beginning of the buffer; each transition says whether the
+	// character read is kept.
+	//
+	// apply() runs the automaton over a buffer once, recording one bit per byte, and returns a dfa_view that
+	// counts and iterates the kept characters through those bits. view() returns a filtered_string_view
+	// whose predicate looks its characters up there, so split() and the rest work on it as on any other
+	// view. Automata built by quoted() are run 64 bytes at a time without stepping through
+	// states: escaped characters are found with carry propagation and the bytes inside quotes with a prefix
+	// XOR, a carry-less multiply where the CPU has one. Other automata take one table lookup per byte.
+	class dfa_filter {
+	 public:
+		static constexpr std::size_t max_states = 256;
+
+		// a single state that drops every character
+		dfa_filter();
+
+		// adds a state that drops every character and stays put, and returns its number. Throws
+		// std::length_error if there are already max_states states.
+		auto add_state() -> std::size_t;
+		// in state from, a character of cls moves the automaton to state to and is kept if keep. With
+		// drop_previous the character before it is dropped too, for two-character openers like -- and /*
+		// whose first character is only known to start one when the second arrives. Later calls override
+		// earlier ones for the characters they share. Throws std::out_of_range for an unknown state.
+		auto on(std::size_t from, const char_class& cls, std::size_t to, bool keep, bool drop_previous = false)
+		    -> dfa_filter&;
+		auto states() const -> std::size_t;
+
+		// writes one bit per byte of [data, data + length), set for kept bytes, in the layout of
+		// scan::classify(); out must hold (length + 63) / 64 words
+		auto classify(const char* data, std::size_t length, std::uint64_t* out) const -> void;
+		// the kept characters of [data, data + length); the buffer must outlive the view and its copies
+		auto apply(const char* data, std::size_t length) const -> dfa_view;
+		auto apply(const std::string& str) const -> dfa_view;
+		// apply(data, length).view()
+		auto view(const char* data, std::size_t length) const -> filtered_string_view;
+		auto view(const std::string& str) const -> filtered_string_view;
+
+		// Keeps everything from a quote character to the next one, quotes included, and only the characters
+		// of keep elsewhere. An escape character, inside or outside quotes, makes the next character an
+		// ordinary one.
+		static auto quoted(char quote, std::optional<char> escape, const char_class& keep) -> dfa_filter;
+		// drops whitespace outside JSON strings
+		static auto minify_json() -> dfa_filter;
+		// drops -- line comments (keeping the newline) and /* */ block comments outside '...' literals
+		static auto strip_sql_comments() -> dfa_filter;
+
+	 private:
+		struct transition {
+			std::uint8_t next;
+			std::uint8_t flags;
+		};
+
+		struct quote_rule {
+			char quote;
+			std::optional<char> escape;
+			char_class keep;
+		};
+
+		// 256 transitions per state
+		std::vector<transition> table_;
+		// set by quoted(), which the bit-parallel kernel implements
+		std::optional<quote_rule> quoted_;
+
+		auto classify_quoted(const char* data, std::size_t length, std::uint64_t* out) const -> void;
+	};
+} // namespace fsv
+
+#endif // COMP6771_ASS2_DFA_FILTER_H
@@ -0,0 +1,156 @@
+#include "./dfa_filter.h"
+#include "./char_class.h"
+#include "./fuzzy.h"
+#include "./hash.h"
+#include "./icase.h"
+#include "./intern_table.h"
+#include "./multi_match.h"
+#include "./regex.h"
+#include "./test_text.h"
+
+#include <catch2/catch.hpp>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+	using fsv::test::random_text;
+
+	auto bits(const fsv::dfa_filter& filter, const std::string& text) -> std::vector<std::uint64_t> {
+		auto result = std::vector<std::uint64_t>((text.size() + 63) / 64);
+		filter.classify(text.data(), text.size(), result.data());
+		return result;
+	}
+
+	auto kept(const fsv::dfa_filter& filter, const std::string& text) -> std::string {
+		return static_cast<std::string>(filter.view(text));
+	}
+} // namespace
+
+TEST_CASE("dfa_filter minifies JSON") {
+	auto const json = std::string("{ \"name\" : \"a b\\\" c\",\n\t\"list\": [ 1, 2 ] , \"esc\\\\\" : \" \" }");
+	auto const minified = fsv::dfa_filter::minify_json().view(json);
+	REQUIRE(static_cast<std::string>(minified) == "{\"name\":\"a b\\\" c\",\"list\":[1,2],\"esc\\\\\":\" \"}");
+	REQUIRE(minified.size() == static_cast<std::string>(minified).size());
+	REQUIRE(minified[1] == '"');
+	auto const parts = fsv::split(minified, fsv::filtered_string_view(","));
+	REQUIRE(parts.size() == 4);
+	REQUIRE(static_cast<std::string>(parts[2]) == "2]");
+}
+
+TEST_CASE("dfa_filter strips SQL comments") {
+	auto const filter = fsv::dfa_filter::strip_sql_comments();
+	REQUIRE(kept(filter, "select a -- the key\nfrom t") == "select a \nfrom t");
+	REQUIRE(kept(filter, "a/* x * / **/b/c*d") == "ab/c*d");
+	REQUIRE(kept(filter, "'-- not /* a comment' - -1") == "'-- not /* a comment' - -1");
+	REQUIRE(kept(filter, "x---y\nz") == "x\nz");
+	REQUIRE(kept(filter, "/*/ still open */!") == "!");
+	REQUIRE(kept(filter, "trailing -") == "trailing -");
+	REQUIRE(kept(filter, "") == "");
+}
+
+TEST_CASE("dfa_filter drops the previous character across words") {
+	auto const filter = fsv::dfa_filter::strip_sql_comments();
+	for (auto const at : {std::size_t{62}, std::size_t{63}, std::size_t{64}, std::size_t{127}}) {
+		auto const text = std::string(at, 'x') + "--c\ny";
+		INFO(at);
+		REQUIRE(kept(filter, text) == std::string(at, 'x') + "\ny");
+	}
+}
+
+TEST_CASE("dfa_filter quoted kernel agrees with stepping the automaton") {
+	for (auto const escape : {std::optional<char>('\\'), std::optional<char>()}) {
+		auto const fast = fsv::dfa_filter::quoted('"', escape, fsv::char_class("ab\\"));
+		// overriding no transitions leaves the automaton unchanged but forgets it came from quoted()
+		auto slow = fsv::dfa_filter::quoted('"', escape, fsv::char_class("ab\\"));
+		slow.on(0, fsv::char_class(), 0, false);
+		// long runs of escapes and quotes cross word boundaries
+		for (auto const& alphabet : {std::string("ab \"\\"), std::string("\\\\\\\\\\\\\"a "), std::string("\"\"\"a")}) {
+			for (auto const seed : {1U, 2U, 3U}) {
+				for (auto const length : {std::size_t{1}, std::size_t{64}, std::size_t{200}, std::size_t{9000}}) {
+					auto const text = random_text(length, alphabet, seed);
+					INFO(text);
+					REQUIRE(bits(fast, text) == bits(slow, text));
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("dfa_filter built by hand") {
+	// keeps the characters between < and >, brackets excluded
+	auto filter = fsv::dfa_filter();
+	auto const tag = filter.add_state();
+	filter.on(0, fsv::char_class("<"), tag, false).on(tag, fsv::char_class::all(), tag, true);
+	filter.on(tag, fsv::char_class(">"), 0, false);
+	REQUIRE(filter.states() == 2);
+	REQUIRE(kept(filter, "a<bc>d<e>") == "bce");
+	auto const text = std::string("x<yz>");
+	REQUIRE(filter.view(text).size() == 2);
+}
+
+TEST_CASE("dfa_view counts and iterates through the bits") {
+	auto const filter = fsv::dfa_filter::minify_json();
+	for (auto const length : {std::size_t{0}, std::size_t{63}, std::size_t{64}, std::size_t{1000}, std::size_t{9000}}) {
+		auto const text = random_text(length, "ab \"\\", 4);
+		auto const applied = filter.apply(text);
+		auto const expected = static_cast<std::string>(filter.view(text));
+		INFO(text);
+		REQUIRE(applied.size() == expected.size());
+		REQUIRE(applied.empty() == expected.empty());
+		REQUIRE(static_cast<std::string>(applied) == expected);
+		REQUIRE(std::string(applied.begin(), applied.end()) == expected);
+		REQUIRE(static_cast<std::string>(applied.view()) == expected);
+		REQUIRE(applied.bits() == bits(filter, text));
+	}
+	// whole words of kept bytes, and a last word that is only partly used
+	auto const text = std::string(200, 'a') + "\"  \" " + std::string(70, 'b');
+	auto const applied = filter.apply(text);
+	REQUIRE(static_cast<std::string>(applied) == std::string(200, 'a') + "\"  \"" + std::string(70, 'b'));
+	REQUIRE(*applied.begin() == 'a');
+	REQUIRE(std::distance(applied.begin(), applied.end()) == 274);
+}
+
+TEST_CASE("dfa_filter views work wherever a view is taken") {
+	auto const text = std::string("{ \"a b\" : 1 }");
+	auto const view = fsv::dfa_filter::minify_json().view(text);
+	auto const minified = std::string("{\"a b\":1}");
+	REQUIRE(static_cast<std::string>(view) == minified);
+	REQUIRE(fsv::regex("\"a b\":1").search(view) == fsv::regex_match{1, 7});
+	REQUIRE(fsv::regex("\\{.*\\}").full_match(view));
+	REQUIRE(view.find("b\":") == 4);
+	REQUIRE(view.rfind('1') == 7);
+	REQUIRE(view == fsv::filtered_string_view(minified));
+	REQUIRE(fsv::hash64(view) == fsv::hash64(minified.data(), minified.size()));
+	REQUIRE(fsv::iequals(view, "{\"A B\":1}"));
+	REQUIRE(fsv::edit_distance(view, fsv::filtered_string_view(minified)) == 0);
+	REQUIRE(fsv::multi_matcher({"a b", ":1"}).find_all(view) == std::vector<fsv::match>{{0, 2}, {1, 6}});
+	auto table = fsv::intern_table();
+	REQUIRE(table.intern(view) == table.intern(minified));
+	REQUIRE(static_cast<std::string>(fsv::substr(view, 1, 5)) == "\"a b\"");
+	auto const parts = fsv::split(view, fsv::filtered_string_view(":"));
+	REQUIRE(parts.size() == 2);
+	REQUIRE(static_cast<std::string>(parts[0]) == "{\"a b\"");
+	REQUIRE(static_cast<std::string>(parts[1]) == "1}");
+
+	// long enough to be compared and hashed a block at a time
+	auto const long_text = random_text(20000, "ab \"\\", 5);
+	auto const long_view = fsv::dfa_filter::minify_json().view(long_text);
+	auto const expected = static_cast<std::string>(long_view);
+	REQUIRE(long_view == fsv::filtered_string_view(expected));
+	REQUIRE(fsv::hash64(long_view) == fsv::hash64(expected.data(), expected.size()));
+	REQUIRE(long_view.find(expected.substr(9000, 20)) == expected.find(expected.substr(9000, 20)));
+}
+
+TEST_CASE("dfa_filter rejects invalid states") {
+	auto filter = fsv::dfa_filter();
+	REQUIRE_THROWS_AS(filter.on(0, fsv::char_class("a"), 1, true), std::out_of_range);
+	REQUIRE_THROWS_AS(filter.on(1, fsv::char_class("a"), 0, true), std::out_of_range);
+	while (filter.states() < fsv::dfa_filter::max_states) {
+		filter.add_state();
+	}
+	REQUIRE_THROWS_AS(filter.add_state(), std::length_error);
+	REQUIRE_NOTHROW(filter.on(255, fsv::char_class("a"), 0, true));
+}
@@ -1,11 +1,24 @@
 #include "./filtered_string_view.h"
+#include "./scan.h"
 #include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 // Implement here
 namespace fsv {
-	const filter filtered_string_view::default_predicate = [](const char&) { return true; };
+	namespace {
+		// a named type, so views holding the default predicate can be recognized through predicate_.target
+		struct accept_all {
+			auto operator()(const char&) const -> bool {
+				return true;
+			}
+		};
+	} // namespace
+
+	const filter filtered_string_view::default_predicate = accept_all();
 
 	filtered_string_view::filtered_string_view()
 	: data_(nullptr)
@@ -22,18 +35,50 @@ namespace fsv {
 	, length_(std::strlen(str))
 	, predicate_(std::move(predicate)) {}
 
+	filtered_string_view::filtered_string_view(const char* str, std::size_t length, filter predicate)
+	: data_(str)
+	, length_(length)
+	, predicate_(std::move(predicate)) {}
+
+	filtered_string_view::filtered_string_view(const std::string& str, const char_class& cls)
+	: data_(str.data())
+	, length_(str.size())
+	, predicate_(cls)
+	, table_(cls) {}
+
+	filtered_string_view::filtered_string_view(const char* str, const char_class& cls)
+	: data_(str)
+	, length_(std::strlen(str))
+	, predicate_(cls)
+	, table_(cls) {}
+
+	filtered_string_view::filtered_string_view(const char* str, std::size_t length, const char_class& cls)
+	: data_(str)
+	, length_(length)
+	, predicate_(cls)
+	, table_(cls) {}
+
 	filtered_string_view::filtered_string_view(const filtered_string_view& other)
 	: data_(other.data_)
 	, length_(other.length_)
-	, predicate_(other.predicate_) {}
+	, predicate_(other.predicate_)
+	, table_(other.table_)
+	, strategy_(other.strategy_)
+	, selected_(other.selected_.load(std::memory_order_relaxed)) {}
 
 	filtered_string_view::filtered_string_view(filtered_string_view&& other) noexcept
 	: data_(other.data_)
 	, length_(other.length_)
-	, predicate_(std::move(other.predicate_)) {
+	, predicate_(std::move(other.predicate_))
+	, table_(other.table_)
+	, strategy_(other.strategy_)
+	, selected_(other.selected_.load(std::memory_order_relaxed)) {
 		other.data_ = nullptr;
 		other.length_ = 0;
 		other.predicate_ = default_predicate;
+		other.table_.reset();
+		other.strategy_ = strategy::automatic;
+		other.selected_.store(strategy::automatic, std::memory_order_relaxed);
 	}
 
 	// assignment operator
@@ -42,6 +87,9 @@ namespace fsv {
 			data_ = other.data_;
 			length_ = other.length_;
 			predicate_ = other.predicate_;
+			table_ = other.table_;
+			strategy_ = other.strategy_;
+			selected_.store(other.selected_.load(std::memory_order_relaxed), std::memory_order_relaxed);
 		}
 		return *this;
 	}
@@ -51,55 +99,44 @@ namespace fsv {
 			data_ = other.data_;
 			length_ = other.length_;
 			predicate_ = std::move(other.predicate_);
+			table_ = other.table_;
+			strategy_ = other.strategy_;
+			selected_.store(other.selected_.load(std::memory_order_relaxed), std::memory_order_relaxed);
 			other.data_ = nullptr;
 			other.length_ = 0;
 			other.predicate_ = default_predicate;
+			other.table_.reset();
+			other.strategy_ = strategy::automatic;
+			other.selected_.store(strategy::automatic, std::memory_order_relaxed);
 		}
 		return *this;
 	}
 
 	// subscript
-	auto filtered_string_view::operator[](int index) const -> const char& {
-		auto count = 0;
-		for (auto i = 0U; i < length_; ++i) {
-			if (predicate_(data_[i])) {
-				if (count == index) {
-					return data_[i];
-				}
-				++count;
-			}
+	auto filtered_string_view::operator[](std::size_t index) const -> const char& {
+		auto const offset = locate(0, index);
+		if (offset == length_) {
+			throw std::out_of_range{"filtered_string_view::operator[](" + std::to_string(index) + "): invalid index"};
 		}
-		throw std::out_of_range{"filtered_string_view::operator[](" + std::to_string(index) + "): invalid index"};
+		return data_[offset];
 	}
 
 	filtered_string_view::operator std::string() const {
 		auto result = std::string();
-		for (auto i = 0U; i < length_; ++i) {
-			if (predicate_(data_[i])) {
-				result.push_back(data_[i]);
-			}
-		}
+		kernel::append(*this, execution_strategy(), result);
 		return result;
 	}
 
-	auto filtered_string_view::at(int index) const -> const char& {
-		if (index < 0) {
+	auto filtered_string_view::at(std::size_t index) const -> const char& {
+		auto const offset = locate(0, index);
+		if (offset == length_) {
 			throw std::domain_error{"filtered_string_view::at(" + std::to_string(index) + "): invalid index"};
 		}
-		auto count = 0;
-		for (auto i = 0U; i < length_; ++i) {
-			if (predicate_(data_[i])) {
-				if (count == index) {
-					return data_[i];
-				}
-				++count;
-			}
-		}
-		throw std::domain_error{"filtered_string_view::at(" + std::to_string(index) + "): invalid index"};
+		return data_[offset];
 	}
 
 	auto filtered_string_view::size() const -> std::size_t {
-		return static_cast<std::size_t>(std::count_if(data_, data_ + length_, predicate_));
+		return kernel::count(*this, execution_strategy());
 	}
 
 	auto filtered_string_view::empty() const -> bool {
@@ -118,17 +155,393 @@ namespace fsv {
 		return predicate_;
 	}
 
-	// Non-member operators
-	auto operator==(const filtered_string_view& lhs, const filtered_string_view& rhs) -> bool {
-		if (lhs.size() != rhs.size()) {
-			return false;
+	auto filtered_string_view::table() const -> const std::optional<char_class>& {
+		return table_;
+	}
+
+	// threads that race to resolve the strategy compute the same one, so relaxed ordering is enough
+	auto filtered_string_view::execution_strategy() const -> strategy {
+		if (strategy_ != strategy::automatic) {
+			return strategy_;
+		}
+		auto s = selected_.load(std::memory_order_relaxed);
+		if (s == strategy::automatic) {
+			s = select_strategy(*this);
+			selected_.store(s, std::memory_order_relaxed);
 		}
-		for (int i = 0; i < static_cast<int>(lhs.size()); ++i) {
-			if (lhs[i] != rhs[i]) {
+		return s;
+	}
+
+	auto filtered_string_view::set_strategy(strategy s) -> void {
+		strategy_ = s;
+		selected_.store(strategy::automatic, std::memory_order_relaxed);
+	}
+
+	namespace {
+		constexpr auto search_block = std::size_t{1} << 16U;
+
+		// first occurrence of needle among the accepted characters in raw bytes [first, length) of fsv, where
+		// index accepted characters come before first. Accepted characters are materialized a block at a time
+		// behind the last needle.size() - 1 of the previous block, so matches across blocks are found too.
+		auto find_forward(const filtered_string_view& fsv,
+		                  std::size_t first,
+		                  std::size_t index,
+		                  std::string_view needle) -> std::size_t {
+			auto const s = kernel::sequential(fsv);
+			auto const keep = needle.size() - 1;
+			auto buffer = std::string(keep + std::min(search_block, fsv.length() - first), '\0');
+			auto size = std::size_t{0};
+			for (auto offset = first; offset < fsv.length();) {
+				auto const count = std::min(search_block, fsv.length() - offset);
+				auto const end = kernel::write(kernel::slice(fsv, offset, count), s, buffer.data() + size);
+				offset += count;
+				size = static_cast<std::size_t>(end - buffer.data());
+				auto const found = scan::find_substring(buffer.data(), size, needle);
+				if (found != size) {
+					return index + found;
+				}
+				auto const kept = std::min(keep, size);
+				std::memmove(buffer.data(), buffer.data() + size - kept, kept);
+				index += size - kept;
+				size = kept;
+			}
+			return filtered_string_view::npos;
+		}
+
+		// last occurrence of needle among the accepted characters in raw bytes [0, last) of fsv; blocks are
+		// materialized from the end, each followed by the first needle.size() - 1 characters of the one after
+		auto find_backward(const filtered_string_view& fsv, std::size_t last, std::string_view needle) -> std::size_t {
+			auto const s = kernel::sequential(fsv);
+			auto const keep = needle.size() - 1;
+			auto buffer = std::string(keep + std::min(search_block, last), '\0');
+			auto carry = std::string();
+			for (auto offset = last; offset > 0;) {
+				auto const count = std::min(search_block, offset);
+				offset -= count;
+				auto const end = kernel::write(kernel::slice(fsv, offset, count), s, buffer.data());
+				auto const written = static_cast<std::size_t>(end - buffer.data());
+				std::memcpy(buffer.data() + written, carry.data(), carry.size());
+				auto const size = written + carry.size();
+				auto const found = scan::rfind_substring(buffer.data(), size, needle);
+				if (found != size) {
+					return kernel::slice(fsv, 0, offset).size() + found;
+				}
+				carry.assign(buffer.data(), std::min(keep, size));
+			}
+			return filtered_string_view::npos;
+		}
+
+		// Finds runs of at least 4 KiB of accepted bytes in the blocks of a char_class view, as [start, end)
+		// offsets into the block. Every 64th byte is looked up, and a run is only measured where those stay
+		// accepted long enough. Shorter runs cost less to copy with the rejected bytes around them than to
+		// search on their own, and after a block without long runs the next few are not looked at, so views
+		// that have none pay little for looking.
+		class run_finder {
+		 public:
+			explicit run_finder(const char_class& cls)
+			: cls_(cls) {}
+
+			auto find(const char* block, std::size_t count) -> const std::vector<std::pair<std::size_t, std::size_t>>& {
+				runs_.clear();
+				if (skip_ > 0) {
+					--skip_;
+					return runs_;
+				}
+				auto from = std::size_t{0};
+				for (auto i = std::size_t{0}; i < count; i += stride) {
+					if (!cls_.contains(block[i])) {
+						continue;
+					}
+					auto j = i;
+					while (j < count && j - i < min_run && cls_.contains(block[j])) {
+						j += stride;
+					}
+					if (j - i < min_run) {
+						i = j;
+						continue;
+					}
+					// the sample before i was rejected, so the run starts less than a stride back
+					auto start = i;
+					while (start > from && cls_.contains(block[start - 1])) {
+						--start;
+					}
+					auto const end = i + scan::find_first_not(block + i, count - i, cls_);
+					if (end - start >= min_run) {
+						runs_.emplace_back(start, end);
+					}
+					from = end;
+					i = end;
+				}
+				skip_ = runs_.empty() ? backoff_ : 0;
+				backoff_ = runs_.empty() ? std::min(backoff_ * 2, max_backoff) : 1;
+				return runs_;
+			}
+
+		 private:
+			static constexpr auto stride = std::size_t{64};
+			static constexpr auto min_run = std::size_t{4096};
+			static constexpr auto max_backoff = std::size_t{16};
+
+			const char_class& cls_;
+			std::vector<std::pair<std::size_t, std::size_t>> runs_;
+			std::size_t skip_ = 0;
+			std::size_t backoff_ = 1;
+		};
+
+		// find_forward for a char_class view. Long runs of accepted bytes are searched where they lie, so only
+		// the characters between them, with needle.size() - 1 on either side, are materialized to find the
+		// matches that straddle rejected bytes.
+		auto find_forward_in_runs(const filtered_string_view& fsv,
+		                          std::size_t first,
+		                          std::size_t index,
+		                          std::string_view needle) -> std::size_t {
+			auto const s = kernel::sequential(fsv);
+			auto const keep = needle.size() - 1;
+			auto finder = run_finder(*fsv.table());
+			// accepted characters from index on, yet to be searched along with what follows them
+			auto pending = std::string();
+			auto const gather = [&](std::size_t from, std::size_t to, std::size_t head) {
+				auto const before = pending.size();
+				pending.resize(before + to - from + head);
+				auto const end = kernel::write(kernel::slice(fsv, from, to - from), s, pending.data() + before);
+				std::memcpy(end, fsv.data() + to, head);
+				pending.resize(static_cast<std::size_t>(end - pending.data()) + head);
+				auto const found = scan::find_substring(pending.data(), pending.size(), needle);
+				return found == pending.size() ? filtered_string_view::npos : index + found;
+			};
+			for (auto offset = first; offset < fsv.length(); offset += search_block) {
+				auto const count = std::min(search_block, fsv.length() - offset);
+				auto gap = offset;
+				for (auto const& [start, end] : finder.find(fsv.data() + offset, count)) {
+					auto const run = fsv.data() + offset + start;
+					auto const length = end - start;
+					if (length <= keep) {
+						continue;
+					}
+					if (auto const found = gather(gap, offset + start, keep); found != filtered_string_view::npos) {
+						return found;
+					}
+					index += pending.size() - keep;
+					auto const found = scan::find_substring(run, length, needle);
+					if (found != length) {
+						return index + found;
+					}
+					index += length - keep;
+					pending.assign(run + length - keep, keep);
+					gap = offset + end;
+				}
+				if (auto const found = gather(gap, offset + count, 0); found != filtered_string_view::npos) {
+					return found;
+				}
+				auto const kept = std::min(keep, pending.size());
+				index += pending.size() - kept;
+				pending.erase(0, pending.size() - kept);
+			}
+			return filtered_string_view::npos;
+		}
+
+		// find_backward for a char_class view, searching long runs in place as find_forward_in_runs does
+		auto find_backward_in_runs(const filtered_string_view& fsv, std::size_t last, std::string_view needle)
+		    -> std::size_t {
+			auto const& cls = *fsv.table();
+			auto const s = kernel::sequential(fsv);
+			auto const keep = needle.size() - 1;
+			auto finder = run_finder(cls);
+			// the first needle.size() - 1 characters after the part searched next
+			auto carry = std::string();
+			auto window = std::string();
+			// searches the tail of a run, raw bytes [from, to) and the carry, in that order, with the window
+			// starting at raw offset from - tail
+			auto const gather = [&](std::size_t tail, std::size_t from, std::size_t to) {
+				window.resize(tail + to - from + carry.size());
+				std::memcpy(window.data(), fsv.data() + from - tail, tail);
+				auto const end = kernel::write(kernel::slice(fsv, from, to - from), s, window.data() + tail);
+				std::memcpy(end, carry.data(), carry.size());
+				window.resize(static_cast<std::size_t>(end - window.data()) + carry.size());
+				auto const found = scan::rfind_substring(window.data(), window.size(), needle);
+				return found == window.size() ? filtered_string_view::npos
+				                              : scan::count(fsv.data(), from - tail, cls) + found;
+			};
+			for (auto offset = last; offset > 0;) {
+				auto const count = std::min(search_block, offset);
+				offset -= count;
+				auto const& found_runs = finder.find(fsv.data() + offset, count);
+				auto gap = offset + count;
+				for (auto it = found_runs.rbegin(); it != found_runs.rend(); ++it) {
+					auto const [start, end] = *it;
+					auto const length = end - start;
+					if (length <= keep) {
+						continue;
+					}
+					if (auto const found = gather(keep, offset + end, gap); found != filtered_string_view::npos) {
+						return found;
+					}
+					auto const run = fsv.data() + offset + start;
+					auto const found = scan::rfind_substring(run, length, needle);
+					if (found != length) {
+						return scan::count(fsv.data(), offset + start, cls) + found;
+					}
+					carry.assign(run, keep);
+					gap = offset + start;
+				}
+				if (auto const found = gather(0, offset, gap); found != filtered_string_view::npos) {
+					return found;
+				}
+				carry.assign(window.data(), std::min(keep, window.size()));
+			}
+			return filtered_string_view::npos;
+		}
+
+		// runs are found with the scan kernels, so only for views whose strategy uses them
+		auto searches_runs(const filtered_string_view& fsv) -> bool {
+			if (!fsv.table()) {
 				return false;
 			}
+			auto const s = kernel::sequential(fsv);
+			return s == strategy::simd || s == strategy::sparse;
 		}
-		return true;
+	} // namespace
+
+	auto filtered_string_view::find(std::string_view needle, std::size_t pos) const -> std::size_t {
+		if (needle.empty()) {
+			return pos <= size() ? pos : npos;
+		}
+		if (unfiltered()) {
+			if (pos >= length_) {
+				return npos;
+			}
+			auto const found = scan::find_substring(data_ + pos, length_ - pos, needle);
+			return found == length_ - pos ? npos : pos + found;
+		}
+		auto const first = locate(0, pos);
+		if (first == length_) {
+			return npos;
+		}
+		return searches_runs(*this) ? find_forward_in_runs(*this, first, pos, needle)
+		                            : find_forward(*this, first, pos, needle);
+	}
+
+	auto filtered_string_view::find(char c, std::size_t pos) const -> std::size_t {
+		return find(std::string_view(&c, 1), pos);
+	}
+
+	auto filtered_string_view::rfind(std::string_view needle, std::size_t pos) const -> std::size_t {
+		if (needle.empty()) {
+			return std::min(pos, size());
+		}
+		// only matches that start at or before pos end before the accepted character pos + needle.size()
+		auto const last = pos > npos - needle.size() ? length_ : locate(0, pos + needle.size());
+		if (unfiltered()) {
+			auto const found = scan::rfind_substring(data_, last, needle);
+			return found == last ? npos : found;
+		}
+		return searches_runs(*this) ? find_backward_in_runs(*this, last, needle) : find_backward(*this, last, needle);
+	}
+
+	auto filtered_string_view::rfind(char c, std::size_t pos) const -> std::size_t {
+		return rfind(std::string_view(&c, 1), pos);
+	}
+
+	auto filtered_string_view::contains(std::string_view needle) const -> bool {
+		return find(needle) != npos;
+	}
+
+	auto filtered_string_view::contains(char c) const -> bool {
+		return find(c) != npos;
+	}
+
+	auto filtered_string_view::starts_with(std::string_view prefix) const -> bool {
+		return std::mismatch(prefix.begin(), prefix.end(), begin(), end()).first == prefix.end();
+	}
+
+	auto filtered_string_view::starts_with(char c) const -> bool {
+		return starts_with(std::string_view(&c, 1));
+	}
+
+	auto filtered_string_view::ends_with(std::string_view suffix) const -> bool {
+		return std::mismatch(suffix.rbegin(), suffix.rend(), rbegin(), rend()).first == suffix.rend();
+	}
+
+	auto filtered_string_view::ends_with(char c) const -> bool {
+		return ends_with(std::string_view(&c, 1));
+	}
+
+	auto filtered_string_view::find_first_of(const char_class& set, std::size_t pos) const -> std::size_t {
+		return find_first_in(set, pos);
+	}
+
+	auto filtered_string_view::find_first_of(std::string_view chars, std::size_t pos) const -> std::size_t {
+		return find_first_in(char_class(chars), pos);
+	}
+
+	auto filtered_string_view::find_last_of(const char_class& set, std::size_t pos) const -> std::size_t {
+		return find_last_in(set, pos);
+	}
+
+	auto filtered_string_view::find_last_of(std::string_view chars, std::size_t pos) const -> std::size_t {
+		return find_last_in(char_class(chars), pos);
+	}
+
+	auto filtered_string_view::find_first_not_of(const char_class& set, std::size_t pos) const -> std::size_t {
+		return find_first_in(~set, pos);
+	}
+
+	auto filtered_string_view::find_first_not_of(std::string_view chars, std::size_t pos) const -> std::size_t {
+		return find_first_in(~char_class(chars), pos);
+	}
+
+	auto filtered_string_view::find_last_not_of(const char_class& set, std::size_t pos) const -> std::size_t {
+		return find_last_in(~set, pos);
+	}
+
+	auto filtered_string_view::find_last_not_of(std::string_view chars, std::size_t pos) const -> std::size_t {
+		return find_last_in(~char_class(chars), pos);
+	}
+
+	auto filtered_string_view::count_of(const char_class& set) const -> std::size_t {
+		if (table_) {
+			return scan::count(data_, length_, *table_ & set);
+		}
+		return static_cast<std::size_t>(std::count_if(data_, data_ + length_, [&](const char& c) {
+			return set.contains(c) && predicate_(c);
+		}));
+	}
+
+	auto filtered_string_view::count_of(std::string_view chars) const -> std::size_t {
+		return count_of(char_class(chars));
+	}
+
+	auto filtered_string_view::find_first_in(const char_class& set, std::size_t pos) const -> std::size_t {
+		auto const first = locate(0, pos);
+		// a char_class view folds its own filter into the set, otherwise candidates still need the predicate
+		auto const candidates = table_ ? *table_ & set : set;
+		for (auto offset = first; offset < length_; ++offset) {
+			offset += scan::find_first(data_ + offset, length_ - offset, candidates);
+			if (offset < length_ && (table_ || predicate_(data_[offset]))) {
+				return pos + kernel::count(kernel::slice(*this, first, offset - first), kernel::sequential(*this));
+			}
+		}
+		return npos;
+	}
+
+	auto filtered_string_view::find_last_in(const char_class& set, std::size_t pos) const -> std::size_t {
+		auto const candidates = table_ ? *table_ & set : set;
+		for (auto last = pos == npos ? length_ : locate(0, pos + 1); last > 0;) {
+			auto const found = scan::find_last(data_, last, candidates);
+			if (found == last) {
+				break;
+			}
+			if (table_ || predicate_(data_[found])) {
+				return kernel::count(kernel::slice(*this, 0, found), kernel::sequential(*this));
+			}
+			last = found;
+		}
+		return npos;
+	}
+
+	// Non-member operators
+	auto operator==(const filtered_string_view& lhs, const filtered_string_view& rhs) -> bool {
+		return kernel::compare(kernel::block_reader(lhs), kernel::block_reader(rhs)) == std::strong_ordering::equal;
 	}
 
 	auto operator!=(const filtered_string_view& lhs, const filtered_string_view& rhs) -> bool {
@@ -136,21 +549,21 @@ namespace fsv {
 	}
 
 	auto operator<=>(const filtered_string_view& lhs, const filtered_string_view& rhs) -> std::strong_ordering {
-		int lhs_length = static_cast<int>(lhs.size());
-		int rhs_length = static_cast<int>(rhs.size());
-		for (int i = 0; i < std::min(lhs_length, rhs_length); ++i) {
-			if (auto cmp = lhs[i] <=> rhs[i]; cmp != std::strong_ordering::equal) {
-				return cmp;
-			}
-		}
-		return lhs_length <=> rhs_length;
+		return kernel::compare(kernel::block_reader(lhs), kernel::block_reader(rhs));
 	}
 
 	auto operator<<(std::ostream& os, const filtered_string_view& fsv) -> std::ostream& {
-		for (auto i = 0U; i < fsv.length_; ++i) {
-			if (fsv.predicate_(fsv.data_[i])) {
-				os << fsv.data_[i];
-			}
+		// materialized a block at a time so huge views are not copied whole
+		constexpr auto block = std::size_t{1} << 16U;
+		auto const s = fsv.execution_strategy();
+		auto buffer = std::string();
+		for (auto offset = std::size_t{0}; offset < fsv.length_; offset += block) {
+			auto const count = std::min(block, fsv.length_ - offset);
+			auto const chunk = fsv.table_ ? filtered_string_view(fsv.data_ + offset, count, *fsv.table_)
+			                              : filtered_string_view(fsv.data_ + offset, count, fsv.predicate_);
+			buffer.clear();
+			kernel::append(chunk, s == strategy::parallel ? strategy::simd : s, buffer);
+			os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
 		}
 		return os;
 	}
@@ -172,65 +585,78 @@ namespace fsv {
 	auto split(const filtered_string_view& fsv, const filtered_string_view& tok) -> std::vector<filtered_string_view> {
 		auto result = std::vector<filtered_string_view>();
 
-		if (fsv.empty()) {
+		auto const text = std::string_view(fsv.data(), fsv.length());
+		auto const delim = std::string_view(tok.data(), tok.length());
+		if (fsv.empty() || delim.empty()) {
 			result.push_back(fsv);
 			return result;
 		}
 
-		auto start = fsv.data();
-		auto end = fsv.data() + fsv.length();
-		auto delim_start = tok.data();
-		auto delim_length = tok.length();
-		auto current = start;
-
-		while (current < end) {
-			auto next_delim = std::search(current, end, delim_start, delim_start + delim_length);
-			if (next_delim == end) {
-				result.emplace_back(current, fsv.predicate());
-				break;
-			}
-
-			result.emplace_back(current, [current, next_delim, fsv](const char& c) {
-				return &c >= current && &c < next_delim && fsv.predicate()(c);
-			});
-			current = next_delim + delim_length;
-		}
-		if (current == end) {
-			result.push_back("");
+		// tokens are bounded slices of the buffer, so they keep the view's char_class and its kernels
+		auto current = std::size_t{0};
+		for (auto next = text.find(delim); next != std::string_view::npos; next = text.find(delim, current)) {
+			result.push_back(kernel::slice(fsv, current, next - current));
+			current = next + delim.size();
 		}
+		result.push_back(kernel::slice(fsv, current, text.size() - current));
 
 		return result;
 	}
 
 	// substr function
-	auto substr(const filtered_string_view& fsv, int pos, int count) -> filtered_string_view {
-		if (pos < 0 || static_cast<std::size_t>(pos) > fsv.size()) {
+	auto substr(const filtered_string_view& fsv, std::size_t pos, std::size_t count) -> filtered_string_view {
+		auto const first = fsv.locate(0, pos);
+		if (first == fsv.length_ && pos > fsv.size()) {
 			throw std::out_of_range{"filtered_string_view::substr(" + std::to_string(pos) + ", " + std::to_string(count)
 			                        + "): invalid position"};
 		}
+		auto const last = count == filtered_string_view::npos ? fsv.length_ : fsv.locate(first, count);
+		return kernel::slice(fsv, first, last - first);
+	}
 
-		auto start_pos = static_cast<std::size_t>(pos);
-		auto rcount = (count <= 0) ? fsv.size() - start_pos : static_cast<std::size_t>(count);
-		if (start_pos + rcount > fsv.size()) {
-			rcount = fsv.size() - start_pos;
-		}
+	auto filtered_string_view::unfiltered() const -> bool {
+		return table_ ? *table_ == char_class::all() : predicate_.target<accept_all>() != nullptr;
+	}
 
-		filter new_predicate = [fsv, start_pos, rcount](const char& c) {
-			for (std::size_t i = 0; i < rcount; ++i) {
-				if (fsv[static_cast<int>(start_pos + i)] == c) {
-					return fsv.predicate()(c);
+	auto filtered_string_view::locate(std::size_t from, std::size_t index) const -> std::size_t {
+		// whole blocks before the one holding the character are counted with the kernels, so long views are
+		// not walked a predicate call at a time
+		constexpr auto block = std::size_t{1} << 16U;
+		auto offset = from;
+		if (length_ - offset > block) {
+			auto const s = kernel::sequential(*this);
+			for (; length_ - offset > block; offset += block) {
+				auto const accepted = kernel::count(kernel::slice(*this, offset, block), s);
+				if (accepted > index) {
+					break;
 				}
+				index -= accepted;
 			}
-			return false;
-		};
-
-		return filtered_string_view(fsv.data() + start_pos, new_predicate);
+		}
+		for (; offset < length_; ++offset) {
+			if (table_ ? (*table_)(data_[offset]) : predicate_(data_[offset])) {
+				if (index == 0) {
+					return offset;
+				}
+				--index;
+			}
+		}
+		return length_;
 	}
 
 	void filtered_string_view::iter::advance() {
-		do {
-			++ptr_;
-		} while (ptr_ != nullptr && view_ != nullptr && *ptr_ != '\0' && !view_->predicate()(*ptr_));
+		++ptr_;
+		if (ptr_ != nullptr && view_ != nullptr && ptr_ < view_->data() + view_->length()) {
+			// resolved on the first step rather than when the iterator is made, so that making end() to
+			// compare against costs nothing; a parallel view is walked with its sequential kernel
+			if (strategy_ == strategy::automatic) {
+				strategy_ = view_->execution_strategy();
+				if (strategy_ == strategy::parallel) {
+					strategy_ = kernel::sequential(*view_);
+				}
+			}
+			ptr_ = kernel::next(*view_, strategy_, ptr_, view_->data() + view_->length());
+		}
 	}
 
 	void filtered_string_view::iter::retreat() {
@@ -242,12 +668,16 @@ namespace fsv {
 	// iterator class implementation
 	filtered_string_view::iter::iter()
 	: ptr_(nullptr)
-	, view_(nullptr) {}
+	, view_(nullptr)
+	, strategy_(strategy::scalar) {}
 
 	filtered_string_view::iter::iter(const char* ptr, const filtered_string_view* view)
 	: ptr_(ptr)
-	, view_(view) {
-		if (ptr_ != nullptr && view_ != nullptr && !view_->predicate()(*ptr_)) {
+	, view_(view)
+	, strategy_(strategy::automatic) {
+		if (ptr_ != nullptr && view_ != nullptr && ptr_ < view_->data() + view_->length()
+		    && !view_->predicate()(*ptr_))
+		{
 			advance();
 		}
 	}
@@ -1,13 +1,23 @@
 #ifndef COMP6771_ASS2_FSV_H
 #define COMP6771_ASS2_FSV_H
 
+#include "./char_class.h"
+#include "./strategy.h"
+
+#include <atomic>
 #include <compare>
+#include <concepts>
 #include <functional>
 #include <iterator>
 #include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 
 namespace fsv {
+	// Views and the functions that take them call a filter with a reference to the byte in the view's own
+	// buffer, never to a copy, so a filter may work out a byte's position from its address, as
+	// dfa_view::view() does. char_class::from() and transform_builder::keep() after map() are the exceptions.
 	using filter = std::function<bool(const char&)>;
 
 	class filtered_string_view {
@@ -36,6 +46,8 @@ namespace fsv {
 			/* Implementation-specific private members */
 			const char* ptr_;
 			const filtered_string_view* view_;
+			// automatic until the first step resolves it
+			strategy strategy_;
 			void advance();
 			void retreat();
 		};
@@ -46,10 +58,18 @@ namespace fsv {
 		using reverse_iterator = std::reverse_iterator<iterator>;
 		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
+		static constexpr auto npos = static_cast<std::size_t>(-1);
+		// accepts every character; views built with it are unfiltered()
+		static const filter default_predicate;
+
 		// constructor
 		filtered_string_view();
 		filtered_string_view(const std::string& str, filter predicate = default_predicate);
 		filtered_string_view(const char* str, filter predicate = default_predicate);
+		filtered_string_view(const char* str, std::size_t length, filter predicate = default_predicate);
+		filtered_string_view(const std::string& str, const char_class& cls);
+		filtered_string_view(const char* str, const char_class& cls);
+		filtered_string_view(const char* str, std::size_t length, const char_class& cls);
 		filtered_string_view(const filtered_string_view& other);
 		filtered_string_view(filtered_string_view&& other) noexcept;
 
@@ -59,19 +79,71 @@ namespace fsv {
 		auto operator=(const filtered_string_view& other) -> filtered_string_view&;
 		auto operator=(filtered_string_view&& other) noexcept -> filtered_string_view&;
 
-		// subscript
-		auto operator[](int index) const -> const char&;
+		// subscript; indices count accepted characters, and signed ones are accepted for compatibility
+		auto operator[](std::size_t index) const -> const char&;
+		template<std::signed_integral Index>
+		auto operator[](Index index) const -> const char& {
+			if (index < 0) {
+				throw std::out_of_range{"filtered_string_view::operator[](" + std::to_string(index)
+				                        + "): invalid index"};
+			}
+			return (*this)[static_cast<std::size_t>(index)];
+		}
 		// string type conversion
 		explicit operator std::string() const;
 
 		// member function
-		auto at(int index) const -> const char&;
+		auto at(std::size_t index) const -> const char&;
+		template<std::signed_integral Index>
+		auto at(Index index) const -> const char& {
+			if (index < 0) {
+				throw std::domain_error{"filtered_string_view::at(" + std::to_string(index) + "): invalid index"};
+			}
+			return at(static_cast<std::size_t>(index));
+		}
 		auto size() const -> std::size_t;
 		auto empty() const -> bool;
 		auto data() const -> const char*;
 		auto predicate() const -> const filter&;
+		// set when the predicate is a char_class, so kernels may classify bytes without calling predicate()
+		auto table() const -> const std::optional<char_class>&;
+		// true if the view accepts every byte, being the default predicate or a char_class of all 256, so its
+		// characters are the buffer as is
+		auto unfiltered() const -> bool;
+		// the strategy used by size(), materialization, iteration, search and comparison; unless one was set
+		// explicitly, it is resolved by select_strategy() the first time it is needed and remembered by the view
+		auto execution_strategy() const -> strategy;
+		// forces a strategy; strategy::automatic restores automatic selection
+		auto set_strategy(strategy s) -> void;
 		auto length() const -> std::size_t;
 
+		// search over the accepted characters, without materializing them: positions and results are
+		// indices of accepted characters, and npos means there is no match. find() returns no index before
+		// pos and rfind() none after it.
+		auto find(std::string_view needle, std::size_t pos = 0) const -> std::size_t;
+		auto find(char c, std::size_t pos = 0) const -> std::size_t;
+		auto rfind(std::string_view needle, std::size_t pos = npos) const -> std::size_t;
+		auto rfind(char c, std::size_t pos = npos) const -> std::size_t;
+		auto contains(std::string_view needle) const -> bool;
+		auto contains(char c) const -> bool;
+		auto starts_with(std::string_view prefix) const -> bool;
+		auto starts_with(char c) const -> bool;
+		auto ends_with(std::string_view suffix) const -> bool;
+		auto ends_with(char c) const -> bool;
+		// the same, for any character of a set; the set is classified with the scan kernels, so the predicate
+		// is only called for candidates and for counting the characters before a match
+		auto find_first_of(const char_class& set, std::size_t pos = 0) const -> std::size_t;
+		auto find_first_of(std::string_view chars, std::size_t pos = 0) const -> std::size_t;
+		auto find_last_of(const char_class& set, std::size_t pos = npos) const -> std::size_t;
+		auto find_last_of(std::string_view chars, std::size_t pos = npos) const -> std::size_t;
+		auto find_first_not_of(const char_class& set, std::size_t pos = 0) const -> std::size_t;
+		auto find_first_not_of(std::string_view chars, std::size_t pos = 0) const -> std::size_t;
+		auto find_last_not_of(const char_class& set, std::size_t pos = npos) const -> std::size_t;
+		auto find_last_not_of(std::string_view chars, std::size_t pos = npos) const -> std::size_t;
+		// accepted characters that belong to set
+		auto count_of(const char_class& set) const -> std::size_t;
+		auto count_of(std::string_view chars) const -> std::size_t;
+
 		// iterator functions
 		auto begin() const -> const_iterator;
 		auto end() const -> const_iterator;
@@ -87,20 +159,50 @@ namespace fsv {
 		friend auto operator!=(const filtered_string_view& lhs, const filtered_string_view& rhs) -> bool;
 		friend auto operator<=>(const filtered_string_view& lhs, const filtered_string_view& rhs) -> std::strong_ordering;
 		friend auto operator<<(std::ostream& os, const filtered_string_view& fsv) -> std::ostream&;
+		friend auto substr(const filtered_string_view& fsv, std::size_t pos, std::size_t count) -> filtered_string_view;
 
 	 private:
 		const char* data_;
 		std::size_t length_;
 		filter predicate_;
-
-		// default predicate
-		static const filter default_predicate;
+		std::optional<char_class> table_;
+		strategy strategy_ = strategy::automatic;
+		// what automatic selection picked, so the view is sampled once rather than on every size(), begin()
+		// or end(); atomic because a const view may be shared between threads
+		mutable std::atomic<strategy> selected_ = strategy::automatic;
+
+		// raw offset of the accepted character index places after raw offset from, or length_ if there are
+		// not that many
+		auto locate(std::size_t from, std::size_t index) const -> std::size_t;
+		// index of the first accepted character in set at or after index pos, or the last at or before it
+		auto find_first_in(const char_class& set, std::size_t pos) const -> std::size_t;
+		auto find_last_in(const char_class& set, std::size_t pos) const -> std::size_t;
 	};
 
 	// non-member utility functions
 	auto compose(const filtered_string_view& fsv, const std::vector<filter>& filts) -> filtered_string_view;
 	auto split(const filtered_string_view& fsv, const filtered_string_view& tok) -> std::vector<filtered_string_view>;
-	auto substr(const filtered_string_view& fsv, int pos = 0, int count = 0) -> filtered_string_view;
+	// accepted characters [pos, pos + count) of fsv, as a bounded view over its buffer; count is clamped to what
+	// is left. Throws std::out_of_range if pos is past the end.
+	auto substr(const filtered_string_view& fsv, std::size_t pos, std::size_t count = filtered_string_view::npos)
+	    -> filtered_string_view;
+	// a count of zero or less takes the rest of the view
+	template<std::signed_integral Pos = int, std::signed_integral Count = int>
+	auto substr(const filtered_string_view& fsv, Pos pos = 0, Count count = 0) -> filtered_string_view {
+		if (pos < 0) {
+			throw std::out_of_range{"filtered_string_view::substr(" + std::to_string(pos) + ", " + std::to_string(count)
+			                        + "): invalid position"};
+		}
+		return substr(fsv,
+		              static_cast<std::size_t>(pos),
+		              count <= 0 ? filtered_string_view::npos : static_cast<std::size_t>(count));
+	}
 } // namespace fsv
 
+// hashes the accepted characters with fsv::hash64(), so views that compare equal hash equally
+template<>
+struct std::hash<fsv::filtered_string_view> {
+	auto operator()(const fsv::filtered_string_view& fsv) const -> std::size_t;
+};
+
 #endif // COMP6771_ASS2_FSV_H
@@ -1,10 +1,14 @@
 #include "./filtered_string_view.h"
 
+#include <algorithm>
 #include <catch2/catch.hpp>
+#include <cstddef>
 #include <cstring>
 #include <set>
 #include <vector>
 
+#include <sys/mman.h>
+
 TEST_CASE("Default constructor") {
 	auto sv = fsv::filtered_string_view();
 	REQUIRE(sv.size() == 0);
@@ -52,6 +56,15 @@ TEST_CASE("Constructor with C-string and predicate") {
 	REQUIRE(sv[4] == 'o');
 }
 
+TEST_CASE("Constructor with pointer and length") {
+	auto str = std::string("hello world");
+	auto sv = fsv::filtered_string_view(str.data(), 5, [](const auto& c) { return c != 'l'; });
+	REQUIRE(sv.length() == 5);
+	REQUIRE(sv.size() == 3);
+	REQUIRE(std::string(sv.begin(), sv.end()) == "heo");
+	REQUIRE(*std::prev(sv.end()) == 'o');
+}
+
 TEST_CASE("Copy constructor") {
 	auto str = std::string("hello world");
 	auto sv1 = fsv::filtered_string_view(str);
@@ -323,4 +336,244 @@ TEST_CASE("Const reverse iterator const correctness") {
 	const auto fsv4 = fsv::filtered_string_view{str};
 	auto it = fsv4.crbegin();
 	REQUIRE(std::is_same_v<decltype(*it), const char&>);
-}
\ No newline at end of file
+}
+
+TEST_CASE("64-bit indices") {
+	auto text = std::string();
+	for (auto i = 0; i < 300000; ++i) {
+		text += (i % 7 == 0) ? static_cast<char>('0' + i % 10) : '-';
+	}
+	auto const digits = fsv::char_class::range('0', '9');
+	auto const expected = static_cast<std::string>(fsv::filtered_string_view(text, digits));
+
+	// one view with a char_class and one with a std::function, both long enough to be located blockwise
+	for (auto const& sv : {fsv::filtered_string_view(text, digits),
+	                       fsv::filtered_string_view(text, [](const char& c) { return c != '-'; })})
+	{
+		for (auto const i : {std::size_t{0}, std::size_t{9361}, std::size_t{9362}, expected.size() - 1}) {
+			REQUIRE(sv[i] == expected[i]);
+			REQUIRE(sv.at(i) == expected[i]);
+			REQUIRE(&sv[i] == &sv[static_cast<int>(i)]);
+		}
+		REQUIRE_THROWS_AS(sv[expected.size()], std::out_of_range);
+		REQUIRE_THROWS_AS(sv.at(expected.size()), std::domain_error);
+		REQUIRE_THROWS_AS(sv[-1], std::out_of_range);
+		REQUIRE_THROWS_AS(sv.at(-1), std::domain_error);
+
+		REQUIRE(static_cast<std::string>(fsv::substr(sv, std::size_t{20000})) == expected.substr(20000));
+		auto const middle = fsv::substr(sv, std::size_t{20000}, std::size_t{30000});
+		REQUIRE(static_cast<std::string>(middle) == expected.substr(20000, 30000));
+		REQUIRE(fsv::substr(sv, std::size_t{5}, std::size_t{0}).empty());
+		REQUIRE(fsv::substr(sv, expected.size()).empty());
+		REQUIRE_THROWS_AS(fsv::substr(sv, expected.size() + 1), std::out_of_range);
+	}
+}
+
+TEST_CASE("indices of any integer type pick one overload") {
+	auto const sv = fsv::filtered_string_view("a-b-c-d", [](const char& c) { return c != '-'; });
+	REQUIRE(sv[2U] == 'c');
+	REQUIRE(sv[2L] == 'c');
+	REQUIRE(sv[std::ptrdiff_t{2}] == 'c');
+	REQUIRE(sv.at(3U) == 'd');
+	REQUIRE(sv.at(3L) == 'd');
+	REQUIRE(sv.at(std::ptrdiff_t{3}) == 'd');
+	REQUIRE_THROWS_AS(sv[4U], std::out_of_range);
+	REQUIRE_THROWS_AS(sv[-1L], std::out_of_range);
+	REQUIRE_THROWS_AS(sv.at(4U), std::domain_error);
+	REQUIRE_THROWS_AS(sv.at(std::ptrdiff_t{-1}), std::domain_error);
+
+	REQUIRE(static_cast<std::string>(fsv::substr(sv, 1U, 2U)) == "bc");
+	REQUIRE(static_cast<std::string>(fsv::substr(sv, 1L, 2L)) == "bc");
+	REQUIRE(static_cast<std::string>(fsv::substr(sv, std::ptrdiff_t{1}, std::ptrdiff_t{0})) == "bcd");
+	REQUIRE(static_cast<std::string>(fsv::substr(sv)) == "abcd");
+	REQUIRE_THROWS_AS(fsv::substr(sv, -1L), std::out_of_range);
+}
+
+TEST_CASE("substr keeps the view's char_class") {
+	auto const sv = fsv::filtered_string_view("a1b2c3", fsv::char_class::range('0', '9'));
+	auto const sub = fsv::substr(sv, 1, 1);
+	REQUIRE(static_cast<std::string>(sub) == "2");
+	REQUIRE(sub.table().has_value());
+}
+
+// over 4 GB of address space, reserved but never backed; run with "[.large]"
+TEST_CASE("views larger than 4 GB", "[.large]") {
+	auto const length = (std::size_t{9} << 29U) + 3;
+	auto const flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+	auto* const mapping = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+	REQUIRE(mapping != MAP_FAILED);
+	auto* const data = static_cast<char*>(mapping);
+	auto const beyond_int = std::size_t{3'000'000'000};
+	auto const beyond_32_bits = (std::size_t{1} << 32U) + 5;
+	data[beyond_int] = 'y';
+	data[beyond_32_bits] = 'x';
+	data[length - 1] = 'z';
+
+	auto all = fsv::char_class::range('x', 'z');
+	all.insert('\0');
+	auto const everything = fsv::filtered_string_view(data, length, all);
+	REQUIRE(everything.size() == length);
+	REQUIRE(everything[beyond_int] == 'y');
+	REQUIRE(everything.at(beyond_32_bits) == 'x');
+	REQUIRE(everything[length - 1] == 'z');
+	REQUIRE_THROWS_AS(everything.at(length), std::domain_error);
+
+	auto const sub = fsv::substr(everything, beyond_32_bits - 5, std::size_t{10});
+	REQUIRE(sub.size() == 10);
+	REQUIRE(sub[5] == 'x');
+	REQUIRE(fsv::substr(everything, length - 1).size() == 1);
+
+	auto const markers = fsv::filtered_string_view(data, length, fsv::char_class::range('x', 'z'));
+	REQUIRE(static_cast<std::string>(markers) == "yxz");
+	REQUIRE(markers[2] == 'z');
+	REQUIRE(markers == fsv::filtered_string_view("yxz"));
+	REQUIRE(markers < fsv::filtered_string_view("yy"));
+
+	auto const shorter = fsv::filtered_string_view(data, length - 1, all);
+	REQUIRE(shorter < everything);
+	REQUIRE(shorter != everything);
+	::munmap(mapping, length);
+}
+
+TEST_CASE("Searching the accepted characters") {
+	auto const sv = fsv::filtered_string_view{"a-b-c-a-b-d", [](const char& c) { return c != '-'; }};
+	REQUIRE(sv.find("ab") == 0);
+	REQUIRE(sv.find("ab", 1) == 3);
+	REQUIRE(sv.find("abd") == 3);
+	REQUIRE(sv.find("b-c") == fsv::filtered_string_view::npos);
+	REQUIRE(sv.find('c') == 2);
+	REQUIRE(sv.find("", 6) == 6);
+	REQUIRE(sv.find("", 7) == fsv::filtered_string_view::npos);
+	REQUIRE(sv.rfind("ab") == 3);
+	REQUIRE(sv.rfind("ab", 2) == 0);
+	REQUIRE(sv.rfind('a') == 3);
+	REQUIRE(sv.rfind("") == 6);
+	REQUIRE(sv.contains("cab"));
+	REQUIRE_FALSE(sv.contains('-'));
+	REQUIRE(sv.starts_with("abc"));
+	REQUIRE_FALSE(sv.starts_with("abcabdx"));
+	REQUIRE(sv.ends_with("abd"));
+	REQUIRE(sv.ends_with('d'));
+	REQUIRE_FALSE(sv.ends_with("xabcabd"));
+	REQUIRE(fsv::filtered_string_view().find("a") == fsv::filtered_string_view::npos);
+	REQUIRE(fsv::filtered_string_view().starts_with(""));
+}
+
+TEST_CASE("Searching agrees with std::string across blocks") {
+	auto text = std::string();
+	for (auto i = 0; text.size() < 300000; ++i) {
+		text += (i % 5 == 0) ? " " : "";
+		text += "token" + std::to_string(i % 1000) + ";";
+	}
+	auto const no_spaces = [](const char& c) { return c != ' '; };
+	for (auto const& sv : {fsv::filtered_string_view(text, ~fsv::char_class(" ")),
+	                       fsv::filtered_string_view(text, no_spaces),
+	                       fsv::filtered_string_view(text, fsv::char_class::all())})
+	{
+		auto const expected = static_cast<std::string>(sv);
+		auto const needles = {"token999;token0;", "n12;", ";", "token42;token43;token44;token45;token46;", "nope"};
+		auto const npos = fsv::filtered_string_view::npos;
+		for (auto const* needle : needles) {
+			for (auto const pos : {std::size_t{0}, std::size_t{65530}, expected.size() / 2, npos}) {
+				if (pos != npos) {
+					REQUIRE(sv.find(needle, pos) == expected.find(needle, pos));
+				}
+				REQUIRE(sv.rfind(needle, pos) == expected.rfind(needle, pos));
+			}
+		}
+		REQUIRE(sv.starts_with(expected.substr(0, 20)));
+		REQUIRE_FALSE(sv.starts_with(expected.substr(0, 19) + "\x01"));
+		REQUIRE(sv.ends_with(expected.substr(expected.size() - 20)));
+	}
+}
+
+TEST_CASE("Searching long runs of accepted bytes and the gaps between them") {
+	// runs of up to 9000 accepted bytes, and stretches where they alternate with rejected ones
+	auto text = std::string();
+	for (auto i = 0; text.size() < 400000; ++i) {
+		auto const run = static_cast<std::size_t>(i * 37 % 9000);
+		for (auto j = std::size_t{0}; j < run; ++j) {
+			text += static_cast<char>('a' + (i + static_cast<int>(j)) % 7);
+		}
+		for (auto j = 0; j < i % 9; ++j) {
+			text += "-b";
+		}
+		text += '-';
+	}
+	auto const sv = fsv::filtered_string_view(text, ~fsv::char_class("-"));
+	auto const expected = static_cast<std::string>(sv);
+	auto const npos = fsv::filtered_string_view::npos;
+	auto const needles = {"a", "bbbb", "gabcdefgab", "fgbbbbbbbbbbbbbab", "abcdefgabcdefgabcdefgabcdefgabcdefga", "x"};
+	for (auto const* needle : needles) {
+		for (auto const pos : {std::size_t{0}, std::size_t{65536}, std::size_t{99999}, expected.size() / 2}) {
+			REQUIRE(sv.find(needle, pos) == expected.find(needle, pos));
+			REQUIRE(sv.rfind(needle, pos) == expected.rfind(needle, pos));
+		}
+		REQUIRE(sv.rfind(needle) == expected.rfind(needle));
+	}
+	// every occurrence of a needle that straddles rejected bytes
+	auto count = std::size_t{0};
+	for (auto at = sv.find("bbb"); at != npos; at = sv.find("bbb", at + 1)) {
+		REQUIRE(expected.compare(at, 3, "bbb") == 0);
+		++count;
+	}
+	auto expected_count = std::size_t{0};
+	for (auto at = expected.find("bbb"); at != std::string::npos; at = expected.find("bbb", at + 1)) {
+		++expected_count;
+	}
+	REQUIRE(count == expected_count);
+
+	// a view with the default predicate is searched in place
+	auto const whole = fsv::filtered_string_view(text);
+	REQUIRE(whole.find("-b-b-b") == text.find("-b-b-b"));
+	REQUIRE(whole.rfind("a-b") == text.rfind("a-b"));
+}
+
+TEST_CASE("Searching for any of a set of characters") {
+	auto const sv = fsv::filtered_string_view{"x1-y2-z3-x", [](const char& c) { return c != '-'; }};
+	auto const npos = fsv::filtered_string_view::npos;
+	auto const digits = fsv::char_class::range('0', '9');
+	REQUIRE(sv.find_first_of(digits) == 1);
+	REQUIRE(sv.find_first_of(digits, 2) == 3);
+	REQUIRE(sv.find_first_of("-") == npos);
+	REQUIRE(sv.find_first_of("zx", 1) == 4);
+	REQUIRE(sv.find_last_of(digits) == 5);
+	REQUIRE(sv.find_last_of(digits, 4) == 3);
+	REQUIRE(sv.find_last_of("x", 5) == 0);
+	REQUIRE(sv.find_first_not_of("xy1") == 3);
+	REQUIRE(sv.find_first_not_of(~fsv::char_class()) == npos);
+	REQUIRE(sv.find_last_not_of("x") == 5);
+	REQUIRE(sv.find_last_not_of("x-", 0) == npos);
+	REQUIRE(sv.count_of(digits) == 3);
+	REQUIRE(sv.count_of("x-") == 2);
+	REQUIRE(sv.find_first_of(digits, 7) == npos);
+	REQUIRE(fsv::filtered_string_view().find_last_of(digits) == npos);
+}
+
+TEST_CASE("Searching for sets agrees with std::string") {
+	auto text = std::string();
+	for (auto i = 0; text.size() < 200000; ++i) {
+		text += (i % 3 == 0) ? " " : "";
+		text += "id" + std::to_string(i % 997) + (i % 11 == 0 ? "=" : ",");
+	}
+	auto const no_spaces = [](const char& c) { return c != ' '; };
+	for (auto const& sv : {fsv::filtered_string_view(text, ~fsv::char_class(" ")),
+	                       fsv::filtered_string_view(text, no_spaces),
+	                       fsv::filtered_string_view(text, fsv::char_class::all())})
+	{
+		auto const expected = static_cast<std::string>(sv);
+		auto const npos = fsv::filtered_string_view::npos;
+		for (auto const* chars : {"=", "0123456789", "di,", " ", "di,0123456789"}) {
+			for (auto const pos : {std::size_t{0}, std::size_t{70}, expected.size() / 2, expected.size(), npos}) {
+				REQUIRE(sv.find_first_of(chars, pos) == expected.find_first_of(chars, pos));
+				REQUIRE(sv.find_last_of(chars, pos) == expected.find_last_of(chars, pos));
+				REQUIRE(sv.find_first_not_of(chars, pos) == expected.find_first_not_of(chars, pos));
+				REQUIRE(sv.find_last_not_of(chars, pos) == expected.find_last_not_of(chars, pos));
+			}
+			auto const count = std::count_if(expected.begin(), expected.end(), [&](char c) {
+				return std::string_view(chars).find(c) != std::string_view::npos;
+			});
+			REQUIRE(sv.count_of(chars) == static_cast<std::size_t>(count));
+		}
+	}
+}
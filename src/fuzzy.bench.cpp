@@ -0,0 +1,114 @@
+#include "./char_class.h"
+#include "./filtered_string_view.h"
+#include "./fuzzy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Ranks a catalogue of names against a query, with punctuation and spaces ignored, by the textbook dynamic
+// program over copies with them removed, by Myers' algorithm over views, and by it with a bound on the
+// distance that ends most comparisons early.
+//
+//   fuzzy_bench [names]
+namespace {
+	using clock = std::chrono::steady_clock;
+
+	auto seconds_since(clock::time_point start) -> double {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	// random names, with every hundredth a copy of query with a few letters changed
+	auto sample_names(std::size_t count, const std::string& query) -> std::vector<std::string> {
+		auto engine = std::mt19937(42);
+		auto letter = std::uniform_int_distribution<int>('a', 'z');
+		auto length = std::uniform_int_distribution<int>(8, 40);
+		auto result = std::vector<std::string>();
+		result.reserve(count);
+		for (auto i = std::size_t{0}; i < count; ++i) {
+			if (i % 100 == 0) {
+				auto name = query;
+				for (auto n = i / 100 % 12; n > 0; --n) {
+					name[engine() % name.size()] = static_cast<char>(letter(engine));
+				}
+				result.push_back(std::move(name));
+				continue;
+			}
+			auto name = std::string();
+			for (auto n = length(engine); n > 0; --n) {
+				name += static_cast<char>(letter(engine));
+				if (n % 7 == 0) {
+					name += n % 2 == 0 ? ' ' : '-';
+				}
+			}
+			result.push_back(std::move(name));
+		}
+		return result;
+	}
+
+	auto levenshtein(const std::string& a, const std::string& b, std::vector<std::size_t>& row) -> std::size_t {
+		row.resize(b.size() + 1);
+		for (auto j = std::size_t{0}; j <= b.size(); ++j) {
+			row[j] = j;
+		}
+		for (auto i = std::size_t{1}; i <= a.size(); ++i) {
+			auto diagonal = row[0];
+			row[0] = i;
+			for (auto j = std::size_t{1}; j <= b.size(); ++j) {
+				auto const above = row[j];
+				row[j] = std::min({above + 1, row[j - 1] + 1, diagonal + (a[i - 1] == b[j - 1] ? 0U : 1U)});
+				diagonal = above;
+			}
+		}
+		return row[b.size()];
+	}
+
+	auto report(const char* name, std::size_t names, double seconds, std::size_t close) -> void {
+		std::cout << std::left << std::setw(28) << name << std::right << std::setw(10)
+		          << static_cast<double>(names) / seconds / 1e6 << " M names/s  (" << close << " within 8)\n";
+	}
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+	auto const count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+	auto const query = std::string("qwerty-uiop asdfgh jklzx");
+	auto const names = sample_names(count, query);
+	auto const letters = fsv::char_class("abcdefghijklmnopqrstuvwxyz");
+	std::cout << std::fixed << std::setprecision(2);
+
+	{
+		auto const start = clock::now();
+		auto const key = static_cast<std::string>(fsv::filtered_string_view(query, letters));
+		auto row = std::vector<std::size_t>();
+		auto close = std::size_t{0};
+		for (auto const& name : names) {
+			auto const copy = static_cast<std::string>(fsv::filtered_string_view(name, letters));
+			close += levenshtein(key, copy, row) <= 8 ? 1U : 0U;
+		}
+		report("dynamic program, copies", names.size(), seconds_since(start), close);
+	}
+	{
+		auto const start = clock::now();
+		auto const pattern = fsv::fuzzy_pattern(fsv::filtered_string_view(query, letters));
+		auto close = std::size_t{0};
+		for (auto const& name : names) {
+			close += pattern.distance(fsv::filtered_string_view(name, letters)) <= 8 ? 1U : 0U;
+		}
+		report("Myers over views", names.size(), seconds_since(start), close);
+	}
+	{
+		auto const start = clock::now();
+		auto const pattern = fsv::fuzzy_pattern(fsv::filtered_string_view(query, letters));
+		auto close = std::size_t{0};
+		for (auto const& name : names) {
+			close += pattern.distance(fsv::filtered_string_view(name, letters), 8) ? 1U : 0U;
+		}
+		report("Myers over views, max 8", names.size(), seconds_since(start), close);
+	}
+	return 0;
+}
@@ -0,0 +1,251 @@
+#include "./fuzzy.h"
+#include "./strategy.h"
+#include <algorithm>
+#include <string>
+#include <string_view>
+
+namespace fsv {
+	namespace {
+		constexpr auto word_bits = std::size_t{64};
+		constexpr auto high_bit = std::uint64_t{1} << 63U;
+
+		// One column of one 64-row block of Myers' algorithm, as Hyyrö laid it out for several blocks. pv and
+		// mv hold the vertical deltas of the block that are +1 and -1, eq the rows whose pattern character
+		// is the text character, and hin the horizontal delta entering the block's first row. Returns the
+		// horizontal delta leaving the row at out_bit.
+		inline auto advance(std::uint64_t& pv, std::uint64_t& mv, std::uint64_t eq, int hin, std::uint64_t out_bit)
+		    -> int {
+			auto const hin_negative = static_cast<std::uint64_t>(hin < 0);
+			auto const xv = eq | mv;
+			eq |= hin_negative;
+			auto const xh = (((eq & pv) + pv) ^ pv) | eq;
+			auto ph = mv | ~(xh | pv);
+			auto mh = pv & xh;
+			auto const hout = static_cast<int>((ph & out_bit) != 0) - static_cast<int>((mh & out_bit) != 0);
+			ph = (ph << 1U) | static_cast<std::uint64_t>(hin > 0);
+			mh = (mh << 1U) | hin_negative;
+			pv = mh | ~(xv | ph);
+			mv = ph & xv;
+			return hout;
+		}
+
+		// x shifted up by one bit across words, least significant word first, with zero shifted in
+		inline auto shifted(const std::uint64_t* x, std::size_t w) -> std::uint64_t {
+			return (x[w] << 1U) | (w == 0 ? 0 : x[w - 1] >> 63U);
+		}
+	} // namespace
+
+	fuzzy_pattern::fuzzy_pattern(const filtered_string_view& pattern)
+	: length_(pattern.size())
+	, words_((length_ + word_bits - 1) / word_bits)
+	, positions_(256 * words_) {
+		auto i = std::size_t{0};
+		kernel::for_each_block(pattern, [this, &i](std::string_view accepted) {
+			for (auto const c : accepted) {
+				auto const word = static_cast<unsigned char>(c) * words_ + i / word_bits;
+				positions_[word] |= std::uint64_t{1} << (i % word_bits);
+				++i;
+			}
+			return true;
+		});
+	}
+
+	auto fuzzy_pattern::distance(const filtered_string_view& fsv) const -> std::size_t {
+		auto const length = fsv.size();
+		return *distance(fsv, std::max(length, length_), length);
+	}
+
+	auto fuzzy_pattern::distance(const filtered_string_view& fsv, std::size_t max) const -> std::optional<std::size_t> {
+		return distance(fsv, max, fsv.size());
+	}
+
+	// The bottom row of the matrix changes by at most one per column, so once it exceeds max by more than
+	// the columns left, the distance cannot come back under max.
+	auto fuzzy_pattern::distance(const filtered_string_view& fsv, std::size_t max, std::size_t length) const
+	    -> std::optional<std::size_t> {
+		auto const gap = length > length_ ? length - length_ : length_ - length;
+		if (gap > max) {
+			return std::nullopt;
+		}
+		if (length_ == 0) {
+			return length;
+		}
+		auto const bounded = max < std::max(length, length_);
+		auto const last_bit = std::uint64_t{1} << ((length_ - 1) % word_bits);
+		// score is the bottom row, which starts at the pattern's length, and left the columns to come
+		auto score = static_cast<std::ptrdiff_t>(length_);
+		auto left = static_cast<std::ptrdiff_t>(length);
+		auto const limit = static_cast<std::ptrdiff_t>(bounded ? max : 0);
+
+		if (words_ == 1) {
+			auto pv = ~std::uint64_t{0};
+			auto mv = std::uint64_t{0};
+			auto const finished = kernel::for_each_block(fsv, [&](std::string_view accepted) {
+				for (auto const c : accepted) {
+					score += advance(pv, mv, positions_[static_cast<unsigned char>(c)], 1, last_bit);
+					--left;
+					if (bounded && score - left > limit) {
+						return false;
+					}
+				}
+				return true;
+			});
+			if (!finished) {
+				return std::nullopt;
+			}
+		}
+		else {
+			auto pv = std::vector<std::uint64_t>(words_, ~std::uint64_t{0});
+			auto mv = std::vector<std::uint64_t>(words_, 0);
+			auto const finished = kernel::for_each_block(fsv, [&](std::string_view accepted) {
+				for (auto const c : accepted) {
+					auto const eq = positions_.data() + static_cast<unsigned char>(c) * words_;
+					auto hout = 1;
+					for (auto w = std::size_t{0}; w + 1 < words_; ++w) {
+						hout = advance(pv[w], mv[w], eq[w], hout, high_bit);
+					}
+					score += advance(pv[words_ - 1], mv[words_ - 1], eq[words_ - 1], hout, last_bit);
+					--left;
+					if (bounded && score - left > limit) {
+						return false;
+					}
+				}
+				return true;
+			});
+			if (!finished) {
+				return std::nullopt;
+			}
+		}
+		auto const result = static_cast<std::size_t>(score);
+		return result <= max ? std::optional<std::size_t>(result) : std::nullopt;
+	}
+
+	// Shift-Or keeps a word per error count d, whose bit i is clear if the first i + 1 pattern characters
+	// match text ending here with at most d edits. The words for d come from those for d - 1 before and
+	// after the character: a substitution and an insertion from before, a deletion from after.
+	template<typename Fn>
+	auto fuzzy_pattern::bitap(const filtered_string_view& fsv, std::size_t k, Fn on_match) const -> void {
+		k = std::min(k, length_);
+		if (length_ == 0) {
+			auto end = std::size_t{0};
+			if (!on_match(end, 0)) {
+				return;
+			}
+			kernel::for_each_block(fsv, [&](std::string_view accepted) {
+				for (auto i = std::size_t{0}; i < accepted.size(); ++i) {
+					if (!on_match(++end, 0)) {
+						return false;
+					}
+				}
+				return true;
+			});
+			return;
+		}
+		auto const last_word = words_ - 1;
+		auto const last_bit = std::uint64_t{1} << ((length_ - 1) % word_bits);
+		// state[d * words_ + w]; d edits cover the first d characters by deleting them
+		auto state = std::vector<std::uint64_t>((k + 1) * words_, ~std::uint64_t{0});
+		for (auto d = std::size_t{1}; d <= k; ++d) {
+			for (auto i = std::size_t{0}; i < d; ++i) {
+				state[d * words_ + i / word_bits] &= ~(std::uint64_t{1} << (i % word_bits));
+			}
+		}
+		auto const matched = [&](std::size_t end) {
+			for (auto d = std::size_t{0}; d <= k; ++d) {
+				if ((state[d * words_ + last_word] & last_bit) == 0) {
+					return on_match(end, d);
+				}
+			}
+			return true;
+		};
+		auto end = std::size_t{0};
+		if (!matched(end)) {
+			return;
+		}
+
+		if (words_ == 1) {
+			kernel::for_each_block(fsv, [&](std::string_view accepted) {
+				for (auto const c : accepted) {
+					auto const mismatch = ~positions_[static_cast<unsigned char>(c)];
+					auto before = state[0];
+					state[0] = (state[0] << 1U) | mismatch;
+					for (auto d = std::size_t{1}; d <= k; ++d) {
+						auto const old = state[d];
+						state[d] = ((old << 1U) | mismatch) & (before << 1U) & (state[d - 1] << 1U) & before;
+						before = old;
+					}
+					if (!matched(++end)) {
+						return false;
+					}
+				}
+				return true;
+			});
+			return;
+		}
+
+		auto before = std::vector<std::uint64_t>(words_);
+		auto old = std::vector<std::uint64_t>(words_);
+		kernel::for_each_block(fsv, [&](std::string_view accepted) {
+			for (auto const c : accepted) {
+				auto const eq = positions_.data() + static_cast<unsigned char>(c) * words_;
+				auto const r0 = state.data();
+				std::copy(r0, r0 + words_, before.begin());
+				for (auto w = words_; w-- > 0;) {
+					r0[w] = shifted(r0, w) | ~eq[w];
+				}
+				for (auto d = std::size_t{1}; d <= k; ++d) {
+					auto const r = state.data() + d * words_;
+					auto const below = r - words_;
+					std::copy(r, r + words_, old.begin());
+					for (auto w = std::size_t{0}; w < words_; ++w) {
+						r[w] = (shifted(old.data(), w) | ~eq[w]) & shifted(before.data(), w) & shifted(below, w)
+						       & before[w];
+					}
+					std::swap(before, old);
+				}
+				if (!matched(++end)) {
+					return false;
+				}
+			}
+			return true;
+		});
+	}
+
+	auto fuzzy_pattern::search(const filtered_string_view& fsv, std::size_t k) const -> std::optional<fuzzy_match> {
+		auto result = std::optional<fuzzy_match>();
+		bitap(fsv, k, [&result](std::size_t end, std::size_t errors) {
+			result = fuzzy_match{end, errors};
+			return false;
+		});
+		return result;
+	}
+
+	auto fuzzy_pattern::find_all(const filtered_string_view& fsv, std::size_t k) const -> std::vector<fuzzy_match> {
+		auto result = std::vector<fuzzy_match>();
+		bitap(fsv, k, [&result](std::size_t end, std::size_t errors) {
+			result.push_back(fuzzy_match{end, errors});
+			return true;
+		});
+		return result;
+	}
+
+	auto fuzzy_pattern::size() const -> std::size_t {
+		return length_;
+	}
+
+	auto edit_distance(const filtered_string_view& a, const filtered_string_view& b) -> std::size_t {
+		auto const a_size = a.size();
+		auto const b_size = b.size();
+		return a_size <= b_size ? fuzzy_pattern(a).distance(b) : fuzzy_pattern(b).distance(a);
+	}
+
+	auto edit_distance(const filtered_string_view& a, const filtered_string_view& b, std::size_t max)
+	    -> std::optional<std::size_t> {
+		auto const a_size = a.size();
+		auto const b_size = b.size();
+		if ((a_size > b_size ? a_size - b_size : b_size - a_size) > max) {
+			return std::nullopt;
+		}
+		return a_size <= b_size ? fuzzy_pattern(a).distance(b, max) : fuzzy_pattern(b).distance(a, max);
+	}
+} // namespace fsv
@@ -0,0 +1,65 @@
+#ifndef COMP6771_ASS2_FUZZY_H
+#define COMP6771_ASS2_FUZZY_H
+
+#include "./filtered_string_view.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace fsv {
+	struct fuzzy_match {
+		// index one past the last matched accepted character
+		std::size_t end;
+		// the fewest edits with which the pattern matches some text ending there
+		std::size_t errors;
+
+		friend auto operator==(const fuzzy_match&, const fuzzy_match&) -> bool = default;
+	};
+
+	// A pattern compiled for bit-parallel approximate matching against the accepted characters of views,
+	// which are read in place, or compacted a block at a time onto the stack, and never materialized.
+	// Each pattern character is one bit of a 64-bit word, and longer patterns take as many words as they
+	// need, so a text character costs one pass over the pattern's words rather than over its characters.
+	//
+	// Compile a pattern once to compare it with many texts, such as a name against a catalogue.
+	class fuzzy_pattern {
+	 public:
+		explicit fuzzy_pattern(const filtered_string_view& pattern);
+
+		// Levenshtein distance between the pattern and the accepted characters, by Myers' algorithm
+		auto distance(const filtered_string_view& fsv) const -> std::size_t;
+		// the distance if it is at most max. Gives up as soon as the lengths, or the distance so far less
+		// the characters left, show that it must be larger.
+		auto distance(const filtered_string_view& fsv, std::size_t max) const -> std::optional<std::size_t>;
+
+		// the first place at which some text ends that is within k edits of the pattern, by Shift-Or
+		// (Bitap) with a state word per error count. A pattern of at most k characters matches at 0.
+		auto search(const filtered_string_view& fsv, std::size_t k) const -> std::optional<fuzzy_match>;
+		// every such place, in order
+		auto find_all(const filtered_string_view& fsv, std::size_t k) const -> std::vector<fuzzy_match>;
+
+		// accepted characters in the pattern
+		auto size() const -> std::size_t;
+
+	 private:
+		std::size_t length_;
+		std::size_t words_;
+		// bit i of word w for byte c, at c * words_ + w, is set if pattern character 64 * w + i is c
+		std::vector<std::uint64_t> positions_;
+
+		auto distance(const filtered_string_view& fsv, std::size_t max, std::size_t length) const
+		    -> std::optional<std::size_t>;
+		template<typename Fn>
+		auto bitap(const filtered_string_view& fsv, std::size_t k, Fn on_match) const -> void;
+	};
+
+	// Levenshtein distance between the accepted characters of a and b, compiling the shorter one
+	auto edit_distance(const filtered_string_view& a, const filtered_string_view& b) -> std::size_t;
+	// the distance if it is at most max
+	auto edit_distance(const filtered_string_view& a, const filtered_string_view& b, std::size_t max)
+	    -> std::optional<std::size_t>;
+} // namespace fsv
+
+#endif // COMP6771_ASS2_FUZZY_H
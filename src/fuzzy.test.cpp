@@ -0,0 +1,185 @@
+#include "./fuzzy.h"
+#include "./char_class.h"
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+	// letters from a small alphabet, so that random strings share plenty of characters
+	auto random_string(std::mt19937& engine, std::size_t length, char last = 'd') -> std::string {
+		auto letter = std::uniform_int_distribution<int>('a', last);
+		auto result = std::string();
+		for (auto i = std::size_t{0}; i < length; ++i) {
+			result += static_cast<char>(letter(engine));
+		}
+		return result;
+	}
+
+	// the textbook dynamic program, a row at a time
+	auto levenshtein(const std::string& a, const std::string& b) -> std::size_t {
+		auto row = std::vector<std::size_t>(b.size() + 1);
+		for (auto j = std::size_t{0}; j <= b.size(); ++j) {
+			row[j] = j;
+		}
+		for (auto i = std::size_t{1}; i <= a.size(); ++i) {
+			auto diagonal = row[0];
+			row[0] = i;
+			for (auto j = std::size_t{1}; j <= b.size(); ++j) {
+				auto const above = row[j];
+				row[j] = std::min({above + 1, row[j - 1] + 1, diagonal + (a[i - 1] == b[j - 1] ? 0U : 1U)});
+				diagonal = above;
+			}
+		}
+		return row[b.size()];
+	}
+
+	// Sellers' variant, where the match may start anywhere in the text: every end within k edits
+	auto matches(const std::string& pattern, const std::string& text, std::size_t k) -> std::vector<fsv::fuzzy_match> {
+		auto column = std::vector<std::size_t>(pattern.size() + 1);
+		for (auto i = std::size_t{0}; i <= pattern.size(); ++i) {
+			column[i] = i;
+		}
+		auto result = std::vector<fsv::fuzzy_match>();
+		auto const report = [&](std::size_t end) {
+			if (column[pattern.size()] <= k) {
+				result.push_back(fsv::fuzzy_match{end, column[pattern.size()]});
+			}
+		};
+		report(0);
+		for (auto j = std::size_t{1}; j <= text.size(); ++j) {
+			auto diagonal = column[0];
+			for (auto i = std::size_t{1}; i <= pattern.size(); ++i) {
+				auto const left = column[i];
+				auto const substitution = diagonal + (pattern[i - 1] == text[j - 1] ? 0U : 1U);
+				column[i] = std::min({left + 1, column[i - 1] + 1, substitution});
+				diagonal = left;
+			}
+			report(j);
+		}
+		return result;
+	}
+
+	// str with a space after every character, and a view that skips them
+	auto spaced(const std::string& str) -> std::string {
+		auto result = std::string();
+		for (auto const c : str) {
+			result += c;
+			result += ' ';
+		}
+		return result;
+	}
+
+	auto const letters = fsv::char_class("abcdefghijklmnopqrstuvwxyz");
+} // namespace
+
+TEST_CASE("distance agrees with the dynamic program") {
+	REQUIRE(fsv::edit_distance("kitten", "sitting") == 3);
+	REQUIRE(fsv::edit_distance("", "abc") == 3);
+	REQUIRE(fsv::edit_distance("abc", "") == 3);
+	REQUIRE(fsv::edit_distance("", "") == 0);
+	REQUIRE(fsv::edit_distance("flaw", "lawn") == 2);
+
+	auto engine = std::mt19937(1);
+	// lengths on both sides of one and two 64-bit words
+	for (auto const length : {1, 5, 63, 64, 65, 127, 128, 150}) {
+		for (auto trial = 0; trial < 20; ++trial) {
+			auto const pattern = random_string(engine, static_cast<std::size_t>(length));
+			auto const text = random_string(engine, static_cast<std::size_t>(std::max(length + trial * 3 - 20, 0)));
+			auto const expected = levenshtein(pattern, text);
+			auto const compiled = fsv::fuzzy_pattern(fsv::filtered_string_view(pattern));
+			REQUIRE(compiled.size() == pattern.size());
+			REQUIRE(compiled.distance(fsv::filtered_string_view(text)) == expected);
+			REQUIRE(fsv::edit_distance(text, pattern) == expected);
+		}
+	}
+}
+
+TEST_CASE("distance reads filtered views without copying them") {
+	auto engine = std::mt19937(2);
+	for (auto const length : {10, 70, 200}) {
+		auto const pattern = random_string(engine, static_cast<std::size_t>(length));
+		auto const text = random_string(engine, static_cast<std::size_t>(length + 7));
+		auto const expected = levenshtein(pattern, text);
+		auto const spaced_pattern = spaced(pattern);
+		auto const spaced_text = spaced(text);
+		auto const compiled = fsv::fuzzy_pattern(fsv::filtered_string_view(spaced_pattern, letters));
+		REQUIRE(compiled.size() == pattern.size());
+		REQUIRE(compiled.distance(fsv::filtered_string_view(spaced_text, letters)) == expected);
+		auto const predicate = [](const char& c) { return c != ' '; };
+		REQUIRE(compiled.distance(fsv::filtered_string_view(spaced_text, predicate)) == expected);
+		auto const view = fsv::filtered_string_view(spaced_text, predicate);
+		REQUIRE(fsv::edit_distance(view, fsv::filtered_string_view(pattern)) == expected);
+	}
+	// long enough to take several compacted blocks
+	auto const text = random_string(engine, 10000);
+	auto const spaced_text = spaced(text);
+	auto const pattern = random_string(engine, 100);
+	auto const compiled = fsv::fuzzy_pattern(fsv::filtered_string_view(pattern));
+	REQUIRE(compiled.distance(fsv::filtered_string_view(spaced_text, letters)) == levenshtein(pattern, text));
+}
+
+TEST_CASE("bounded distance gives up past the bound") {
+	auto engine = std::mt19937(3);
+	for (auto const length : {20, 100}) {
+		for (auto trial = 0; trial < 20; ++trial) {
+			auto const pattern = random_string(engine, static_cast<std::size_t>(length));
+			auto const text = random_string(engine, static_cast<std::size_t>(length + trial % 5));
+			auto const expected = levenshtein(pattern, text);
+			auto const compiled = fsv::fuzzy_pattern(fsv::filtered_string_view(pattern));
+			for (auto const max : {expected - 1, expected, expected + 1, std::size_t{0}}) {
+				auto const bounded = compiled.distance(fsv::filtered_string_view(text), max);
+				if (expected <= max) {
+					REQUIRE(bounded == expected);
+				}
+				else {
+					REQUIRE_FALSE(bounded.has_value());
+				}
+				REQUIRE(fsv::edit_distance(pattern, text, max) == bounded);
+			}
+		}
+	}
+	REQUIRE(fsv::edit_distance("abc", "abcdefgh", 4) == std::nullopt);
+	REQUIRE(fsv::edit_distance("abc", "abcdefgh", 5) == 5);
+	REQUIRE(fsv::edit_distance("", "ab", 2) == 2);
+	REQUIRE(fsv::edit_distance("", "ab", 1) == std::nullopt);
+}
+
+TEST_CASE("search finds the first end within k edits") {
+	auto const pattern = fsv::fuzzy_pattern(fsv::filtered_string_view("needle"));
+	REQUIRE(pattern.search(fsv::filtered_string_view("a haystack with a needle in it"), 0) == fsv::fuzzy_match{24, 0});
+	REQUIRE(pattern.search(fsv::filtered_string_view("a haystack with a nedle in it"), 0) == std::nullopt);
+	REQUIRE(pattern.search(fsv::filtered_string_view("a haystack with a nedle in it"), 1) == fsv::fuzzy_match{23, 1});
+	auto const spaced_text = spaced("haystack needle");
+	REQUIRE(pattern.search(fsv::filtered_string_view(spaced_text, letters), 0) == fsv::fuzzy_match{14, 0});
+	// a pattern no longer than k matches before any text
+	REQUIRE(pattern.search(fsv::filtered_string_view(""), 6) == fsv::fuzzy_match{0, 6});
+	REQUIRE(fsv::fuzzy_pattern(fsv::filtered_string_view("")).search(fsv::filtered_string_view("abc"), 0)
+	        == fsv::fuzzy_match{0, 0});
+}
+
+TEST_CASE("find_all agrees with the dynamic program") {
+	auto engine = std::mt19937(4);
+	for (auto const length : {1, 8, 64, 65, 150}) {
+		for (auto const k : {0, 1, 3, 10}) {
+			auto const pattern = random_string(engine, static_cast<std::size_t>(length), 'c');
+			auto text = random_string(engine, 600, 'c');
+			// plant a copy of the pattern with a couple of substitutions
+			auto planted = pattern;
+			planted[0] = 'x';
+			planted[planted.size() / 2] = 'y';
+			text.insert(200, planted);
+			auto const expected = matches(pattern, text, static_cast<std::size_t>(k));
+			auto const compiled = fsv::fuzzy_pattern(fsv::filtered_string_view(pattern));
+			REQUIRE(compiled.find_all(fsv::filtered_string_view(text), static_cast<std::size_t>(k)) == expected);
+			auto const spaced_text = spaced(text);
+			REQUIRE(compiled.find_all(fsv::filtered_string_view(spaced_text, ~fsv::char_class(" ")),
+			                          static_cast<std::size_t>(k))
+			        == expected);
+			auto const first = compiled.search(fsv::filtered_string_view(text), static_cast<std::size_t>(k));
+			REQUIRE(first == (expected.empty() ? std::nullopt : std::optional<fsv::fuzzy_match>(expected.front())));
+		}
+	}
+}
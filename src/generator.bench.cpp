@@ -0,0 +1,102 @@
+#include "./char_class.h"
+#include "./filtered_string_view.h"
+#include "./generator.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// Compares eager split() with lazy_split() when every token is consumed and when the consumer stops after
+// the first few, and reports how many coroutine frames reached the heap.
+//
+//   generator_bench [megabytes] [tokens taken when stopping early]
+namespace {
+	using clock = std::chrono::steady_clock;
+
+	auto seconds_since(clock::time_point start) -> double {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	auto sample_text(std::size_t length) -> std::string {
+		auto result = std::string();
+		result.reserve(length);
+		for (auto i = std::size_t{0}; result.size() < length; ++i) {
+			result += (i % 7 == 0) ? "12 ab," : "word,";
+		}
+		result.resize(length);
+		return result;
+	}
+
+	auto report(const char* name, std::size_t bytes, double seconds, std::size_t checksum) -> void {
+		std::cout << std::left << std::setw(28) << name << std::right << std::setw(10)
+		          << static_cast<double>(bytes) / seconds / 1e6 << " MB/s  (" << checksum << ")\n";
+	}
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+	auto const megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64;
+	auto const taken = static_cast<std::size_t>(argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 16);
+	auto const text = sample_text(megabytes << 20U);
+	auto const view = fsv::filtered_string_view(text, fsv::char_class::range('0', '9'));
+	auto const comma = fsv::filtered_string_view(",");
+	std::cout << std::fixed << std::setprecision(1);
+
+	{
+		auto const start = clock::now();
+		auto sum = std::size_t{0};
+		for (auto const& token : fsv::split(view, comma)) {
+			sum += token.size();
+		}
+		report("split, all tokens", text.size(), seconds_since(start), sum);
+	}
+	{
+		auto const start = clock::now();
+		auto sum = std::size_t{0};
+		for (auto const& token : fsv::lazy_split(view, comma)) {
+			sum += token.size();
+		}
+		report("lazy_split, all tokens", text.size(), seconds_since(start), sum);
+	}
+
+	// a request handler that only needs a prefix: eager splitting still pays for the whole input
+	auto const rounds = std::size_t{20};
+	auto const heap_before = fsv::frame_pool::heap_allocations();
+	{
+		auto const start = clock::now();
+		auto sum = std::size_t{0};
+		for (auto r = std::size_t{0}; r < rounds; ++r) {
+			auto const tokens = fsv::split(view, comma);
+			for (auto i = std::size_t{0}; i < taken && i < tokens.size(); ++i) {
+				sum += tokens[i].size();
+			}
+		}
+		report("split, first tokens", rounds * text.size(), seconds_since(start), sum);
+	}
+	{
+		auto const start = clock::now();
+		auto sum = std::size_t{0};
+		for (auto r = std::size_t{0}; r < rounds; ++r) {
+			auto i = std::size_t{0};
+			for (auto const& token : fsv::lazy_split(view, comma)) {
+				if (i++ == taken) {
+					break;
+				}
+				sum += token.size();
+			}
+		}
+		report("lazy_split, first tokens", rounds * text.size(), seconds_since(start), sum);
+	}
+	{
+		auto const start = clock::now();
+		auto sum = std::size_t{0};
+		for (auto const run : fsv::lazy_runs(view)) {
+			sum += run.size();
+		}
+		report("lazy_runs", text.size(), seconds_since(start), sum);
+	}
+	std::cout << "coroutine frames from the heap: " << fsv::frame_pool::heap_allocations() - heap_before << " for "
+	          << rounds + 1 << " generators\n";
+	return 0;
+}
@@ -0,0 +1,132 @@
+#include "./generator.h"
+#include "./scan.h"
+#include "./strategy.h"
+#include <algorithm>
+#include <array>
+#include <new>
+
+namespace fsv {
+	namespace {
+		constexpr auto granularity = std::size_t{64};
+		// frames of up to 2 KiB are cached; larger ones go straight to the heap
+		constexpr auto size_classes = std::size_t{32};
+		constexpr auto frames_per_class = std::size_t{8};
+
+		struct free_frame {
+			free_frame* next;
+		};
+
+		class frame_cache {
+		 public:
+			frame_cache() = default;
+			frame_cache(const frame_cache&) = delete;
+			auto operator=(const frame_cache&) -> frame_cache& = delete;
+
+			~frame_cache() {
+				for (auto c = std::size_t{0}; c < size_classes; ++c) {
+					while (heads[c] != nullptr) {
+						::operator delete(std::exchange(heads[c], heads[c]->next), class_bytes(c));
+					}
+				}
+			}
+
+			static auto size_class(std::size_t bytes) -> std::size_t {
+				return (std::max(bytes, std::size_t{1}) + granularity - 1) / granularity - 1;
+			}
+
+			static auto class_bytes(std::size_t size_class) -> std::size_t {
+				return (size_class + 1) * granularity;
+			}
+
+			std::array<free_frame*, size_classes> heads = {};
+			std::array<std::size_t, size_classes> counts = {};
+			std::size_t heap_allocations = 0;
+		};
+
+		thread_local auto cache = frame_cache();
+	} // namespace
+
+	namespace frame_pool {
+		auto allocate(std::size_t bytes) -> void* {
+			auto const c = frame_cache::size_class(bytes);
+			if (c >= size_classes) {
+				++cache.heap_allocations;
+				return ::operator new(bytes);
+			}
+			if (cache.heads[c] != nullptr) {
+				--cache.counts[c];
+				return std::exchange(cache.heads[c], cache.heads[c]->next);
+			}
+			++cache.heap_allocations;
+			return ::operator new(frame_cache::class_bytes(c));
+		}
+
+		auto deallocate(void* frame, std::size_t bytes) noexcept -> void {
+			auto const c = frame_cache::size_class(bytes);
+			if (c >= size_classes) {
+				::operator delete(frame, bytes);
+				return;
+			}
+			if (cache.counts[c] == frames_per_class) {
+				::operator delete(frame, frame_cache::class_bytes(c));
+				return;
+			}
+			cache.heads[c] = ::new (frame) free_frame{cache.heads[c]};
+			++cache.counts[c];
+		}
+
+		auto heap_allocations() -> std::size_t {
+			return cache.heap_allocations;
+		}
+	} // namespace frame_pool
+
+	auto lazy_split(filtered_string_view fsv, filtered_string_view tok) -> generator<filtered_string_view> {
+		auto const text = std::string_view(fsv.data(), fsv.length());
+		auto const delim = std::string_view(tok.data(), tok.length());
+		if (fsv.empty() || delim.empty()) {
+			co_yield fsv;
+			co_return;
+		}
+
+		auto current = std::size_t{0};
+		for (auto next = text.find(delim); next != std::string_view::npos; next = text.find(delim, current)) {
+			co_yield kernel::slice(fsv, current, next - current);
+			current = next + delim.size();
+		}
+		co_yield kernel::slice(fsv, current, text.size() - current);
+	}
+
+	auto lazy_lines(filtered_string_view fsv) -> generator<filtered_string_view> {
+		auto const text = std::string_view(fsv.data(), fsv.length());
+		for (auto current = std::size_t{0}; current < text.size();) {
+			auto const next = std::min(text.find('\n', current), text.size());
+			co_yield kernel::slice(fsv, current, next - current);
+			current = next + 1;
+		}
+	}
+
+	auto lazy_runs(filtered_string_view fsv) -> generator<std::string_view> {
+		auto const data = fsv.data();
+		auto const length = fsv.length();
+		auto const& table = fsv.table();
+		auto const& predicate = fsv.predicate();
+		// offset of the first accepted, or with accepted false rejected, character at or after from
+		auto const find = [&](std::size_t from, bool accepted) -> std::size_t {
+			if (table) {
+				return from
+				       + (accepted ? scan::find_first(data + from, length - from, *table)
+				                   : scan::find_first_not(data + from, length - from, *table));
+			}
+			auto const found = std::find_if(data + from, data + length, [&](const char& c) {
+				return predicate(c) == accepted;
+			});
+			return static_cast<std::size_t>(found - data);
+		};
+
+		for (auto first = find(0, true); first < length;) {
+			auto const last = find(first + 1, false);
+			co_yield std::string_view(data + first, last - first);
+			first = last < length ? find(last + 1, true) : length;
+		}
+	}
+} // namespace fsv
@@ -0,0 +1,174 @@
+#ifndef COMP6771_ASS2_GENERATOR_H
+#define COMP6771_ASS2_GENERATOR_H
+
+#include "./filtered_string_view.h"
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+namespace fsv {
+	// Coroutine frames are recycled through a per-thread cache of size classes, so a generator created in a
+	// loop reuses the previous one's frame instead of going to the heap each call.
+	namespace frame_pool {
+		auto allocate(std::size_t bytes) -> void*;
+		auto deallocate(void* frame, std::size_t bytes) noexcept -> void;
+		// frames this thread has had to take from the heap
+		auto heap_allocations() -> std::size_t;
+	} // namespace frame_pool
+
+	// A lazily evaluated sequence produced by a coroutine that co_yields values of type T. The coroutine runs
+	// only as far as the consumer iterates, and abandoning the generator destroys its frame. Yielded values
+	// are referred to, not copied, and are valid until the iterator is next advanced.
+	template<typename T>
+	class generator {
+	 public:
+		class promise_type {
+		 public:
+			static auto operator new(std::size_t bytes) -> void* {
+				return frame_pool::allocate(bytes);
+			}
+
+			static auto operator delete(void* frame, std::size_t bytes) noexcept -> void {
+				frame_pool::deallocate(frame, bytes);
+			}
+
+			auto get_return_object() -> generator {
+				return generator(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+
+			auto initial_suspend() noexcept -> std::suspend_always {
+				return {};
+			}
+
+			auto final_suspend() noexcept -> std::suspend_always {
+				return {};
+			}
+
+			// the yielded temporary lives in the frame until the coroutine is resumed
+			auto yield_value(const T& value) noexcept -> std::suspend_always {
+				value_ = std::addressof(value);
+				return {};
+			}
+
+			auto return_void() noexcept -> void {}
+
+			auto unhandled_exception() noexcept -> void {
+				error_ = std::current_exception();
+			}
+
+			auto value() const -> const T& {
+				return *value_;
+			}
+
+			auto rethrow_if_failed() const -> void {
+				if (error_ != nullptr) {
+					std::rethrow_exception(error_);
+				}
+			}
+
+		 private:
+			const T* value_ = nullptr;
+			std::exception_ptr error_;
+		};
+
+		class iterator {
+		 public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const T*;
+			using reference = const T&;
+
+			iterator() = default;
+
+			explicit iterator(std::coroutine_handle<promise_type> handle)
+			: handle_(handle) {}
+
+			auto operator*() const -> reference {
+				return handle_.promise().value();
+			}
+
+			auto operator->() const -> pointer {
+				return std::addressof(handle_.promise().value());
+			}
+
+			auto operator++() -> iterator& {
+				handle_.resume();
+				handle_.promise().rethrow_if_failed();
+				return *this;
+			}
+
+			auto operator++(int) -> void {
+				++*this;
+			}
+
+			friend auto operator==(const iterator& it, std::default_sentinel_t) -> bool {
+				return it.handle_ == nullptr || it.handle_.done();
+			}
+
+		 private:
+			std::coroutine_handle<promise_type> handle_;
+		};
+
+		generator(generator&& other) noexcept
+		: handle_(std::exchange(other.handle_, nullptr)) {}
+
+		auto operator=(generator&& other) noexcept -> generator& {
+			if (this != &other) {
+				destroy();
+				handle_ = std::exchange(other.handle_, nullptr);
+			}
+			return *this;
+		}
+
+		generator(const generator&) = delete;
+		auto operator=(const generator&) -> generator& = delete;
+
+		~generator() {
+			destroy();
+		}
+
+		// runs the coroutine to its first value; a generator may be iterated once
+		auto begin() -> iterator {
+			if (handle_ != nullptr) {
+				handle_.resume();
+				handle_.promise().rethrow_if_failed();
+			}
+			return iterator(handle_);
+		}
+
+		auto end() -> std::default_sentinel_t {
+			return std::default_sentinel;
+		}
+
+	 private:
+		std::coroutine_handle<promise_type> handle_;
+
+		explicit generator(std::coroutine_handle<promise_type> handle)
+		: handle_(handle) {}
+
+		auto destroy() -> void {
+			if (handle_ != nullptr) {
+				handle_.destroy();
+			}
+		}
+	};
+
+	// the tokens split() returns, produced one at a time; fsv and tok are copied into the coroutine, but the
+	// characters they view must outlive it
+	auto lazy_split(filtered_string_view fsv, filtered_string_view tok) -> generator<filtered_string_view>;
+
+	// the lines of fsv's underlying buffer, without their '\n', viewed through its filter; a final '\n'
+	// does not begin another line
+	auto lazy_lines(filtered_string_view fsv) -> generator<filtered_string_view>;
+
+	// maximal runs of characters fsv accepts, as raw spans of its buffer
+	auto lazy_runs(filtered_string_view fsv) -> generator<std::string_view>;
+} // namespace fsv
+
+#endif // COMP6771_ASS2_GENERATOR_H
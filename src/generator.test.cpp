@@ -0,0 +1,136 @@
+#include "./generator.h"
+#include "./char_class.h"
+
+#include <catch2/catch.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+	auto to_strings(const std::vector<fsv::filtered_string_view>& views) -> std::vector<std::string> {
+		auto result = std::vector<std::string>();
+		for (auto const& view : views) {
+			result.push_back(static_cast<std::string>(view));
+		}
+		return result;
+	}
+
+	auto collect(fsv::generator<fsv::filtered_string_view> gen) -> std::vector<std::string> {
+		auto result = std::vector<std::string>();
+		for (auto const& view : gen) {
+			result.push_back(static_cast<std::string>(view));
+		}
+		return result;
+	}
+} // namespace
+
+TEST_CASE("lazy_split yields the tokens split returns") {
+	auto const text = std::string("xax/bb//c/xd/");
+	auto const no_x = [](const char& c) { return c != 'x'; };
+	for (auto const* delim : {"/", "//", "x", "", "zz"}) {
+		auto const view = fsv::filtered_string_view(text, no_x);
+		auto const tok = fsv::filtered_string_view(delim);
+		CHECK(collect(fsv::lazy_split(view, tok)) == to_strings(fsv::split(view, tok)));
+	}
+	auto const empty = fsv::filtered_string_view("");
+	CHECK(collect(fsv::lazy_split(empty, fsv::filtered_string_view("/"))) == std::vector<std::string>{""});
+}
+
+TEST_CASE("lazy_split tokens keep the view's char_class") {
+	auto const text = std::string("a1b2,c3,,44");
+	auto const digits = fsv::filtered_string_view(text, fsv::char_class::range('0', '9'));
+	auto tokens = std::vector<fsv::filtered_string_view>();
+	for (auto const& token : fsv::lazy_split(digits, ",")) {
+		tokens.push_back(token);
+	}
+	CHECK(to_strings(tokens) == std::vector<std::string>{"12", "3", "", "44"});
+	CHECK(tokens[0].table().has_value());
+}
+
+TEST_CASE("lazy_lines yields the lines std::getline reads") {
+	for (auto const* text : {"one\ntwo\n\nthree", "one\n", "\n\n", "", "no newline"}) {
+		auto expected = std::vector<std::string>();
+		auto in = std::istringstream(text);
+		for (auto line = std::string(); std::getline(in, line);) {
+			expected.push_back(line);
+		}
+		CHECK(collect(fsv::lazy_lines(fsv::filtered_string_view(text))) == expected);
+	}
+	auto const upper = fsv::filtered_string_view("aBc\nDeF", fsv::char_class::range('A', 'Z'));
+	CHECK(collect(fsv::lazy_lines(upper)) == std::vector<std::string>{"B", "DF"});
+}
+
+TEST_CASE("lazy_runs yields maximal accepted runs") {
+	auto const text = std::string("12ab345c6");
+	auto const digits = fsv::char_class::range('0', '9');
+	auto const expected = std::vector<std::string_view>{"12", "345", "6"};
+
+	auto runs = std::vector<std::string_view>();
+	for (auto const run : fsv::lazy_runs(fsv::filtered_string_view(text, digits))) {
+		runs.push_back(run);
+	}
+	CHECK(runs == expected);
+
+	runs.clear();
+	for (auto const run : fsv::lazy_runs(fsv::filtered_string_view(text, [](const char& c) { return c < 'a'; }))) {
+		runs.push_back(run);
+	}
+	CHECK(runs == expected);
+
+	auto none = fsv::lazy_runs(fsv::filtered_string_view("abc", digits));
+	CHECK((none.begin() == none.end()));
+}
+
+TEST_CASE("a generator does no work past the point the consumer stops") {
+	auto const text = std::string("1a") + std::string(10000, 'b');
+	auto calls = 0;
+	auto const counting = [&calls](const char& c) {
+		++calls;
+		return c == '1';
+	};
+	for (auto const run : fsv::lazy_runs(fsv::filtered_string_view(text, counting))) {
+		CHECK(run == "1");
+		break;
+	}
+	CHECK(calls == 2);
+}
+
+TEST_CASE("a generator rethrows the coroutine's exception to its consumer") {
+	auto const throwing = [](const char& c) {
+		if (c == '!') {
+			throw std::runtime_error("bad character");
+		}
+		return c != ' ';
+	};
+	auto gen = fsv::lazy_runs(fsv::filtered_string_view("ok fine !", throwing));
+	auto it = gen.begin();
+	CHECK(*it == "ok");
+	++it;
+	CHECK(*it == "fine");
+	CHECK_THROWS_AS(++it, std::runtime_error);
+}
+
+TEST_CASE("generator frames are reused rather than allocated per call") {
+	auto const text = std::string("a,b,c");
+	auto count = std::size_t{0};
+	for (auto const& token : fsv::lazy_split(text, ",")) {
+		count += token.size();
+	}
+	auto const before = fsv::frame_pool::heap_allocations();
+	for (auto i = 0; i < 1000; ++i) {
+		for (auto const& token : fsv::lazy_split(text, ",")) {
+			count += token.size();
+		}
+	}
+	CHECK(count == 3003);
+	CHECK(fsv::frame_pool::heap_allocations() == before);
+}
+
+TEST_CASE("generators are movable") {
+	auto gen = fsv::lazy_lines(fsv::filtered_string_view("x\ny"));
+	auto moved = std::move(gen);
+	CHECK(collect(std::move(moved)) == std::vector<std::string>{"x", "y"});
+	gen = fsv::lazy_lines(fsv::filtered_string_view("z"));
+	CHECK(collect(std::move(gen)) == std::vector<std::string>{"z"});
+}
@@ -0,0 +1,233 @@
+#include "./hash.h"
+#include "./strategy.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__)
+#	include <immintrin.h>
+#endif
+
+namespace fsv {
+	namespace {
+		// XXH64 primes
+		constexpr auto prime1 = std::uint64_t{0x9E3779B185EBCA87};
+		constexpr auto prime2 = std::uint64_t{0xC2B2AE3D27D4EB4F};
+		constexpr auto prime3 = std::uint64_t{0x165667B19E3779F9};
+		constexpr auto prime4 = std::uint64_t{0x85EBCA77C2B2AE63};
+		constexpr auto prime5 = std::uint64_t{0x27D4EB2F165667C5};
+
+		auto read64(const char* p) -> std::uint64_t {
+			auto result = std::uint64_t{0};
+			std::memcpy(&result, p, sizeof(result));
+			return result;
+		}
+
+		auto read32(const char* p) -> std::uint64_t {
+			auto result = std::uint32_t{0};
+			std::memcpy(&result, p, sizeof(result));
+			return result;
+		}
+
+		auto round(std::uint64_t acc, std::uint64_t input) -> std::uint64_t {
+			return std::rotl(acc + input * prime2, 31) * prime1;
+		}
+
+		auto merge(std::uint64_t acc, std::uint64_t lane) -> std::uint64_t {
+			return (acc ^ round(0, lane)) * prime1 + prime4;
+		}
+
+		auto stripe(std::array<std::uint64_t, 4>& lanes, const char* p) -> void {
+			for (auto i = std::size_t{0}; i < 4; ++i) {
+				lanes[i] = round(lanes[i], read64(p + 8 * i));
+			}
+		}
+
+		auto initial_lanes(std::uint64_t seed) -> std::array<std::uint64_t, 4> {
+			return {seed + prime1 + prime2, seed + prime2, seed, seed - prime1};
+		}
+
+		// the digest of total bytes, of which the last length at p are not yet in lanes
+		auto finish(std::uint64_t seed,
+		            const std::array<std::uint64_t, 4>& lanes,
+		            std::uint64_t total,
+		            const char* p,
+		            std::size_t length) -> std::uint64_t {
+			auto hash = std::uint64_t{0};
+			if (total >= 32) {
+				hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12)
+				       + std::rotl(lanes[3], 18);
+				for (auto lane : lanes) {
+					hash = merge(hash, lane);
+				}
+			}
+			else {
+				hash = seed + prime5;
+			}
+			hash += total;
+			auto const end = p + length;
+			for (; p + 8 <= end; p += 8) {
+				hash = std::rotl(hash ^ round(0, read64(p)), 27) * prime1 + prime4;
+			}
+			if (p + 4 <= end) {
+				hash = std::rotl(hash ^ (read32(p) * prime1), 23) * prime2 + prime3;
+				p += 4;
+			}
+			for (; p < end; ++p) {
+				hash = std::rotl(hash ^ (static_cast<unsigned char>(*p) * prime5), 11) * prime1;
+			}
+			hash ^= hash >> 33U;
+			hash *= prime2;
+			hash ^= hash >> 29U;
+			hash *= prime3;
+			hash ^= hash >> 32U;
+			return hash;
+		}
+
+		// reflected Castagnoli polynomial
+		constexpr auto crc_polynomial = std::uint32_t{0x82F63B78};
+
+		constexpr auto crc_table = [] {
+			auto result = std::array<std::uint32_t, 256>();
+			for (auto b = 0U; b < 256; ++b) {
+				auto crc = b;
+				for (auto bit = 0; bit < 8; ++bit) {
+					crc = (crc & 1U) != 0 ? (crc >> 1U) ^ crc_polynomial : crc >> 1U;
+				}
+				result[b] = crc;
+			}
+			return result;
+		}();
+
+		// crc here and below is not inverted
+		auto table_crc32c(const char* data, std::size_t length, std::uint32_t crc) -> std::uint32_t {
+			for (auto i = std::size_t{0}; i < length; ++i) {
+				crc = (crc >> 8U) ^ crc_table[(crc ^ static_cast<unsigned char>(data[i])) & 0xffU];
+			}
+			return crc;
+		}
+
+#if defined(__x86_64__)
+		[[gnu::target("sse4.2")]] auto sse42_crc32c(const char* data, std::size_t length, std::uint32_t crc)
+		    -> std::uint32_t {
+			auto wide = std::uint64_t{crc};
+			auto i = std::size_t{0};
+			for (; i + 8 <= length; i += 8) {
+				wide = _mm_crc32_u64(wide, read64(data + i));
+			}
+			crc = static_cast<std::uint32_t>(wide);
+			for (; i < length; ++i) {
+				crc = _mm_crc32_u8(crc, static_cast<unsigned char>(data[i]));
+			}
+			return crc;
+		}
+
+		auto has_sse42() -> bool {
+			static auto const supported = __builtin_cpu_supports("sse4.2") != 0;
+			return supported;
+		}
+#endif
+
+		auto raw_crc32c(const char* data, std::size_t length, std::uint32_t crc) -> std::uint32_t {
+#if defined(__x86_64__)
+			if (has_sse42()) {
+				return sse42_crc32c(data, length, crc);
+			}
+#endif
+			return table_crc32c(data, length, crc);
+		}
+	} // namespace
+
+	hash64_stream::hash64_stream(std::uint64_t seed)
+	: seed_(seed)
+	, lanes_(initial_lanes(seed))
+	, pending_()
+	, pending_size_(0)
+	, total_(0) {}
+
+	auto hash64_stream::update(const char* data, std::size_t length) -> void {
+		total_ += length;
+		if (pending_size_ + length < pending_.size()) {
+			std::memcpy(pending_.data() + pending_size_, data, length);
+			pending_size_ += length;
+			return;
+		}
+		auto const end = data + length;
+		if (pending_size_ != 0) {
+			auto const fill = pending_.size() - pending_size_;
+			std::memcpy(pending_.data() + pending_size_, data, fill);
+			stripe(lanes_, pending_.data());
+			data += fill;
+			pending_size_ = 0;
+		}
+		for (; end - data >= 32; data += 32) {
+			stripe(lanes_, data);
+		}
+		pending_size_ = static_cast<std::size_t>(end - data);
+		std::memcpy(pending_.data(), data, pending_size_);
+	}
+
+	auto hash64_stream::update(std::string_view str) -> void {
+		update(str.data(), str.size());
+	}
+
+	auto hash64_stream::digest() const -> std::uint64_t {
+		return finish(seed_, lanes_, total_, pending_.data(), pending_size_);
+	}
+
+	auto hash64(const filtered_string_view& fsv, std::uint64_t seed) -> std::uint64_t {
+		auto stream = hash64_stream(seed);
+		kernel::for_each_block(fsv, [&stream](std::string_view accepted) {
+			stream.update(accepted);
+			return true;
+		});
+		return stream.digest();
+	}
+
+	// the bytes are read in place rather than through a stream's buffer, which matters for short keys
+	auto hash64(const char* data, std::size_t length, std::uint64_t seed) -> std::uint64_t {
+		auto lanes = initial_lanes(seed);
+		auto const whole = length / 32 * 32;
+		for (auto i = std::size_t{0}; i < whole; i += 32) {
+			stripe(lanes, data + i);
+		}
+		return finish(seed, lanes, length, data + whole, length - whole);
+	}
+
+	auto crc32c(const filtered_string_view& fsv, std::uint32_t crc) -> std::uint32_t {
+		auto state = ~crc;
+		kernel::for_each_block(fsv, [&state](std::string_view accepted) {
+			state = raw_crc32c(accepted.data(), accepted.size(), state);
+			return true;
+		});
+		return ~state;
+	}
+
+	auto crc32c(const char* data, std::size_t length, std::uint32_t crc) -> std::uint32_t {
+		return ~raw_crc32c(data, length, ~crc);
+	}
+
+	auto equals(const filtered_string_view& fsv, std::string_view str) -> bool {
+		auto rest = str;
+		auto const same = kernel::for_each_block(fsv, [&rest](std::string_view accepted) {
+			if (rest.substr(0, accepted.size()) != accepted) {
+				return false;
+			}
+			rest.remove_prefix(accepted.size());
+			return true;
+		});
+		return same && rest.empty();
+	}
+
+	auto string_hash::operator()(std::string_view str) const -> std::size_t {
+		return static_cast<std::size_t>(hash64(str.data(), str.size()));
+	}
+
+	auto string_equal::operator()(std::string_view lhs, std::string_view rhs) const -> bool {
+		return lhs == rhs;
+	}
+} // namespace fsv
+
+auto std::hash<fsv::filtered_string_view>::operator()(const fsv::filtered_string_view& fsv) const -> std::size_t {
+	return static_cast<std::size_t>(fsv::hash64(fsv));
+}
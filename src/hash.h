@@ -0,0 +1,88 @@
+#ifndef COMP6771_ASS2_HASH_H
+#define COMP6771_ASS2_HASH_H
+
+#include "./filtered_string_view.h"
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace fsv {
+	// XXH64 fed a piece at a time. The digest depends only on the concatenation of what was fed, not on how it
+	// was split, so the accepted characters of a view can be hashed block by block as the kernels produce them.
+	class hash64_stream {
+	 public:
+		explicit hash64_stream(std::uint64_t seed = 0);
+
+		auto update(const char* data, std::size_t length) -> void;
+		auto update(std::string_view str) -> void;
+		// the hash of everything fed so far; more may be fed afterwards
+		auto digest() const -> std::uint64_t;
+
+	 private:
+		std::uint64_t seed_;
+		std::array<std::uint64_t, 4> lanes_;
+		// bytes short of a whole 32-byte stripe
+		std::array<char, 32> pending_;
+		std::size_t pending_size_;
+		std::uint64_t total_;
+	};
+
+	// XXH64 of the accepted characters, equal to that of the same characters in a string. A view that accepts
+	// every byte is hashed in place; any other is compacted a block at a time into a buffer on the stack by
+	// the view's kernels, so no allocation is made either way.
+	auto hash64(const filtered_string_view& fsv, std::uint64_t seed = 0) -> std::uint64_t;
+	auto hash64(const char* data, std::size_t length, std::uint64_t seed = 0) -> std::uint64_t;
+
+	// CRC-32C (Castagnoli) of the accepted characters, using the SSE4.2 crc32 instruction where the CPU has
+	// it. crc is the checksum of whatever came before, so checksums can be chained across pieces.
+	auto crc32c(const filtered_string_view& fsv, std::uint32_t crc = 0) -> std::uint32_t;
+	auto crc32c(const char* data, std::size_t length, std::uint32_t crc = 0) -> std::uint32_t;
+
+	// true if the accepted characters of fsv are str, found without materializing the view
+	auto equals(const filtered_string_view& fsv, std::string_view str) -> bool;
+
+	// Transparent hash and equality, for containers keyed by std::string that are looked up with views or
+	// string_views without building a std::string:
+	//
+	//   auto counts = std::unordered_map<std::string, int, fsv::string_hash, fsv::string_equal>();
+	//   counts.find(fsv::filtered_string_view(line, letters));
+	//
+	// The view overloads are templates only so that a std::string, which converts to both a string_view and
+	// a view, picks the string_view ones.
+	struct string_hash {
+		using is_transparent = void;
+
+		auto operator()(std::string_view str) const -> std::size_t;
+
+		template<std::same_as<filtered_string_view> View>
+		auto operator()(const View& fsv) const -> std::size_t {
+			return static_cast<std::size_t>(hash64(fsv));
+		}
+	};
+
+	struct string_equal {
+		using is_transparent = void;
+
+		auto operator()(std::string_view lhs, std::string_view rhs) const -> bool;
+
+		template<std::same_as<filtered_string_view> View>
+		auto operator()(const View& lhs, std::string_view rhs) const -> bool {
+			return equals(lhs, rhs);
+		}
+
+		template<std::same_as<filtered_string_view> View>
+		auto operator()(std::string_view lhs, const View& rhs) const -> bool {
+			return equals(rhs, lhs);
+		}
+
+		template<std::same_as<filtered_string_view> View>
+		auto operator()(const View& lhs, const View& rhs) const -> bool {
+			return lhs == rhs;
+		}
+	};
+} // namespace fsv
+
+#endif // COMP6771_ASS2_HASH_H
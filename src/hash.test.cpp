@@ -0,0 +1,113 @@
+#include "./hash.h"
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+	auto hash(const std::string& str, std::uint64_t seed = 0) -> std::uint64_t {
+		auto stream = fsv::hash64_stream(seed);
+		stream.update(str);
+		return stream.digest();
+	}
+} // namespace
+
+TEST_CASE("hash64_stream computes XXH64") {
+	REQUIRE(hash("") == 0xEF46DB3751D8E999);
+	REQUIRE(hash("a") == 0xD24EC4F1A98C6E5B);
+	REQUIRE(hash("abc") == 0x44BC2CF5AD770999);
+	REQUIRE(hash("", 1) != hash(""));
+}
+
+TEST_CASE("hash64_stream does not depend on how its input is split") {
+	auto text = std::string();
+	for (auto i = 0; i < 200; ++i) {
+		text += static_cast<char>('a' + i * 7 % 26);
+	}
+	for (auto const length : {std::size_t{0}, std::size_t{5}, std::size_t{31}, std::size_t{32}, std::size_t{200}}) {
+		auto const expected = hash(text.substr(0, length));
+		for (auto const piece : {std::size_t{1}, std::size_t{3}, std::size_t{31}, std::size_t{33}}) {
+			auto stream = fsv::hash64_stream();
+			for (auto at = std::size_t{0}; at < length; at += piece) {
+				stream.update(text.data() + at, std::min(piece, length - at));
+			}
+			INFO(length << " in pieces of " << piece);
+			REQUIRE(stream.digest() == expected);
+		}
+	}
+}
+
+TEST_CASE("hash64 hashes the accepted characters") {
+	auto const digits = fsv::char_class::range('0', '9');
+	auto const text = std::string("a1b22c333");
+	auto const view = fsv::filtered_string_view(text, digits);
+	REQUIRE(fsv::hash64(view) == hash("122333"));
+	REQUIRE(fsv::hash64(view, 7) == hash("122333", 7));
+	REQUIRE(fsv::hash64(fsv::filtered_string_view(text, [](const char& c) { return c >= '0' && c <= '9'; }))
+	        == fsv::hash64(view));
+	REQUIRE(fsv::hash64(fsv::filtered_string_view(text, fsv::char_class::all())) == hash(text));
+	REQUIRE(fsv::hash64(text.data(), text.size()) == hash(text));
+	REQUIRE(fsv::hash64(fsv::filtered_string_view()) == hash(""));
+
+	// the same characters spread over many blocks, however they are interleaved with rejected ones
+	auto sparse = std::string();
+	auto dense = std::string();
+	for (auto i = 0; i < 20000; ++i) {
+		auto const c = static_cast<char>('0' + i % 10);
+		dense += c;
+		sparse += std::string(static_cast<std::size_t>(i % 7), 'x') + c;
+	}
+	REQUIRE(fsv::hash64(fsv::filtered_string_view(sparse, digits)) == hash(dense));
+	REQUIRE(fsv::equals(fsv::filtered_string_view(sparse, digits), dense));
+	REQUIRE_FALSE(fsv::equals(fsv::filtered_string_view(sparse, digits), dense + "0"));
+	REQUIRE_FALSE(fsv::equals(fsv::filtered_string_view(sparse, digits), dense.substr(1)));
+}
+
+TEST_CASE("views key unordered containers through std::hash") {
+	auto const text = std::string("a-b a_b ab");
+	auto const letters = fsv::char_class::range('a', 'z');
+	auto seen = std::unordered_set<fsv::filtered_string_view>();
+	seen.insert(fsv::filtered_string_view(text.data(), 3, letters));
+	seen.insert(fsv::filtered_string_view(text.data() + 4, 3, letters));
+	seen.insert(fsv::filtered_string_view(text.data() + 8, 2, letters));
+	REQUIRE(seen.size() == 1);
+	REQUIRE(seen.contains(fsv::filtered_string_view("ab")));
+	REQUIRE(std::hash<fsv::filtered_string_view>()(fsv::filtered_string_view("ab")) == hash("ab"));
+}
+
+TEST_CASE("string_hash and string_equal look up std::string keys with views") {
+	auto counts = std::unordered_map<std::string, int, fsv::string_hash, fsv::string_equal>();
+	counts["content-type"] = 1;
+	counts["host"] = 2;
+	auto const line = std::string("  host  ");
+	REQUIRE(counts.find(fsv::filtered_string_view(line, ~fsv::char_class(" ")))->second == 2);
+	REQUIRE(counts.find(std::string_view("content-type"))->second == 1);
+	REQUIRE(counts.find("content-type")->second == 1);
+	REQUIRE(counts.find(fsv::filtered_string_view(line)) == counts.end());
+	REQUIRE(counts.count(std::string("host")) == 1);
+	auto const equal = fsv::string_equal();
+	REQUIRE(equal(fsv::filtered_string_view("x-y", ~fsv::char_class("-")), "xy"));
+	REQUIRE(equal(std::string("xy"), fsv::filtered_string_view("x-y", ~fsv::char_class("-"))));
+	REQUIRE_FALSE(equal(fsv::filtered_string_view("x"), fsv::filtered_string_view("y")));
+}
+
+TEST_CASE("crc32c computes CRC-32C") {
+	auto const check = std::string("123456789");
+	REQUIRE(fsv::crc32c(check.data(), check.size()) == 0xE3069283);
+	REQUIRE(fsv::crc32c(check.data(), 0) == 0);
+	REQUIRE(fsv::crc32c(check.data() + 4, 5, fsv::crc32c(check.data(), 4)) == 0xE3069283);
+	auto const text = std::string("1-2-3-4-5-6-7-8-9");
+	REQUIRE(fsv::crc32c(fsv::filtered_string_view(text, ~fsv::char_class("-"))) == 0xE3069283);
+	REQUIRE(fsv::crc32c(fsv::filtered_string_view(text, [](const char& c) { return c != '-'; })) == 0xE3069283);
+
+	auto large = std::string();
+	for (auto i = 0; i < 10000; ++i) {
+		large += static_cast<char>(i * 31 % 256);
+	}
+	auto const whole = fsv::crc32c(large.data(), large.size());
+	REQUIRE(fsv::crc32c(fsv::filtered_string_view(large, fsv::char_class::all())) == whole);
+	REQUIRE(fsv::crc32c(large.data() + 777, large.size() - 777, fsv::crc32c(large.data(), 777)) == whole);
+}
@@ -0,0 +1,172 @@
+#include "./icase.h"
+#include "./hash.h"
+#include "./scan.h"
+#include "./strategy.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#	include <immintrin.h>
+#endif
+
+namespace fsv {
+	namespace {
+		auto lower(char c) -> char {
+			auto const u = static_cast<unsigned char>(c);
+			return static_cast<char>(static_cast<unsigned char>(u - 'A') < 26 ? u | 0x20U : u);
+		}
+
+		auto read64(const char* p) -> std::uint64_t {
+			auto result = std::uint64_t{0};
+			std::memcpy(&result, p, sizeof(result));
+			return result;
+		}
+
+		// lowercases the eight bytes of a word at once: adding to the low seven bits of each byte sets its top
+		// bit when the byte is at least 'A', and again when it is past 'Z'
+		auto lower64(std::uint64_t x) -> std::uint64_t {
+			constexpr auto ones = std::uint64_t{0x0101010101010101};
+			auto const low = x & (0x7f * ones);
+			auto const from_a = low + (0x80 - 'A') * ones;
+			auto const past_z = low + (0x80 - 'Z' - 1) * ones;
+			auto const upper = (from_a ^ past_z) & ~x & (0x80 * ones);
+			return x | (upper >> 2U);
+		}
+
+#if defined(__x86_64__)
+		// sets bit 5 of the bytes in A-Z, which is all ASCII lowercasing takes
+		[[gnu::target("avx2")]] inline auto avx2_lower(__m256i x) -> __m256i {
+			auto const offset = _mm256_sub_epi8(x, _mm256_set1_epi8('A'));
+			auto const upper = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(25)), offset);
+			return _mm256_or_si256(x, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+		}
+
+		// the offset of the first 32-byte block of a and b that differs once folded, or the length of the
+		// whole blocks if none does
+		[[gnu::target("avx2")]] auto avx2_mismatch(const char* a, const char* b, std::size_t length) -> std::size_t {
+			auto i = std::size_t{0};
+			for (; i + 32 <= length; i += 32) {
+				auto const x = avx2_lower(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)));
+				auto const y = avx2_lower(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+				if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)) != -1) {
+					break;
+				}
+			}
+			return i;
+		}
+
+		[[gnu::target("avx2")]] auto avx2_fold(const char* data, std::size_t length, char* out) -> std::size_t {
+			auto i = std::size_t{0};
+			for (; i + 32 <= length; i += 32) {
+				auto const x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), avx2_lower(x));
+			}
+			return i;
+		}
+#endif
+
+		// index of the first position where a and b differ once folded, or length
+		auto folded_mismatch(const char* a, const char* b, std::size_t length) -> std::size_t {
+			auto i = std::size_t{0};
+#if defined(__x86_64__)
+			if (scan::vectorized()) {
+				i = avx2_mismatch(a, b, length);
+			}
+#endif
+			for (; i + 8 <= length; i += 8) {
+				if (lower64(read64(a + i)) != lower64(read64(b + i))) {
+					break;
+				}
+			}
+			for (; i < length; ++i) {
+				if (lower(a[i]) != lower(b[i])) {
+					return i;
+				}
+			}
+			return length;
+		}
+
+		// orders characters that differ once folded
+		auto ordered(char x, char y) -> std::strong_ordering {
+			return lower(x) <=> lower(y);
+		}
+
+		auto fold(const char* data, std::size_t length, char* out) -> void {
+			auto i = std::size_t{0};
+#if defined(__x86_64__)
+			if (scan::vectorized()) {
+				i = avx2_fold(data, length, out);
+			}
+#endif
+			for (; i + 8 <= length; i += 8) {
+				auto const word = lower64(read64(data + i));
+				std::memcpy(out + i, &word, sizeof(word));
+			}
+			for (; i < length; ++i) {
+				out[i] = lower(data[i]);
+			}
+		}
+	} // namespace
+
+	auto iequals(const filtered_string_view& lhs, const filtered_string_view& rhs) -> bool {
+		if (lhs.unfiltered() && rhs.unfiltered() && lhs.length() != rhs.length()) {
+			return false;
+		}
+		return icompare(lhs, rhs) == std::strong_ordering::equal;
+	}
+
+	auto iequals(const filtered_string_view& lhs, std::string_view rhs) -> bool {
+		if (lhs.unfiltered() && lhs.length() != rhs.size()) {
+			return false;
+		}
+		return icompare(lhs, rhs) == std::strong_ordering::equal;
+	}
+
+	auto iequals(const filtered_string_view& lhs, const std::string& rhs) -> bool {
+		return iequals(lhs, std::string_view(rhs));
+	}
+
+	auto iequals(const filtered_string_view& lhs, const char* rhs) -> bool {
+		return iequals(lhs, std::string_view(rhs));
+	}
+
+	auto icompare(const filtered_string_view& lhs, const filtered_string_view& rhs) -> std::strong_ordering {
+		return kernel::compare(kernel::block_reader(lhs), kernel::block_reader(rhs), folded_mismatch, ordered);
+	}
+
+	auto icompare(const filtered_string_view& lhs, std::string_view rhs) -> std::strong_ordering {
+		return kernel::compare(kernel::block_reader(lhs), kernel::string_reader(rhs), folded_mismatch, ordered);
+	}
+
+	auto icompare(const filtered_string_view& lhs, const std::string& rhs) -> std::strong_ordering {
+		return icompare(lhs, std::string_view(rhs));
+	}
+
+	auto icompare(const filtered_string_view& lhs, const char* rhs) -> std::strong_ordering {
+		return icompare(lhs, std::string_view(rhs));
+	}
+
+	auto ihash(const filtered_string_view& fsv) -> std::uint64_t {
+		constexpr auto block = kernel::block_reader::block;
+		auto reader = kernel::block_reader(fsv);
+		auto stream = hash64_stream();
+		std::array<char, block> folded;
+		for (auto run = reader.next(); !run.empty(); run = reader.next()) {
+			for (; !run.empty(); run.remove_prefix(std::min(block, run.size()))) {
+				auto const count = std::min(block, run.size());
+				fold(run.data(), count, folded.data());
+				stream.update(folded.data(), count);
+			}
+		}
+		return stream.digest();
+	}
+
+	auto ihasher::operator()(const filtered_string_view& fsv) const -> std::size_t {
+		return static_cast<std::size_t>(ihash(fsv));
+	}
+
+	auto iequal_to::operator()(const filtered_string_view& lhs, const filtered_string_view& rhs) const -> bool {
+		return iequals(lhs, rhs);
+	}
+} // namespace fsv
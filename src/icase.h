@@ -0,0 +1,41 @@
+#ifndef COMP6771_ASS2_ICASE_H
+#define COMP6771_ASS2_ICASE_H
+
+#include "./filtered_string_view.h"
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace fsv {
+	// ASCII case-insensitive comparison and hashing of the accepted characters of views. Results are those of
+	// lowercasing A-Z on both sides and comparing as char, but nothing is copied to the heap: accepted
+	// characters are written a block at a time to a buffer on the stack, or read in place when the view
+	// accepts everything, and folded 32 at a time with AVX2 where available. Comparisons stop at the first
+	// block that differs.
+	auto iequals(const filtered_string_view& lhs, const filtered_string_view& rhs) -> bool;
+	// a plain string on the right is read as is, rather than through a view; the std::string and const char*
+	// overloads only settle which conversion applies
+	auto iequals(const filtered_string_view& lhs, std::string_view rhs) -> bool;
+	auto iequals(const filtered_string_view& lhs, const std::string& rhs) -> bool;
+	auto iequals(const filtered_string_view& lhs, const char* rhs) -> bool;
+	auto icompare(const filtered_string_view& lhs, const filtered_string_view& rhs) -> std::strong_ordering;
+	auto icompare(const filtered_string_view& lhs, std::string_view rhs) -> std::strong_ordering;
+	auto icompare(const filtered_string_view& lhs, const std::string& rhs) -> std::strong_ordering;
+	auto icompare(const filtered_string_view& lhs, const char* rhs) -> std::strong_ordering;
+	// XXH64 of the lowercased accepted characters, so views that are iequals() hash equally
+	auto ihash(const filtered_string_view& fsv) -> std::uint64_t;
+
+	// for unordered containers keyed by views without regard to case
+	struct ihasher {
+		auto operator()(const filtered_string_view& fsv) const -> std::size_t;
+	};
+
+	struct iequal_to {
+		auto operator()(const filtered_string_view& lhs, const filtered_string_view& rhs) const -> bool;
+	};
+} // namespace fsv
+
+#endif // COMP6771_ASS2_ICASE_H
@@ -0,0 +1,95 @@
+#include "./icase.h"
+#include "./char_class.h"
+#include "./test_text.h"
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+	using fsv::test::ascii_lower;
+	using fsv::test::random_text;
+
+	// flips the case of every other letter
+	auto mixed_case(std::string str) -> std::string {
+		for (auto i = std::size_t{0}; i < str.size(); i += 2) {
+			auto const u = static_cast<unsigned char>(str[i]);
+			if ((u | 0x20U) >= 'a' && (u | 0x20U) <= 'z') {
+				str[i] = static_cast<char>(u ^ 0x20U);
+			}
+		}
+		return str;
+	}
+} // namespace
+
+TEST_CASE("iequals folds ASCII letters only") {
+	auto const view = [](const char* str) { return fsv::filtered_string_view(str); };
+	REQUIRE(fsv::iequals(view("Content-Length"), view("content-LENGTH")));
+	REQUIRE_FALSE(fsv::iequals(view("Content-Length"), view("Content-Lengt")));
+	REQUIRE_FALSE(fsv::iequals(view("@"), view("`")));
+	REQUIRE_FALSE(fsv::iequals(view("["), view("{")));
+	REQUIRE_FALSE(fsv::iequals(view("\xC9"), view("\xE9")));
+	REQUIRE(fsv::iequals(view(""), ""));
+	REQUIRE(fsv::iequals(view("Host"), "hOST"));
+	REQUIRE_FALSE(fsv::iequals(view("Host"), "hosts"));
+}
+
+TEST_CASE("iequals compares the accepted characters") {
+	auto const text = std::string("WWW.Example.COM.");
+	auto const host = fsv::filtered_string_view(text, [](const char& c) { return c != '.'; });
+	REQUIRE(fsv::iequals(host, "wwwexamplecom"));
+	REQUIRE(fsv::iequals(host, fsv::filtered_string_view("w.w.w.EXAMPLE.com", ~fsv::char_class("."))));
+	REQUIRE(fsv::iequals(fsv::filtered_string_view(text, fsv::char_class::all()), "www.example.com."));
+	REQUIRE(fsv::ihash(host) == fsv::ihash(fsv::filtered_string_view("wwwexamplecom")));
+}
+
+TEST_CASE("icompare orders like lowercasing both sides") {
+	auto const words = std::vector<std::string>{"", "a", "A", "ab", "Ab", "b", "_", "Z", "z[", "\xC0", "zz"};
+	for (auto const& a : words) {
+		for (auto const& b : words) {
+			INFO(a << " vs " << b);
+			// views order characters as char, where std::string orders them as unsigned char
+			auto const lowered_a = ascii_lower(a);
+			auto const lowered_b = ascii_lower(b);
+			auto const expected = fsv::filtered_string_view(lowered_a) <=> fsv::filtered_string_view(lowered_b);
+			REQUIRE(fsv::icompare(fsv::filtered_string_view(a), fsv::filtered_string_view(b)) == expected);
+			REQUIRE(fsv::icompare(fsv::filtered_string_view(a, fsv::char_class::all()), b) == expected);
+		}
+	}
+}
+
+TEST_CASE("icase kernels agree with lowercase copies on long views") {
+	auto const keep = ~fsv::char_class("\n\t ");
+	for (auto const length : {std::size_t{31}, std::size_t{64}, std::size_t{5000}, std::size_t{20000}}) {
+		auto const a = random_text(length, 1);
+		auto b = mixed_case(a);
+		auto const lhs = fsv::filtered_string_view(a, keep);
+		INFO(length);
+		REQUIRE(fsv::iequals(lhs, fsv::filtered_string_view(b, keep)));
+		REQUIRE(fsv::iequals(fsv::filtered_string_view(a, fsv::char_class::all()), b));
+		REQUIRE(fsv::ihash(lhs) == fsv::ihash(fsv::filtered_string_view(b, keep)));
+
+		// a difference in the last character only
+		b.back() = static_cast<char>(b.back() ^ 1);
+		auto const rhs = fsv::filtered_string_view(b, keep);
+		auto const lowered_a = ascii_lower(static_cast<std::string>(lhs));
+		auto const lowered_b = ascii_lower(static_cast<std::string>(rhs));
+		REQUIRE(fsv::iequals(lhs, rhs) == (lowered_a == lowered_b));
+		REQUIRE(fsv::icompare(lhs, rhs)
+		        == (fsv::filtered_string_view(lowered_a) <=> fsv::filtered_string_view(lowered_b)));
+	}
+}
+
+TEST_CASE("ihasher and iequal_to key unordered containers") {
+	auto const names = std::vector<std::string>{"Accept", "ACCEPT", "accept", "Host", "host"};
+	auto counts = std::unordered_map<fsv::filtered_string_view, int, fsv::ihasher, fsv::iequal_to>();
+	for (auto const& name : names) {
+		++counts[fsv::filtered_string_view(name)];
+	}
+	REQUIRE(counts.size() == 2);
+	REQUIRE(counts.at(fsv::filtered_string_view("aCCEPT")) == 3);
+	REQUIRE(counts.at(fsv::filtered_string_view("HOST")) == 2);
+	REQUIRE(fsv::ihash(fsv::filtered_string_view("Accept")) != fsv::ihash(fsv::filtered_string_view("Host")));
+}
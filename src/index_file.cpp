@@ -0,0 +1,328 @@
+#include "./index_file.h"
+#include "./hash.h"
+#include "./scan.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fsv {
+	namespace {
+		enum field : std::size_t {
+			magic_field,
+			version_field,
+			block_size_field,
+			checksum_field,
+			sample_field,
+			predicate_field,
+			length_field,
+			size_field,
+			block_count_field,
+			run_count_field,
+			header_words,
+		};
+
+		constexpr auto header_bytes = header_words * sizeof(std::uint64_t);
+		constexpr auto words_per_block = mapped_index::block_size / 64;
+		constexpr auto samples = std::size_t{64};
+		constexpr auto sample_bytes = std::size_t{64};
+
+		// classifies one block of fsv into words, one bit per byte
+		auto classify_block(const filtered_string_view& fsv,
+		                    std::size_t offset,
+		                    std::size_t count,
+		                    std::array<std::uint64_t, words_per_block>& words) -> void {
+			words.fill(0);
+			if (fsv.table()) {
+				scan::classify(fsv.data() + offset, count, *fsv.table(), words.data());
+				return;
+			}
+			for (auto i = std::size_t{0}; i < count; ++i) {
+				auto const accepted = fsv.predicate()(fsv.data()[offset + i]);
+				words[i / 64] |= static_cast<std::uint64_t>(accepted) << (i % 64);
+			}
+		}
+	} // namespace
+
+	auto content_checksum(const char* data, std::size_t length) -> std::uint64_t {
+		return hash64(data, length);
+	}
+
+	auto sample_checksum(const char* data, std::size_t length) -> std::uint64_t {
+		if (length <= samples * sample_bytes) {
+			return content_checksum(data, length);
+		}
+		auto stream = hash64_stream();
+		auto const total = static_cast<std::uint64_t>(length);
+		stream.update(reinterpret_cast<const char*>(&total), sizeof(total));
+		auto const last = length - sample_bytes;
+		for (auto i = std::size_t{0}; i < samples; ++i) {
+			stream.update(data + last * i / (samples - 1), sample_bytes);
+		}
+		return stream.digest();
+	}
+
+	auto predicate_id(std::string_view predicate_name) -> std::uint64_t {
+		return content_checksum(predicate_name.data(), predicate_name.size());
+	}
+
+	auto write_index(const std::string& path, const filtered_string_view& fsv, std::string_view predicate_name)
+	    -> void {
+		auto const length = fsv.length();
+		auto const blocks = (length + mapped_index::block_size - 1) / mapped_index::block_size;
+		// runs are dropped once they would take more room than a bitmap of the input
+		auto const run_limit = length / (8 * 2 * sizeof(std::uint64_t));
+
+		auto counts = std::vector<std::uint64_t>{0};
+		auto runs = std::vector<std::uint64_t>();
+		auto keep_runs = true;
+		auto previous = std::uint64_t{0};
+		auto words = std::array<std::uint64_t, words_per_block>();
+		for (auto b = std::size_t{0}; b < blocks; ++b) {
+			auto const offset = b * mapped_index::block_size;
+			auto const count = std::min(mapped_index::block_size, length - offset);
+			classify_block(fsv, offset, count, words);
+
+			auto accepted = std::uint64_t{0};
+			for (auto w = std::size_t{0}; w < (count + 63) / 64 && keep_runs; ++w) {
+				// a run starts at a set bit after a clear one and ends at a clear bit after a set one
+				auto const shifted = (words[w] << 1U) | previous;
+				auto const starts = words[w] & ~shifted;
+				auto const ends = ~words[w] & shifted;
+				for (auto edges = starts | ends; edges != 0; edges &= edges - 1) {
+					auto const bit = static_cast<std::size_t>(std::countr_zero(edges));
+					runs.push_back(offset + w * 64 + bit);
+				}
+				previous = words[w] >> 63U;
+				if (runs.size() / 2 > run_limit) {
+					keep_runs = false;
+					runs = {};
+				}
+			}
+			for (auto w = std::size_t{0}; w < (count + 63) / 64; ++w) {
+				accepted += static_cast<std::uint64_t>(std::popcount(words[w]));
+			}
+			counts.push_back(counts.back() + accepted);
+		}
+		if (keep_runs && runs.size() % 2 == 1) {
+			runs.push_back(length);
+		}
+
+		auto header = std::array<std::uint64_t, header_words>();
+		header[magic_field] = mapped_index::magic;
+		header[version_field] = mapped_index::version;
+		header[block_size_field] = mapped_index::block_size;
+		header[checksum_field] = content_checksum(fsv.data(), length);
+		header[sample_field] = sample_checksum(fsv.data(), length);
+		header[predicate_field] = predicate_id(predicate_name);
+		header[length_field] = length;
+		header[size_field] = counts.back();
+		header[block_count_field] = blocks;
+		header[run_count_field] = runs.size() / 2;
+
+		// Truncating the file in place would make any process reading a mapping of it fault, and a temporary
+		// name of its own keeps writers of the same index from interleaving; the last rename wins.
+		auto temporary = path + ".XXXXXX";
+		auto const fd = ::mkstemp(temporary.data());
+		if (fd < 0) {
+			throw std::runtime_error{"write_index(" + path + "): cannot create file"};
+		}
+		auto const write = [fd](const std::uint64_t* words, std::size_t count) {
+			auto const* bytes = reinterpret_cast<const char*>(words);
+			auto left = count * sizeof(std::uint64_t);
+			while (left > 0) {
+				auto const written = ::write(fd, bytes, left);
+				if (written <= 0) {
+					return false;
+				}
+				bytes += written;
+				left -= static_cast<std::size_t>(written);
+			}
+			return true;
+		};
+		auto const written = ::fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) == 0
+		                     && write(header.data(), header.size()) && write(counts.data(), counts.size())
+		                     && write(runs.data(), runs.size());
+		if (::close(fd) != 0 || !written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+			std::remove(temporary.c_str());
+			throw std::runtime_error{"write_index(" + path + "): cannot write file"};
+		}
+	}
+
+	auto load_index(const std::string& path,
+	                const filtered_string_view& fsv,
+	                std::string_view predicate_name,
+	                index_check check) -> std::optional<mapped_index> {
+		if (::access(path.c_str(), R_OK) != 0) {
+			return std::nullopt;
+		}
+		// an index left by another version is stale rather than corrupt, and is rebuilt like one
+		auto prefix = std::array<std::uint64_t, 2>();
+		auto in = std::ifstream(path, std::ios::binary);
+		in.read(reinterpret_cast<char*>(prefix.data()), sizeof(prefix));
+		if (in && prefix[magic_field] == mapped_index::magic && prefix[version_field] != mapped_index::version) {
+			return std::nullopt;
+		}
+		// a truncated or corrupt file is stale too, so the caller rebuilds it rather than failing
+		try {
+			auto index = mapped_index(path);
+			if (!index.matches(fsv, predicate_name, check)) {
+				return std::nullopt;
+			}
+			return index;
+		} catch (const std::runtime_error&) {
+			return std::nullopt;
+		}
+	}
+
+	mapped_index::mapped_index(const std::string& path)
+	: mapping_(nullptr)
+	, mapping_size_(0)
+	, header_(nullptr)
+	, counts_(nullptr)
+	, runs_(nullptr) {
+		auto const fail = [&path](const std::string& why) {
+			return std::runtime_error{"mapped_index(" + path + "): " + why};
+		};
+
+		auto const fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw fail("cannot open file");
+		}
+		struct stat info = {};
+		if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < header_bytes) {
+			::close(fd);
+			throw fail("file too small");
+		}
+		mapping_size_ = static_cast<std::size_t>(info.st_size);
+		auto const mapping = ::mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (mapping == MAP_FAILED) {
+			throw fail("cannot map file");
+		}
+		mapping_ = mapping;
+
+		header_ = static_cast<const std::uint64_t*>(mapping_);
+		counts_ = header_ + header_words;
+		// counts bounded by the file size first, so the expected size below cannot overflow
+		auto const words = mapping_size_ / sizeof(std::uint64_t);
+		auto const blocks = std::min<std::size_t>(header_[block_count_field], words);
+		auto const run_count = std::min<std::size_t>(header_[run_count_field], words);
+		runs_ = counts_ + blocks + 1;
+		auto const expected = header_bytes + (blocks + 1 + run_count * 2) * sizeof(std::uint64_t);
+		auto why = static_cast<const char*>(nullptr);
+		if (header_[magic_field] != magic) {
+			why = "not an index file";
+		}
+		else if (header_[version_field] != version || header_[block_size_field] != block_size) {
+			why = "unsupported version";
+		}
+		else if (expected != mapping_size_ || blocks != header_[block_count_field]
+		         || header_[size_field] != counts_[blocks])
+		{
+			why = "truncated or corrupt file";
+		}
+		if (why != nullptr) {
+			::munmap(const_cast<void*>(mapping_), mapping_size_);
+			throw fail(why);
+		}
+	}
+
+	mapped_index::mapped_index(mapped_index&& other) noexcept
+	: mapping_(other.mapping_)
+	, mapping_size_(other.mapping_size_)
+	, header_(other.header_)
+	, counts_(other.counts_)
+	, runs_(other.runs_) {
+		other.mapping_ = nullptr;
+		other.mapping_size_ = 0;
+	}
+
+	auto mapped_index::operator=(mapped_index&& other) noexcept -> mapped_index& {
+		if (this != &other) {
+			if (mapping_ != nullptr) {
+				::munmap(const_cast<void*>(mapping_), mapping_size_);
+			}
+			mapping_ = other.mapping_;
+			mapping_size_ = other.mapping_size_;
+			header_ = other.header_;
+			counts_ = other.counts_;
+			runs_ = other.runs_;
+			other.mapping_ = nullptr;
+			other.mapping_size_ = 0;
+		}
+		return *this;
+	}
+
+	mapped_index::~mapped_index() {
+		if (mapping_ != nullptr) {
+			::munmap(const_cast<void*>(mapping_), mapping_size_);
+		}
+	}
+
+	auto mapped_index::checksum() const -> std::uint64_t {
+		return header_[checksum_field];
+	}
+
+	auto mapped_index::sample_checksum() const -> std::uint64_t {
+		return header_[sample_field];
+	}
+
+	auto mapped_index::predicate_id() const -> std::uint64_t {
+		return header_[predicate_field];
+	}
+
+	auto mapped_index::length() const -> std::size_t {
+		return header_[length_field];
+	}
+
+	auto mapped_index::size() const -> std::size_t {
+		return header_[size_field];
+	}
+
+	auto mapped_index::block_count() const -> std::size_t {
+		return header_[block_count_field];
+	}
+
+	auto mapped_index::accepted_before(std::size_t block) const -> std::size_t {
+		return counts_[std::min(block, block_count())];
+	}
+
+	auto mapped_index::runs() const -> std::span<const std::uint64_t> {
+		return {runs_, header_[run_count_field] * 2};
+	}
+
+	auto mapped_index::matches(const filtered_string_view& fsv,
+	                           std::string_view predicate_name,
+	                           index_check check) const -> bool {
+		if (length() != fsv.length() || predicate_id() != fsv::predicate_id(predicate_name)
+		    || sample_checksum() != fsv::sample_checksum(fsv.data(), fsv.length()))
+		{
+			return false;
+		}
+		return check == index_check::sampled || checksum() == content_checksum(fsv.data(), fsv.length());
+	}
+
+	auto mapped_index::position(const filtered_string_view& fsv, std::size_t index) const -> std::size_t {
+		if (index >= size()) {
+			throw std::out_of_range{"mapped_index::position(" + std::to_string(index) + "): invalid index"};
+		}
+		auto const next = std::upper_bound(counts_, counts_ + block_count() + 1, index);
+		auto const block = static_cast<std::size_t>(next - counts_) - 1;
+		auto count = counts_[block];
+		for (auto i = block * block_size;; ++i) {
+			if (fsv.predicate()(fsv.data()[i]) && count++ == index) {
+				return i;
+			}
+		}
+	}
+} // namespace fsv
@@ -0,0 +1,93 @@
+#ifndef COMP6771_ASS2_INDEX_FILE_H
+#define COMP6771_ASS2_INDEX_FILE_H
+
+#include "./filtered_string_view.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace fsv {
+	// Sidecar files holding a view's accepted-position index, so a restarted process can map it instead of
+	// rescanning the input. Layout (host byte order, every field 8-byte aligned):
+	//
+	//   header     magic, version, block size, content checksum, sample checksum, predicate id, raw length,
+	//              accepted count, block count, run count
+	//   counts     block count + 1 cumulative accepted counts, one per block boundary
+	//   runs       run count [first, last) raw offset pairs of accepted runs; only written when the runs take
+	//              less room than a bitmap of the input would, otherwise run count is zero
+	//
+	// A file is keyed by the checksum of the raw bytes and by an identifier naming the predicate, since the
+	// predicate itself cannot be stored.
+	//
+	// Checking the whole checksum reads every byte of the input, which would cost as much as the scan the
+	// index saves, so by default only the length and a checksum of bytes sampled across the input are
+	// compared. That catches a different or resized input, but not an edit between samples; pass
+	// index_check::full where inputs may be modified in place.
+	enum class index_check { sampled, full };
+
+	class mapped_index {
+	 public:
+		static constexpr std::uint64_t magic = 0x5845444e49565346; // "FSVINDEX"
+		static constexpr std::uint32_t version = 2;
+		static constexpr std::size_t block_size = std::size_t{1} << 16U;
+
+		// maps path read-only; throws std::runtime_error if it is missing or not a valid index
+		explicit mapped_index(const std::string& path);
+		mapped_index(mapped_index&& other) noexcept;
+		auto operator=(mapped_index&& other) noexcept -> mapped_index&;
+		mapped_index(const mapped_index&) = delete;
+		auto operator=(const mapped_index&) -> mapped_index& = delete;
+		~mapped_index();
+
+		auto checksum() const -> std::uint64_t;
+		auto sample_checksum() const -> std::uint64_t;
+		auto predicate_id() const -> std::uint64_t;
+		auto length() const -> std::size_t;
+		// accepted characters in the whole view
+		auto size() const -> std::size_t;
+		auto block_count() const -> std::size_t;
+		// accepted characters in blocks before block
+		auto accepted_before(std::size_t block) const -> std::size_t;
+		// flattened [first, last) pairs; empty if the file holds no runs
+		auto runs() const -> std::span<const std::uint64_t>;
+
+		// true if this index was written for fsv's bytes under predicate_name, as far as check can tell
+		auto matches(const filtered_string_view& fsv,
+		             std::string_view predicate_name,
+		             index_check check = index_check::sampled) const -> bool;
+		// raw offset of the index-th accepted character of fsv, using the block counts to skip ahead
+		auto position(const filtered_string_view& fsv, std::size_t index) const -> std::size_t;
+
+	 private:
+		const void* mapping_;
+		std::size_t mapping_size_;
+		const std::uint64_t* header_;
+		const std::uint64_t* counts_;
+		const std::uint64_t* runs_;
+	};
+
+	// checksum of raw bytes used to key index files
+	auto content_checksum(const char* data, std::size_t length) -> std::uint64_t;
+	// checksum of the length and of at most 64 evenly spaced 64-byte samples, the first and last included
+	auto sample_checksum(const char* data, std::size_t length) -> std::uint64_t;
+	auto predicate_id(std::string_view predicate_name) -> std::uint64_t;
+
+	// scans fsv once and writes its index to path. The file is written under a unique name beside path and
+	// renamed over it, so a process that has the old index mapped keeps reading the old contents, and
+	// processes writing the same index at once leave one of their files whole.
+	auto write_index(const std::string& path, const filtered_string_view& fsv, std::string_view predicate_name)
+	    -> void;
+
+	// maps the index at path if it exists, is valid, has this version and was written for fsv under
+	// predicate_name; anything else is stale and gives nullopt
+	auto load_index(const std::string& path,
+	                const filtered_string_view& fsv,
+	                std::string_view predicate_name,
+	                index_check check = index_check::sampled) -> std::optional<mapped_index>;
+} // namespace fsv
+
+#endif // COMP6771_ASS2_INDEX_FILE_H
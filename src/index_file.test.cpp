@@ -0,0 +1,152 @@
+#include "./index_file.h"
+
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	auto corpus() -> std::string {
+		auto result = std::string();
+		for (auto i = 0; i < 30000; ++i) {
+			result += "id=" + std::to_string(i) + ";";
+		}
+		return result;
+	}
+} // namespace
+
+TEST_CASE("index files round-trip through mmap") {
+	auto const path = std::string("fsv_index_test.idx");
+	auto const text = corpus();
+	auto const digits = fsv::filtered_string_view{text, fsv::char_class::range('0', '9')};
+	fsv::write_index(path, digits, "digits");
+
+	auto const index = fsv::mapped_index(path);
+	REQUIRE(index.length() == text.size());
+	REQUIRE(index.size() == digits.size());
+	REQUIRE(index.block_count() == (text.size() + fsv::mapped_index::block_size - 1) / fsv::mapped_index::block_size);
+	REQUIRE(index.accepted_before(0) == 0);
+	REQUIRE(index.accepted_before(1)
+	        == fsv::filtered_string_view(text.data(), fsv::mapped_index::block_size, *digits.table()).size());
+	REQUIRE(index.accepted_before(index.block_count()) == digits.size());
+	REQUIRE(index.matches(digits, "digits"));
+	REQUIRE(!index.matches(digits, "letters"));
+
+	auto const materialized = static_cast<std::string>(digits);
+	for (auto i = std::size_t{0}; i < materialized.size(); i += 997) {
+		REQUIRE(text[index.position(digits, i)] == materialized[i]);
+	}
+	REQUIRE_THROWS_AS(index.position(digits, materialized.size()), std::out_of_range);
+
+	// the digit runs outnumber what a bitmap would cost, so none are stored
+	REQUIRE(index.runs().empty());
+	std::remove(path.c_str());
+}
+
+TEST_CASE("index files keep compact run lists") {
+	auto const path = std::string("fsv_index_runs.idx");
+	auto const text = std::string(1000, '#') + std::string(200000, 'a') + std::string(50, '#') + "bb";
+	auto const body = fsv::filtered_string_view{text, [](const char& c) { return c != '#'; }};
+	fsv::write_index(path, body, "body");
+
+	auto const index = fsv::load_index(path, body, "body");
+	REQUIRE(index.has_value());
+	REQUIRE(index->size() == 200002);
+	auto const runs = index->runs();
+	REQUIRE(runs.size() == 4);
+	REQUIRE(runs[0] == 1000);
+	REQUIRE(runs[1] == 201000);
+	REQUIRE(runs[2] == 201050);
+	REQUIRE(runs[3] == text.size());
+	std::remove(path.c_str());
+}
+
+TEST_CASE("stale or invalid index files are rejected") {
+	auto const path = std::string("fsv_index_stale.idx");
+	auto text = corpus();
+	auto const view = fsv::filtered_string_view{text, fsv::char_class("=")};
+	REQUIRE(!fsv::load_index(path, view, "equals").has_value());
+
+	fsv::write_index(path, view, "equals");
+	REQUIRE(fsv::load_index(path, view, "equals", fsv::index_check::full).has_value());
+	auto const first = text[10];
+	text[10] = 'x';
+	REQUIRE(!fsv::load_index(path, view, "equals").has_value());
+
+	// a byte between the sampled ones is only noticed by a full check
+	text[10] = first;
+	text[text.size() / 2] = '#';
+	REQUIRE(fsv::load_index(path, view, "equals").has_value());
+	REQUIRE(!fsv::load_index(path, view, "equals", fsv::index_check::full).has_value());
+
+	{
+		auto out = std::ofstream(path, std::ios::binary | std::ios::trunc);
+		out << "definitely not an index, but long enough to have a full header in it";
+	}
+	REQUIRE_THROWS_AS(fsv::mapped_index(path), std::runtime_error);
+	REQUIRE(!fsv::load_index(path, view, "equals").has_value());
+
+	// cut short, as a file copied or written by something else might be
+	fsv::write_index(path, view, "equals");
+	std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+	REQUIRE(!fsv::load_index(path, view, "equals").has_value());
+	std::remove(path.c_str());
+	REQUIRE_THROWS_AS(fsv::mapped_index(path), std::runtime_error);
+}
+
+TEST_CASE("rewriting an index leaves existing mappings intact") {
+	auto const path = std::string("fsv_index_rewrite.idx");
+	auto const text = corpus();
+	auto const digits = fsv::filtered_string_view{text, fsv::char_class::range('0', '9')};
+	auto const equals = fsv::filtered_string_view{text, fsv::char_class("=")};
+	fsv::write_index(path, digits, "digits");
+	auto const before = fsv::mapped_index(path);
+
+	fsv::write_index(path, equals, "equals");
+	REQUIRE(before.matches(digits, "digits"));
+	REQUIRE(before.accepted_before(before.block_count()) == digits.size());
+	auto const after = fsv::load_index(path, equals, "equals");
+	REQUIRE(after.has_value());
+	REQUIRE(after->size() == equals.size());
+	std::remove(path.c_str());
+}
+
+TEST_CASE("writers of the same index do not interleave") {
+	auto const path = std::string("fsv_index_concurrent.idx");
+	auto const text = corpus();
+	auto const digits = fsv::filtered_string_view{text, fsv::char_class::range('0', '9')};
+	auto writers = std::vector<std::thread>();
+	for (auto i = 0; i < 4; ++i) {
+		writers.emplace_back([&] {
+			for (auto n = 0; n < 10; ++n) {
+				fsv::write_index(path, digits, "digits");
+			}
+		});
+	}
+	for (auto& writer : writers) {
+		writer.join();
+	}
+	auto const index = fsv::load_index(path, digits, "digits", fsv::index_check::full);
+	REQUIRE(index.has_value());
+	REQUIRE(index->accepted_before(index->block_count()) == digits.size());
+	// no temporary file is left beside it
+	for (auto const& entry : std::filesystem::directory_iterator(".")) {
+		auto const name = entry.path().filename().string();
+		REQUIRE((name == path || !name.starts_with(path)));
+	}
+	std::remove(path.c_str());
+}
+
+TEST_CASE("content checksums depend on every byte") {
+	auto const text = corpus();
+	auto const whole = fsv::content_checksum(text.data(), text.size());
+	REQUIRE(whole == fsv::content_checksum(text.data(), text.size()));
+	REQUIRE(whole != fsv::content_checksum(text.data(), text.size() - 1));
+	REQUIRE(fsv::content_checksum("", 0) != fsv::content_checksum("a", 1));
+	REQUIRE(fsv::predicate_id("digits") != fsv::predicate_id("letters"));
+	REQUIRE(fsv::sample_checksum(text.data(), text.size()) != fsv::sample_checksum(text.data(), text.size() - 1));
+	REQUIRE(fsv::sample_checksum("abc", 3) == fsv::content_checksum("abc", 3));
+}
@@ -0,0 +1,91 @@
+#include "./char_class.h"
+#include "./filtered_string_view.h"
+#include "./intern_table.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Interns dash-separated header names with the dashes filtered out, as a tokenizer would, through a
+// std::unordered_map that needs each view materialized and through intern_table, on one thread and several.
+//
+//   intern_table_bench [millions of tokens] [distinct tokens]
+namespace {
+	using clock = std::chrono::steady_clock;
+
+	auto seconds_since(clock::time_point start) -> double {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	auto report(const char* name, std::size_t tokens, double seconds, std::size_t checksum) -> void {
+		std::cout << std::left << std::setw(28) << name << std::right << std::setw(10)
+		          << static_cast<double>(tokens) / seconds / 1e6 << " Mtokens/s  (" << checksum << ")\n";
+	}
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+	auto const tokens = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10) * 1000000;
+	auto const distinct = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100000;
+	auto names = std::vector<std::string>();
+	for (auto i = std::size_t{0}; i < distinct; ++i) {
+		names.push_back("X-Request-Field-" + std::to_string(i * 2654435761 % 1000003));
+	}
+	// views are built up front, since building one costs the same whichever way it is interned
+	auto const dashes = ~fsv::char_class("-");
+	auto views = std::vector<fsv::filtered_string_view>();
+	for (auto const& name : names) {
+		views.emplace_back(name, dashes);
+	}
+	auto order = std::vector<std::uint32_t>();
+	auto state = std::uint64_t{1};
+	for (auto i = std::size_t{0}; i < tokens; ++i) {
+		state = state * 6364136223846793005 + 1442695040888963407;
+		order.push_back(static_cast<std::uint32_t>((state >> 33U) % distinct));
+	}
+	std::cout << std::fixed << std::setprecision(1);
+
+	{
+		auto const start = clock::now();
+		auto symbols = std::unordered_map<std::string, std::uint32_t>();
+		auto checksum = std::size_t{0};
+		for (auto const i : order) {
+			checksum += symbols.try_emplace(static_cast<std::string>(views[i]), symbols.size()).first->second;
+		}
+		report("unordered_map<string>", tokens, seconds_since(start), checksum);
+	}
+	{
+		auto const start = clock::now();
+		auto table = fsv::intern_table();
+		auto checksum = std::size_t{0};
+		for (auto const i : order) {
+			checksum += table.intern(views[i]);
+		}
+		report("intern_table", tokens, seconds_since(start), checksum);
+	}
+	{
+		auto const threads = std::max(2U, std::thread::hardware_concurrency());
+		auto const start = clock::now();
+		auto table = fsv::intern_table();
+		auto workers = std::vector<std::thread>();
+		for (auto t = 0U; t < threads; ++t) {
+			workers.emplace_back([&table, &views, &order, t, threads] {
+				for (auto i = std::size_t{t}; i < order.size(); i += threads) {
+					table.intern(views[order[i]]);
+				}
+			});
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+		auto const name = "intern_table, " + std::to_string(threads) + " threads";
+		report(name.c_str(), tokens, seconds_since(start), table.size());
+	}
+	return 0;
+}
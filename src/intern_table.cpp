@@ -0,0 +1,305 @@
+#include "./intern_table.h"
+#include "./hash.h"
+#include "./strategy.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#	include <immintrin.h>
+#endif
+
+namespace fsv {
+	namespace {
+		// arena chunk size; longer strings get a chunk of their own
+		constexpr auto chunk_size = std::size_t{64} * 1024;
+
+		auto tag_of(std::uint64_t hash) -> std::uint64_t {
+			return 0x80U | (hash >> 57U);
+		}
+
+		// bit i is set if byte i of the 16 control bytes in low and high is byte
+		auto match(std::uint64_t low, std::uint64_t high, std::uint64_t byte) -> std::uint32_t {
+#if defined(__SSE2__)
+			auto const group = _mm_set_epi64x(static_cast<long long>(high), static_cast<long long>(low));
+			auto const equal = _mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(byte)));
+			return static_cast<std::uint32_t>(_mm_movemask_epi8(equal));
+#else
+			auto result = std::uint32_t{0};
+			for (auto i = 0U; i < 8; ++i) {
+				result |= static_cast<std::uint32_t>(((low >> (8 * i)) & 0xffU) == byte) << i;
+				result |= static_cast<std::uint32_t>(((high >> (8 * i)) & 0xffU) == byte) << (i + 8);
+			}
+			return result;
+#endif
+		}
+
+		auto same(std::string_view candidate, std::string_view key) -> bool {
+			return candidate == key;
+		}
+
+		auto same(std::string_view candidate, const filtered_string_view& key) -> bool {
+			return equals(key, candidate);
+		}
+
+		auto max_symbols() -> std::uint64_t {
+			return std::uint64_t{std::numeric_limits<std::uint32_t>::max()} + 1;
+		}
+
+		// the segment holding a symbol and its offset in it
+		auto segment_of(std::size_t id, std::size_t first_segment) -> std::pair<std::size_t, std::size_t> {
+			auto const k = static_cast<std::size_t>(std::bit_width(id / first_segment + 1)) - 1;
+			return {k, id - first_segment * ((std::size_t{1} << k) - 1)};
+		}
+	} // namespace
+
+	intern_table::table::table(std::size_t groups)
+	: mask(groups - 1)
+	, groups(std::make_unique<group[]>(groups)) {}
+
+	intern_table::intern_table(std::size_t shards)
+	: shards_(std::make_unique<shard[]>(std::bit_ceil(std::max(shards, std::size_t{1}))))
+	, shard_mask_(std::bit_ceil(std::max(shards, std::size_t{1})) - 1)
+	, segments_()
+	, next_symbol_(0)
+	, size_(0) {
+		for (auto i = std::size_t{0}; i <= shard_mask_; ++i) {
+			auto& s = shards_[i];
+			s.tables.push_back(std::make_unique<table>(1));
+			s.current.store(s.tables.back().get(), std::memory_order_relaxed);
+			s.count = 0;
+			s.next = nullptr;
+			s.left = 0;
+		}
+	}
+
+	intern_table::~intern_table() {
+		for (auto& segment : segments_) {
+			delete[] segment.load(std::memory_order_relaxed);
+		}
+	}
+
+	auto intern_table::intern(const filtered_string_view& fsv) -> symbol {
+		// a view the reader returns in one run is interned as a string
+		if (fsv.unfiltered() || fsv.length() <= kernel::block_reader::block) {
+			auto reader = kernel::block_reader(fsv);
+			return intern(reader.next());
+		}
+		auto const hash = hash64(fsv);
+		if (auto const found = probe(*shard_of(hash).current.load(std::memory_order_acquire), fsv, hash)) {
+			return *found;
+		}
+		return insert(fsv, hash);
+	}
+
+	auto intern_table::intern(std::string_view str) -> symbol {
+		auto const hash = hash64(str.data(), str.size());
+		if (auto const found = probe(*shard_of(hash).current.load(std::memory_order_acquire), str, hash)) {
+			return *found;
+		}
+		return insert(str, hash);
+	}
+
+	auto intern_table::intern(const std::string& str) -> symbol {
+		return intern(std::string_view(str));
+	}
+
+	auto intern_table::intern(const char* str) -> symbol {
+		return intern(std::string_view(str));
+	}
+
+	auto intern_table::find(const filtered_string_view& fsv) const -> std::optional<symbol> {
+		if (fsv.unfiltered() || fsv.length() <= kernel::block_reader::block) {
+			auto reader = kernel::block_reader(fsv);
+			return find(reader.next());
+		}
+		auto const hash = hash64(fsv);
+		return probe(*shard_of(hash).current.load(std::memory_order_acquire), fsv, hash);
+	}
+
+	auto intern_table::find(std::string_view str) const -> std::optional<symbol> {
+		auto const hash = hash64(str.data(), str.size());
+		return probe(*shard_of(hash).current.load(std::memory_order_acquire), str, hash);
+	}
+
+	auto intern_table::find(const std::string& str) const -> std::optional<symbol> {
+		return find(std::string_view(str));
+	}
+
+	auto intern_table::find(const char* str) const -> std::optional<symbol> {
+		return find(std::string_view(str));
+	}
+
+	auto intern_table::operator[](symbol id) const -> std::string_view {
+		if (valid(id)) {
+			return stored(id);
+		}
+		throw std::out_of_range{"intern_table::operator[](" + std::to_string(id) + "): invalid symbol"};
+	}
+
+	auto intern_table::at(symbol id) const -> std::string_view {
+		if (valid(id)) {
+			return stored(id);
+		}
+		throw std::domain_error{"intern_table::at(" + std::to_string(id) + "): invalid symbol"};
+	}
+
+	auto intern_table::size() const -> std::size_t {
+		return size_.load(std::memory_order_acquire);
+	}
+
+	auto intern_table::empty() const -> bool {
+		return size() == 0;
+	}
+
+	auto intern_table::shard_of(std::uint64_t hash) const -> shard& {
+		return shards_[(hash >> 32U) & shard_mask_];
+	}
+
+	// Triangular steps between groups visit every group of a power-of-two table, and a table is never more
+	// than 7/8 full, so the probe meets an empty slot before it runs out of groups.
+	template<typename Key>
+	auto intern_table::probe(const table& t, const Key& key, std::uint64_t hash) const -> std::optional<symbol> {
+		auto const tag = tag_of(hash);
+		auto index = static_cast<std::size_t>(hash) & t.mask;
+		for (auto step = std::size_t{1};; ++step) {
+			auto const& g = t.groups[index];
+			// a slot's symbol is stored before its control byte is released
+			auto const low = g.control[0].load(std::memory_order_acquire);
+			auto const high = g.control[1].load(std::memory_order_acquire);
+			for (auto hits = match(low, high, tag); hits != 0; hits &= hits - 1) {
+				auto const slot = static_cast<std::size_t>(std::countr_zero(hits));
+				auto const id = g.symbols[slot].load(std::memory_order_relaxed);
+				if (same(stored(id), key)) {
+					return id;
+				}
+			}
+			if (match(low, high, 0) != 0) {
+				return std::nullopt;
+			}
+			index = (index + step) & t.mask;
+		}
+	}
+
+	template<typename Key>
+	auto intern_table::insert(const Key& key, std::uint64_t hash) -> symbol {
+		auto& s = shard_of(hash);
+		auto const lock = std::lock_guard<std::mutex>(s.mutex);
+		// another writer may have added it, or grown the table, since the lock-free probe
+		if (auto const found = probe(*s.current.load(std::memory_order_relaxed), key, hash)) {
+			return *found;
+		}
+		auto const next = next_symbol_.fetch_add(1, std::memory_order_relaxed);
+		if (next >= max_symbols()) {
+			throw std::length_error{"intern_table::intern(): more than 2^32 symbols"};
+		}
+		auto const id = static_cast<symbol>(next);
+
+		auto str = std::string_view();
+		if constexpr (std::is_same_v<Key, std::string_view>) {
+			auto const data = reserve(s, key.size());
+			std::copy(key.begin(), key.end(), data);
+			str = std::string_view(data, key.size());
+		}
+		else {
+			// written straight into the arena, giving back what the filter rejected if it can
+			auto const data = reserve(s, key.length());
+			auto const end = kernel::write(key, kernel::sequential(key), data);
+			str = std::string_view(data, static_cast<std::size_t>(end - data));
+			if (s.next == data + key.length()) {
+				s.next = end;
+				s.left += key.length() - str.size();
+			}
+		}
+		entry(id) = str;
+
+		auto const capacity = (s.current.load(std::memory_order_relaxed)->mask + 1) * group_size;
+		if ((s.count + 1) * 8 > capacity * 7) {
+			grow(s);
+		}
+		place(*s.current.load(std::memory_order_relaxed), id, hash);
+		++s.count;
+		size_.fetch_add(1, std::memory_order_release);
+		return id;
+	}
+
+	auto intern_table::place(table& t, symbol id, std::uint64_t hash) -> void {
+		auto index = static_cast<std::size_t>(hash) & t.mask;
+		for (auto step = std::size_t{1};; ++step) {
+			auto& g = t.groups[index];
+			auto const low = g.control[0].load(std::memory_order_relaxed);
+			auto const high = g.control[1].load(std::memory_order_relaxed);
+			if (auto const empty = match(low, high, 0); empty != 0) {
+				auto const slot = static_cast<std::size_t>(std::countr_zero(empty));
+				g.symbols[slot].store(id, std::memory_order_relaxed);
+				auto& word = g.control[slot / 8];
+				auto const shift = 8 * (slot % 8);
+				word.store(word.load(std::memory_order_relaxed) | (tag_of(hash) << shift), std::memory_order_release);
+				return;
+			}
+			index = (index + step) & t.mask;
+		}
+	}
+
+	// The old table is kept, not freed, since lock-free readers may still be probing it; the tables of a
+	// shard double in size, so together the old ones take less memory than the current one.
+	auto intern_table::grow(shard& s) -> void {
+		auto const& old = *s.current.load(std::memory_order_relaxed);
+		auto bigger = std::make_unique<table>(2 * (old.mask + 1));
+		for (auto index = std::size_t{0}; index <= old.mask; ++index) {
+			auto const& g = old.groups[index];
+			for (auto slot = std::size_t{0}; slot < group_size; ++slot) {
+				if (((g.control[slot / 8].load(std::memory_order_relaxed) >> (8 * (slot % 8))) & 0xffU) != 0) {
+					auto const id = g.symbols[slot].load(std::memory_order_relaxed);
+					auto const str = stored(id);
+					place(*bigger, id, hash64(str.data(), str.size()));
+				}
+			}
+		}
+		s.current.store(bigger.get(), std::memory_order_release);
+		s.tables.push_back(std::move(bigger));
+	}
+
+	auto intern_table::reserve(shard& s, std::size_t length) -> char* {
+		if (length > s.left) {
+			if (length > chunk_size / 4) {
+				s.chunks.push_back(std::make_unique<char[]>(length));
+				return s.chunks.back().get();
+			}
+			s.chunks.push_back(std::make_unique<char[]>(chunk_size));
+			s.next = s.chunks.back().get();
+			s.left = chunk_size;
+		}
+		auto const result = s.next;
+		s.next += length;
+		s.left -= length;
+		return result;
+	}
+
+	// segments are allocated by whichever writer first needs one; a writer that loses the race frees its own
+	auto intern_table::entry(symbol id) -> std::string_view& {
+		auto const [k, offset] = segment_of(id, first_segment);
+		auto segment = segments_[k].load(std::memory_order_acquire);
+		if (segment == nullptr) {
+			auto fresh = std::make_unique<std::string_view[]>(first_segment << k);
+			if (segments_[k].compare_exchange_strong(segment, fresh.get(), std::memory_order_acq_rel)) {
+				segment = fresh.release();
+			}
+		}
+		return segment[offset];
+	}
+
+	auto intern_table::stored(symbol id) const -> std::string_view {
+		auto const [k, offset] = segment_of(id, first_segment);
+		return segments_[k].load(std::memory_order_acquire)[offset];
+	}
+
+	auto intern_table::valid(symbol id) const -> bool {
+		return id < next_symbol_.load(std::memory_order_acquire)
+		       && segments_[segment_of(id, first_segment).first].load(std::memory_order_acquire) != nullptr;
+	}
+} // namespace fsv
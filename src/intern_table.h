@@ -0,0 +1,117 @@
+#ifndef COMP6771_ASS2_INTERN_TABLE_H
+#define COMP6771_ASS2_INTERN_TABLE_H
+
+#include "./filtered_string_view.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fsv {
+	// Deduplicates strings into dense 32-bit symbols, numbered from 0 in the order they were first interned.
+	// Views are interned by their accepted characters without building a std::string: short views are
+	// compacted onto the stack by the view's kernels, and long ones hashed and compared a block at a time.
+	//
+	// The strings live in append-only arenas and never move, so the string_views handed out stay valid for
+	// the life of the table. Symbols are found through open-addressed hash tables whose 16-slot groups of
+	// control bytes are probed with one SSE2 compare each.
+	//
+	// Any number of threads may intern and look up concurrently. Lookups take no lock. The table is split
+	// into shards by hash, and an insertion locks only its own shard; a shard that outgrows its hash table
+	// publishes a larger one and keeps the old one, which readers may still be probing, until destruction.
+	class intern_table {
+	 public:
+		using symbol = std::uint32_t;
+
+		// shards is rounded up to a power of two
+		explicit intern_table(std::size_t shards = 16);
+
+		intern_table(const intern_table&) = delete;
+		auto operator=(const intern_table&) -> intern_table& = delete;
+
+		~intern_table();
+
+		// the symbol of the accepted characters, added if they have not been seen. Throws std::length_error
+		// once 2^32 symbols have been handed out.
+		auto intern(const filtered_string_view& fsv) -> symbol;
+		// the std::string and const char* overloads only settle which conversion applies
+		auto intern(std::string_view str) -> symbol;
+		auto intern(const std::string& str) -> symbol;
+		auto intern(const char* str) -> symbol;
+
+		// the symbol of the accepted characters, if they have been interned
+		auto find(const filtered_string_view& fsv) const -> std::optional<symbol>;
+		auto find(std::string_view str) const -> std::optional<symbol>;
+		auto find(const std::string& str) const -> std::optional<symbol>;
+		auto find(const char* str) const -> std::optional<symbol>;
+
+		// the string of a symbol returned by this table
+		auto operator[](symbol id) const -> std::string_view;
+		auto at(symbol id) const -> std::string_view;
+
+		auto size() const -> std::size_t;
+		auto empty() const -> bool;
+
+	 private:
+		// slots per group of control bytes
+		static constexpr std::size_t group_size = 16;
+		// symbols in the first segment; each later segment is twice the size of the one before
+		static constexpr std::size_t first_segment = 1024;
+
+		// A zero control byte is an empty slot, and a full one holds 0x80 | seven bits of the hash. They are
+		// kept in words of eight, so that a group is read with two atomic loads, next to the symbols of their
+		// slots, so that a hit usually costs one cache miss.
+		struct group {
+			std::array<std::atomic<std::uint64_t>, 2> control;
+			std::array<std::atomic<symbol>, group_size> symbols;
+		};
+
+		struct table {
+			explicit table(std::size_t groups);
+
+			std::size_t mask;
+			std::unique_ptr<group[]> groups;
+		};
+
+		struct alignas(64) shard {
+			std::mutex mutex;
+			std::atomic<table*> current;
+			// the remaining members are only touched by writers holding the mutex
+			std::vector<std::unique_ptr<table>> tables;
+			std::size_t count;
+			std::vector<std::unique_ptr<char[]>> chunks;
+			char* next;
+			std::size_t left;
+		};
+
+		std::unique_ptr<shard[]> shards_;
+		std::size_t shard_mask_;
+		// segment k holds the strings of symbols first_segment * (2^k - 1) onwards
+		std::array<std::atomic<std::string_view*>, 32> segments_;
+		std::atomic<std::uint64_t> next_symbol_;
+		std::atomic<std::size_t> size_;
+
+		auto shard_of(std::uint64_t hash) const -> shard&;
+		// Key is a std::string_view, or a filtered_string_view too long to compact on the stack
+		template<typename Key>
+		auto probe(const table& t, const Key& key, std::uint64_t hash) const -> std::optional<symbol>;
+		template<typename Key>
+		auto insert(const Key& key, std::uint64_t hash) -> symbol;
+		static auto place(table& t, symbol id, std::uint64_t hash) -> void;
+		auto grow(shard& s) -> void;
+		auto reserve(shard& s, std::size_t length) -> char*;
+		auto entry(symbol id) -> std::string_view&;
+		// the string of a symbol already placed in a table
+		auto stored(symbol id) const -> std::string_view;
+		auto valid(symbol id) const -> bool;
+	};
+} // namespace fsv
+
+#endif // COMP6771_ASS2_INTERN_TABLE_H
@@ -0,0 +1,130 @@
+#include "./intern_table.h"
+#include "./char_class.h"
+
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	auto token(std::size_t i) -> std::string {
+		return "field_" + std::to_string(i * 7919 % 100003);
+	}
+} // namespace
+
+TEST_CASE("intern hands out dense symbols in first-seen order") {
+	auto table = fsv::intern_table();
+	REQUIRE(table.empty());
+	REQUIRE(table.intern("host") == 0);
+	REQUIRE(table.intern(std::string("accept")) == 1);
+	REQUIRE(table.intern(std::string_view("host")) == 0);
+	REQUIRE(table.intern("") == 2);
+	REQUIRE(table.intern(std::string()) == 2);
+	REQUIRE(table.size() == 3);
+	REQUIRE(table[0] == "host");
+	REQUIRE(table.at(1) == "accept");
+	REQUIRE(table[2].empty());
+	REQUIRE(table.find("accept") == 1);
+	REQUIRE_FALSE(table.find("Accept").has_value());
+	REQUIRE_THROWS_AS(table[3], std::out_of_range);
+	REQUIRE_THROWS_AS(table.at(3), std::domain_error);
+}
+
+TEST_CASE("views are interned by their accepted characters") {
+	auto table = fsv::intern_table();
+	auto const letters = fsv::char_class::range('a', 'z');
+	auto const text = std::string("x-forwarded-for");
+	auto const id = table.intern(fsv::filtered_string_view(text, letters));
+	REQUIRE(table[id] == "xforwardedfor");
+	REQUIRE(table.intern("xforwardedfor") == id);
+	REQUIRE(table.intern(fsv::filtered_string_view("x_forwarded_for", [](const char& c) { return c != '_'; })) == id);
+	REQUIRE(table.intern(fsv::filtered_string_view(text, fsv::char_class::all())) != id);
+	REQUIRE(table.find(fsv::filtered_string_view("x forwarded for", letters)) == id);
+	REQUIRE_FALSE(table.find(fsv::filtered_string_view("x forwarded", letters)).has_value());
+	REQUIRE(table.intern(fsv::filtered_string_view("---", letters)) == table.intern(""));
+}
+
+TEST_CASE("views too long to compact on the stack are interned in place") {
+	auto table = fsv::intern_table();
+	auto text = std::string();
+	auto dense = std::string();
+	for (auto i = 0; i < 30000; ++i) {
+		auto const c = static_cast<char>('a' + i % 26);
+		text += c;
+		text += ' ';
+		dense += c;
+	}
+	auto const spaces = ~fsv::char_class(" ");
+	auto const id = table.intern(fsv::filtered_string_view(text, spaces));
+	REQUIRE(table[id] == dense);
+	REQUIRE(table.intern(dense) == id);
+	REQUIRE(table.find(fsv::filtered_string_view(text, spaces)) == id);
+	REQUIRE(table.intern(fsv::filtered_string_view(text, [](const char& c) { return c != ' '; })) == id);
+	// it was written into a chunk of its own, which later strings leave alone
+	REQUIRE(table[table.intern("after")] == "after");
+	REQUIRE(table[id] == dense);
+}
+
+TEST_CASE("intern_table keeps its symbols as its hash tables grow") {
+	for (auto const shards : {std::size_t{1}, std::size_t{3}, std::size_t{16}}) {
+		auto table = fsv::intern_table(shards);
+		for (auto i = std::size_t{0}; i < 50000; ++i) {
+			REQUIRE(table.intern(token(i)) == i);
+		}
+		INFO(shards << " shards");
+		REQUIRE(table.size() == 50000);
+		auto consistent = true;
+		for (auto i = std::size_t{0}; i < 50000; ++i) {
+			auto const id = static_cast<fsv::intern_table::symbol>(i);
+			consistent = consistent && table.find(token(i)) == id && table[id] == token(i);
+		}
+		REQUIRE(consistent);
+		REQUIRE_FALSE(table.find("field_").has_value());
+	}
+}
+
+TEST_CASE("concurrent writers agree on symbols while readers look them up") {
+	auto table = fsv::intern_table(4);
+	auto constexpr count = std::size_t{20000};
+	auto constexpr writers = 4;
+	auto ids = std::vector<std::vector<fsv::intern_table::symbol>>(writers);
+	// Catch2 assertions are not thread-safe, so the threads only record what they saw
+	auto reader_consistent = std::atomic<bool>(true);
+	auto done = std::atomic<bool>(false);
+	auto reader = std::thread([&] {
+		while (!done.load()) {
+			for (auto i = std::size_t{0}; i < count; i += 97) {
+				if (auto const id = table.find(token(i)); id.has_value() && table[*id] != token(i)) {
+					reader_consistent = false;
+				}
+			}
+		}
+	});
+	auto threads = std::vector<std::thread>();
+	for (auto w = 0; w < writers; ++w) {
+		threads.emplace_back([&table, &ids, w] {
+			// each writer starts at a different point, so every token is raced for
+			auto const first = 5000 * static_cast<std::size_t>(w);
+			for (auto i = std::size_t{0}; i < count; ++i) {
+				ids[static_cast<std::size_t>(w)].push_back(table.intern(token((i + first) % count)));
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	done = true;
+	reader.join();
+
+	REQUIRE(reader_consistent);
+	REQUIRE(table.size() == count);
+	auto consistent = true;
+	for (auto w = std::size_t{0}; w < writers; ++w) {
+		for (auto i = std::size_t{0}; i < count; ++i) {
+			consistent = consistent && table[ids[w][i]] == token((i + 5000 * w) % count);
+		}
+	}
+	REQUIRE(consistent);
+}
@@ -0,0 +1,75 @@
+#include "./char_class.h"
+#include "./filtered_string_view.h"
+#include "./multi_match.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Compares one find() per keyword with a single multi_matcher pass as the number of keywords grows.
+//
+//   multi_match_bench [megabytes]
+namespace {
+	using clock = std::chrono::steady_clock;
+
+	auto seconds_since(clock::time_point start) -> double {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	auto sample_text(std::size_t length) -> std::string {
+		auto result = std::string();
+		result.reserve(length);
+		for (auto i = std::size_t{0}; result.size() < length; ++i) {
+			result += "ts=" + std::to_string(i * 7919 % 100000) + " lvl=info msg=request\tserved id" + std::to_string(i)
+			          + "\n";
+		}
+		result.resize(length);
+		return result;
+	}
+
+	auto keywords(std::size_t count) -> std::vector<std::string> {
+		auto result = std::vector<std::string>();
+		for (auto i = std::size_t{0}; i < count; ++i) {
+			// half of them occur in the text
+			result.push_back((i % 2 == 0 ? "id" : "kw") + std::to_string(i * 97) + "\n");
+		}
+		return result;
+	}
+
+	auto report(const std::string& name, std::size_t bytes, double seconds, std::size_t checksum) -> void {
+		std::cout << std::left << std::setw(32) << name << std::right << std::setw(10)
+		          << static_cast<double>(bytes) / seconds / 1e6 << " MB/s  (" << checksum << ")\n";
+	}
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+	auto const megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 8;
+	auto const text = sample_text(megabytes << 20U);
+	auto const view = fsv::filtered_string_view(text, ~fsv::char_class("\t"));
+	std::cout << std::fixed << std::setprecision(1);
+
+	for (auto const count : {std::size_t{10}, std::size_t{100}, std::size_t{1000}}) {
+		auto const patterns = keywords(count);
+		{
+			auto const start = clock::now();
+			auto found = std::size_t{0};
+			for (auto const& pattern : patterns) {
+				for (auto at = view.find(pattern); at != fsv::filtered_string_view::npos;
+				     at = view.find(pattern, at + 1)) {
+					++found;
+				}
+			}
+			report("find per keyword, " + std::to_string(count), text.size(), seconds_since(start), found);
+		}
+		{
+			auto const start = clock::now();
+			auto const matcher = fsv::multi_matcher(patterns);
+			auto const found = matcher.find_all(view).size();
+			report("multi_matcher, " + std::to_string(count), text.size(), seconds_since(start), found);
+		}
+	}
+	return 0;
+}
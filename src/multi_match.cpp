@@ -0,0 +1,222 @@
+#include "./multi_match.h"
+#include "./strategy.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace fsv {
+	namespace {
+		// dense tables of up to 4 MiB; past that the states are too many or the alphabet too large for a row
+		// per state to stay in cache
+		constexpr auto dense_limit = std::size_t{1} << 20U;
+
+		using edge_list = std::vector<std::pair<std::uint16_t, std::uint32_t>>;
+	} // namespace
+
+	multi_matcher::multi_matcher(const std::vector<std::string>& patterns)
+	: width_(1) {
+		// trie over input classes, with the patterns ending at each state
+		auto edges = std::vector<edge_list>(1);
+		auto own = std::vector<std::vector<std::uint32_t>>(1);
+		auto const child = [&](std::uint32_t s, std::uint16_t c) -> std::uint32_t {
+			for (auto const& [k, t] : edges[s]) {
+				if (k == c) {
+					return t;
+				}
+			}
+			return none;
+		};
+		for (auto const& pattern : patterns) {
+			if (pattern.empty()) {
+				throw std::domain_error{"multi_matcher(" + std::to_string(lengths_.size()) + "): empty pattern"};
+			}
+			auto s = std::uint32_t{0};
+			for (auto const ch : pattern) {
+				auto& c = classes_[static_cast<unsigned char>(ch)];
+				if (c == 0) {
+					c = static_cast<std::uint16_t>(width_++);
+				}
+				auto t = child(s, c);
+				if (t == none) {
+					t = static_cast<std::uint32_t>(edges.size());
+					edges.emplace_back();
+					own.emplace_back();
+					edges[s].emplace_back(c, t);
+				}
+				s = t;
+			}
+			own[s].push_back(static_cast<std::uint32_t>(lengths_.size()));
+			lengths_.push_back(pattern.size());
+		}
+
+		// failure links in breadth-first order, so a state's link is always resolved before its children's
+		auto const n = edges.size();
+		fail_.assign(n, 0);
+		auto order = std::vector<std::uint32_t>{0};
+		order.reserve(n);
+		for (auto i = std::size_t{0}; i < order.size(); ++i) {
+			auto const s = order[i];
+			std::sort(edges[s].begin(), edges[s].end());
+			for (auto const& [c, t] : edges[s]) {
+				if (s != 0) {
+					auto f = fail_[s];
+					while (f != 0 && child(f, c) == none) {
+						f = fail_[f];
+					}
+					auto const g = child(f, c);
+					fail_[t] = g == none ? 0 : g;
+				}
+				order.push_back(t);
+			}
+		}
+
+		first_id_.push_back(0);
+		for (auto const& ids : own) {
+			ids_.insert(ids_.end(), ids.begin(), ids.end());
+			first_id_.push_back(static_cast<std::uint32_t>(ids_.size()));
+		}
+		emit_.assign(n, none);
+		report_.assign(n, none);
+		for (auto const s : order) {
+			if (s != 0) {
+				report_[s] = emit_[fail_[s]];
+				emit_[s] = own[s].empty() ? report_[s] : s;
+			}
+		}
+
+		if (n * width_ <= dense_limit) {
+			// a state's row is its failure state's row with its own edges written over it
+			transitions_.assign(n * width_, 0);
+			for (auto const s : order) {
+				if (s != 0) {
+					std::copy_n(transitions_.begin() + static_cast<std::ptrdiff_t>(fail_[s] * width_),
+					            width_,
+					            transitions_.begin() + static_cast<std::ptrdiff_t>(s * width_));
+				}
+				for (auto const& [c, t] : edges[s]) {
+					transitions_[s * width_ + c] = t;
+				}
+			}
+			return;
+		}
+
+		// double array: each state's edges are placed at the first base where all their slots are free
+		base_.assign(n, 0);
+		auto first_free = std::size_t{1};
+		for (auto const s : order) {
+			auto const& out = edges[s];
+			if (out.empty()) {
+				continue;
+			}
+			while (first_free < check_.size() && check_[first_free] != none) {
+				++first_free;
+			}
+			auto b = first_free > out.front().first ? first_free - out.front().first : std::size_t{0};
+			for (;; ++b) {
+				if (check_.size() < b + width_) {
+					check_.resize(b + width_, none);
+					next_.resize(b + width_, 0);
+				}
+				auto const free = std::all_of(out.begin(), out.end(), [&](const auto& e) {
+					return check_[b + e.first] == none;
+				});
+				if (free) {
+					break;
+				}
+			}
+			base_[s] = static_cast<std::uint32_t>(b);
+			for (auto const& [c, t] : out) {
+				check_[b + c] = s;
+				next_[b + c] = t;
+			}
+		}
+		// leaves keep base 0, so slots [0, width_) must exist even if no state has edges there
+		if (check_.size() < width_) {
+			check_.resize(width_, none);
+			next_.resize(width_, 0);
+		}
+	}
+
+	auto multi_matcher::find_all(const filtered_string_view& fsv) const -> std::vector<match> {
+		return stream(*this).feed(fsv);
+	}
+
+	auto multi_matcher::patterns() const -> std::size_t {
+		return lengths_.size();
+	}
+
+	auto multi_matcher::states() const -> std::size_t {
+		return fail_.size();
+	}
+
+	auto multi_matcher::dense() const -> bool {
+		return !transitions_.empty();
+	}
+
+	auto multi_matcher::step(std::uint32_t state, std::uint16_t c) const -> std::uint32_t {
+		if (c == 0) {
+			return 0;
+		}
+		for (;;) {
+			auto const slot = base_[state] + c;
+			if (check_[slot] == state) {
+				return next_[slot];
+			}
+			if (state == 0) {
+				return 0;
+			}
+			state = fail_[state];
+		}
+	}
+
+	auto multi_matcher::scan(const char* data,
+	                         std::size_t length,
+	                         std::uint32_t& state,
+	                         std::size_t position,
+	                         std::vector<match>& out) const -> void {
+		auto const report = [&](std::uint32_t s, std::size_t end) {
+			for (auto t = emit_[s]; t != none; t = report_[t]) {
+				for (auto k = first_id_[t]; k < first_id_[t + 1]; ++k) {
+					out.push_back({ids_[k], end - lengths_[ids_[k]]});
+				}
+			}
+		};
+		auto s = state;
+		if (dense()) {
+			for (auto i = std::size_t{0}; i < length; ++i) {
+				s = transitions_[s * width_ + classes_[static_cast<unsigned char>(data[i])]];
+				if (emit_[s] != none) {
+					report(s, position + i + 1);
+				}
+			}
+		}
+		else {
+			for (auto i = std::size_t{0}; i < length; ++i) {
+				s = step(s, classes_[static_cast<unsigned char>(data[i])]);
+				if (emit_[s] != none) {
+					report(s, position + i + 1);
+				}
+			}
+		}
+		state = s;
+	}
+
+	multi_matcher::stream::stream(const multi_matcher& matcher)
+	: matcher_(&matcher)
+	, state_(0)
+	, position_(0) {}
+
+	auto multi_matcher::stream::feed(const filtered_string_view& chunk) -> std::vector<match> {
+		auto result = std::vector<match>();
+		kernel::for_each_block(chunk, [this, &result](std::string_view accepted) {
+			matcher_->scan(accepted.data(), accepted.size(), state_, position_, result);
+			position_ += accepted.size();
+			return true;
+		});
+		return result;
+	}
+
+	auto multi_matcher::stream::position() const -> std::size_t {
+		return position_;
+	}
+} // namespace fsv
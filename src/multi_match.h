@@ -0,0 +1,87 @@
+#ifndef COMP6771_ASS2_MULTI_MATCH_H
+#define COMP6771_ASS2_MULTI_MATCH_H
+
+#include "./filtered_string_view.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fsv {
+	struct match {
+		// index of the pattern in the list the matcher was built from
+		std::size_t pattern;
+		// index of the first matched accepted character
+		std::size_t offset;
+
+		friend auto operator==(const match&, const match&) -> bool = default;
+	};
+
+	// Finds every occurrence of many patterns in one pass over the accepted characters, using an Aho-Corasick
+	// automaton, so the cost per character does not grow with the number of patterns. Bytes that appear in no
+	// pattern share one input class. When the full transition table over the remaining classes is small it is
+	// stored densely and every character costs one lookup; otherwise only the trie's own edges are stored, in
+	// a double array, and failure links are followed at match time.
+	class multi_matcher {
+	 public:
+		// Throws std::domain_error if a pattern is empty.
+		explicit multi_matcher(const std::vector<std::string>& patterns);
+
+		// matches in the order they end; matches that end together are reported longest first
+		auto find_all(const filtered_string_view& fsv) const -> std::vector<match>;
+		auto patterns() const -> std::size_t;
+		auto states() const -> std::size_t;
+		// true if the transition table is stored densely
+		auto dense() const -> bool;
+
+		// Matches across a sequence of views as if they were one; offsets count the accepted characters of
+		// every chunk fed so far. The matcher must outlive the stream.
+		class stream {
+		 public:
+			explicit stream(const multi_matcher& matcher);
+			// matches that end in chunk, including those that start in earlier chunks
+			auto feed(const filtered_string_view& chunk) -> std::vector<match>;
+			// accepted characters fed so far
+			auto position() const -> std::size_t;
+
+		 private:
+			const multi_matcher* matcher_;
+			std::uint32_t state_;
+			std::size_t position_;
+		};
+
+	 private:
+		static constexpr auto none = static_cast<std::uint32_t>(-1);
+
+		// input class of each byte; 0 for bytes that are in no pattern
+		std::array<std::uint16_t, 256> classes_ = {};
+		std::size_t width_;
+		std::vector<std::size_t> lengths_;
+		// dense layout: next state for state * width_ + class
+		std::vector<std::uint32_t> transitions_;
+		// double-array layout: the edge on class c out of state s is in slot base_[s] + c if check_ there is s
+		std::vector<std::uint32_t> base_;
+		std::vector<std::uint32_t> check_;
+		std::vector<std::uint32_t> next_;
+		std::vector<std::uint32_t> fail_;
+		// patterns ending at state s are ids_[first_id_[s], first_id_[s + 1]); emit_[s] is the longest
+		// suffix state, s included, with patterns ending there, and report_[s] the next one after s
+		std::vector<std::uint32_t> first_id_;
+		std::vector<std::uint32_t> ids_;
+		std::vector<std::uint32_t> emit_;
+		std::vector<std::uint32_t> report_;
+
+		auto step(std::uint32_t state, std::uint16_t c) const -> std::uint32_t;
+		// runs the automaton over the plain characters [data, data + length), the first of which is accepted
+		// character position
+		auto scan(const char* data,
+		          std::size_t length,
+		          std::uint32_t& state,
+		          std::size_t position,
+		          std::vector<match>& out) const -> void;
+	};
+} // namespace fsv
+
+#endif // COMP6771_ASS2_MULTI_MATCH_H
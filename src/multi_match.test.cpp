@@ -0,0 +1,95 @@
+#include "./multi_match.h"
+#include "./char_class.h"
+#include "./test_text.h"
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+	using fsv::test::random_text;
+
+	// every occurrence of every pattern in text, ordered as multi_matcher reports them
+	auto naive_matches(const std::string& text, const std::vector<std::string>& patterns) -> std::vector<fsv::match> {
+		auto result = std::vector<fsv::match>();
+		for (auto id = std::size_t{0}; id < patterns.size(); ++id) {
+			for (auto at = text.find(patterns[id]); at != std::string::npos; at = text.find(patterns[id], at + 1)) {
+				result.push_back({id, at});
+			}
+		}
+		std::sort(result.begin(), result.end(), [&](const fsv::match& a, const fsv::match& b) {
+			auto const a_end = a.offset + patterns[a.pattern].size();
+			auto const b_end = b.offset + patterns[b.pattern].size();
+			if (a_end != b_end) {
+				return a_end < b_end;
+			}
+			return a.offset != b.offset ? a.offset < b.offset : a.pattern < b.pattern;
+		});
+		return result;
+	}
+} // namespace
+
+TEST_CASE("multi_matcher finds overlapping patterns") {
+	auto const patterns = std::vector<std::string>{"he", "she", "his", "hers", "she"};
+	auto const matcher = fsv::multi_matcher(patterns);
+	REQUIRE(matcher.patterns() == 5);
+	REQUIRE(matcher.dense());
+	auto const expected = std::vector<fsv::match>{{1, 1}, {4, 1}, {0, 2}, {3, 2}};
+	REQUIRE(matcher.find_all(fsv::filtered_string_view("ushers")) == expected);
+	REQUIRE(matcher.find_all(fsv::filtered_string_view("")).empty());
+	REQUIRE_THROWS_AS(fsv::multi_matcher({"a", ""}), std::domain_error);
+}
+
+TEST_CASE("multi_matcher reports offsets among the accepted characters") {
+	auto const matcher = fsv::multi_matcher({"error", "warn"});
+	auto const line = fsv::filtered_string_view("e-r-r-o-r w-a-r-n", [](const char& c) { return c != '-'; });
+	REQUIRE(matcher.find_all(line) == std::vector<fsv::match>{{0, 0}, {1, 6}});
+	auto const letters = fsv::filtered_string_view("[warn] [error]", fsv::char_class::range('a', 'z'));
+	REQUIRE(matcher.find_all(letters) == std::vector<fsv::match>{{1, 0}, {0, 4}});
+}
+
+TEST_CASE("multi_matcher agrees with a search per pattern") {
+	auto const text = random_text(200000, "abcd", 1);
+	auto patterns = std::vector<std::string>();
+	for (auto i = std::size_t{0}; i < 300; ++i) {
+		patterns.push_back(text.substr(i * 613 % (text.size() - 16), 3 + i % 12));
+	}
+	auto const matcher = fsv::multi_matcher(patterns);
+	REQUIRE(matcher.dense());
+	REQUIRE(matcher.find_all(fsv::filtered_string_view(text)) == naive_matches(text, patterns));
+	// filtered views are matched across the blocks they are materialized in
+	auto const view = fsv::filtered_string_view(text, fsv::char_class("abc"));
+	REQUIRE(matcher.find_all(view) == naive_matches(static_cast<std::string>(view), patterns));
+}
+
+TEST_CASE("multi_matcher with a large alphabet uses the double array") {
+	auto const text = random_text(100000, 2);
+	auto patterns = std::vector<std::string>();
+	for (auto i = std::size_t{0}; i < 5000; ++i) {
+		patterns.push_back(text.substr(i * 19, 1 + i % 24));
+	}
+	patterns.push_back(random_text(40, 3));
+	auto const matcher = fsv::multi_matcher(patterns);
+	REQUIRE_FALSE(matcher.dense());
+	REQUIRE(matcher.find_all(fsv::filtered_string_view(text)) == naive_matches(text, patterns));
+	auto const view = fsv::filtered_string_view(text, [](const char& c) { return c != '\0'; });
+	REQUIRE(matcher.find_all(view) == naive_matches(static_cast<std::string>(view), patterns));
+}
+
+TEST_CASE("multi_matcher streams matches across chunks") {
+	auto const text = random_text(50000, "abc", 4);
+	auto const patterns = std::vector<std::string>{"abcab", "cc", "bbbbbb", text.substr(100, 40)};
+	auto const matcher = fsv::multi_matcher(patterns);
+	for (auto const chunk : {std::size_t{1}, std::size_t{7}, std::size_t{4096}}) {
+		auto stream = fsv::multi_matcher::stream(matcher);
+		auto matches = std::vector<fsv::match>();
+		for (auto offset = std::size_t{0}; offset < text.size(); offset += chunk) {
+			auto const found = stream.feed(fsv::filtered_string_view(text.substr(offset, chunk)));
+			matches.insert(matches.end(), found.begin(), found.end());
+		}
+		REQUIRE(stream.position() == text.size());
+		REQUIRE(matches == naive_matches(text, patterns));
+	}
+}
@@ -0,0 +1,382 @@
+#include "./parallel.h"
+#include "./strategy.h"
+#include <algorithm>
+#include <numeric>
+#include <string_view>
+
+namespace fsv {
+	namespace {
+		thread_local auto inside_loop = false;
+
+		auto pool_of(const execution::parallel_policy& policy) -> thread_pool& {
+			return policy.pool == nullptr ? thread_pool::shared() : *policy.pool;
+		}
+
+		// the raw buffer of fsv cut into policy-sized chunks
+		struct chunking {
+			std::size_t size;
+			std::size_t count;
+
+			chunking(const execution::parallel_policy& policy, const filtered_string_view& fsv)
+			: size(std::max<std::size_t>(policy.chunk_size, 64))
+			, count((fsv.length() + size - 1) / size) {}
+
+			auto chunk(const filtered_string_view& fsv, std::size_t i) const -> filtered_string_view {
+				auto const offset = i * size;
+				return kernel::slice(fsv, offset, std::min(size, fsv.length() - offset));
+			}
+		};
+
+		// offsets[i] is the number of accepted characters before chunk i; the last entry is the total
+		auto prefix_counts(const execution::parallel_policy& policy,
+		                   const filtered_string_view& fsv,
+		                   const chunking& chunks,
+		                   strategy s) -> std::vector<std::size_t> {
+			auto offsets = std::vector<std::size_t>(chunks.count + 1);
+			pool_of(policy).parallel_for(chunks.count, [&](std::size_t i) {
+				offsets[i + 1] = kernel::count(chunks.chunk(fsv, i), s);
+			});
+			std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+			return offsets;
+		}
+
+		// the prefix of text holding every delimiter that starts before until
+		auto delimiter_window(std::string_view text, std::string_view delim, std::size_t until) -> std::string_view {
+			return text.substr(0, std::min(text.size(), until + delim.size() - 1));
+		}
+
+		// leftmost non-overlapping delimiters starting in [from, until), searching greedily from from
+		auto find_delimiters(std::string_view text, std::string_view delim, std::size_t from, std::size_t until)
+		    -> std::vector<std::size_t> {
+			auto const window = delimiter_window(text, delim, until);
+			auto result = std::vector<std::size_t>();
+			for (auto at = window.find(delim, from); at != std::string_view::npos;
+			     at = window.find(delim, at + delim.size()))
+			{
+				result.push_back(at);
+			}
+			return result;
+		}
+
+		// the delimiters split() picks, grouped by the chunk they start in
+		struct split_plan {
+			std::vector<std::vector<std::size_t>> delimiters;
+			// end of the last delimiter before each chunk, i.e. where its first token starts
+			std::vector<std::size_t> token_starts;
+			// index of each chunk's first token
+			std::vector<std::size_t> first_tokens;
+		};
+
+		auto plan_split(const execution::parallel_policy& policy, std::string_view text, std::string_view delim)
+		    -> split_plan {
+			auto const chunk_size = std::max<std::size_t>(policy.chunk_size, 64);
+			auto const chunks = (text.size() + chunk_size - 1) / chunk_size;
+			auto plan = split_plan{std::vector<std::vector<std::size_t>>(chunks),
+			                       std::vector<std::size_t>(chunks),
+			                       std::vector<std::size_t>(chunks)};
+			pool_of(policy).parallel_for(chunks, [&](std::size_t i) {
+				auto const first = i * chunk_size;
+				plan.delimiters[i] = find_delimiters(text, delim, first, std::min(first + chunk_size, text.size()));
+			});
+
+			// a chunk is searched as if no delimiter straddled into it; when one did, the greedy search is
+			// redone from its end until it meets a delimiter the chunk already found, after which both agree
+			auto token_start = std::size_t{0};
+			auto tokens = std::size_t{0};
+			for (auto i = std::size_t{0}; i < chunks; ++i) {
+				auto const first = i * chunk_size;
+				auto const until = std::min(first + chunk_size, text.size());
+				auto& found = plan.delimiters[i];
+				if (token_start > first) {
+					auto fixed = std::vector<std::size_t>();
+					auto const window = delimiter_window(text, delim, until);
+					for (auto at = window.find(delim, token_start); at != std::string_view::npos;
+					     at = window.find(delim, at + delim.size()))
+					{
+						auto const same = std::lower_bound(found.begin(), found.end(), at);
+						if (same != found.end() && *same == at) {
+							fixed.insert(fixed.end(), same, found.end());
+							break;
+						}
+						fixed.push_back(at);
+					}
+					found = std::move(fixed);
+				}
+				plan.token_starts[i] = token_start;
+				plan.first_tokens[i] = tokens;
+				if (!found.empty()) {
+					token_start = found.back() + delim.size();
+				}
+				tokens += found.size();
+			}
+			plan.token_starts.push_back(token_start);
+			plan.first_tokens.push_back(tokens);
+			return plan;
+		}
+
+		// calls fn for every token of fsv as planned, one chunk per task; returns the number of tokens
+		auto emit_tokens(const execution::parallel_policy& policy,
+		                 const filtered_string_view& fsv,
+		                 std::size_t delim_size,
+		                 const split_plan& plan,
+		                 const token_callback& fn) -> std::size_t {
+			pool_of(policy).parallel_for(plan.delimiters.size(), [&](std::size_t i) {
+				auto start = plan.token_starts[i];
+				auto index = plan.first_tokens[i];
+				for (auto const at : plan.delimiters[i]) {
+					fn(index++, kernel::slice(fsv, start, at - start));
+					start = at + delim_size;
+				}
+			});
+			auto const last = plan.token_starts.back();
+			fn(plan.first_tokens.back(), kernel::slice(fsv, last, fsv.length() - last));
+			return plan.first_tokens.back() + 1;
+		}
+	} // namespace
+
+	thread_pool::thread_pool(std::size_t threads)
+	: job_(nullptr)
+	, count_(0)
+	, generation_(0)
+	, active_(0)
+	, stopping_(false)
+	, next_(0) {
+		for (auto i = std::size_t{1}; i < threads; ++i) {
+			workers_.emplace_back([this] { work(); });
+		}
+	}
+
+	thread_pool::~thread_pool() {
+		{
+			auto const lock = std::lock_guard(mutex_);
+			stopping_ = true;
+		}
+		wake_.notify_all();
+		for (auto& worker : workers_) {
+			worker.join();
+		}
+	}
+
+	auto thread_pool::size() const -> std::size_t {
+		return workers_.size() + 1;
+	}
+
+	auto thread_pool::shared() -> thread_pool& {
+		static auto pool = thread_pool();
+		return pool;
+	}
+
+	auto thread_pool::parallel_for(std::size_t count, const std::function<void(std::size_t)>& fn) -> void {
+		if (inside_loop || workers_.empty() || count <= 1) {
+			for (auto i = std::size_t{0}; i < count; ++i) {
+				fn(i);
+			}
+			return;
+		}
+
+		auto const submit = std::lock_guard(submit_mutex_);
+		{
+			auto const lock = std::lock_guard(mutex_);
+			job_ = &fn;
+			count_ = count;
+			next_.store(0);
+			error_ = nullptr;
+			active_ = workers_.size();
+			++generation_;
+		}
+		wake_.notify_all();
+		run_job();
+
+		auto lock = std::unique_lock(mutex_);
+		done_.wait(lock, [this] { return active_ == 0; });
+		job_ = nullptr;
+		if (error_ != nullptr) {
+			std::rethrow_exception(error_);
+		}
+	}
+
+	auto thread_pool::work() -> void {
+		auto seen = std::size_t{0};
+		for (;;) {
+			{
+				auto lock = std::unique_lock(mutex_);
+				wake_.wait(lock, [this, seen] { return stopping_ || generation_ != seen; });
+				if (stopping_) {
+					return;
+				}
+				seen = generation_;
+			}
+			run_job();
+			auto const lock = std::lock_guard(mutex_);
+			if (--active_ == 0) {
+				done_.notify_one();
+			}
+		}
+	}
+
+	auto thread_pool::run_job() -> void {
+		inside_loop = true;
+		for (auto i = next_.fetch_add(1); i < count_; i = next_.fetch_add(1)) {
+			try {
+				(*job_)(i);
+			} catch (...) {
+				auto const lock = std::lock_guard(mutex_);
+				if (error_ == nullptr) {
+					error_ = std::current_exception();
+				}
+				// hand out no further indices
+				next_.store(count_);
+			}
+		}
+		inside_loop = false;
+	}
+
+	auto size(const execution::sequenced_policy&, const filtered_string_view& fsv) -> std::size_t {
+		return fsv.size();
+	}
+
+	auto size(const execution::parallel_policy& policy, const filtered_string_view& fsv) -> std::size_t {
+		auto const chunks = chunking(policy, fsv);
+		return prefix_counts(policy, fsv, chunks, kernel::sequential(fsv)).back();
+	}
+
+	auto equal(const execution::sequenced_policy&, const filtered_string_view& lhs, const filtered_string_view& rhs)
+	    -> bool {
+		return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+	}
+
+	auto equal(const execution::parallel_policy& policy,
+	           const filtered_string_view& lhs,
+	           const filtered_string_view& rhs) -> bool {
+		auto const lhs_strategy = kernel::sequential(lhs);
+		auto const rhs_strategy = kernel::sequential(rhs);
+		auto const lhs_chunks = chunking(policy, lhs);
+		auto const rhs_chunks = chunking(policy, rhs);
+		auto const lhs_offsets = prefix_counts(policy, lhs, lhs_chunks, lhs_strategy);
+		auto const rhs_offsets = prefix_counts(policy, rhs, rhs_chunks, rhs_strategy);
+		if (lhs_offsets.back() != rhs_offsets.back()) {
+			return false;
+		}
+
+		// each lhs chunk is compared against the rhs characters at the same filtered offsets
+		auto mismatch = std::atomic<bool>(false);
+		auto const rhs_end = rhs.data() + rhs.length();
+		pool_of(policy).parallel_for(lhs_chunks.count, [&](std::size_t i) {
+			auto remaining = lhs_offsets[i + 1] - lhs_offsets[i];
+			if (remaining == 0 || mismatch.load(std::memory_order_relaxed)) {
+				return;
+			}
+			auto const next_chunk = std::upper_bound(rhs_offsets.begin(), rhs_offsets.end(), lhs_offsets[i]);
+			auto const j = static_cast<std::size_t>(next_chunk - rhs_offsets.begin()) - 1;
+			auto r = kernel::next(rhs, rhs_strategy, rhs.data() + j * rhs_chunks.size, rhs_end);
+			for (auto skip = lhs_offsets[i] - rhs_offsets[j]; skip > 0; --skip) {
+				r = kernel::next(rhs, rhs_strategy, r + 1, rhs_end);
+			}
+
+			auto const chunk = lhs_chunks.chunk(lhs, i);
+			auto const lhs_end = chunk.data() + chunk.length();
+			for (auto l = kernel::next(chunk, lhs_strategy, chunk.data(), lhs_end); remaining > 0; --remaining) {
+				if (*l != *r) {
+					mismatch.store(true, std::memory_order_relaxed);
+					return;
+				}
+				l = kernel::next(chunk, lhs_strategy, l + 1, lhs_end);
+				r = kernel::next(rhs, rhs_strategy, r + 1, rhs_end);
+			}
+		});
+		return !mismatch.load();
+	}
+
+	auto to_string(const execution::sequenced_policy&, const filtered_string_view& fsv) -> std::string {
+		return static_cast<std::string>(fsv);
+	}
+
+	auto to_string(const execution::parallel_policy& policy, const filtered_string_view& fsv) -> std::string {
+		auto result = std::string();
+		append(policy, fsv, result);
+		return result;
+	}
+
+	auto append(const execution::parallel_policy& policy, const filtered_string_view& fsv, std::string& out)
+	    -> void {
+		auto const s = kernel::sequential(fsv);
+		auto const chunks = chunking(policy, fsv);
+		auto const offsets = prefix_counts(policy, fsv, chunks, s);
+		auto const base = out.size();
+		out.resize(base + offsets.back());
+		auto const dest = out.data() + base;
+		pool_of(policy).parallel_for(chunks.count, [&](std::size_t i) {
+			kernel::write(chunks.chunk(fsv, i), s, dest + offsets[i]);
+		});
+	}
+
+	auto split(const execution::sequenced_policy&,
+	           const filtered_string_view& fsv,
+	           const filtered_string_view& tok) -> std::vector<filtered_string_view> {
+		return split(fsv, tok);
+	}
+
+	auto split(const execution::parallel_policy& policy,
+	           const filtered_string_view& fsv,
+	           const filtered_string_view& tok) -> std::vector<filtered_string_view> {
+		auto const delim = std::string_view(tok.data(), tok.length());
+		if (fsv.empty() || delim.empty()) {
+			return {fsv};
+		}
+		auto const plan = plan_split(policy, std::string_view(fsv.data(), fsv.length()), delim);
+		auto result = std::vector<filtered_string_view>(plan.first_tokens.back() + 1);
+		emit_tokens(policy, fsv, delim.size(), plan, [&result](std::size_t i, const filtered_string_view& token) {
+			result[i] = token;
+		});
+		return result;
+	}
+
+	auto split(const execution::sequenced_policy&,
+	           const filtered_string_view& fsv,
+	           const filtered_string_view& tok,
+	           const token_callback& fn) -> std::size_t {
+		auto const tokens = split(fsv, tok);
+		for (auto i = std::size_t{0}; i < tokens.size(); ++i) {
+			fn(i, tokens[i]);
+		}
+		return tokens.size();
+	}
+
+	auto split(const execution::parallel_policy& policy,
+	           const filtered_string_view& fsv,
+	           const filtered_string_view& tok,
+	           const token_callback& fn) -> std::size_t {
+		auto const delim = std::string_view(tok.data(), tok.length());
+		if (fsv.empty() || delim.empty()) {
+			fn(0, fsv);
+			return 1;
+		}
+		auto const plan = plan_split(policy, std::string_view(fsv.data(), fsv.length()), delim);
+		return emit_tokens(policy, fsv, delim.size(), plan, fn);
+	}
+
+	auto write(const execution::sequenced_policy&, std::ostream& os, const filtered_string_view& fsv)
+	    -> std::ostream& {
+		return os << fsv;
+	}
+
+	auto write(const execution::parallel_policy& policy, std::ostream& os, const filtered_string_view& fsv)
+	    -> std::ostream& {
+		// chunks are materialized a batch at a time in parallel, then written in order
+		auto const s = kernel::sequential(fsv);
+		auto const chunks = chunking(policy, fsv);
+		auto& pool = pool_of(policy);
+		auto buffers = std::vector<std::string>(pool.size() * 4);
+		for (auto first = std::size_t{0}; first < chunks.count; first += buffers.size()) {
+			auto const batch = std::min(buffers.size(), chunks.count - first);
+			pool.parallel_for(batch, [&](std::size_t i) {
+				buffers[i].clear();
+				kernel::append(chunks.chunk(fsv, first + i), s, buffers[i]);
+			});
+			for (auto i = std::size_t{0}; i < batch; ++i) {
+				os.write(buffers[i].data(), static_cast<std::streamsize>(buffers[i].size()));
+			}
+		}
+		return os;
+	}
+} // namespace fsv
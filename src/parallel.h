@@ -0,0 +1,127 @@
+#ifndef COMP6771_ASS2_PARALLEL_H
+#define COMP6771_ASS2_PARALLEL_H
+
+#include "./filtered_string_view.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fsv {
+	// A fixed set of worker threads that run index-parallel loops. The calling thread takes part in every
+	// loop, so a pool of size n runs n - 1 workers.
+	class thread_pool {
+	 public:
+		explicit thread_pool(std::size_t threads = std::thread::hardware_concurrency());
+		thread_pool(const thread_pool&) = delete;
+		auto operator=(const thread_pool&) -> thread_pool& = delete;
+		~thread_pool();
+
+		// number of threads taking part in a loop, including the caller
+		auto size() const -> std::size_t;
+
+		// calls fn(i) for every i in [0, count) and returns once all calls have finished; indices are handed
+		// out dynamically, so uneven work balances itself. The first exception thrown by fn is rethrown here.
+		// Loops started from inside fn run inline on the calling thread.
+		auto parallel_for(std::size_t count, const std::function<void(std::size_t)>& fn) -> void;
+
+		// process-wide pool sized to the hardware
+		static auto shared() -> thread_pool&;
+
+	 private:
+		std::vector<std::thread> workers_;
+		std::mutex submit_mutex_;
+
+		std::mutex mutex_;
+		std::condition_variable wake_;
+		std::condition_variable done_;
+		const std::function<void(std::size_t)>* job_;
+		std::size_t count_;
+		std::size_t generation_;
+		std::size_t active_;
+		bool stopping_;
+		std::atomic<std::size_t> next_;
+		std::exception_ptr error_;
+
+		auto work() -> void;
+		auto run_job() -> void;
+	};
+
+	// Execution policies in the style of std::execution. Both parallel policies split the raw buffer into
+	// cache-sized chunks handed to a thread_pool (the shared one unless on() names another); within a chunk
+	// the view's own kernels are used, which already vectorize where the predicate allows it.
+	namespace execution {
+		struct sequenced_policy {};
+
+		struct parallel_policy {
+			thread_pool* pool = nullptr;
+			std::size_t chunk_size = std::size_t{1} << 18U;
+
+			constexpr auto on(thread_pool& p) const -> parallel_policy {
+				return {&p, chunk_size};
+			}
+			constexpr auto with_chunk_size(std::size_t bytes) const -> parallel_policy {
+				return {pool, bytes};
+			}
+		};
+
+		struct parallel_unsequenced_policy : parallel_policy {};
+
+		inline constexpr auto seq = sequenced_policy{};
+		inline constexpr auto par = parallel_policy{};
+		inline constexpr auto par_unseq = parallel_unsequenced_policy{};
+	} // namespace execution
+
+	auto size(const execution::sequenced_policy& policy, const filtered_string_view& fsv) -> std::size_t;
+	auto size(const execution::parallel_policy& policy, const filtered_string_view& fsv) -> std::size_t;
+
+	auto equal(const execution::sequenced_policy& policy,
+	           const filtered_string_view& lhs,
+	           const filtered_string_view& rhs) -> bool;
+	auto equal(const execution::parallel_policy& policy,
+	           const filtered_string_view& lhs,
+	           const filtered_string_view& rhs) -> bool;
+
+	auto to_string(const execution::sequenced_policy& policy, const filtered_string_view& fsv) -> std::string;
+	auto to_string(const execution::parallel_policy& policy, const filtered_string_view& fsv) -> std::string;
+
+	// appends the accepted characters of fsv to out; chunks are written in place after a prefix sum of their
+	// counts
+	auto append(const execution::parallel_policy& policy, const filtered_string_view& fsv, std::string& out) -> void;
+
+	// called with each token's index and the token; the parallel overloads call it concurrently from the
+	// pool's threads, each chunk's tokens in order
+	using token_callback = std::function<void(std::size_t, const filtered_string_view&)>;
+
+	// the same tokens as split(fsv, tok). The parallel overloads search each chunk for delimiters concurrently
+	// and then fix up, in order, the chunks whose first delimiter overlapped one straddling the previous
+	// chunk's end. The callback overloads return the number of tokens.
+	auto split(const execution::sequenced_policy& policy,
+	           const filtered_string_view& fsv,
+	           const filtered_string_view& tok) -> std::vector<filtered_string_view>;
+	auto split(const execution::parallel_policy& policy,
+	           const filtered_string_view& fsv,
+	           const filtered_string_view& tok) -> std::vector<filtered_string_view>;
+	auto split(const execution::sequenced_policy& policy,
+	           const filtered_string_view& fsv,
+	           const filtered_string_view& tok,
+	           const token_callback& fn) -> std::size_t;
+	auto split(const execution::parallel_policy& policy,
+	           const filtered_string_view& fsv,
+	           const filtered_string_view& tok,
+	           const token_callback& fn) -> std::size_t;
+
+	auto write(const execution::sequenced_policy& policy, std::ostream& os, const filtered_string_view& fsv)
+	    -> std::ostream&;
+	auto write(const execution::parallel_policy& policy, std::ostream& os, const filtered_string_view& fsv)
+	    -> std::ostream&;
+} // namespace fsv
+
+#endif // COMP6771_ASS2_PARALLEL_H
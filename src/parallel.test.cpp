@@ -0,0 +1,164 @@
+#include "./parallel.h"
+#include "./char_class.h"
+#include "./filtered_string_view.h"
+#include "./test_text.h"
+
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+	using fsv::test::sample_text;
+} // namespace
+
+TEST_CASE("thread_pool runs every index exactly once") {
+	auto pool = fsv::thread_pool(4);
+	CHECK(pool.size() == 4);
+	auto hits = std::vector<std::atomic<int>>(10000);
+	pool.parallel_for(hits.size(), [&](std::size_t i) { ++hits[i]; });
+	for (auto const& hit : hits) {
+		CHECK(hit.load() == 1);
+	}
+
+	// nested loops run inline rather than deadlocking
+	auto total = std::atomic<std::size_t>(0);
+	pool.parallel_for(8, [&](std::size_t) { pool.parallel_for(8, [&](std::size_t) { ++total; }); });
+	CHECK(total.load() == 64);
+}
+
+TEST_CASE("thread_pool rethrows the first exception and stays usable") {
+	auto pool = fsv::thread_pool(3);
+	CHECK_THROWS_AS(pool.parallel_for(100,
+	                                  [](std::size_t i) {
+		                                  if (i == 42) {
+			                                  throw std::runtime_error{"boom"};
+		                                  }
+	                                  }),
+	                std::runtime_error);
+	auto count = std::atomic<std::size_t>(0);
+	pool.parallel_for(100, [&](std::size_t) { ++count; });
+	CHECK(count.load() == 100);
+}
+
+TEST_CASE("policies agree on a char_class view") {
+	auto const text = sample_text(100003);
+	auto const view = fsv::filtered_string_view(text, fsv::char_class::range('0', '9'));
+	auto const expected = static_cast<std::string>(view);
+	auto pool = fsv::thread_pool(4);
+	auto const par = fsv::execution::par.on(pool).with_chunk_size(1000);
+	auto const par_unseq = fsv::execution::par_unseq.with_chunk_size(4096);
+
+	CHECK(fsv::size(fsv::execution::seq, view) == expected.size());
+	CHECK(fsv::size(par, view) == expected.size());
+	CHECK(fsv::size(par_unseq, view) == expected.size());
+	CHECK(fsv::to_string(fsv::execution::seq, view) == expected);
+	CHECK(fsv::to_string(par, view) == expected);
+	CHECK(fsv::to_string(par_unseq, view) == expected);
+
+	auto seq_out = std::ostringstream();
+	auto par_out = std::ostringstream();
+	fsv::write(fsv::execution::seq, seq_out, view);
+	fsv::write(par, par_out, view);
+	CHECK(seq_out.str() == expected);
+	CHECK(par_out.str() == expected);
+}
+
+TEST_CASE("policies agree on an arbitrary predicate") {
+	auto const text = sample_text(50000);
+	auto const view = fsv::filtered_string_view(text, [](const char& c) { return c == 'w' || c == '1'; });
+	auto const expected = static_cast<std::string>(view);
+	auto const par = fsv::execution::par.with_chunk_size(777);
+	CHECK(fsv::size(par, view) == expected.size());
+	CHECK(fsv::to_string(par, view) == expected);
+}
+
+TEST_CASE("parallel equal compares filtered characters across unaligned chunks") {
+	auto const text = sample_text(60000);
+	// the same digits padded differently, so their chunks do not line up
+	auto const padded = "xx" + text;
+	auto const digits = fsv::char_class::range('0', '9');
+	auto const lhs = fsv::filtered_string_view(text, digits);
+	auto const rhs = fsv::filtered_string_view(padded, digits);
+	auto const par = fsv::execution::par.with_chunk_size(1000);
+	CHECK(fsv::equal(fsv::execution::seq, lhs, rhs));
+	CHECK(fsv::equal(par, lhs, rhs));
+
+	auto changed = padded;
+	changed[changed.rfind('2')] = '3';
+	auto const other = fsv::filtered_string_view(changed, digits);
+	CHECK_FALSE(fsv::equal(fsv::execution::seq, lhs, other));
+	CHECK_FALSE(fsv::equal(par, lhs, other));
+
+	auto const prefix = text.substr(0, 30000);
+	auto const shorter = fsv::filtered_string_view(prefix, digits);
+	CHECK_FALSE(fsv::equal(par, lhs, shorter));
+	CHECK(fsv::equal(par, fsv::filtered_string_view(), fsv::filtered_string_view()));
+}
+
+TEST_CASE("parallel split matches split across chunk boundaries") {
+	auto const check = [](const std::string& text, const std::string& delim, std::size_t chunk_size) {
+		auto const view = fsv::filtered_string_view(text);
+		auto const tok = fsv::filtered_string_view(delim);
+		auto const expected = fsv::split(view, tok);
+		auto const actual = fsv::split(fsv::execution::par.with_chunk_size(chunk_size), view, tok);
+		REQUIRE(actual.size() == expected.size());
+		for (auto i = std::size_t{0}; i < expected.size(); ++i) {
+			CHECK(static_cast<std::string>(actual[i]) == static_cast<std::string>(expected[i]));
+		}
+	};
+
+	auto lines = std::string();
+	for (auto i = 0; i < 5000; ++i) {
+		lines += std::to_string(i * 37) + (i % 11 == 0 ? "\n\n" : "\n");
+	}
+	check(lines, "\n", 64);
+	check(lines, "\n", 1000);
+	// self-overlapping delimiters force the fix-up of chunks entered mid-delimiter
+	check(std::string(1000, 'a'), "aa", 64);
+	check(std::string(1000, 'a'), "aaa", 65);
+	// delimiters longer than a chunk
+	check(std::string(999, 'a') + "b", std::string(70, 'a'), 64);
+	auto mixed = std::string();
+	for (auto i = 0; i < 3000; ++i) {
+		mixed += (i % 3 == 0) ? "ab" : "aba";
+	}
+	check(mixed, "aba", 64);
+	check(mixed, "abaab", 100);
+	check("no delimiter here", "\n", 64);
+	check("trailing\n", "\n", 64);
+	check("x", "", 64);
+}
+
+TEST_CASE("parallel split keeps the view's filter and reports every token once") {
+	auto text = std::string();
+	for (auto i = 0; i < 20000; ++i) {
+		text += 'r';
+		text += std::to_string(i);
+		text += ',';
+	}
+	auto const view = fsv::filtered_string_view(text, fsv::char_class::range('0', '9'));
+	auto const tok = fsv::filtered_string_view(",");
+	auto seen = std::vector<std::atomic<int>>(20001);
+	auto digits = std::atomic<std::size_t>(0);
+	auto unfiltered = std::atomic<bool>(false);
+	auto const tokens = fsv::split(fsv::execution::par.with_chunk_size(4096),
+	                               view,
+	                               tok,
+	                               [&](std::size_t i, const fsv::filtered_string_view& token) {
+		                               ++seen[i];
+		                               digits += token.size();
+		                               // Catch2 assertions are not thread-safe, so only record here
+		                               if (!token.table()) {
+			                               unfiltered = true;
+		                               }
+	                               });
+	CHECK(tokens == seen.size());
+	for (auto const& hit : seen) {
+		CHECK(hit.load() == 1);
+	}
+	CHECK(digits.load() == view.size());
+	CHECK_FALSE(unfiltered.load());
+}
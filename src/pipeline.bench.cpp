@@ -0,0 +1,176 @@
+#include "./char_class.h"
+#include "./filtered_string_view.h"
+#include "./pipeline.h"
+#include "./ring_buffer.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Reports end-to-end throughput and per-stage queueing latency of a read -> filter -> transform -> write
+// pipeline, and compares the ring buffers with a mutex and condition variable queue.
+//
+//   pipeline_bench [megabytes] [chunk kilobytes]
+namespace {
+	using clock = std::chrono::steady_clock;
+
+	auto seconds_since(clock::time_point start) -> double {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	auto sample_text(std::size_t length) -> std::string {
+		auto result = std::string();
+		result.reserve(length);
+		for (auto i = std::size_t{0}; result.size() < length; ++i) {
+			result += (i % 7 == 0) ? "  12 " : "word ";
+		}
+		result.resize(length);
+		return result;
+	}
+
+	// the hand-rolled queue the rings replace
+	template<typename T>
+	class locked_queue {
+	 public:
+		explicit locked_queue(std::size_t capacity)
+		: capacity_(capacity) {}
+
+		auto push(T value) -> void {
+			auto lock = std::unique_lock(mutex_);
+			not_full_.wait(lock, [this] { return items_.size() < capacity_; });
+			items_.push_back(std::move(value));
+			not_empty_.notify_one();
+		}
+
+		auto pop() -> T {
+			auto lock = std::unique_lock(mutex_);
+			not_empty_.wait(lock, [this] { return !items_.empty(); });
+			auto value = std::move(items_.front());
+			items_.pop_front();
+			not_full_.notify_one();
+			return value;
+		}
+
+	 private:
+		std::size_t capacity_;
+		std::mutex mutex_;
+		std::condition_variable not_full_;
+		std::condition_variable not_empty_;
+		std::deque<T> items_;
+	};
+
+	auto bench_queues(std::size_t items) -> void {
+		auto sink = std::size_t{0};
+		{
+			auto ring = fsv::spsc_ring<std::size_t>(1024);
+			auto const start = clock::now();
+			auto producer = std::thread([&] {
+				for (auto i = std::size_t{0}; i < items; ++i) {
+					while (!ring.try_push(std::size_t{i})) {
+						std::this_thread::yield();
+					}
+				}
+			});
+			auto value = std::size_t{0};
+			for (auto received = std::size_t{0}; received < items;) {
+				if (!ring.try_pop(value)) {
+					std::this_thread::yield();
+					continue;
+				}
+				sink += value;
+				++received;
+			}
+			producer.join();
+			std::cout << "spsc_ring     " << static_cast<double>(items) / seconds_since(start) / 1e6 << " M items/s\n";
+		}
+		{
+			auto ring = fsv::mpmc_ring<std::size_t>(1024);
+			auto const start = clock::now();
+			auto producer = std::thread([&] {
+				for (auto i = std::size_t{0}; i < items; ++i) {
+					while (!ring.try_push(std::size_t{i})) {
+						std::this_thread::yield();
+					}
+				}
+			});
+			auto value = std::size_t{0};
+			for (auto received = std::size_t{0}; received < items;) {
+				if (!ring.try_pop(value)) {
+					std::this_thread::yield();
+					continue;
+				}
+				sink += value;
+				++received;
+			}
+			producer.join();
+			std::cout << "mpmc_ring     " << static_cast<double>(items) / seconds_since(start) / 1e6 << " M items/s\n";
+		}
+		{
+			auto queue = locked_queue<std::size_t>(1024);
+			auto const start = clock::now();
+			auto producer = std::thread([&] {
+				for (auto i = std::size_t{0}; i < items; ++i) {
+					queue.push(i);
+				}
+			});
+			for (auto received = std::size_t{0}; received < items; ++received) {
+				sink += queue.pop();
+			}
+			producer.join();
+			std::cout << "locked_queue  " << static_cast<double>(items) / seconds_since(start) / 1e6 << " M items/s\n";
+		}
+		if (sink == 0) {
+			std::cout << '\n';
+		}
+	}
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+	auto const megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256;
+	auto const chunk_kb = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 256;
+	auto const text = sample_text(megabytes << 20U);
+	auto const chunk_size = static_cast<std::size_t>(chunk_kb << 10U);
+	auto const digits = fsv::char_class::range('0', '9');
+
+	auto p = fsv::pipeline();
+	p.add_stage("filter",
+	            [&](const fsv::chunk& c, fsv::emitter& out) {
+		            out.emit(fsv::filtered_string_view(c.view.data(), c.view.length(), digits), c.owner);
+	            })
+	    .add_stage("transform", [](const fsv::chunk& c, fsv::emitter& out) {
+		    auto owned = std::make_shared<std::string>(static_cast<std::string>(c.view));
+		    for (auto& ch : *owned) {
+			    ch = static_cast<char>(ch + 1);
+		    }
+		    out.emit(fsv::filtered_string_view(*owned), owned);
+	    });
+	auto written = std::size_t{0};
+	auto offset = std::size_t{0};
+	auto const stats = p.run(
+	    [&](fsv::emitter& out) {
+		    if (offset >= text.size()) {
+			    return false;
+		    }
+		    auto const count = std::min(chunk_size, text.size() - offset);
+		    out.emit(fsv::filtered_string_view(text.data() + offset, count, fsv::char_class::all()));
+		    offset += count;
+		    return true;
+	    },
+	    [&](const fsv::chunk& c) { written += c.view.length(); });
+
+	std::cout << std::fixed << std::setprecision(1) << "pipeline      " << stats.throughput() / 1e6 << " MB/s over "
+	          << megabytes << " MiB in " << chunk_kb << " KiB chunks, " << written << " bytes written\n";
+	for (auto const& stage : stats.stages) {
+		std::cout << "  " << std::left << std::setw(10) << stage.name << std::right << std::setw(8) << stage.chunks
+		          << " chunks, wait mean " << static_cast<double>(stage.mean_wait().count()) / 1e3 << " us, max "
+		          << static_cast<double>(stage.max_wait.count()) / 1e3 << " us\n";
+	}
+	bench_queues(std::size_t{1} << 22U);
+	return 0;
+}
@@ -0,0 +1,268 @@
+#include "./pipeline.h"
+#include "./ring_buffer.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace fsv {
+	namespace {
+		using clock = std::chrono::steady_clock;
+
+		// a queue between two stages; closed once every producer has finished
+		class channel {
+		 public:
+			explicit channel(std::size_t producers)
+			: producers_(producers)
+			, closed_(false) {}
+			channel(const channel&) = delete;
+			auto operator=(const channel&) -> channel& = delete;
+			virtual ~channel() = default;
+
+			virtual auto try_push(chunk&& c) -> bool = 0;
+			virtual auto try_pop_batch(std::vector<chunk>& out, std::size_t max) -> std::size_t = 0;
+
+			auto producer_done() -> void {
+				if (producers_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					closed_.store(true, std::memory_order_release);
+				}
+			}
+
+			auto closed() const -> bool {
+				return closed_.load(std::memory_order_acquire);
+			}
+
+		 private:
+			std::atomic<std::size_t> producers_;
+			std::atomic<bool> closed_;
+		};
+
+		template<typename Ring>
+		class ring_channel final : public channel {
+		 public:
+			ring_channel(std::size_t producers, std::size_t capacity)
+			: channel(producers)
+			, ring_(capacity) {}
+
+			auto try_push(chunk&& c) -> bool override {
+				return ring_.try_push(std::move(c));
+			}
+
+			auto try_pop_batch(std::vector<chunk>& out, std::size_t max) -> std::size_t override {
+				return ring_.try_pop_batch(std::back_inserter(out), max);
+			}
+
+		 private:
+			Ring ring_;
+		};
+
+		struct run_state {
+			std::atomic<bool> failed = false;
+			std::mutex mutex;
+			std::exception_ptr error;
+
+			// records the exception being handled and tells every stage to stop
+			auto fail() -> void {
+				auto const lock = std::lock_guard(mutex);
+				if (error == nullptr) {
+					error = std::current_exception();
+				}
+				failed.store(true);
+			}
+		};
+
+		class batching_emitter final : public emitter {
+		 public:
+			using emitter::emit;
+
+			batching_emitter(channel& out, run_state& state, std::size_t batch_size)
+			: out_(out)
+			, state_(state)
+			, batch_size_(batch_size) {}
+
+			auto emit(chunk c) -> void override {
+				bytes_ += c.view.length();
+				pending_.push_back(std::move(c));
+				if (pending_.size() >= batch_size_) {
+					flush();
+				}
+			}
+
+			// waits for room in the queue, unless the pipeline has failed
+			auto flush() -> void {
+				auto const now = clock::now();
+				for (auto& c : pending_) {
+					c.enqueued = now;
+					while (!out_.try_push(std::move(c))) {
+						if (state_.failed.load(std::memory_order_relaxed)) {
+							pending_.clear();
+							return;
+						}
+						std::this_thread::yield();
+					}
+				}
+				pending_.clear();
+			}
+
+			auto bytes() const -> std::size_t {
+				return bytes_;
+			}
+
+		 private:
+			channel& out_;
+			run_state& state_;
+			std::size_t batch_size_;
+			std::vector<chunk> pending_;
+			std::size_t bytes_ = 0;
+		};
+
+		// pops batches from in until it is closed and drained, calling fn on each chunk and after_batch
+		// after each batch
+		template<typename F, typename G>
+		auto consume(channel& in, run_state& state, std::size_t batch_size, stage_stats& stats, F fn, G after_batch)
+		    -> void {
+			auto batch = std::vector<chunk>();
+			batch.reserve(batch_size);
+			for (;;) {
+				batch.clear();
+				if (in.try_pop_batch(batch, batch_size) == 0) {
+					if (state.failed.load(std::memory_order_relaxed)) {
+						return;
+					}
+					// everything pushed before the channel closed is visible once closed() is seen
+					if (!in.closed()) {
+						std::this_thread::yield();
+						continue;
+					}
+					if (in.try_pop_batch(batch, batch_size) == 0) {
+						return;
+					}
+				}
+				auto const now = clock::now();
+				for (auto const& c : batch) {
+					auto const wait = std::chrono::duration_cast<std::chrono::nanoseconds>(now - c.enqueued);
+					stats.total_wait += wait;
+					stats.max_wait = std::max(stats.max_wait, wait);
+					stats.bytes += c.view.length();
+					++stats.chunks;
+					fn(c);
+				}
+				after_batch();
+			}
+		}
+	} // namespace
+
+	auto emitter::emit(filtered_string_view view, std::shared_ptr<const void> owner) -> void {
+		emit(chunk{std::move(view), std::move(owner), {}});
+	}
+
+	auto stage_stats::mean_wait() const -> std::chrono::nanoseconds {
+		return chunks == 0 ? std::chrono::nanoseconds(0) : total_wait / static_cast<std::int64_t>(chunks);
+	}
+
+	auto pipeline_stats::throughput() const -> double {
+		auto const seconds = std::chrono::duration<double>(elapsed).count();
+		return seconds == 0.0 ? 0.0 : static_cast<double>(bytes) / seconds;
+	}
+
+	pipeline::pipeline(pipeline_options options)
+	: options_(options) {
+		options_.batch_size = std::max<std::size_t>(options_.batch_size, 1);
+	}
+
+	auto pipeline::add_stage(std::string name, stage_function fn, std::size_t workers) -> pipeline& {
+		stages_.push_back({std::move(name), std::move(fn), std::max<std::size_t>(workers, 1)});
+		return *this;
+	}
+
+	auto pipeline::run(const source_function& source, const sink_function& sink) -> pipeline_stats {
+		auto const start = clock::now();
+		auto state = run_state();
+
+		// channel i feeds stage i; the last one feeds the sink
+		auto channels = std::vector<std::unique_ptr<channel>>();
+		for (auto i = std::size_t{0}; i <= stages_.size(); ++i) {
+			auto const producers = i == 0 ? 1 : stages_[i - 1].workers;
+			auto const consumers = i == stages_.size() ? 1 : stages_[i].workers;
+			auto const capacity = options_.queue_capacity;
+			if (producers == 1 && consumers == 1) {
+				channels.push_back(std::make_unique<ring_channel<spsc_ring<chunk>>>(producers, capacity));
+			}
+			else {
+				channels.push_back(std::make_unique<ring_channel<mpmc_ring<chunk>>>(producers, capacity));
+			}
+		}
+
+		auto source_bytes = std::size_t{0};
+		auto threads = std::vector<std::thread>();
+		threads.emplace_back([&] {
+			try {
+				auto out = batching_emitter(*channels[0], state, options_.batch_size);
+				while (!state.failed.load(std::memory_order_relaxed) && source(out)) {
+					out.flush();
+				}
+				out.flush();
+				source_bytes = out.bytes();
+			} catch (...) {
+				state.fail();
+			}
+			channels[0]->producer_done();
+		});
+
+		// one stats entry per worker, merged per stage once they have all finished
+		auto worker_stats = std::vector<std::vector<stage_stats>>(stages_.size());
+		for (auto s = std::size_t{0}; s < stages_.size(); ++s) {
+			worker_stats[s].resize(stages_[s].workers);
+			for (auto w = std::size_t{0}; w < stages_[s].workers; ++w) {
+				threads.emplace_back([&, s, w] {
+					try {
+						auto out = batching_emitter(*channels[s + 1], state, options_.batch_size);
+						consume(
+						    *channels[s],
+						    state,
+						    options_.batch_size,
+						    worker_stats[s][w],
+						    [&](const chunk& c) { stages_[s].fn(c, out); },
+						    [&] { out.flush(); });
+						out.flush();
+					} catch (...) {
+						state.fail();
+					}
+					channels[s + 1]->producer_done();
+				});
+			}
+		}
+
+		auto sink_stats = stage_stats{"sink"};
+		try {
+			consume(*channels.back(), state, options_.batch_size, sink_stats, sink, [] {});
+		} catch (...) {
+			state.fail();
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		if (state.error != nullptr) {
+			std::rethrow_exception(state.error);
+		}
+
+		auto result = pipeline_stats();
+		for (auto s = std::size_t{0}; s < stages_.size(); ++s) {
+			auto merged = stage_stats{stages_[s].name};
+			for (auto const& w : worker_stats[s]) {
+				merged.chunks += w.chunks;
+				merged.bytes += w.bytes;
+				merged.total_wait += w.total_wait;
+				merged.max_wait = std::max(merged.max_wait, w.max_wait);
+			}
+			result.stages.push_back(std::move(merged));
+		}
+		result.stages.push_back(std::move(sink_stats));
+		result.bytes = source_bytes;
+		result.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+		return result;
+	}
+} // namespace fsv
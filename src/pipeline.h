@@ -0,0 +1,94 @@
+#ifndef COMP6771_ASS2_PIPELINE_H
+#define COMP6771_ASS2_PIPELINE_H
+
+#include "./filtered_string_view.h"
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fsv {
+	// The unit passed between pipeline stages. A stage that forwards or refilters a chunk passes its owner
+	// along; a stage that writes new bytes makes owner keep them alive until the last stage is done.
+	struct chunk {
+		filtered_string_view view;
+		std::shared_ptr<const void> owner;
+		// when the chunk entered its current queue; set by the pipeline
+		std::chrono::steady_clock::time_point enqueued;
+	};
+
+	// Where a stage sends its output. Chunks are batched, and emit() blocks while the next queue is full,
+	// which is what keeps a fast stage from running ahead of a slow one.
+	class emitter {
+	 public:
+		virtual ~emitter() = default;
+		virtual auto emit(chunk c) -> void = 0;
+
+		auto emit(filtered_string_view view, std::shared_ptr<const void> owner = nullptr) -> void;
+	};
+
+	// returns false once it has nothing more to emit
+	using source_function = std::function<bool(emitter&)>;
+	using stage_function = std::function<void(const chunk&, emitter&)>;
+	using sink_function = std::function<void(const chunk&)>;
+
+	struct pipeline_options {
+		// chunks each queue holds before its producer has to wait
+		std::size_t queue_capacity = 256;
+		// chunks moved per queue operation
+		std::size_t batch_size = 16;
+	};
+
+	struct stage_stats {
+		std::string name;
+		std::size_t chunks = 0;
+		// raw bytes of the chunks the stage received
+		std::size_t bytes = 0;
+		// time the stage's input chunks spent waiting in its queue
+		std::chrono::nanoseconds total_wait = {};
+		std::chrono::nanoseconds max_wait = {};
+
+		auto mean_wait() const -> std::chrono::nanoseconds;
+	};
+
+	struct pipeline_stats {
+		// one entry per stage, then one for the sink
+		std::vector<stage_stats> stages;
+		std::chrono::nanoseconds elapsed = {};
+		// raw bytes emitted by the source
+		std::size_t bytes = 0;
+
+		// source bytes per second
+		auto throughput() const -> double;
+	};
+
+	// A chain of stages, each on its own thread(s), connected by bounded lock-free queues. Queues between
+	// single-threaded stages are SPSC rings; a stage with several workers reads from and writes to MPMC rings
+	// and does not preserve chunk order. The source runs on its own thread and the sink on the thread that
+	// calls run().
+	class pipeline {
+	 public:
+		explicit pipeline(pipeline_options options = {});
+
+		auto add_stage(std::string name, stage_function fn, std::size_t workers = 1) -> pipeline&;
+
+		// pushes everything source emits through the stages into sink. The first exception thrown by any of
+		// them stops the pipeline and is rethrown here.
+		auto run(const source_function& source, const sink_function& sink) -> pipeline_stats;
+
+	 private:
+		struct stage {
+			std::string name;
+			stage_function fn;
+			std::size_t workers;
+		};
+
+		pipeline_options options_;
+		std::vector<stage> stages_;
+	};
+} // namespace fsv
+
+#endif // COMP6771_ASS2_PIPELINE_H
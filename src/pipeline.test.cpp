@@ -0,0 +1,165 @@
+#include "./pipeline.h"
+#include "./char_class.h"
+#include "./filtered_string_view.h"
+#include "./ring_buffer.h"
+#include "./test_text.h"
+
+#include <algorithm>
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <cctype>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	using fsv::test::sample_text;
+
+	// emits text in pieces of chunk_size bytes
+	auto chunks_of(const std::string& text, std::size_t chunk_size) -> fsv::source_function {
+		return [&text, chunk_size, offset = std::size_t{0}](fsv::emitter& out) mutable {
+			if (offset >= text.size()) {
+				return false;
+			}
+			auto const count = std::min(chunk_size, text.size() - offset);
+			out.emit(fsv::filtered_string_view(text.data() + offset, count, fsv::char_class::all()));
+			offset += count;
+			return true;
+		};
+	}
+} // namespace
+
+TEST_CASE("spsc_ring is a bounded FIFO") {
+	auto ring = fsv::spsc_ring<int>(5);
+	CHECK(ring.capacity() == 8);
+	for (auto i = 0; i < 8; ++i) {
+		CHECK(ring.try_push(int{i}));
+	}
+	CHECK_FALSE(ring.try_push(8));
+	auto out = std::vector<int>();
+	CHECK(ring.try_pop_batch(std::back_inserter(out), 3) == 3);
+	CHECK(ring.try_push(8));
+	CHECK(ring.try_pop_batch(std::back_inserter(out), 100) == 6);
+	CHECK(out == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8});
+	auto value = 0;
+	CHECK_FALSE(ring.try_pop(value));
+}
+
+TEST_CASE("spsc_ring keeps order across threads") {
+	constexpr auto count = 200000;
+	auto ring = fsv::spsc_ring<int>(64);
+	auto producer = std::thread([&] {
+		for (auto i = 0; i < count; ++i) {
+			while (!ring.try_push(int{i})) {
+				std::this_thread::yield();
+			}
+		}
+	});
+	auto in_order = true;
+	auto batch = std::vector<int>();
+	for (auto expected = 0; expected < count;) {
+		batch.clear();
+		if (ring.try_pop_batch(std::back_inserter(batch), 16) == 0) {
+			std::this_thread::yield();
+		}
+		for (auto const value : batch) {
+			in_order = in_order && value == expected++;
+		}
+	}
+	producer.join();
+	CHECK(in_order);
+}
+
+TEST_CASE("mpmc_ring delivers every value once") {
+	constexpr auto per_producer = 50000;
+	auto ring = fsv::mpmc_ring<int>(128);
+	auto seen = std::vector<std::atomic<int>>(4 * per_producer);
+	auto received = std::atomic<int>(0);
+	auto threads = std::vector<std::thread>();
+	for (auto p = 0; p < 4; ++p) {
+		threads.emplace_back([&, p] {
+			for (auto i = 0; i < per_producer; ++i) {
+				while (!ring.try_push(p * per_producer + i)) {
+					std::this_thread::yield();
+				}
+			}
+		});
+		threads.emplace_back([&] {
+			auto value = 0;
+			while (received.load() < 4 * per_producer) {
+				if (!ring.try_pop(value)) {
+					std::this_thread::yield();
+					continue;
+				}
+				++seen[static_cast<std::size_t>(value)];
+				++received;
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	CHECK(std::all_of(seen.begin(), seen.end(), [](const std::atomic<int>& n) { return n.load() == 1; }));
+}
+
+TEST_CASE("pipeline chains refiltering and transforming stages in order") {
+	auto const text = sample_text(1000003);
+	auto const digits = fsv::char_class::range('0', '9') | fsv::char_class(" ");
+	auto expected = static_cast<std::string>(fsv::filtered_string_view(text, digits));
+	std::transform(expected.begin(), expected.end(), expected.begin(), [](char c) { return c == ' ' ? '_' : c; });
+
+	auto p = fsv::pipeline(fsv::pipeline_options{8, 4});
+	p.add_stage("filter",
+	            [&](const fsv::chunk& c, fsv::emitter& out) {
+		            out.emit(fsv::filtered_string_view(c.view.data(), c.view.length(), digits), c.owner);
+	            })
+	    .add_stage("transform", [](const fsv::chunk& c, fsv::emitter& out) {
+		    auto owned = std::make_shared<std::string>(static_cast<std::string>(c.view));
+		    std::replace(owned->begin(), owned->end(), ' ', '_');
+		    out.emit(fsv::filtered_string_view(*owned), owned);
+	    });
+	auto result = std::string();
+	auto const append = [&result](const fsv::chunk& c) { result += static_cast<std::string>(c.view); };
+	auto const stats = p.run(chunks_of(text, 4096), append);
+
+	CHECK(result == expected);
+	CHECK(stats.bytes == text.size());
+	REQUIRE(stats.stages.size() == 3);
+	CHECK(stats.stages[0].name == "filter");
+	CHECK(stats.stages[0].chunks == (text.size() + 4095) / 4096);
+	CHECK(stats.stages[0].bytes == text.size());
+	CHECK(stats.stages[2].name == "sink");
+	CHECK(stats.stages[2].bytes == expected.size());
+	CHECK(stats.stages[0].max_wait >= stats.stages[0].mean_wait());
+	CHECK(stats.throughput() > 0.0);
+}
+
+TEST_CASE("pipeline stages with several workers see every chunk") {
+	auto const text = sample_text(300000);
+	auto p = fsv::pipeline();
+	p.add_stage(
+	    "count",
+	    [](const fsv::chunk& c, fsv::emitter& out) {
+		    auto const accepted = fsv::filtered_string_view(c.view.data(), c.view.length(), fsv::char_class("12"));
+		    out.emit(accepted, c.owner);
+	    },
+	    3);
+	auto total = std::size_t{0};
+	auto const stats = p.run(chunks_of(text, 1000), [&](const fsv::chunk& c) { total += c.view.size(); });
+	CHECK(total == fsv::filtered_string_view(text, fsv::char_class("12")).size());
+	CHECK(stats.stages[0].chunks == 300);
+}
+
+TEST_CASE("pipeline rethrows a stage's exception") {
+	auto const text = sample_text(100000);
+	auto p = fsv::pipeline(fsv::pipeline_options{4, 2});
+	p.add_stage("fail", [calls = 0](const fsv::chunk& c, fsv::emitter& out) mutable {
+		if (++calls == 10) {
+			throw std::runtime_error{"stage failed"};
+		}
+		out.emit(c);
+	});
+	CHECK_THROWS_AS(p.run(chunks_of(text, 100), [](const fsv::chunk&) {}), std::runtime_error);
+}
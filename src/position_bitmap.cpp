@@ -0,0 +1,584 @@
+#include "./position_bitmap.h"
+#include "./scan.h"
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace fsv {
+	namespace {
+		constexpr auto words_per_block = position_bitmap::block_size / 64;
+		constexpr auto none = static_cast<std::uint32_t>(position_bitmap::block_size);
+
+		// the bits of word w of a block that lie in [first, last]
+		auto range_mask(std::uint32_t w, std::uint32_t first, std::uint32_t last) -> std::uint64_t {
+			auto const lo = (w == first / 64) ? first % 64 : 0U;
+			auto const hi = (w == last / 64) ? last % 64 : 63U;
+			auto const width = hi - lo + 1;
+			return width == 64 ? ~std::uint64_t{0} : ((std::uint64_t{1} << width) - 1) << lo;
+		}
+
+		// sets bits [first, last] of a block
+		auto set_range(std::vector<std::uint64_t>& words, std::uint32_t first, std::uint32_t last) -> void {
+			for (auto w = first / 64; w <= last / 64; ++w) {
+				words[w] |= range_mask(w, first, last);
+			}
+		}
+
+		// number of set bits in [first, last]
+		auto count_range(const std::vector<std::uint64_t>& words, std::uint32_t first, std::uint32_t last)
+		    -> std::uint32_t {
+			auto result = std::uint32_t{0};
+			for (auto w = first / 64; w <= last / 64; ++w) {
+				result += static_cast<std::uint32_t>(std::popcount(words[w] & range_mask(w, first, last)));
+			}
+			return result;
+		}
+
+		// number of runs of set bits that overlap [first, last]
+		auto runs_in_range(const std::vector<std::uint64_t>& words, std::uint32_t first, std::uint32_t last)
+		    -> std::uint32_t {
+			auto result = std::uint32_t{0};
+			for (auto w = first / 64; w <= last / 64; ++w) {
+				auto const carry = w == 0 ? std::uint64_t{0} : words[w - 1] >> 63U;
+				auto const starts = words[w] & ~((words[w] << 1U) | carry);
+				result += static_cast<std::uint32_t>(std::popcount(starts & range_mask(w, first, last)));
+			}
+			// a run that began before first but reaches it
+			auto const inside = (words[first / 64] >> (first % 64)) & 1U;
+			auto const before = first == 0 ? 0U : (words[(first - 1) / 64] >> ((first - 1) % 64)) & 1U;
+			return result + static_cast<std::uint32_t>(inside & before);
+		}
+
+		// first bit at or after from whose value equals set, or none
+		auto next_bit(const std::vector<std::uint64_t>& words, std::uint32_t from, bool set) -> std::uint32_t {
+			for (auto w = from / 64; w < words_per_block; ++w) {
+				auto word = set ? words[w] : ~words[w];
+				if (w == from / 64) {
+					word &= ~std::uint64_t{0} << (from % 64);
+				}
+				if (word != 0) {
+					return static_cast<std::uint32_t>(w * 64 + static_cast<std::size_t>(std::countr_zero(word)));
+				}
+			}
+			return none;
+		}
+
+		// the smallest representation for a block with this many positions in this many runs
+		auto choose(std::size_t cardinality, std::size_t runs) -> position_bitmap::kind {
+			auto const bitmap_bytes = words_per_block * 8;
+			auto const array_bytes = cardinality <= position_bitmap::array_limit ? cardinality * 2 : bitmap_bytes;
+			auto const run_bytes = runs * 4;
+			if (run_bytes < array_bytes && run_bytes < bitmap_bytes) {
+				return position_bitmap::kind::run;
+			}
+			return cardinality <= position_bitmap::array_limit ? position_bitmap::kind::array
+			                                                    : position_bitmap::kind::bitmap;
+		}
+	} // namespace
+
+	position_bitmap::position_bitmap(const filtered_string_view& fsv) {
+		auto const data = fsv.data();
+		auto const length = fsv.length();
+		auto words = std::vector<std::uint64_t>(words_per_block);
+		for (auto begin = std::size_t{0}; begin < length; begin += block_size) {
+			auto const count = std::min(block_size, length - begin);
+			std::fill(words.begin(), words.end(), 0);
+			if (fsv.table()) {
+				scan::classify(data + begin, count, *fsv.table(), words.data());
+			}
+			else {
+				for (auto i = std::size_t{0}; i < count; ++i) {
+					words[i / 64] |= static_cast<std::uint64_t>(fsv.predicate()(data[begin + i])) << (i % 64);
+				}
+			}
+			if (std::any_of(words.begin(), words.end(), [](std::uint64_t w) { return w != 0; })) {
+				containers_.push_back(from_words(begin / block_size, words));
+			}
+		}
+		reindex();
+	}
+
+	auto position_bitmap::from_words(std::uint64_t key, const std::vector<std::uint64_t>& words) -> container {
+		auto cardinality = std::size_t{0};
+		auto runs = std::size_t{0};
+		auto carry = std::uint64_t{0};
+		for (auto word : words) {
+			cardinality += static_cast<std::size_t>(std::popcount(word));
+			// a run starts wherever a set bit follows a clear one
+			runs += static_cast<std::size_t>(std::popcount(word & ~((word << 1U) | carry)));
+			carry = word >> 63U;
+		}
+
+		auto result = container{key,
+		                        choose(cardinality, runs),
+		                        static_cast<std::uint32_t>(cardinality),
+		                        static_cast<std::uint32_t>(runs),
+		                        {},
+		                        {}};
+		if (result.type == kind::bitmap) {
+			result.words = words;
+		}
+		else if (result.type == kind::array) {
+			result.values.reserve(cardinality);
+			for (auto w = std::size_t{0}; w < words.size(); ++w) {
+				for (auto word = words[w]; word != 0; word &= word - 1) {
+					auto const low = w * 64 + static_cast<std::size_t>(std::countr_zero(word));
+					result.values.push_back(static_cast<std::uint16_t>(low));
+				}
+			}
+		}
+		else {
+			result.values.reserve(runs * 2);
+			for (auto first = next_bit(words, 0, true); first != none;) {
+				auto const end = next_bit(words, first, false);
+				result.values.push_back(static_cast<std::uint16_t>(first));
+				result.values.push_back(static_cast<std::uint16_t>(end - 1));
+				first = end == none ? none : next_bit(words, end, true);
+			}
+		}
+		return result;
+	}
+
+	auto position_bitmap::from_values(std::uint64_t key, std::vector<std::uint16_t> values) -> container {
+		auto runs = values.empty() ? std::size_t{0} : std::size_t{1};
+		for (auto i = std::size_t{1}; i < values.size(); ++i) {
+			runs += values[i] != values[i - 1] + 1 ? 1U : 0U;
+		}
+		if (choose(values.size(), runs) != kind::array) {
+			auto words = std::vector<std::uint64_t>(words_per_block);
+			for (auto v : values) {
+				words[v / 64U] |= std::uint64_t{1} << (v % 64U);
+			}
+			return from_words(key, words);
+		}
+		auto const cardinality = static_cast<std::uint32_t>(values.size());
+		return container{key, kind::array, cardinality, static_cast<std::uint32_t>(runs), std::move(values), {}};
+	}
+
+	auto position_bitmap::from_range(std::uint64_t key, std::uint32_t first, std::uint32_t last) -> container {
+		auto const cardinality = last - first + 1;
+		auto result = container{key, choose(cardinality, 1), cardinality, 1, {}, {}};
+		if (result.type == kind::run) {
+			result.values = {static_cast<std::uint16_t>(first), static_cast<std::uint16_t>(last)};
+		}
+		else if (result.type == kind::array) {
+			result.values.resize(cardinality);
+			std::iota(result.values.begin(), result.values.end(), static_cast<std::uint16_t>(first));
+		}
+		else {
+			result.words.resize(words_per_block);
+			set_range(result.words, first, last);
+		}
+		return result;
+	}
+
+	// Adds [first, last] to c where it is stored, keeping its cardinality and run count current, so that it
+	// is only rebuilt when those make another kind the smallest. Runs that overlap or touch the range merge
+	// with it into one.
+	auto position_bitmap::insert(container& c, std::uint32_t first, std::uint32_t last) -> void {
+		auto const lo = first == 0 ? first : first - 1;
+		auto const hi = last + 1 == none ? last : last + 1;
+		if (c.type == kind::bitmap) {
+			auto const merged = runs_in_range(c.words, lo, hi);
+			auto const present = count_range(c.words, first, last);
+			set_range(c.words, first, last);
+			c.cardinality += last - first + 1 - present;
+			c.runs = c.runs + 1 - merged;
+		}
+		else if (c.type == kind::run) {
+			// the first run that ends at or after lo, then every run that starts by hi
+			auto begin = std::size_t{0};
+			for (auto end = c.values.size() / 2; begin < end;) {
+				auto const mid = (begin + end) / 2;
+				if (c.values[2 * mid + 1] < lo) {
+					begin = mid + 1;
+				}
+				else {
+					end = mid;
+				}
+			}
+			auto end = begin;
+			auto removed = std::uint32_t{0};
+			for (; 2 * end < c.values.size() && c.values[2 * end] <= hi; ++end) {
+				first = std::min<std::uint32_t>(first, c.values[2 * end]);
+				last = std::max<std::uint32_t>(last, c.values[2 * end + 1]);
+				removed += static_cast<std::uint32_t>(c.values[2 * end + 1] - c.values[2 * end] + 1);
+			}
+			auto const at = c.values.begin() + static_cast<std::ptrdiff_t>(2 * begin);
+			c.values.erase(at, c.values.begin() + static_cast<std::ptrdiff_t>(2 * end));
+			c.values.insert(c.values.begin() + static_cast<std::ptrdiff_t>(2 * begin),
+			                {static_cast<std::uint16_t>(first), static_cast<std::uint16_t>(last)});
+			c.cardinality = c.cardinality - removed + (last - first + 1);
+			c.runs = c.runs + 1 - static_cast<std::uint32_t>(end - begin);
+		}
+		else {
+			auto const from = std::lower_bound(c.values.begin(), c.values.end(), first);
+			auto const to = std::upper_bound(from, c.values.end(), last);
+			auto const present = static_cast<std::uint32_t>(to - from);
+			if (c.cardinality - present + (last - first + 1) > array_limit) {
+				auto words = to_words(c);
+				set_range(words, first, last);
+				c = from_words(c.key, words);
+				return;
+			}
+			auto merged = std::uint32_t{0};
+			auto const touching = std::lower_bound(c.values.begin(), c.values.end(), lo);
+			for (auto v = touching; v != c.values.end() && *v <= hi; ++v) {
+				merged += v == touching || *(v - 1) + 1 != *v ? 1U : 0U;
+			}
+			auto const index = from - c.values.begin();
+			c.values.erase(from, to);
+			c.values.insert(c.values.begin() + index, last - first + 1, 0);
+			auto const at = c.values.begin() + index;
+			std::iota(at, at + (last - first + 1), static_cast<std::uint16_t>(first));
+			c.cardinality = static_cast<std::uint32_t>(c.values.size());
+			c.runs = c.runs + 1 - merged;
+		}
+		if (choose(c.cardinality, c.runs) != c.type) {
+			c = from_words(c.key, to_words(c));
+		}
+	}
+
+	auto position_bitmap::to_words(const container& c) -> std::vector<std::uint64_t> {
+		if (c.type == kind::bitmap) {
+			return c.words;
+		}
+		auto words = std::vector<std::uint64_t>(words_per_block);
+		if (c.type == kind::array) {
+			for (auto v : c.values) {
+				words[v / 64U] |= std::uint64_t{1} << (v % 64U);
+			}
+		}
+		else {
+			for (auto i = std::size_t{0}; i < c.values.size(); i += 2) {
+				set_range(words, c.values[i], c.values[i + 1]);
+			}
+		}
+		return words;
+	}
+
+	auto position_bitmap::contains(const container& c, std::uint32_t low) -> bool {
+		if (c.type == kind::bitmap) {
+			return ((c.words[low / 64] >> (low % 64)) & 1U) != 0;
+		}
+		if (c.type == kind::array) {
+			return std::binary_search(c.values.begin(), c.values.end(), low);
+		}
+		for (auto i = std::size_t{0}; i < c.values.size() && c.values[i] <= low; i += 2) {
+			if (low <= c.values[i + 1]) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	auto position_bitmap::rank(const container& c, std::uint32_t low) -> std::uint64_t {
+		if (c.type == kind::array) {
+			auto const next = std::lower_bound(c.values.begin(), c.values.end(), low);
+			return static_cast<std::uint64_t>(next - c.values.begin());
+		}
+		auto result = std::uint64_t{0};
+		if (c.type == kind::run) {
+			for (auto i = std::size_t{0}; i < c.values.size() && c.values[i] < low; i += 2) {
+				result += std::min<std::uint64_t>(c.values[i + 1] + 1U, low) - c.values[i];
+			}
+			return result;
+		}
+		for (auto w = std::size_t{0}; w < low / 64; ++w) {
+			result += static_cast<std::uint64_t>(std::popcount(c.words[w]));
+		}
+		if (low % 64 != 0) {
+			auto const below = (std::uint64_t{1} << (low % 64)) - 1;
+			result += static_cast<std::uint64_t>(std::popcount(c.words[low / 64] & below));
+		}
+		return result;
+	}
+
+	auto position_bitmap::select(const container& c, std::uint32_t index) -> std::uint32_t {
+		if (c.type == kind::array) {
+			return c.values[index];
+		}
+		if (c.type == kind::run) {
+			for (auto i = std::size_t{0};; i += 2) {
+				auto const width = static_cast<std::uint32_t>(c.values[i + 1] - c.values[i] + 1);
+				if (index < width) {
+					return c.values[i] + index;
+				}
+				index -= width;
+			}
+		}
+		for (auto w = std::size_t{0};; ++w) {
+			auto word = c.words[w];
+			auto const count = static_cast<std::uint32_t>(std::popcount(word));
+			if (index < count) {
+				for (; index > 0; --index) {
+					word &= word - 1;
+				}
+				return static_cast<std::uint32_t>(w * 64 + static_cast<std::size_t>(std::countr_zero(word)));
+			}
+			index -= count;
+		}
+	}
+
+	auto position_bitmap::find(std::uint64_t key) const -> std::vector<container>::const_iterator {
+		return std::lower_bound(containers_.begin(), containers_.end(), key, [](const container& c, std::uint64_t k) {
+			return c.key < k;
+		});
+	}
+
+	auto position_bitmap::reindex() -> void {
+		prefix_.assign(1, 0);
+		for (auto& c : containers_) {
+			c.values.shrink_to_fit();
+			c.words.shrink_to_fit();
+			prefix_.push_back(prefix_.back() + c.cardinality);
+		}
+	}
+
+	auto position_bitmap::add_range(std::uint64_t first, std::uint64_t last) -> void {
+		for (auto key = first / block_size; first < last && key <= (last - 1) / block_size; ++key) {
+			auto const lo = static_cast<std::uint32_t>(std::max(first, key * block_size) - key * block_size);
+			auto const hi = static_cast<std::uint32_t>(std::min(last, (key + 1) * block_size) - 1 - key * block_size);
+			auto const pos = find(key);
+			auto const index = static_cast<std::size_t>(pos - containers_.begin());
+			auto added = std::uint64_t{0};
+			if (pos != containers_.end() && pos->key == key) {
+				auto const before = containers_[index].cardinality;
+				insert(containers_[index], lo, hi);
+				added = containers_[index].cardinality - before;
+			}
+			else {
+				containers_.insert(containers_.begin() + static_cast<std::ptrdiff_t>(index), from_range(key, lo, hi));
+				prefix_.insert(prefix_.begin() + static_cast<std::ptrdiff_t>(index) + 1, prefix_[index]);
+				added = hi - lo + 1;
+			}
+			// only the counts after the container change, which is none of them when adding at the end
+			for (auto i = index + 1; i < prefix_.size(); ++i) {
+				prefix_[i] += added;
+			}
+		}
+	}
+
+	auto position_bitmap::add(std::uint64_t position) -> void {
+		add_range(position, position + 1);
+	}
+
+	auto position_bitmap::contains(std::uint64_t position) const -> bool {
+		auto const pos = find(position / block_size);
+		return pos != containers_.end() && pos->key == position / block_size
+		       && contains(*pos, static_cast<std::uint32_t>(position % block_size));
+	}
+
+	auto position_bitmap::cardinality() const -> std::uint64_t {
+		return prefix_.back();
+	}
+
+	auto position_bitmap::empty() const -> bool {
+		return containers_.empty();
+	}
+
+	auto position_bitmap::rank(std::uint64_t position) const -> std::uint64_t {
+		auto const pos = find(position / block_size);
+		auto const index = static_cast<std::size_t>(pos - containers_.begin());
+		auto result = prefix_[index];
+		if (pos != containers_.end() && pos->key == position / block_size) {
+			result += rank(*pos, static_cast<std::uint32_t>(position % block_size));
+		}
+		return result;
+	}
+
+	auto position_bitmap::select(std::uint64_t index) const -> std::uint64_t {
+		if (index >= cardinality()) {
+			throw std::out_of_range{"position_bitmap::select(" + std::to_string(index) + "): invalid index"};
+		}
+		auto const next = std::upper_bound(prefix_.begin(), prefix_.end(), index);
+		auto const i = static_cast<std::size_t>(next - prefix_.begin()) - 1;
+		auto const& c = containers_[i];
+		return c.key * block_size + select(c, static_cast<std::uint32_t>(index - prefix_[i]));
+	}
+
+	auto position_bitmap::memory_usage() const -> std::size_t {
+		auto result = containers_.size() * sizeof(container) + prefix_.size() * sizeof(std::uint64_t);
+		for (auto const& c : containers_) {
+			result += c.values.size() * sizeof(std::uint16_t) + c.words.size() * sizeof(std::uint64_t);
+		}
+		return result;
+	}
+
+	auto position_bitmap::container_count(kind k) const -> std::size_t {
+		return static_cast<std::size_t>(
+		    std::count_if(containers_.begin(), containers_.end(), [k](const container& c) { return c.type == k; }));
+	}
+
+	auto position_bitmap::view(const char* data, std::size_t length) const -> filtered_string_view {
+		auto const shared = std::make_shared<const position_bitmap>(*this);
+		return filtered_string_view(data, length, [shared, data](const char& c) {
+			return shared->contains(static_cast<std::uint64_t>(&c - data));
+		});
+	}
+
+	auto position_bitmap::combine(const position_bitmap& lhs, const position_bitmap& rhs, set_op op)
+	    -> position_bitmap {
+		auto result = position_bitmap();
+		auto l = lhs.containers_.begin();
+		auto r = rhs.containers_.begin();
+		while (l != lhs.containers_.end() || r != rhs.containers_.end()) {
+			if (r == rhs.containers_.end() || (l != lhs.containers_.end() && l->key < r->key)) {
+				if (op != set_op::intersect) {
+					result.containers_.push_back(*l);
+				}
+				++l;
+				continue;
+			}
+			if (l == lhs.containers_.end() || r->key < l->key) {
+				if (op == set_op::unite) {
+					result.containers_.push_back(*r);
+				}
+				++r;
+				continue;
+			}
+
+			if (l->type == kind::array && r->type == kind::array) {
+				// small sorted sets merge directly without expanding to bitmaps
+				auto values = std::vector<std::uint16_t>();
+				auto const out = std::back_inserter(values);
+				if (op == set_op::intersect) {
+					std::set_intersection(l->values.begin(), l->values.end(), r->values.begin(), r->values.end(), out);
+				}
+				else if (op == set_op::unite) {
+					std::set_union(l->values.begin(), l->values.end(), r->values.begin(), r->values.end(), out);
+				}
+				else {
+					std::set_difference(l->values.begin(), l->values.end(), r->values.begin(), r->values.end(), out);
+				}
+				if (!values.empty()) {
+					result.containers_.push_back(from_values(l->key, std::move(values)));
+				}
+			}
+			else {
+				auto words = to_words(*l);
+				auto const other = to_words(*r);
+				auto any = std::uint64_t{0};
+				for (auto w = std::size_t{0}; w < words_per_block; ++w) {
+					words[w] = op == set_op::intersect ? words[w] & other[w]
+					           : op == set_op::unite   ? words[w] | other[w]
+					                                   : words[w] & ~other[w];
+					any |= words[w];
+				}
+				if (any != 0) {
+					result.containers_.push_back(from_words(l->key, words));
+				}
+			}
+			++l;
+			++r;
+		}
+		result.reindex();
+		return result;
+	}
+
+	auto operator&(const position_bitmap& lhs, const position_bitmap& rhs) -> position_bitmap {
+		return position_bitmap::combine(lhs, rhs, position_bitmap::set_op::intersect);
+	}
+
+	auto operator|(const position_bitmap& lhs, const position_bitmap& rhs) -> position_bitmap {
+		return position_bitmap::combine(lhs, rhs, position_bitmap::set_op::unite);
+	}
+
+	auto andnot(const position_bitmap& lhs, const position_bitmap& rhs) -> position_bitmap {
+		return position_bitmap::combine(lhs, rhs, position_bitmap::set_op::subtract);
+	}
+
+	auto operator==(const position_bitmap& lhs, const position_bitmap& rhs) -> bool {
+		// containers are always stored in their canonical (smallest) form
+		return std::equal(lhs.containers_.begin(),
+		                  lhs.containers_.end(),
+		                  rhs.containers_.begin(),
+		                  rhs.containers_.end(),
+		                  [](const position_bitmap::container& a, const position_bitmap::container& b) {
+			                  return a.key == b.key && a.type == b.type && a.values == b.values && a.words == b.words;
+		                  });
+	}
+
+	// iterator class implementation
+	position_bitmap::iter::iter()
+	: bitmap_(nullptr)
+	, container_(0)
+	, cursor_(0)
+	, low_(0) {}
+
+	position_bitmap::iter::iter(const position_bitmap* bitmap, std::size_t container)
+	: bitmap_(bitmap)
+	, container_(container)
+	, cursor_(0)
+	, low_(0) {
+		enter();
+	}
+
+	void position_bitmap::iter::enter() {
+		cursor_ = 0;
+		low_ = 0;
+		if (container_ >= bitmap_->containers_.size()) {
+			return;
+		}
+		auto const& c = bitmap_->containers_[container_];
+		low_ = c.type == kind::bitmap ? next_bit(c.words, 0, true) : c.values[0];
+	}
+
+	auto position_bitmap::iter::operator*() const -> reference {
+		return bitmap_->containers_[container_].key * block_size + low_;
+	}
+
+	auto position_bitmap::iter::operator++() -> iter& {
+		auto const& c = bitmap_->containers_[container_];
+		auto next = none;
+		if (c.type == kind::array) {
+			if (++cursor_ < c.values.size()) {
+				next = c.values[cursor_];
+			}
+		}
+		else if (c.type == kind::run) {
+			if (low_ < c.values[cursor_ * 2 + 1]) {
+				next = low_ + 1;
+			}
+			else if (++cursor_ * 2 < c.values.size()) {
+				next = c.values[cursor_ * 2];
+			}
+		}
+		else if (low_ + 1 < none) {
+			next = next_bit(c.words, low_ + 1, true);
+		}
+
+		if (next == none) {
+			++container_;
+			enter();
+		}
+		else {
+			low_ = next;
+		}
+		return *this;
+	}
+
+	auto position_bitmap::iter::operator++(int) -> iter {
+		iter temp = *this;
+		++*this;
+		return temp;
+	}
+
+	auto operator==(const position_bitmap::iterator& lhs, const position_bitmap::iterator& rhs) -> bool {
+		return lhs.container_ == rhs.container_ && lhs.low_ == rhs.low_;
+	}
+
+	auto operator!=(const position_bitmap::iterator& lhs, const position_bitmap::iterator& rhs) -> bool {
+		return !(lhs == rhs);
+	}
+
+	auto position_bitmap::begin() const -> const_iterator {
+		return const_iterator(this, 0);
+	}
+
+	auto position_bitmap::end() const -> const_iterator {
+		return const_iterator(this, containers_.size());
+	}
+} // namespace fsv
@@ -0,0 +1,152 @@
+#ifndef COMP6771_ASS2_POSITION_BITMAP_H
+#define COMP6771_ASS2_POSITION_BITMAP_H
+
+#include "./filtered_string_view.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace fsv {
+	// Compressed set of accepted raw positions, split into 64 KiB blocks in the style of Roaring bitmaps.
+	// Each non-empty block is kept as whichever container is smallest:
+	//  - array:  sorted 16-bit offsets (2 bytes per position);
+	//  - bitmap: 1024 64-bit words (8 KiB);
+	//  - run:    inclusive [first, last] offset pairs (4 bytes per run).
+	// Bitmaps of views over the same buffer can be combined without re-evaluating any predicate.
+	class position_bitmap {
+	 public:
+		enum class kind { array, bitmap, run };
+
+		static constexpr std::size_t block_size = std::size_t{1} << 16U;
+		static constexpr std::size_t array_limit = 4096;
+
+		class iter {
+		 public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::uint64_t;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = std::uint64_t;
+
+			iter();
+			iter(const position_bitmap* bitmap, std::size_t container);
+
+			auto operator*() const -> reference;
+
+			auto operator++() -> iter&;
+			auto operator++(int) -> iter;
+
+			friend auto operator==(const iter&, const iter&) -> bool;
+			friend auto operator!=(const iter&, const iter&) -> bool;
+
+		 private:
+			const position_bitmap* bitmap_;
+			std::size_t container_;
+			// array index or run index, depending on the container kind
+			std::size_t cursor_;
+			std::uint32_t low_;
+			void enter();
+		};
+
+		using iterator = iter;
+		using const_iterator = iter;
+
+		position_bitmap() = default;
+		// positions accepted by fsv, relative to fsv.data()
+		explicit position_bitmap(const filtered_string_view& fsv);
+
+		// adds every position in [first, last)
+		auto add_range(std::uint64_t first, std::uint64_t last) -> void;
+		auto add(std::uint64_t position) -> void;
+
+		auto contains(std::uint64_t position) const -> bool;
+		auto cardinality() const -> std::uint64_t;
+		auto empty() const -> bool;
+		// number of positions strictly below position
+		auto rank(std::uint64_t position) const -> std::uint64_t;
+		// the index-th smallest position
+		auto select(std::uint64_t index) const -> std::uint64_t;
+
+		// bytes held by the containers
+		auto memory_usage() const -> std::size_t;
+		// number of containers of each kind, indexed by kind
+		auto container_count(kind k) const -> std::size_t;
+
+		// a view of data whose predicate is membership in this bitmap; data must be the buffer the
+		// positions were taken from
+		auto view(const char* data, std::size_t length) const -> filtered_string_view;
+
+		auto begin() const -> const_iterator;
+		auto end() const -> const_iterator;
+
+		template<typename F>
+		auto for_each(F fn) const -> void {
+			for (auto const& c : containers_) {
+				auto const base = c.key * block_size;
+				if (c.type == kind::array) {
+					for (auto low : c.values) {
+						fn(base + low);
+					}
+				}
+				else if (c.type == kind::run) {
+					for (auto i = std::size_t{0}; i < c.values.size(); i += 2) {
+						for (auto low = std::uint64_t{c.values[i]}; low <= c.values[i + 1]; ++low) {
+							fn(base + low);
+						}
+					}
+				}
+				else {
+					for (auto w = std::size_t{0}; w < c.words.size(); ++w) {
+						for (auto word = c.words[w]; word != 0; word &= word - 1) {
+							fn(base + w * 64 + static_cast<std::uint64_t>(std::countr_zero(word)));
+						}
+					}
+				}
+			}
+		}
+
+		friend auto operator&(const position_bitmap& lhs, const position_bitmap& rhs) -> position_bitmap;
+		friend auto operator|(const position_bitmap& lhs, const position_bitmap& rhs) -> position_bitmap;
+		friend auto andnot(const position_bitmap& lhs, const position_bitmap& rhs) -> position_bitmap;
+		friend auto operator==(const position_bitmap& lhs, const position_bitmap& rhs) -> bool;
+
+	 private:
+		struct container {
+			std::uint64_t key;
+			kind type;
+			std::uint32_t cardinality;
+			// maximal runs of consecutive positions, which decides the smallest kind
+			std::uint32_t runs;
+			// array: sorted offsets; run: flattened inclusive [first, last] pairs
+			std::vector<std::uint16_t> values;
+			// bitmap: 1024 words
+			std::vector<std::uint64_t> words;
+		};
+
+		std::vector<container> containers_;
+		// prefix_[i] is the number of positions in containers before i; the last entry is the cardinality
+		std::vector<std::uint64_t> prefix_ = {0};
+
+		static auto to_words(const container& c) -> std::vector<std::uint64_t>;
+		static auto from_words(std::uint64_t key, const std::vector<std::uint64_t>& words) -> container;
+		static auto from_range(std::uint64_t key, std::uint32_t first, std::uint32_t last) -> container;
+		static auto insert(container& c, std::uint32_t first, std::uint32_t last) -> void;
+		static auto contains(const container& c, std::uint32_t low) -> bool;
+		static auto rank(const container& c, std::uint32_t low) -> std::uint64_t;
+		static auto select(const container& c, std::uint32_t index) -> std::uint32_t;
+
+		auto find(std::uint64_t key) const -> std::vector<container>::const_iterator;
+		auto reindex() -> void;
+
+		enum class set_op { intersect, unite, subtract };
+		static auto from_values(std::uint64_t key, std::vector<std::uint16_t> values) -> container;
+		static auto combine(const position_bitmap& lhs, const position_bitmap& rhs, set_op op) -> position_bitmap;
+	};
+
+	auto andnot(const position_bitmap& lhs, const position_bitmap& rhs) -> position_bitmap;
+} // namespace fsv
+
+#endif // COMP6771_ASS2_POSITION_BITMAP_H
@@ -0,0 +1,160 @@
+#include "./position_bitmap.h"
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+	auto positions(const fsv::position_bitmap& bitmap) -> std::vector<std::uint64_t> {
+		return std::vector<std::uint64_t>(bitmap.begin(), bitmap.end());
+	}
+} // namespace
+
+TEST_CASE("position_bitmap built from a view") {
+	auto const text = std::string("a1b22c333");
+	auto const bitmap = fsv::position_bitmap(fsv::filtered_string_view{text, fsv::char_class::range('0', '9')});
+	REQUIRE(bitmap.cardinality() == 6);
+	REQUIRE(positions(bitmap) == std::vector<std::uint64_t>{1, 3, 4, 6, 7, 8});
+	REQUIRE(bitmap.contains(3));
+	REQUIRE(!bitmap.contains(5));
+	REQUIRE(bitmap.rank(5) == 3);
+	REQUIRE(bitmap.select(3) == 6);
+	REQUIRE_THROWS_AS(bitmap.select(6), std::out_of_range);
+	REQUIRE(static_cast<std::string>(bitmap.view(text.data(), text.size())) == "122333");
+
+	auto const scalar = fsv::position_bitmap(fsv::filtered_string_view{text, [](const char& c) { return c > '9'; }});
+	REQUIRE(positions(scalar) == std::vector<std::uint64_t>{0, 2, 5});
+}
+
+TEST_CASE("position_bitmap picks compact containers") {
+	auto const size = 4 * fsv::position_bitmap::block_size;
+
+	SECTION("a stripped header becomes a single run per block") {
+		auto bitmap = fsv::position_bitmap();
+		bitmap.add_range(1000, size);
+		REQUIRE(bitmap.cardinality() == size - 1000);
+		REQUIRE(bitmap.container_count(fsv::position_bitmap::kind::run) == 4);
+		REQUIRE(bitmap.memory_usage() < 512);
+		REQUIRE(bitmap.rank(size) == size - 1000);
+		REQUIRE(bitmap.select(0) == 1000);
+		REQUIRE(bitmap.select(size - 1001) == size - 1);
+	}
+
+	SECTION("scattered positions use arrays, dense noise uses bitmaps") {
+		auto text = std::string(size, 'x');
+		auto engine = std::mt19937(6771);
+		for (auto i = std::size_t{0}; i < fsv::position_bitmap::block_size; ++i) {
+			text[i] = (engine() & 1U) != 0 ? 'y' : 'x';
+		}
+		for (auto i = fsv::position_bitmap::block_size; i < size; i += 100) {
+			text[i] = 'y';
+		}
+		auto const bitmap = fsv::position_bitmap(fsv::filtered_string_view{text, fsv::char_class("y")});
+		REQUIRE(bitmap.container_count(fsv::position_bitmap::kind::bitmap) == 1);
+		REQUIRE(bitmap.container_count(fsv::position_bitmap::kind::array) == 3);
+		REQUIRE(bitmap.cardinality() == fsv::filtered_string_view(text, fsv::char_class("y")).size());
+	}
+}
+
+TEST_CASE("position_bitmap built incrementally matches one built from a view") {
+	auto const block = fsv::position_bitmap::block_size;
+	auto text = std::string(4 * block, 'x');
+	auto engine = std::mt19937(42);
+	// dense noise, scattered positions, long runs, and runs of every length up to a hundred
+	for (auto i = std::size_t{0}; i < block; ++i) {
+		text[i] = (engine() & 1U) != 0 ? 'y' : 'x';
+	}
+	for (auto i = block; i < 2 * block; i += 1 + engine() % 200) {
+		text[i] = 'y';
+	}
+	std::fill(text.begin() + 2 * block + 100, text.begin() + 3 * block - 100, 'y');
+	for (auto i = 3 * block; i < 4 * block; i += 2 + engine() % 100) {
+		auto const run = std::min<std::size_t>(1 + engine() % 100, 4 * block - i);
+		text.replace(i, run, run, 'y');
+		i += run;
+	}
+	auto const expected = fsv::position_bitmap(fsv::filtered_string_view{text, fsv::char_class("y")});
+
+	// the runs of accepted positions, added in random order, single positions one at a time
+	auto runs = std::vector<std::pair<std::uint64_t, std::uint64_t>>();
+	for (auto i = std::size_t{0}; i < text.size();) {
+		auto const end = std::min(text.find('x', i), text.size());
+		if (end > i) {
+			runs.emplace_back(i, end);
+		}
+		i = end + 1;
+	}
+	std::shuffle(runs.begin(), runs.end(), engine);
+	auto bitmap = fsv::position_bitmap();
+	for (auto const& [first, last] : runs) {
+		if (last - first == 1) {
+			bitmap.add(first);
+		}
+		else {
+			bitmap.add_range(first, last);
+		}
+	}
+	REQUIRE(bitmap == expected);
+	REQUIRE(bitmap.cardinality() == expected.cardinality());
+	REQUIRE(bitmap.rank(3 * block) == expected.rank(3 * block));
+	// adding what is already there changes nothing
+	bitmap.add_range(2 * block, 2 * block + 200);
+	bitmap.add(2 * block + 150);
+	REQUIRE(bitmap.cardinality() == expected.cardinality() + 100);
+
+	// positions added one at a time in order, the usual way to build a bitmap incrementally
+	auto ordered = fsv::position_bitmap();
+	expected.for_each([&ordered](std::uint64_t p) { ordered.add(p); });
+	REQUIRE(ordered == expected);
+	REQUIRE(positions(ordered) == positions(expected));
+}
+
+TEST_CASE("position_bitmap rank and select agree with iteration") {
+	auto bitmap = fsv::position_bitmap();
+	bitmap.add_range(10, 5000);
+	bitmap.add_range(70000, 70003);
+	bitmap.add(200000);
+	for (auto i = 131072U; i < 196608U; i += 13) {
+		bitmap.add(i);
+	}
+	auto const all = positions(bitmap);
+	REQUIRE(all.size() == bitmap.cardinality());
+	for (auto i = std::size_t{0}; i < all.size(); i += 101) {
+		REQUIRE(bitmap.select(i) == all[i]);
+		REQUIRE(bitmap.rank(all[i]) == i);
+		REQUIRE(bitmap.contains(all[i]));
+	}
+	auto visited = std::size_t{0};
+	bitmap.for_each([&](std::uint64_t p) { REQUIRE(p == all[visited++]); });
+	REQUIRE(visited == all.size());
+}
+
+TEST_CASE("position_bitmap set operations") {
+	auto text = std::string();
+	for (auto i = 0; i < 40000; ++i) {
+		text += "ab1 ";
+	}
+	auto const letters = fsv::position_bitmap(fsv::filtered_string_view{text, fsv::char_class("ab")});
+	auto const not_b = fsv::position_bitmap(fsv::filtered_string_view{text, ~fsv::char_class("b")});
+	auto header = fsv::position_bitmap();
+	header.add_range(0, 100);
+
+	auto const a_only = letters & not_b;
+	REQUIRE(a_only == fsv::position_bitmap(fsv::filtered_string_view{text, fsv::char_class("a")}));
+	auto const everything = letters | not_b;
+	REQUIRE(everything.cardinality() == text.size());
+	auto const body = andnot(letters, header);
+	REQUIRE(body.cardinality() == letters.cardinality() - 50);
+	REQUIRE(!body.contains(0));
+	REQUIRE(body.contains(100));
+	REQUIRE((header & fsv::position_bitmap()).empty());
+
+	auto const small_a = fsv::position_bitmap(fsv::filtered_string_view{"a.a.a", fsv::char_class("a")});
+	auto const small_b = fsv::position_bitmap(fsv::filtered_string_view{"..a.a", fsv::char_class("a")});
+	REQUIRE(positions(small_a & small_b) == std::vector<std::uint64_t>{2, 4});
+	REQUIRE(positions(small_a | small_b) == std::vector<std::uint64_t>{0, 2, 4});
+	REQUIRE(positions(andnot(small_a, small_b)) == std::vector<std::uint64_t>{0});
+}
@@ -0,0 +1,82 @@
+#include "./char_class.h"
+#include "./filtered_string_view.h"
+#include "./regex.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+// Validates many short request fields, as a validation layer would, by materializing each view for
+// std::regex and by matching the view in place with fsv::regex.
+//
+//   regex_bench [fields]
+namespace {
+	using clock = std::chrono::steady_clock;
+
+	auto seconds_since(clock::time_point start) -> double {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	auto sample_fields(std::size_t count) -> std::vector<std::string> {
+		auto result = std::vector<std::string>();
+		for (auto i = std::size_t{0}; i < count; ++i) {
+			// surrounding whitespace is filtered out; every fifth field is malformed
+			auto const at = i % 5 == 0 ? "@@" : "@";
+			result.push_back(" user" + std::to_string(i) + at + "example" + std::to_string(i % 17) + ".com\t");
+		}
+		return result;
+	}
+
+	auto report(const char* name, std::size_t fields, double seconds, std::size_t checksum) -> void {
+		std::cout << std::left << std::setw(28) << name << std::right << std::setw(10)
+		          << static_cast<double>(fields) / seconds / 1e6 << " M fields/s  (" << checksum << ")\n";
+	}
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+	auto const count = static_cast<std::size_t>(argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000);
+	auto const fields = sample_fields(count);
+	auto const trimmed = ~fsv::char_class(" \t");
+	auto const pattern = std::string("[a-z0-9._]+@[a-z0-9]+(\\.[a-z]{2,6})+");
+	std::cout << std::fixed << std::setprecision(2);
+
+	{
+		auto const start = clock::now();
+		auto const re = std::regex(pattern);
+		auto valid = std::size_t{0};
+		for (auto const& field : fields) {
+			auto const text = static_cast<std::string>(fsv::filtered_string_view(field, trimmed));
+			if (std::regex_match(text, re)) {
+				++valid;
+			}
+		}
+		report("std::string + std::regex", count, seconds_since(start), valid);
+	}
+	{
+		auto const start = clock::now();
+		auto const re = fsv::regex(pattern);
+		auto valid = std::size_t{0};
+		for (auto const& field : fields) {
+			if (re.full_match(fsv::filtered_string_view(field, trimmed))) {
+				++valid;
+			}
+		}
+		report("fsv::regex::full_match", count, seconds_since(start), valid);
+	}
+	{
+		auto const start = clock::now();
+		auto const re = fsv::regex("@@");
+		auto found = std::size_t{0};
+		for (auto const& field : fields) {
+			if (re.search(fsv::filtered_string_view(field, trimmed))) {
+				++found;
+			}
+		}
+		report("fsv::regex::search", count, seconds_since(start), found);
+	}
+	return 0;
+}
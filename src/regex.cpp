@@ -0,0 +1,764 @@
+#include "./regex.h"
+#include "./strategy.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace fsv {
+	namespace {
+		constexpr auto none = static_cast<std::uint32_t>(-1);
+		// closes each group of a deterministic state
+		constexpr auto mark = none;
+		// leads an unanchored state that comes after a match, so no more threads are started
+		constexpr auto settled = none - 1;
+		// the class of bytes the view rejects, which leave the state as it is
+		constexpr auto skip = static_cast<std::uint16_t>(-1);
+		constexpr auto max_repeat = 1000;
+		constexpr auto max_nodes = std::size_t{1} << 16U;
+		// deterministic states cached per automaton; a full cache is emptied and refilled from the state in use
+		constexpr auto max_states = std::size_t{1} << 12U;
+
+		struct syntax {
+			enum class kind { empty, set, concat, alternate, repeat, begin, end };
+			kind type = kind::empty;
+			char_class set;
+			std::vector<syntax> items;
+			// bounds of a repeat; a negative max is unbounded
+			int min = 0;
+			int max = 0;
+		};
+
+		auto single(char c) -> char_class {
+			auto result = char_class();
+			result.insert(c);
+			return result;
+		}
+
+		auto of(const char_class& set) -> syntax {
+			return syntax{syntax::kind::set, set, {}};
+		}
+
+		auto digits() -> char_class {
+			return char_class::range('0', '9');
+		}
+
+		auto word() -> char_class {
+			return char_class::range('a', 'z') | char_class::range('A', 'Z') | digits() | single('_');
+		}
+
+		auto space() -> char_class {
+			return char_class(" \t\n\r\f\v");
+		}
+
+		class parser {
+		 public:
+			explicit parser(std::string_view pattern)
+			: pattern_(pattern)
+			, at_(0) {}
+
+			auto parse() -> syntax {
+				auto result = alternation();
+				if (!done()) {
+					fail("unmatched )");
+				}
+				return result;
+			}
+
+		 private:
+			std::string_view pattern_;
+			std::size_t at_;
+
+			[[noreturn]] auto fail(const std::string& why) const -> void {
+				throw std::domain_error{"regex(" + std::string(pattern_) + "): " + why + " at " + std::to_string(at_)};
+			}
+
+			auto done() const -> bool {
+				return at_ == pattern_.size();
+			}
+
+			auto peek() const -> char {
+				return pattern_[at_];
+			}
+
+			auto eat(char c) -> bool {
+				if (done() || peek() != c) {
+					return false;
+				}
+				++at_;
+				return true;
+			}
+
+			auto alternation() -> syntax {
+				auto branches = std::vector<syntax>();
+				branches.push_back(concatenation());
+				while (eat('|')) {
+					branches.push_back(concatenation());
+				}
+				if (branches.size() == 1) {
+					return std::move(branches.front());
+				}
+				return syntax{syntax::kind::alternate, {}, std::move(branches)};
+			}
+
+			auto concatenation() -> syntax {
+				auto items = std::vector<syntax>();
+				while (!done() && peek() != '|' && peek() != ')') {
+					items.push_back(repetition());
+				}
+				if (items.size() == 1) {
+					return std::move(items.front());
+				}
+				return syntax{items.empty() ? syntax::kind::empty : syntax::kind::concat, {}, std::move(items)};
+			}
+
+			auto repetition() -> syntax {
+				auto result = atom();
+				while (!done()) {
+					auto min = 0;
+					auto max = -1;
+					if (eat('+')) {
+						min = 1;
+					}
+					else if (eat('?')) {
+						max = 1;
+					}
+					else if (!eat('*') && !(peek() == '{' && bounds(min, max))) {
+						break;
+					}
+					if (!done() && peek() == '?') {
+						fail("lazy repetition is not supported");
+					}
+					auto items = std::vector<syntax>();
+					items.push_back(std::move(result));
+					result = syntax{syntax::kind::repeat, {}, std::move(items), min, max};
+				}
+				return result;
+			}
+
+			// reads {m}, {m,} or {m,n}; anything else leaves the { to be read as a literal
+			auto bounds(int& min, int& max) -> bool {
+				auto const start = at_++;
+				auto const number = [&](int& value) {
+					auto const first = at_;
+					value = 0;
+					for (; !done() && peek() >= '0' && peek() <= '9'; ++at_) {
+						value = std::min(value * 10 + (peek() - '0'), max_repeat + 1);
+					}
+					return at_ != first;
+				};
+				if (!number(min)) {
+					at_ = start;
+					return false;
+				}
+				max = min;
+				if (eat(',') && !number(max)) {
+					max = -1;
+				}
+				if (!eat('}')) {
+					at_ = start;
+					return false;
+				}
+				if (min > max_repeat || max > max_repeat) {
+					fail("repetition count above " + std::to_string(max_repeat));
+				}
+				if (max >= 0 && max < min) {
+					fail("repetition bounds out of order");
+				}
+				return true;
+			}
+
+			auto atom() -> syntax {
+				switch (auto const c = pattern_[at_++]; c) {
+				case '(': {
+					if (eat('?') && !eat(':')) {
+						fail("unsupported group");
+					}
+					auto inner = alternation();
+					if (!eat(')')) {
+						fail("missing )");
+					}
+					return inner;
+				}
+				case '[': return of(bracket());
+				case '.': return of(~single('\n'));
+				case '^': return syntax{syntax::kind::begin, {}, {}};
+				case '$': return syntax{syntax::kind::end, {}, {}};
+				case '\\': return of(escape());
+				case '*':
+				case '+':
+				case '?': --at_; fail("nothing to repeat");
+				default: return of(single(c));
+				}
+			}
+
+			auto escape() -> char_class {
+				if (done()) {
+					fail("trailing \\");
+				}
+				switch (auto const c = pattern_[at_++]; c) {
+				case 'd': return digits();
+				case 'D': return ~digits();
+				case 'w': return word();
+				case 'W': return ~word();
+				case 's': return space();
+				case 'S': return ~space();
+				case 'n': return single('\n');
+				case 'r': return single('\r');
+				case 't': return single('\t');
+				case 'f': return single('\f');
+				case 'v': return single('\v');
+				case '0': return single('\0');
+				default:
+					if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '1' && c <= '9')) {
+						fail("unknown escape");
+					}
+					return single(c);
+				}
+			}
+
+			auto bracket() -> char_class {
+				auto const negated = eat('^');
+				auto result = char_class();
+				// a ] straight after [ or [^ is a literal
+				for (auto first = true;; first = false) {
+					if (done()) {
+						fail("missing ]");
+					}
+					if (peek() == ']' && !first) {
+						++at_;
+						break;
+					}
+					auto const c = pattern_[at_++];
+					if (c == '\\') {
+						result = result | escape();
+					}
+					else if (at_ + 1 < pattern_.size() && peek() == '-' && pattern_[at_ + 1] != ']') {
+						auto const last = pattern_[at_ + 1];
+						at_ += 2;
+						if (last == '\\' || static_cast<unsigned char>(last) < static_cast<unsigned char>(c)) {
+							fail("invalid range");
+						}
+						result = result | char_class::range(c, last);
+					}
+					else {
+						result.insert(c);
+					}
+				}
+				return negated ? ~result : result;
+			}
+		};
+
+		enum class op : std::uint8_t { set, split, begin, end, match };
+
+		struct node {
+			op kind;
+			std::uint32_t out;
+			std::uint32_t out1;
+			char_class set;
+		};
+
+		// node 0 of every automaton is its match node
+		constexpr auto match_node = std::uint32_t{0};
+
+		struct automaton {
+			std::vector<node> nodes;
+			std::uint32_t entry = match_node;
+		};
+
+		// Thompson's construction, emitted back to front so each piece is compiled knowing the node it leads
+		// to. Reversed, concatenations are laid out the other way round and ^ and $ trade places, giving an
+		// automaton that reads the text from the end.
+		class compiler {
+		 public:
+			compiler(std::string_view pattern, bool reversed)
+			: pattern_(pattern)
+			, reversed_(reversed) {}
+
+			auto compile(const syntax& tree) -> automaton {
+				add({op::match, none, none, {}});
+				auto const entry = emit(tree, match_node);
+				return {std::move(nodes_), entry};
+			}
+
+		 private:
+			std::string_view pattern_;
+			bool reversed_;
+			std::vector<node> nodes_;
+
+			auto add(const node& n) -> std::uint32_t {
+				if (nodes_.size() == max_nodes) {
+					throw std::domain_error{"regex(" + std::string(pattern_) + "): pattern too large"};
+				}
+				nodes_.push_back(n);
+				return static_cast<std::uint32_t>(nodes_.size() - 1);
+			}
+
+			auto emit(const syntax& s, std::uint32_t next) -> std::uint32_t {
+				switch (s.type) {
+				case syntax::kind::empty: return next;
+				case syntax::kind::set: return add({op::set, next, none, s.set});
+				case syntax::kind::begin: return add({reversed_ ? op::end : op::begin, next, none, {}});
+				case syntax::kind::end: return add({reversed_ ? op::begin : op::end, next, none, {}});
+				case syntax::kind::concat:
+					if (reversed_) {
+						for (auto const& item : s.items) {
+							next = emit(item, next);
+						}
+					}
+					else {
+						for (auto item = s.items.rbegin(); item != s.items.rend(); ++item) {
+							next = emit(*item, next);
+						}
+					}
+					return next;
+				case syntax::kind::alternate: {
+					auto entry = emit(s.items.back(), next);
+					for (auto i = s.items.size() - 1; i-- > 0;) {
+						auto const branch = emit(s.items[i], next);
+						entry = add({op::split, branch, entry, {}});
+					}
+					return entry;
+				}
+				case syntax::kind::repeat: {
+					auto const& item = s.items.front();
+					if (s.max < 0) {
+						auto const loop = add({op::split, none, next, {}});
+						auto const body = emit(item, loop);
+						nodes_[loop].out = body;
+						next = loop;
+					}
+					else {
+						for (auto i = s.min; i < s.max; ++i) {
+							auto const body = emit(item, next);
+							next = add({op::split, body, next, {}});
+						}
+					}
+					for (auto i = 0; i < s.min; ++i) {
+						next = emit(item, next);
+					}
+					return next;
+				}
+				}
+				return next;
+			}
+		};
+
+		// bytes no set in the pattern tells apart share a class
+		struct byte_classes {
+			std::array<std::uint16_t, 256> of = {};
+			// a byte of each class
+			std::vector<char> representative;
+		};
+
+		auto partition(const std::vector<node>& nodes) -> byte_classes {
+			auto sets = std::set<std::array<std::uint64_t, 4>>();
+			for (auto const& n : nodes) {
+				if (n.kind == op::set) {
+					sets.insert(n.set.words());
+				}
+			}
+			auto result = byte_classes();
+			auto count = std::size_t{1};
+			for (auto const& words : sets) {
+				// every class splits into the bytes in the set and those outside it
+				auto renumber = std::vector<std::uint16_t>(2 * count, skip);
+				count = 0;
+				for (auto b = 0U; b < 256; ++b) {
+					auto const in = (words[b >> 6U] >> (b & 63U)) & 1U;
+					auto& id = renumber[2 * result.of[b] + in];
+					if (id == skip) {
+						id = static_cast<std::uint16_t>(count++);
+					}
+					result.of[b] = id;
+				}
+			}
+			result.representative.assign(count, '\0');
+			for (auto b = 256U; b-- > 0;) {
+				result.representative[result.of[b]] = static_cast<char>(b);
+			}
+			return result;
+		}
+
+		// Deterministic states of an automaton, built the first time they are reached. A state is the set of
+		// live nodes grouped by the position their thread started at, earliest first, each group sorted and
+		// closed by a mark. In an unanchored automaton a new group starts at every character until some group
+		// matches; the groups after the first one to match are dropped, and no group is started once there has
+		// been a match, so the last match seen before the automaton dies ends the leftmost-longest match.
+		class dfa {
+		 public:
+			static constexpr auto dead = std::uint32_t{0};
+
+			dfa(const automaton& a, const byte_classes& classes, bool unanchored)
+			: automaton_(a)
+			, classes_(classes)
+			, width_(classes.representative.size())
+			, unanchored_(unanchored)
+			, seen_(a.nodes.size(), 0) {
+				reset();
+			}
+
+			// the state before any character, at the start of the text if at_begin
+			auto start(bool at_begin) -> std::uint32_t {
+				auto& id = starts_[at_begin ? 1 : 0];
+				if (id == none) {
+					auto set = std::vector<std::uint32_t>();
+					++generation_;
+					add_group(set, automaton_.entry, at_begin);
+					id = intern(set);
+				}
+				return id;
+			}
+
+			auto next(std::uint32_t state, std::uint16_t c) -> std::uint32_t {
+				auto const t = table_[state * width_ + c];
+				return t != none ? t : build(state, c);
+			}
+
+			auto accepting(std::uint32_t state) const -> bool {
+				return accepting_[state] != 0;
+			}
+
+			// whether state accepts once the $ assertions it is waiting on hold
+			auto accepting_at_end(std::uint32_t state) -> bool {
+				if (at_end_[state] == unknown) {
+					auto set = std::vector<std::uint32_t>();
+					++generation_;
+					for (auto const n : sets_[state]) {
+						if (n != mark && n != settled && automaton_.nodes[n].kind == op::end) {
+							closure(n, false, true, set);
+						}
+					}
+					auto const matched = accepting(state) || std::find(set.begin(), set.end(), match_node) != set.end();
+					at_end_[state] = matched ? yes : no;
+				}
+				return at_end_[state] == yes;
+			}
+
+			auto size() const -> std::size_t {
+				return sets_.size();
+			}
+
+		 private:
+			static constexpr auto unknown = std::uint8_t{0};
+			static constexpr auto no = std::uint8_t{1};
+			static constexpr auto yes = std::uint8_t{2};
+
+			const automaton& automaton_;
+			const byte_classes& classes_;
+			std::size_t width_;
+			bool unanchored_;
+			std::map<std::vector<std::uint32_t>, std::uint32_t> ids_;
+			std::vector<std::vector<std::uint32_t>> sets_;
+			// width_ transitions per state, none until built
+			std::vector<std::uint32_t> table_;
+			std::vector<std::uint8_t> accepting_;
+			std::vector<std::uint8_t> at_end_;
+			std::array<std::uint32_t, 2> starts_ = {};
+			// counts cache resets, so a transition is not recorded for a state that no longer exists
+			std::size_t epoch_ = 0;
+			// nodes already added to the state being built are marked with its generation
+			std::vector<std::uint32_t> seen_;
+			std::uint32_t generation_ = 0;
+			std::vector<std::uint32_t> stack_;
+
+			auto reset() -> void {
+				ids_.clear();
+				sets_.clear();
+				table_.clear();
+				accepting_.clear();
+				at_end_.clear();
+				starts_ = {none, none};
+				++epoch_;
+				intern({});
+			}
+
+			auto intern(const std::vector<std::uint32_t>& set) -> std::uint32_t {
+				if (auto const found = ids_.find(set); found != ids_.end()) {
+					return found->second;
+				}
+				if (sets_.size() == max_states) {
+					reset();
+					if (set.empty()) {
+						return dead;
+					}
+				}
+				auto const id = static_cast<std::uint32_t>(sets_.size());
+				ids_.emplace(set, id);
+				sets_.push_back(set);
+				table_.resize(table_.size() + width_, none);
+				accepting_.push_back(std::find(set.begin(), set.end(), match_node) != set.end() ? 1 : 0);
+				at_end_.push_back(unknown);
+				return id;
+			}
+
+			// adds the nodes reachable from n without reading a character and not yet in this generation
+			auto closure(std::uint32_t n, bool at_begin, bool at_end, std::vector<std::uint32_t>& set) -> void {
+				stack_.push_back(n);
+				while (!stack_.empty()) {
+					auto const i = stack_.back();
+					stack_.pop_back();
+					if (seen_[i] == generation_) {
+						continue;
+					}
+					seen_[i] = generation_;
+					auto const& x = automaton_.nodes[i];
+					switch (x.kind) {
+					case op::split:
+						stack_.push_back(x.out1);
+						stack_.push_back(x.out);
+						break;
+					case op::begin:
+						if (at_begin) {
+							stack_.push_back(x.out);
+						}
+						break;
+					case op::end:
+						if (at_end) {
+							stack_.push_back(x.out);
+						}
+						else {
+							set.push_back(i);
+						}
+						break;
+					case op::set:
+					case op::match: set.push_back(i); break;
+					}
+				}
+			}
+
+			// closes the group that starts at first; returns whether it matches
+			static auto close_group(std::vector<std::uint32_t>& set, std::size_t first) -> bool {
+				if (set.size() == first) {
+					return false;
+				}
+				std::sort(set.begin() + static_cast<std::ptrdiff_t>(first), set.end());
+				auto const matched = set[first] == match_node;
+				set.push_back(mark);
+				return matched;
+			}
+
+			auto add_group(std::vector<std::uint32_t>& set, std::uint32_t entry, bool at_begin) -> void {
+				auto const first = set.size();
+				closure(entry, at_begin, false, set);
+				close_group(set, first);
+			}
+
+			auto build(std::uint32_t state, std::uint16_t c) -> std::uint32_t {
+				auto const from = sets_[state];
+				auto const byte = classes_.representative[c];
+				auto const after_match = accepting(state) || (!from.empty() && from.front() == settled);
+				auto set = std::vector<std::uint32_t>();
+				if (after_match) {
+					set.push_back(settled);
+				}
+				++generation_;
+				auto matched = false;
+				auto first = set.size();
+				for (auto const n : from) {
+					if (n == settled) {
+						continue;
+					}
+					if (n != mark) {
+						auto const& x = automaton_.nodes[n];
+						if (x.kind == op::set && x.set.contains(byte)) {
+							closure(x.out, false, false, set);
+						}
+						continue;
+					}
+					matched = close_group(set, first);
+					first = set.size();
+					if (matched) {
+						break;
+					}
+				}
+				if (unanchored_ && !matched && !after_match) {
+					add_group(set, automaton_.entry, false);
+				}
+				if (set.size() == 1 && after_match) {
+					set.clear();
+				}
+				auto const epoch = epoch_;
+				auto const id = intern(set);
+				if (epoch == epoch_) {
+					table_[state * width_ + c] = id;
+				}
+				return id;
+			}
+		};
+	} // namespace
+
+	class regex::program {
+	 public:
+		explicit program(std::string_view pattern)
+		: program(parser(pattern).parse(), pattern) {}
+
+		// held while matching or reading the cache, which const members of regex share
+		auto lock() -> std::unique_lock<std::mutex> {
+			return std::unique_lock(mutex_);
+		}
+
+		// runs fn with a function giving the class of each byte of fsv, or skip for bytes fsv rejects
+		template<typename Fn>
+		auto run(const filtered_string_view& fsv, Fn fn) {
+			if (auto const& table = fsv.table()) {
+				// a char_class filter is folded into the byte classes; the last one is kept, since a regex
+				// tends to be run over many views with the same filter
+				if (!folded_for_ || !(*folded_for_ == *table)) {
+					folded_for_ = *table;
+					folded_ = classes_.of;
+					for (auto b = 0U; b < 256; ++b) {
+						if (!table->contains(static_cast<char>(b))) {
+							folded_[b] = skip;
+						}
+					}
+				}
+				return fn([&](const char& c) { return folded_[static_cast<unsigned char>(c)]; });
+			}
+			auto const& predicate = fsv.predicate();
+			return fn([&](const char& c) { return predicate(c) ? classes_.of[static_cast<unsigned char>(c)] : skip; });
+		}
+
+		template<typename Classify>
+		auto search(const filtered_string_view& fsv, Classify classify) -> std::optional<regex_match> {
+			auto const data = fsv.data();
+			auto const length = fsv.length();
+			auto const npos = filtered_string_view::npos;
+
+			// forwards, to where the leftmost-longest match ends
+			auto end = npos;
+			auto s = search_.start(true);
+			if (search_.accepting(s)) {
+				end = 0;
+			}
+			auto i = std::size_t{0};
+			for (; i < length; ++i) {
+				auto const c = classify(data[i]);
+				if (c == skip) {
+					continue;
+				}
+				s = search_.next(s, c);
+				if (s == dfa::dead) {
+					break;
+				}
+				if (search_.accepting(s)) {
+					end = i + 1;
+				}
+			}
+			if (i == length && search_.accepting_at_end(s)) {
+				end = length;
+			}
+			if (end == npos) {
+				return std::nullopt;
+			}
+
+			// then backwards from there, to the earliest start of a match with that end
+			auto begin = end;
+			auto r = backward_.start(end == length);
+			auto j = end;
+			for (; j > 0; --j) {
+				auto const c = classify(data[j - 1]);
+				if (c == skip) {
+					continue;
+				}
+				r = backward_.next(r, c);
+				if (r == dfa::dead) {
+					break;
+				}
+				if (backward_.accepting(r)) {
+					begin = j - 1;
+				}
+			}
+			if (j == 0 && backward_.accepting_at_end(r)) {
+				begin = 0;
+			}
+			auto const strategy = kernel::sequential(fsv);
+			return regex_match{kernel::count(kernel::slice(fsv, 0, begin), strategy),
+			                   kernel::count(kernel::slice(fsv, begin, end - begin), strategy)};
+		}
+
+		template<typename Classify>
+		auto full_match(const filtered_string_view& fsv, Classify classify) -> bool {
+			auto const data = fsv.data();
+			auto s = anchored_.start(true);
+			for (auto i = std::size_t{0}; i < fsv.length(); ++i) {
+				auto const c = classify(data[i]);
+				if (c == skip) {
+					continue;
+				}
+				s = anchored_.next(s, c);
+				if (s == dfa::dead) {
+					return false;
+				}
+			}
+			return anchored_.accepting_at_end(s);
+		}
+
+		auto cached_states() const -> std::size_t {
+			return search_.size() + anchored_.size() + backward_.size();
+		}
+
+	 private:
+		automaton forward_;
+		automaton reverse_;
+		byte_classes classes_;
+		dfa search_;
+		dfa anchored_;
+		dfa backward_;
+		std::optional<char_class> folded_for_;
+		std::array<std::uint16_t, 256> folded_ = {};
+		std::mutex mutex_;
+
+		program(const syntax& tree, std::string_view pattern)
+		: forward_(compiler(pattern, false).compile(tree))
+		, reverse_(compiler(pattern, true).compile(tree))
+		, classes_(partition(forward_.nodes))
+		, search_(forward_, classes_, true)
+		, anchored_(forward_, classes_, false)
+		, backward_(reverse_, classes_, false) {}
+	};
+
+	regex::regex(std::string_view pattern)
+	: pattern_(pattern)
+	, program_(std::make_unique<program>(pattern_)) {}
+
+	regex::regex(const regex& other)
+	: regex(other.pattern_) {}
+
+	regex::regex(regex&& other) noexcept = default;
+
+	auto regex::operator=(const regex& other) -> regex& {
+		if (this != &other) {
+			*this = regex(other);
+		}
+		return *this;
+	}
+
+	auto regex::operator=(regex&& other) noexcept -> regex& = default;
+
+	regex::~regex() = default;
+
+	auto regex::search(const filtered_string_view& fsv) const -> std::optional<regex_match> {
+		auto const lock = program_->lock();
+		return program_->run(fsv, [&](auto classify) { return program_->search(fsv, classify); });
+	}
+
+	auto regex::full_match(const filtered_string_view& fsv) const -> bool {
+		auto const lock = program_->lock();
+		return program_->run(fsv, [&](auto classify) { return program_->full_match(fsv, classify); });
+	}
+
+	auto regex::pattern() const -> const std::string& {
+		return pattern_;
+	}
+
+	auto regex::cached_states() const -> std::size_t {
+		auto const lock = program_->lock();
+		return program_->cached_states();
+	}
+} // namespace fsv
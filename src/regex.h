@@ -0,0 +1,59 @@
+#ifndef COMP6771_ASS2_REGEX_H
+#define COMP6771_ASS2_REGEX_H
+
+#include "./filtered_string_view.h"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace fsv {
+	struct regex_match {
+		// index of the first matched accepted character
+		std::size_t offset;
+		// accepted characters matched
+		std::size_t length;
+
+		friend auto operator==(const regex_match&, const regex_match&) -> bool = default;
+	};
+
+	// A regular expression matched against the accepted characters of a view without materializing them.
+	// The syntax is a practical subset: literals and escapes, ., classes such as [a-z_] and [^,], \d \w \s
+	// and their negations, grouping with (...) or (?:...), alternation, the repetitions * + ? {m} {m,}
+	// {m,n}, and ^ and $ for the start and end of the view. There are no captures, backreferences or lazy
+	// repetitions.
+	//
+	// A pattern compiles to a nondeterministic automaton over classes of bytes it cannot tell apart.
+	// Deterministic states are built from it on first use and cached, so once warm each character costs one
+	// table lookup; bytes the view rejects leave the state as it is. Matching updates that cache under a
+	// lock, so one regex may be shared between threads, which then match one at a time; copies have caches
+	// and locks of their own, so threads that each hold one match in parallel.
+	class regex {
+	 public:
+		// Throws std::domain_error if pattern is malformed or compiles to too many states.
+		explicit regex(std::string_view pattern);
+		regex(const regex& other);
+		regex(regex&& other) noexcept;
+		auto operator=(const regex& other) -> regex&;
+		auto operator=(regex&& other) noexcept -> regex&;
+		~regex();
+
+		// the leftmost match and, of those starting there, the longest
+		auto search(const filtered_string_view& fsv) const -> std::optional<regex_match>;
+		// true if the accepted characters as a whole match
+		auto full_match(const filtered_string_view& fsv) const -> bool;
+		auto pattern() const -> const std::string&;
+		// deterministic states built so far
+		auto cached_states() const -> std::size_t;
+
+	 private:
+		class program;
+
+		std::string pattern_;
+		std::unique_ptr<program> program_;
+	};
+} // namespace fsv
+
+#endif // COMP6771_ASS2_REGEX_H
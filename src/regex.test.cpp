@@ -0,0 +1,157 @@
+#include "./regex.h"
+#include "./char_class.h"
+#include "./test_text.h"
+
+#include <catch2/catch.hpp>
+#include <optional>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	using fsv::test::random_text;
+
+	// the leftmost-longest match std::regex finds with POSIX semantics
+	auto posix_search(const std::string& pattern, const std::string& text) -> std::optional<fsv::regex_match> {
+		auto found = std::smatch();
+		if (!std::regex_search(text, found, std::regex(pattern, std::regex::extended))) {
+			return std::nullopt;
+		}
+		return fsv::regex_match{static_cast<std::size_t>(found.position(0)), static_cast<std::size_t>(found.length(0))};
+	}
+} // namespace
+
+TEST_CASE("regex search finds the leftmost-longest match") {
+	auto const view = [](const char* text) { return fsv::filtered_string_view(text); };
+	REQUIRE(fsv::regex("b+").search(view("abbbc")) == fsv::regex_match{1, 3});
+	REQUIRE(fsv::regex("abcd|c").search(view("xabcd")) == fsv::regex_match{1, 4});
+	REQUIRE(fsv::regex("a|ab|abc").search(view("abcabc")) == fsv::regex_match{0, 3});
+	REQUIRE(fsv::regex("x*").search(view("abc")) == fsv::regex_match{0, 0});
+	REQUIRE(fsv::regex("\\d{3}-\\d{4}").search(view("call 555-0199 now")) == fsv::regex_match{5, 8});
+	REQUIRE(fsv::regex("[^,]+$").search(view("a,bc,def")) == fsv::regex_match{5, 3});
+	REQUIRE(fsv::regex("^a").search(view("ba")) == std::nullopt);
+	REQUIRE(fsv::regex("(?:ab)+").search(view("aababab")) == fsv::regex_match{1, 6});
+	REQUIRE(fsv::regex("[]x]+").search(view("a]x]")) == fsv::regex_match{1, 3});
+	REQUIRE(fsv::regex("a.c").search(view("a\nc abc")) == fsv::regex_match{4, 3});
+	REQUIRE_FALSE(fsv::regex("q").search(view("")));
+	REQUIRE(fsv::regex("").search(view("")) == fsv::regex_match{0, 0});
+}
+
+TEST_CASE("regex full_match matches the whole view") {
+	auto const identifier = fsv::regex("[A-Za-z_]\\w*");
+	REQUIRE(identifier.full_match(fsv::filtered_string_view("snake_case2")));
+	REQUIRE_FALSE(identifier.full_match(fsv::filtered_string_view("2fast")));
+	REQUIRE_FALSE(identifier.full_match(fsv::filtered_string_view("")));
+	REQUIRE(fsv::regex("a{2,3}").full_match(fsv::filtered_string_view("aaa")));
+	REQUIRE_FALSE(fsv::regex("a{2,3}").full_match(fsv::filtered_string_view("aaaa")));
+	REQUIRE(fsv::regex("^(ab|cd)*$").full_match(fsv::filtered_string_view("abcdab")));
+	REQUIRE(fsv::regex("x?").full_match(fsv::filtered_string_view("")));
+}
+
+TEST_CASE("regex matches the accepted characters only") {
+	auto const no_dashes = [](const char& c) { return c != '-'; };
+	auto const phone = fsv::regex("^\\d{10}$");
+	REQUIRE(phone.full_match(fsv::filtered_string_view("555-867-5309", no_dashes)));
+	REQUIRE(phone.full_match(fsv::filtered_string_view("-555-867-5309-", ~fsv::char_class("-"))));
+	REQUIRE_FALSE(phone.full_match(fsv::filtered_string_view("555-867-530", no_dashes)));
+	// offsets count accepted characters
+	auto const digits = fsv::filtered_string_view("a1b22c333", fsv::char_class::range('0', '9'));
+	REQUIRE(fsv::regex("3+").search(digits) == fsv::regex_match{3, 3});
+	REQUIRE(fsv::regex("12").search(digits) == fsv::regex_match{0, 2});
+	REQUIRE(fsv::regex("23$").search(fsv::filtered_string_view("1-2-3--", no_dashes)) == fsv::regex_match{1, 2});
+}
+
+TEST_CASE("regex calls predicates with the buffer's own characters") {
+	// accepts every other byte, by its position in the buffer
+	auto const text = std::string("aXbYcZ");
+	auto const even = [data = text.data()](const char& c) { return (&c - data) % 2 == 0; };
+	auto const view = fsv::filtered_string_view(text, even);
+	REQUIRE(fsv::regex("abc").full_match(view));
+	REQUIRE(fsv::regex("b+").search(view) == fsv::regex_match{1, 1});
+}
+
+TEST_CASE("regex search agrees with POSIX std::regex") {
+	auto const patterns = std::vector<std::string>{
+	    "abc",    "a|b-",         "(a|ab)(c|bcd)", "a*b",       "(ab|a)*c",    "b{2,4}", "-[ab]+-", "[^-]{3}",
+	    "^a+",    "c+$",          "(a|b|c)*cab",   "((a|b)c)+", "a?b?c?-",     "^$",     "(c|-)+$", "b(a|c){3}",
+	    "(a*)*b", "(-|ab|abc)+c", "cc|c-c|-cc",    "a{0,2}c",   "(a|b)-(c|a)", "-+a*-+",
+	};
+	for (auto const seed : {1U, 2U, 3U}) {
+		for (auto const length : {std::size_t{0}, std::size_t{5}, std::size_t{40}, std::size_t{300}}) {
+			auto const text = random_text(length, "abc-", seed);
+			for (auto const& pattern : patterns) {
+				auto const re = fsv::regex(pattern);
+				INFO(pattern << " in " << text);
+				REQUIRE(re.search(fsv::filtered_string_view(text)) == posix_search(pattern, text));
+				REQUIRE(re.full_match(fsv::filtered_string_view(text))
+				        == std::regex_match(text, std::regex(pattern, std::regex::extended)));
+			}
+		}
+	}
+}
+
+TEST_CASE("regex keeps working when its state cache fills up") {
+	// the deterministic automaton needs a state for each of the 2^13 possible last 13 characters
+	auto const re = fsv::regex("(a|b)*a(a|b){12}c");
+	auto text = random_text(20000, "abc-", 4);
+	for (auto& c : text) {
+		c = c == 'c' || c == '-' ? 'a' : c;
+	}
+	text += "c";
+	text[text.size() - 14] = 'b';
+	REQUIRE_FALSE(re.search(fsv::filtered_string_view(text)));
+	text[text.size() - 14] = 'a';
+	REQUIRE(re.search(fsv::filtered_string_view(text)) == fsv::regex_match{0, text.size()});
+	REQUIRE(re.full_match(fsv::filtered_string_view(text)));
+	REQUIRE(re.cached_states() <= 3 * 4096);
+}
+
+TEST_CASE("regex rejects malformed patterns") {
+	for (auto const* pattern : {"(a", "a)", "[ab", "*a", "a**?", "a{3,2}", "a{1001}", "\\q", "(?=a)", "[z-a]", "a\\"}) {
+		INFO(pattern);
+		REQUIRE_THROWS_AS(fsv::regex(pattern), std::domain_error);
+	}
+	// a { that does not start a repetition is a literal
+	REQUIRE(fsv::regex("a{x").full_match(fsv::filtered_string_view("a{x")));
+}
+
+TEST_CASE("regex copies have their own cache") {
+	auto const original = fsv::regex("(ab)+");
+	REQUIRE(original.search(fsv::filtered_string_view("xabab")) == fsv::regex_match{1, 4});
+	auto copy = original;
+	REQUIRE(copy.pattern() == "(ab)+");
+	REQUIRE(copy.cached_states() < original.cached_states());
+	REQUIRE(copy.full_match(fsv::filtered_string_view("abab")));
+	copy = fsv::regex("c");
+	REQUIRE(copy.search(fsv::filtered_string_view("abc")) == fsv::regex_match{2, 1});
+}
+
+TEST_CASE("regex may be shared between threads") {
+	auto const re = fsv::regex("b[ab]*c");
+	auto const text = random_text(20000, "abc-", 7);
+	// views with different filters, so threads also contend for the folded byte classes
+	auto const filters =
+	    std::vector<fsv::char_class>{fsv::char_class("abc"), fsv::char_class("bc-"), ~fsv::char_class()};
+	auto expected = std::vector<std::optional<fsv::regex_match>>();
+	for (auto const& filter : filters) {
+		expected.push_back(fsv::regex("b[ab]*c").search(fsv::filtered_string_view(text, filter)));
+	}
+	auto mismatches = std::vector<int>(4, 0);
+	auto threads = std::vector<std::thread>();
+	for (auto t = std::size_t{0}; t < mismatches.size(); ++t) {
+		threads.emplace_back([&, t] {
+			for (auto i = std::size_t{0}; i < 200; ++i) {
+				auto const which = (t + i) % filters.size();
+				if (re.search(fsv::filtered_string_view(text, filters[which])) != expected[which]) {
+					++mismatches[t];
+				}
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	REQUIRE(mismatches == std::vector<int>(4, 0));
+}
@@ -0,0 +1,199 @@
+#include "./resumable.h"
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+namespace fsv {
+	namespace {
+		// failure[i] is the length of the longest proper border of pattern[0, i]
+		auto failure_function(std::string_view pattern) -> std::vector<std::size_t> {
+			auto failure = std::vector<std::size_t>(pattern.size(), 0);
+			for (auto i = std::size_t{1}, k = std::size_t{0}; i < pattern.size(); ++i) {
+				while (k > 0 && pattern[i] != pattern[k]) {
+					k = failure[k - 1];
+				}
+				if (pattern[i] == pattern[k]) {
+					++k;
+				}
+				failure[i] = k;
+			}
+			return failure;
+		}
+
+		// extends a partial match of matched characters by c and returns the new match length
+		auto advance(std::string_view pattern, const std::vector<std::size_t>& failure, std::size_t matched, char c)
+		    -> std::size_t {
+			while (matched > 0 && pattern[matched] != c) {
+				matched = failure[matched - 1];
+			}
+			return pattern[matched] == c ? matched + 1 : matched;
+		}
+	} // namespace
+
+	resumable_scan::resumable_scan(const filtered_string_view& fsv)
+	: fsv_(fsv)
+	, strategy_(kernel::sequential(fsv))
+	, position_(0)
+	, done_(false) {}
+
+	auto resumable_scan::step(std::size_t budget) -> bool {
+		if (done_) {
+			return true;
+		}
+		auto const last = position_ + std::min(budget, length() - position_);
+		position_ = scan(position_, last);
+		if (!done_ && position_ == length()) {
+			finish();
+			done_ = true;
+		}
+		return done_;
+	}
+
+	auto resumable_scan::done() const -> bool {
+		return done_;
+	}
+
+	auto resumable_scan::position() const -> std::size_t {
+		return position_;
+	}
+
+	auto resumable_scan::length() const -> std::size_t {
+		return fsv_.length();
+	}
+
+	auto resumable_scan::stop() -> void {
+		done_ = true;
+	}
+
+	auto resumable_scan::view() const -> const filtered_string_view& {
+		return fsv_;
+	}
+
+	auto resumable_scan::kernel_strategy() const -> strategy {
+		return strategy_;
+	}
+
+	resumable_count::resumable_count(const filtered_string_view& fsv)
+	: resumable_scan(fsv)
+	, count_(0) {}
+
+	auto resumable_count::count() const -> std::size_t {
+		return count_;
+	}
+
+	auto resumable_count::scan(std::size_t first, std::size_t last) -> std::size_t {
+		count_ += kernel::count(kernel::slice(view(), first, last - first), kernel_strategy());
+		return last;
+	}
+
+	resumable_string::resumable_string(const filtered_string_view& fsv)
+	: resumable_scan(fsv) {}
+
+	auto resumable_string::result() const -> const std::string& {
+		return result_;
+	}
+
+	auto resumable_string::take() -> std::string {
+		return std::exchange(result_, std::string());
+	}
+
+	auto resumable_string::scan(std::size_t first, std::size_t last) -> std::size_t {
+		kernel::append(kernel::slice(view(), first, last - first), kernel_strategy(), result_);
+		return last;
+	}
+
+	resumable_find::resumable_find(const filtered_string_view& fsv, const filtered_string_view& needle)
+	: resumable_scan(fsv)
+	, needle_(static_cast<std::string>(needle))
+	, failure_(failure_function(needle_))
+	, matched_(0)
+	, accepted_(0) {
+		if (needle_.empty()) {
+			result_ = 0;
+			stop();
+		}
+	}
+
+	auto resumable_find::result() const -> std::optional<std::size_t> {
+		return result_;
+	}
+
+	auto resumable_find::scan(std::size_t first, std::size_t last) -> std::size_t {
+		auto const data = view().data();
+		auto const s = kernel_strategy();
+		for (auto i = first; i < last; ++i) {
+			// rejected stretches are skipped with the view's kernel
+			i = static_cast<std::size_t>(kernel::next(view(), s, data + i, data + last) - data);
+			if (i == last) {
+				break;
+			}
+			++accepted_;
+			matched_ = advance(needle_, failure_, matched_, data[i]);
+			if (matched_ == needle_.size()) {
+				result_ = accepted_ - needle_.size();
+				stop();
+				return i + 1;
+			}
+		}
+		return last;
+	}
+
+	resumable_split::resumable_split(const filtered_string_view& fsv, const filtered_string_view& tok)
+	: resumable_scan(fsv)
+	, delimiter_(tok.data(), tok.length())
+	, failure_(failure_function(delimiter_))
+	, matched_(0)
+	, token_start_(0)
+	, published_(false) {}
+
+	auto resumable_split::tokens() const -> const std::vector<filtered_string_view>& {
+		static auto const none = std::vector<filtered_string_view>();
+		return published_ ? tokens_ : none;
+	}
+
+	auto resumable_split::take_tokens() -> std::vector<filtered_string_view> {
+		if (!published_) {
+			return {};
+		}
+		return std::exchange(tokens_, std::vector<filtered_string_view>());
+	}
+
+	auto resumable_split::scan(std::size_t first, std::size_t last) -> std::size_t {
+		if (delimiter_.empty()) {
+			return last;
+		}
+		// split() returns a view with no accepted characters whole, so tokens are held back until an
+		// accepted character has been seen
+		auto const data = view().data();
+		if (!published_) {
+			published_ = kernel::next(view(), kernel_strategy(), data + first, data + last) != data + last;
+		}
+		for (auto i = first; i < last; ++i) {
+			if (matched_ == 0) {
+				auto const found = std::memchr(data + i, delimiter_[0], last - i);
+				if (found == nullptr) {
+					break;
+				}
+				i = static_cast<std::size_t>(static_cast<const char*>(found) - data);
+			}
+			matched_ = advance(delimiter_, failure_, matched_, data[i]);
+			if (matched_ == delimiter_.size()) {
+				auto const start = i + 1 - delimiter_.size();
+				tokens_.push_back(kernel::slice(view(), token_start_, start - token_start_));
+				token_start_ = i + 1;
+				matched_ = 0;
+			}
+		}
+		return last;
+	}
+
+	auto resumable_split::finish() -> void {
+		if (delimiter_.empty() || !published_) {
+			tokens_ = {view()};
+			published_ = true;
+			return;
+		}
+		tokens_.push_back(kernel::slice(view(), token_start_, length() - token_start_));
+	}
+} // namespace fsv
@@ -0,0 +1,119 @@
+#ifndef COMP6771_ASS2_RESUMABLE_H
+#define COMP6771_ASS2_RESUMABLE_H
+
+#include "./filtered_string_view.h"
+#include "./strategy.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fsv {
+	// A scan over a view that does a bounded amount of work per step() and keeps its cursor in between, so
+	// an event loop can interleave a long scan with other work. The budget is counted in raw bytes of the
+	// underlying buffer, whatever the filter accepts; each step uses the kernels of the strategy the view
+	// would pick sequentially, never threads.
+	//
+	// A scan refers to the view's characters, which must outlive it.
+	class resumable_scan {
+	 public:
+		explicit resumable_scan(const filtered_string_view& fsv);
+		resumable_scan(const resumable_scan&) = default;
+		auto operator=(const resumable_scan&) -> resumable_scan& = default;
+		virtual ~resumable_scan() = default;
+
+		// examines at most budget more raw bytes; returns true once the scan has finished
+		auto step(std::size_t budget) -> bool;
+		auto done() const -> bool;
+		// raw bytes examined so far, out of length()
+		auto position() const -> std::size_t;
+		auto length() const -> std::size_t;
+
+	 protected:
+		// scans raw bytes [first, last) and returns where it stopped, which is last unless it called stop()
+		virtual auto scan(std::size_t first, std::size_t last) -> std::size_t = 0;
+		// called once when the whole buffer has been scanned without stop()
+		virtual auto finish() -> void {}
+		// ends the scan before the end of the buffer
+		auto stop() -> void;
+
+		auto view() const -> const filtered_string_view&;
+		auto kernel_strategy() const -> strategy;
+
+	 private:
+		filtered_string_view fsv_;
+		strategy strategy_;
+		std::size_t position_;
+		bool done_;
+	};
+
+	// size(), a step at a time
+	class resumable_count final : public resumable_scan {
+	 public:
+		explicit resumable_count(const filtered_string_view& fsv);
+		// accepted characters counted so far; size() of the view once done()
+		auto count() const -> std::size_t;
+
+	 private:
+		std::size_t count_;
+
+		auto scan(std::size_t first, std::size_t last) -> std::size_t override;
+	};
+
+	// operator std::string(), a step at a time
+	class resumable_string final : public resumable_scan {
+	 public:
+		explicit resumable_string(const filtered_string_view& fsv);
+		// accepted characters materialized so far
+		auto result() const -> const std::string&;
+		auto take() -> std::string;
+
+	 private:
+		std::string result_;
+
+		auto scan(std::size_t first, std::size_t last) -> std::size_t override;
+	};
+
+	// finds the first occurrence of needle's accepted characters among fsv's accepted characters
+	class resumable_find final : public resumable_scan {
+	 public:
+		resumable_find(const filtered_string_view& fsv, const filtered_string_view& needle);
+		// once done(), the index among fsv's accepted characters where the match starts, if there is one;
+		// an empty needle matches at 0
+		auto result() const -> std::optional<std::size_t>;
+
+	 private:
+		std::string needle_;
+		// Knuth-Morris-Pratt failure function of needle_, so a partial match survives between steps
+		std::vector<std::size_t> failure_;
+		std::size_t matched_;
+		std::size_t accepted_;
+		std::optional<std::size_t> result_;
+
+		auto scan(std::size_t first, std::size_t last) -> std::size_t override;
+	};
+
+	// split(), a step at a time; tokens become available as soon as their delimiter has been seen
+	class resumable_split final : public resumable_scan {
+	 public:
+		resumable_split(const filtered_string_view& fsv, const filtered_string_view& tok);
+		// tokens found and not yet taken
+		auto tokens() const -> const std::vector<filtered_string_view>&;
+		auto take_tokens() -> std::vector<filtered_string_view>;
+
+	 private:
+		std::string delimiter_;
+		std::vector<std::size_t> failure_;
+		std::size_t matched_;
+		std::size_t token_start_;
+		// false until the view is known to accept a character
+		bool published_;
+		std::vector<filtered_string_view> tokens_;
+
+		auto scan(std::size_t first, std::size_t last) -> std::size_t override;
+		auto finish() -> void override;
+	};
+} // namespace fsv
+
+#endif // COMP6771_ASS2_RESUMABLE_H
@@ -0,0 +1,143 @@
+#include "./resumable.h"
+#include "./char_class.h"
+
+#include <catch2/catch.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+	auto sample_text() -> std::string {
+		auto result = std::string();
+		for (auto i = 0; i < 2000; ++i) {
+			result += "ab" + std::to_string(i * 7) + ",;" + std::string(static_cast<std::size_t>(i % 13), 'z');
+		}
+		return result;
+	}
+
+	// steps scan with budget until it finishes, checking no step goes further than its budget
+	auto run(fsv::resumable_scan& scan, std::size_t budget) -> std::size_t {
+		auto steps = std::size_t{0};
+		while (!scan.done()) {
+			auto const before = scan.position();
+			scan.step(budget);
+			CHECK(scan.position() - before <= budget);
+			++steps;
+		}
+		return steps;
+	}
+
+	auto to_strings(const std::vector<fsv::filtered_string_view>& views) -> std::vector<std::string> {
+		auto result = std::vector<std::string>();
+		for (auto const& view : views) {
+			result.push_back(static_cast<std::string>(view));
+		}
+		return result;
+	}
+} // namespace
+
+TEST_CASE("resumable_count and resumable_string match size() and operator std::string()") {
+	auto const text = sample_text();
+	auto const views = std::vector<fsv::filtered_string_view>{
+	    fsv::filtered_string_view(text, fsv::char_class::range('0', '9')),
+	    fsv::filtered_string_view(text, [](const char& c) { return c != 'z'; }),
+	    fsv::filtered_string_view(text, fsv::char_class::range('q', 'q')),
+	};
+	for (auto const& view : views) {
+		for (auto const budget : {std::size_t{1}, std::size_t{7}, std::size_t{4096}, text.size()}) {
+			auto count = fsv::resumable_count(view);
+			auto const steps = run(count, budget);
+			CHECK(steps == (text.size() + budget - 1) / budget);
+			CHECK(count.count() == view.size());
+
+			auto string = fsv::resumable_string(view);
+			run(string, budget);
+			CHECK(string.result() == static_cast<std::string>(view));
+		}
+	}
+}
+
+TEST_CASE("resumable_string hands over what it has materialized so far") {
+	auto const view = fsv::filtered_string_view("a1b2c3d4", fsv::char_class::range('0', '9'));
+	auto string = fsv::resumable_string(view);
+	CHECK_FALSE(string.step(4));
+	CHECK(string.take() == "12");
+	CHECK(string.step(4));
+	CHECK(string.take() == "34");
+	CHECK(string.position() == string.length());
+}
+
+TEST_CASE("resumable_find finds a match that spans steps") {
+	auto const text = sample_text();
+	auto const digits = fsv::filtered_string_view(text, fsv::char_class::range('0', '9'));
+	auto const filtered = static_cast<std::string>(digits);
+	for (auto const* needle : {"13986", "0714", "99", "1111111", ""}) {
+		for (auto const budget : {std::size_t{1}, std::size_t{5}, std::size_t{1000}}) {
+			auto find = fsv::resumable_find(digits, fsv::filtered_string_view(needle));
+			run(find, budget);
+			auto const expected = filtered.find(needle);
+			if (expected == std::string::npos) {
+				CHECK_FALSE(find.result());
+				CHECK(find.position() == find.length());
+			}
+			else {
+				REQUIRE(find.result());
+				CHECK(*find.result() == expected);
+			}
+		}
+	}
+}
+
+TEST_CASE("resumable_find stops at the first match") {
+	auto const text = std::string("aaXbb") + std::string(10000, 'c');
+	auto find = fsv::resumable_find(fsv::filtered_string_view(text), fsv::filtered_string_view("Xb"));
+	CHECK(find.step(100));
+	CHECK(find.result() == 2);
+	CHECK(find.position() == 4);
+	// needles are compared by their accepted characters
+	auto const needle = fsv::filtered_string_view("-a-b-", [](const char& c) { return c != '-'; });
+	auto filtered = fsv::resumable_find(fsv::filtered_string_view("xxab"), needle);
+	filtered.step(2);
+	CHECK_FALSE(filtered.done());
+	CHECK(filtered.step(2));
+	CHECK(filtered.result() == 2);
+}
+
+TEST_CASE("resumable_split returns the tokens split returns") {
+	auto const text = sample_text();
+	auto const cases = std::vector<std::pair<fsv::filtered_string_view, std::string>>{
+	    {fsv::filtered_string_view(text, fsv::char_class::range('0', '9')), ",;"},
+	    {fsv::filtered_string_view(text, fsv::char_class::range('0', '9')), "zz"},
+	    {fsv::filtered_string_view(text, [](const char& c) { return c != 'a'; }), "b"},
+	    {fsv::filtered_string_view(text), ""},
+	    {fsv::filtered_string_view("//", fsv::char_class::range('0', '9')), "/"},
+	    {fsv::filtered_string_view(""), "/"},
+	};
+	for (auto const& [view, delimiter] : cases) {
+		auto const tok = fsv::filtered_string_view(delimiter);
+		auto const expected = to_strings(fsv::split(view, tok));
+		for (auto const budget : {std::size_t{1}, std::size_t{3}, std::size_t{4096}}) {
+			auto split = fsv::resumable_split(view, tok);
+			auto tokens = std::vector<fsv::filtered_string_view>();
+			while (!split.step(budget)) {
+				for (auto& token : split.take_tokens()) {
+					tokens.push_back(std::move(token));
+				}
+			}
+			for (auto& token : split.take_tokens()) {
+				tokens.push_back(std::move(token));
+			}
+			CHECK(to_strings(tokens) == expected);
+		}
+	}
+}
+
+TEST_CASE("resumable_split makes tokens available before the scan finishes") {
+	auto const text = std::string("1,2,3") + std::string(1000, 'x');
+	auto split = fsv::resumable_split(fsv::filtered_string_view(text), ",");
+	CHECK_FALSE(split.step(4));
+	CHECK(to_strings(split.tokens()) == std::vector<std::string>{"1", "2"});
+	split.take_tokens();
+	CHECK(split.tokens().empty());
+	run(split, 64);
+	CHECK(split.tokens().size() == 1);
+}
@@ -0,0 +1,173 @@
+#ifndef COMP6771_ASS2_RING_BUFFER_H
+#define COMP6771_ASS2_RING_BUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace fsv {
+	// Bounded single-producer single-consumer queue. Each side caches the other side's index and only
+	// reloads it when the ring looks full or empty, so in the steady state a push or pop touches no cache
+	// line the other thread is writing. Capacity is rounded up to a power of two.
+	template<typename T>
+	class spsc_ring {
+	 public:
+		explicit spsc_ring(std::size_t capacity)
+		: mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1)
+		, slots_(std::make_unique<T[]>(mask_ + 1))
+		, head_(0)
+		, cached_tail_(0)
+		, tail_(0)
+		, cached_head_(0) {}
+
+		spsc_ring(const spsc_ring&) = delete;
+		auto operator=(const spsc_ring&) -> spsc_ring& = delete;
+		~spsc_ring() = default;
+
+		auto capacity() const -> std::size_t {
+			return mask_ + 1;
+		}
+
+		// producer only; false if the ring is full, in which case value is left untouched
+		auto try_push(T&& value) -> bool {
+			auto const tail = tail_.load(std::memory_order_relaxed);
+			if (tail - cached_head_ > mask_) {
+				cached_head_ = head_.load(std::memory_order_acquire);
+				if (tail - cached_head_ > mask_) {
+					return false;
+				}
+			}
+			slots_[tail & mask_] = std::move(value);
+			tail_.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		// consumer only; moves up to max values to out and returns how many there were
+		template<typename OutputIt>
+		auto try_pop_batch(OutputIt out, std::size_t max) -> std::size_t {
+			auto const head = head_.load(std::memory_order_relaxed);
+			if (cached_tail_ - head < max) {
+				cached_tail_ = tail_.load(std::memory_order_acquire);
+			}
+			auto const count = std::min(max, cached_tail_ - head);
+			for (auto i = std::size_t{0}; i < count; ++i) {
+				*out++ = std::move(slots_[(head + i) & mask_]);
+			}
+			if (count != 0) {
+				head_.store(head + count, std::memory_order_release);
+			}
+			return count;
+		}
+
+		// consumer only
+		auto try_pop(T& value) -> bool {
+			return try_pop_batch(&value, 1) == 1;
+		}
+
+	 private:
+		std::size_t mask_;
+		std::unique_ptr<T[]> slots_;
+
+		// consumer side
+		alignas(64) std::atomic<std::size_t> head_;
+		std::size_t cached_tail_;
+		// producer side
+		alignas(64) std::atomic<std::size_t> tail_;
+		std::size_t cached_head_;
+	};
+
+	// Bounded multi-producer multi-consumer queue after Vyukov: every slot carries a sequence number saying
+	// which lap of the ring may write or read it next, so producers and consumers claim slots with one
+	// compare-exchange on their own index and never wait on each other's locks.
+	template<typename T>
+	class mpmc_ring {
+	 public:
+		explicit mpmc_ring(std::size_t capacity)
+		: mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1)
+		, cells_(std::make_unique<cell[]>(mask_ + 1))
+		, head_(0)
+		, tail_(0) {
+			for (auto i = std::size_t{0}; i <= mask_; ++i) {
+				cells_[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		mpmc_ring(const mpmc_ring&) = delete;
+		auto operator=(const mpmc_ring&) -> mpmc_ring& = delete;
+		~mpmc_ring() = default;
+
+		auto capacity() const -> std::size_t {
+			return mask_ + 1;
+		}
+
+		// false if the ring is full, in which case value is left untouched
+		auto try_push(T&& value) -> bool {
+			auto pos = tail_.load(std::memory_order_relaxed);
+			for (;;) {
+				auto& c = cells_[pos & mask_];
+				auto const sequence = c.sequence.load(std::memory_order_acquire);
+				if (sequence == pos) {
+					if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						c.value = std::move(value);
+						c.sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (sequence < pos) {
+					return false;
+				}
+				else {
+					pos = tail_.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		auto try_pop(T& value) -> bool {
+			auto pos = head_.load(std::memory_order_relaxed);
+			for (;;) {
+				auto& c = cells_[pos & mask_];
+				auto const sequence = c.sequence.load(std::memory_order_acquire);
+				if (sequence == pos + 1) {
+					if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						value = std::move(c.value);
+						c.sequence.store(pos + mask_ + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (sequence < pos + 1) {
+					return false;
+				}
+				else {
+					pos = head_.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		template<typename OutputIt>
+		auto try_pop_batch(OutputIt out, std::size_t max) -> std::size_t {
+			auto count = std::size_t{0};
+			auto value = T();
+			while (count < max && try_pop(value)) {
+				*out++ = std::move(value);
+				++count;
+			}
+			return count;
+		}
+
+	 private:
+		struct cell {
+			std::atomic<std::size_t> sequence;
+			T value;
+		};
+
+		std::size_t mask_;
+		std::unique_ptr<cell[]> cells_;
+		alignas(64) std::atomic<std::size_t> head_;
+		alignas(64) std::atomic<std::size_t> tail_;
+	};
+} // namespace fsv
+
+#endif // COMP6771_ASS2_RING_BUFFER_H
@@ -0,0 +1,362 @@
+#include "./scan.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <functional>
+
+#if defined(__x86_64__)
+#	include <immintrin.h>
+#endif
+
+namespace fsv::scan {
+	namespace {
+		constexpr auto block = std::size_t{64};
+
+		auto scalar_mask(const char* data, std::size_t length, const char_class& cls) -> std::uint64_t {
+			auto mask = std::uint64_t{0};
+			for (auto i = std::size_t{0}; i < length; ++i) {
+				mask |= static_cast<std::uint64_t>(cls.contains(data[i])) << i;
+			}
+			return mask;
+		}
+
+#if defined(__x86_64__)
+		// Muła's nibble lookup: the low nibble selects a row of membership bits, the high nibble selects
+		// the bit within that row (rows for high nibbles 8..15 live in a second table chosen by the sign bit)
+		struct nibble_tables {
+			__m256i low;
+			__m256i high;
+		};
+
+		[[gnu::target("avx2")]] auto make_tables(const char_class& cls) -> nibble_tables {
+			// the last class seen by this thread is remembered, since callers tend to scan with one class
+			// many times over short ranges
+			thread_local auto cached = char_class();
+			thread_local auto low = std::array<std::uint8_t, 16>();
+			thread_local auto high = std::array<std::uint8_t, 16>();
+			if (!(cached == cls)) {
+				cached = cls;
+				low = {};
+				high = {};
+				for (auto b = 0U; b < 256; ++b) {
+					if (cls.contains(static_cast<char>(b))) {
+						auto const row = b & 15U;
+						auto const column = b >> 4U;
+						if (column < 8) {
+							low[row] = static_cast<std::uint8_t>(low[row] | (1U << column));
+						}
+						else {
+							high[row] = static_cast<std::uint8_t>(high[row] | (1U << (column - 8)));
+						}
+					}
+				}
+			}
+			return {_mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(low.data()))),
+			        _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(high.data())))};
+		}
+
+		[[gnu::target("avx2")]] inline auto avx2_mask32(const char* data, const nibble_tables& tables)
+		    -> std::uint32_t {
+			auto const x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+			auto const nibble = _mm256_set1_epi8(0x0f);
+			auto const row_index = _mm256_and_si256(x, nibble);
+			auto const column = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+			auto const row = _mm256_blendv_epi8(_mm256_shuffle_epi8(tables.low, row_index),
+			                                    _mm256_shuffle_epi8(tables.high, row_index),
+			                                    x);
+			auto const bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+			                                   1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+			auto const hit = _mm256_and_si256(row, _mm256_shuffle_epi8(bits, column));
+			auto const miss = _mm256_cmpeq_epi8(hit, _mm256_setzero_si256());
+			return ~static_cast<std::uint32_t>(_mm256_movemask_epi8(miss));
+		}
+
+		[[gnu::target("avx2")]] inline auto avx2_mask64(const char* data, const nibble_tables& tables)
+		    -> std::uint64_t {
+			return std::uint64_t{avx2_mask32(data, tables)}
+			       | (std::uint64_t{avx2_mask32(data + 32, tables)} << 32U);
+		}
+
+		[[gnu::target("avx2")]] auto avx2_classify(const char* data,
+		                                           std::size_t length,
+		                                           const char_class& cls,
+		                                           std::uint64_t* out) -> std::size_t {
+			auto const tables = make_tables(cls);
+			auto i = std::size_t{0};
+			for (; i + block <= length; i += block) {
+				out[i / block] = avx2_mask64(data + i, tables);
+			}
+			return i;
+		}
+
+		[[gnu::target("avx2")]] auto
+		avx2_count(const char* data, std::size_t length, const char_class& cls, std::size_t& i) -> std::size_t {
+			auto const tables = make_tables(cls);
+			auto result = std::size_t{0};
+			for (; i + block <= length; i += block) {
+				result += static_cast<std::size_t>(std::popcount(avx2_mask64(data + i, tables)));
+			}
+			return result;
+		}
+
+		[[gnu::target("avx2")]] auto
+		avx2_find(const char* data, std::size_t length, const char_class& cls, bool member, std::size_t& i) -> bool {
+			auto const tables = make_tables(cls);
+			for (; i + block <= length; i += block) {
+				auto mask = avx2_mask64(data + i, tables);
+				mask = member ? mask : ~mask;
+				if (mask != 0) {
+					i += static_cast<std::size_t>(std::countr_zero(mask));
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// as avx2_find, from the end: searches [0, end) a block at a time downwards and sets end to one past
+		// the last byte not searched, or to the byte found
+		[[gnu::target("avx2")]] auto avx2_find_last(const char* data, const char_class& cls, std::size_t& end) -> bool {
+			auto const tables = make_tables(cls);
+			for (; end >= block; end -= block) {
+				auto const mask = avx2_mask64(data + end - block, tables);
+				if (mask != 0) {
+					end -= static_cast<std::size_t>(std::countl_zero(mask)) + 1;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// candidate positions p in [i, i + 32) where data[p] is the needle's first byte and
+		// data[p + m - 1] its last
+		[[gnu::target("avx2")]] inline auto
+		avx2_candidates(const char* data, std::size_t i, std::size_t m, __m256i first, __m256i last) -> std::uint32_t {
+			auto const at_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+			auto const at_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + m - 1));
+			auto const both = _mm256_and_si256(_mm256_cmpeq_epi8(at_first, first), _mm256_cmpeq_epi8(at_last, last));
+			return static_cast<std::uint32_t>(_mm256_movemask_epi8(both));
+		}
+
+		// searches the start positions [0, i_end) 32 at a time, where i_end leaves room for whole loads;
+		// sets i to the first start position not searched
+		[[gnu::target("avx2")]] auto
+		avx2_find_substring(const char* data, std::size_t length, std::string_view needle, std::size_t& i) -> bool {
+			auto const m = needle.size();
+			auto const first = _mm256_set1_epi8(needle.front());
+			auto const last = _mm256_set1_epi8(needle.back());
+			for (; i + m - 1 + 32 <= length; i += 32) {
+				for (auto mask = avx2_candidates(data, i, m, first, last); mask != 0; mask &= mask - 1) {
+					auto const p = i + static_cast<std::size_t>(std::countr_zero(mask));
+					if (std::memcmp(data + p + 1, needle.data() + 1, m - 2) == 0) {
+						i = p;
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		// for each 8-bit membership mask, the pshufb indices that move the member bytes of an 8-byte group to
+		// its front, in order
+		constexpr auto pack_indices = [] {
+			auto result = std::array<std::uint64_t, 256>();
+			for (auto m = 0U; m < 256; ++m) {
+				auto k = 0U;
+				for (auto bit = 0U; bit < 8; ++bit) {
+					if ((m >> bit & 1U) != 0) {
+						result[m] |= std::uint64_t{bit} << (8 * k++);
+					}
+				}
+			}
+			return result;
+		}();
+
+		// Copies the members of each whole 64-byte block to out. Groups of 8 bytes are packed with one shuffle
+		// and an 8-byte store, which may write past the group's members but never past the block's, whose
+		// count is known before any is stored; the last group or two of a block go byte by byte.
+		[[gnu::target("avx2")]] auto
+		avx2_compact(const char* data, std::size_t length, const char_class& cls, char*& out) -> std::size_t {
+			auto const tables = make_tables(cls);
+			auto i = std::size_t{0};
+			for (; i + block <= length; i += block) {
+				auto const mask = avx2_mask64(data + i, tables);
+				if (mask == ~std::uint64_t{0}) {
+					std::memcpy(out, data + i, block);
+					out += block;
+					continue;
+				}
+				auto const end = out + std::popcount(mask);
+				for (auto group = 0U; group < 8 && out != end; ++group) {
+					auto const bits = static_cast<unsigned>(mask >> (8 * group)) & 0xffU;
+					auto const source = data + i + 8 * group;
+					if (end - out >= 8) {
+						auto const bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source));
+						auto const indices = _mm_cvtsi64_si128(static_cast<long long>(pack_indices[bits]));
+						_mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(bytes, indices));
+						out += std::popcount(bits);
+						continue;
+					}
+					for (auto rest = bits; rest != 0; rest &= rest - 1) {
+						*out++ = source[std::countr_zero(rest)];
+					}
+				}
+			}
+			return i;
+		}
+
+		// as above, from the end: searches the start positions [0, end) 32 at a time downwards, and sets end
+		// to one past the last start position not searched
+		[[gnu::target("avx2")]] auto
+		avx2_rfind_substring(const char* data, std::string_view needle, std::size_t& end) -> bool {
+			auto const m = needle.size();
+			auto const first = _mm256_set1_epi8(needle.front());
+			auto const last = _mm256_set1_epi8(needle.back());
+			for (; end >= 32; end -= 32) {
+				auto const i = end - 32;
+				for (auto mask = avx2_candidates(data, i, m, first, last); mask != 0;) {
+					auto const bit = 31 - std::countl_zero(mask);
+					auto const p = i + static_cast<std::size_t>(bit);
+					if (std::memcmp(data + p + 1, needle.data() + 1, m - 2) == 0) {
+						end = p;
+						return true;
+					}
+					mask &= ~(std::uint32_t{1} << static_cast<unsigned>(bit));
+				}
+			}
+			return false;
+		}
+#endif
+
+		// needles longer than this skip ahead with Horspool instead of checking first and last bytes
+		constexpr auto short_needle = std::size_t{32};
+
+		auto find(const char* data, std::size_t length, const char_class& cls, bool member) -> std::size_t {
+			auto i = std::size_t{0};
+#if defined(__x86_64__)
+			if (vectorized() && avx2_find(data, length, cls, member, i)) {
+				return i;
+			}
+#endif
+			for (; i < length; ++i) {
+				if (cls.contains(data[i]) == member) {
+					return i;
+				}
+			}
+			return length;
+		}
+	} // namespace
+
+	auto vectorized() -> bool {
+#if defined(__x86_64__)
+		static auto const supported = __builtin_cpu_supports("avx2") != 0;
+		return supported;
+#else
+		return false;
+#endif
+	}
+
+	auto classify(const char* data, std::size_t length, const char_class& cls, std::uint64_t* out) -> void {
+		auto i = std::size_t{0};
+#if defined(__x86_64__)
+		if (vectorized()) {
+			i = avx2_classify(data, length, cls, out);
+		}
+#endif
+		for (; i < length; i += block) {
+			out[i / block] = scalar_mask(data + i, std::min(block, length - i), cls);
+		}
+	}
+
+	auto count(const char* data, std::size_t length, const char_class& cls) -> std::size_t {
+		auto i = std::size_t{0};
+		auto result = std::size_t{0};
+#if defined(__x86_64__)
+		if (vectorized()) {
+			result = avx2_count(data, length, cls, i);
+		}
+#endif
+		for (; i < length; ++i) {
+			result += static_cast<std::size_t>(cls.contains(data[i]));
+		}
+		return result;
+	}
+
+	auto compact(const char* data, std::size_t length, const char_class& cls, char* out) -> char* {
+		auto i = std::size_t{0};
+#if defined(__x86_64__)
+		if (vectorized()) {
+			i = avx2_compact(data, length, cls, out);
+		}
+#endif
+		return std::copy_if(data + i, data + length, out, cls);
+	}
+
+	auto find_first(const char* data, std::size_t length, const char_class& cls) -> std::size_t {
+		return find(data, length, cls, true);
+	}
+
+	auto find_first_not(const char* data, std::size_t length, const char_class& cls) -> std::size_t {
+		return find(data, length, cls, false);
+	}
+
+	auto find_last(const char* data, std::size_t length, const char_class& cls) -> std::size_t {
+		auto end = length;
+#if defined(__x86_64__)
+		if (vectorized() && avx2_find_last(data, cls, end)) {
+			return end;
+		}
+#endif
+		while (end > 0) {
+			if (cls.contains(data[--end])) {
+				return end;
+			}
+		}
+		return length;
+	}
+
+	auto find_substring(const char* data, std::size_t length, std::string_view needle) -> std::size_t {
+		auto const m = needle.size();
+		if (m > length) {
+			return length;
+		}
+		if (m == 0) {
+			return 0;
+		}
+		if (m == 1) {
+			auto const found = std::memchr(data, needle.front(), length);
+			return found == nullptr ? length : static_cast<std::size_t>(static_cast<const char*>(found) - data);
+		}
+		if (m > short_needle) {
+			auto const searcher = std::boyer_moore_horspool_searcher(needle.begin(), needle.end());
+			return static_cast<std::size_t>(std::search(data, data + length, searcher) - data);
+		}
+		auto i = std::size_t{0};
+#if defined(__x86_64__)
+		if (vectorized() && avx2_find_substring(data, length, needle, i)) {
+			return i;
+		}
+#endif
+		auto const found = std::string_view(data + i, length - i).find(needle);
+		return found == std::string_view::npos ? length : i + found;
+	}
+
+	auto rfind_substring(const char* data, std::size_t length, std::string_view needle) -> std::size_t {
+		auto const m = needle.size();
+		if (m > length) {
+			return length;
+		}
+		if (m == 0) {
+			return length;
+		}
+		// start positions [0, end) remain to be searched
+		auto end = length - m + 1;
+#if defined(__x86_64__)
+		if (m >= 2 && m <= short_needle && vectorized() && avx2_rfind_substring(data, needle, end)) {
+			return end;
+		}
+#endif
+		auto const found = std::string_view(data, end + m - 1).rfind(needle);
+		return found == std::string_view::npos ? length : found;
+	}
+} // namespace fsv::scan
@@ -0,0 +1,46 @@
+#ifndef COMP6771_ASS2_SCAN_H
+#define COMP6771_ASS2_SCAN_H
+
+#include "./char_class.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Bulk classification kernels over raw bytes. Each has a portable table-driven version and, on x86-64
+// machines that support it, an AVX2 version selected at runtime.
+namespace fsv::scan {
+	// writes one bit per byte of [data, data + length) into out, 64 bytes per word, least significant bit
+	// first; out must hold (length + 63) / 64 words and unused high bits of the last word are cleared
+	auto classify(const char* data, std::size_t length, const char_class& cls, std::uint64_t* out) -> void;
+
+	// number of bytes in [data, data + length) that belong to cls
+	auto count(const char* data, std::size_t length, const char_class& cls) -> std::size_t;
+
+	// copies the bytes of [data, data + length) that belong to cls to out, in order, and returns the end of
+	// what was written; nothing past it is touched
+	auto compact(const char* data, std::size_t length, const char_class& cls, char* out) -> char*;
+
+	// offset of the first byte that belongs to cls, or length if there is none
+	auto find_first(const char* data, std::size_t length, const char_class& cls) -> std::size_t;
+
+	// offset of the first byte that does not belong to cls, or length if there is none
+	auto find_first_not(const char* data, std::size_t length, const char_class& cls) -> std::size_t;
+
+	// offset of the last byte that belongs to cls, or length if there is none
+	auto find_last(const char* data, std::size_t length, const char_class& cls) -> std::size_t;
+
+	// offset of the first occurrence of needle in [data, data + length), or length if there is none. Needles
+	// of up to 32 bytes are located by comparing their first and last bytes at 32 positions at once and
+	// checking the candidates; longer ones use Boyer-Moore-Horspool. An empty needle is found at 0.
+	auto find_substring(const char* data, std::size_t length, std::string_view needle) -> std::size_t;
+
+	// offset of the last occurrence of needle in [data, data + length), or length if there is none; an empty
+	// needle is found at length
+	auto rfind_substring(const char* data, std::size_t length, std::string_view needle) -> std::size_t;
+
+	// true when the AVX2 kernels are in use on this machine
+	auto vectorized() -> bool;
+} // namespace fsv::scan
+
+#endif // COMP6771_ASS2_SCAN_H
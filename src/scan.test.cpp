@@ -0,0 +1,114 @@
+#include "./scan.h"
+#include "./filtered_string_view.h"
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+	auto random_bytes(std::size_t length) -> std::string {
+		auto engine = std::mt19937(6771);
+		auto dist = std::uniform_int_distribution<int>(0, 255);
+		auto result = std::string(length, '\0');
+		for (auto& c : result) {
+			c = static_cast<char>(dist(engine));
+		}
+		return result;
+	}
+} // namespace
+
+TEST_CASE("char_class membership") {
+	constexpr auto digits = fsv::char_class::range('0', '9');
+	static_assert(digits.contains('5'));
+	static_assert(!digits.contains('a'));
+	auto const vowels = fsv::char_class("aeiou");
+	REQUIRE(vowels.count() == 5);
+	REQUIRE((vowels | digits).count() == 15);
+	REQUIRE((vowels & digits).count() == 0);
+	REQUIRE((~vowels).count() == 251);
+	REQUIRE(fsv::char_class::all().contains('\xff'));
+	REQUIRE(fsv::char_class::from([](const char& c) { return c == 'x' || c == '\x80'; }) == fsv::char_class("x\x80"));
+}
+
+TEST_CASE("filtered_string_view with a char_class") {
+	auto sv = fsv::filtered_string_view{"a1b2c3", fsv::char_class::range('0', '9')};
+	REQUIRE(sv.table().has_value());
+	REQUIRE(static_cast<std::string>(sv) == "123");
+	auto copy = sv;
+	REQUIRE(copy.table() == sv.table());
+	auto moved = std::move(copy);
+	REQUIRE(moved.table().has_value());
+	REQUIRE(!copy.table().has_value());
+	REQUIRE(!fsv::filtered_string_view{"abc"}.table().has_value());
+}
+
+TEST_CASE("scan kernels agree with per-byte classification") {
+	auto const classes = std::vector<fsv::char_class>{
+	    fsv::char_class(),
+	    fsv::char_class::all(),
+	    fsv::char_class(" \t\n"),
+	    fsv::char_class::range('\x80', '\xff'),
+	    fsv::char_class::range('a', 'z') | fsv::char_class("\x01\x7f\xfe"),
+	};
+	for (auto const length : {0UL, 1UL, 63UL, 64UL, 65UL, 1000UL, 4099UL}) {
+		auto const bytes = random_bytes(length);
+		for (auto const& cls : classes) {
+			auto expected_count = std::size_t{0};
+			auto first = length;
+			auto first_not = length;
+			auto last = length;
+			auto masks = std::vector<std::uint64_t>((length + 63) / 64, ~std::uint64_t{0});
+			fsv::scan::classify(bytes.data(), length, cls, masks.data());
+			for (auto i = std::size_t{0}; i < length; ++i) {
+				auto const member = cls.contains(bytes[i]);
+				expected_count += member ? 1 : 0;
+				first = (member && first == length) ? i : first;
+				first_not = (!member && first_not == length) ? i : first_not;
+				last = member ? i : last;
+				REQUIRE(((masks[i / 64] >> (i % 64)) & 1U) == (member ? 1U : 0U));
+			}
+			if (length % 64 != 0) {
+				REQUIRE((masks.back() >> (length % 64)) == 0);
+			}
+			REQUIRE(fsv::scan::count(bytes.data(), length, cls) == expected_count);
+			REQUIRE(fsv::scan::find_first(bytes.data(), length, cls) == first);
+			REQUIRE(fsv::scan::find_first_not(bytes.data(), length, cls) == first_not);
+			REQUIRE(fsv::scan::find_last(bytes.data(), length, cls) == last);
+
+			auto expected = std::string();
+			std::copy_if(bytes.begin(), bytes.end(), std::back_inserter(expected), cls);
+			auto out = std::string(length + 8, '#');
+			auto const end = fsv::scan::compact(bytes.data(), length, cls, out.data());
+			REQUIRE(std::string(out.data(), end) == expected);
+			// nothing is written past the members
+			REQUIRE(out.substr(expected.size()) == std::string(out.size() - expected.size(), '#'));
+		}
+	}
+}
+
+TEST_CASE("substring search agrees with std::string_view") {
+	// a small alphabet, so partial matches are frequent
+	auto text = random_bytes(5000);
+	for (auto& c : text) {
+		c = static_cast<char>('a' + static_cast<unsigned char>(c) % 3);
+	}
+	auto const view = std::string_view(text);
+	for (auto const m : {1, 2, 3, 5, 8, 17, 32, 33, 40}) {
+		for (auto const at : {std::size_t{0}, std::size_t{31}, std::size_t{1234}, text.size() - 40}) {
+			auto const needle = view.substr(at, static_cast<std::size_t>(m));
+			for (auto const length : {text.size(), std::size_t{100}, std::size_t{33}, std::size_t{2}}) {
+				auto const haystack = view.substr(0, length);
+				auto const first = haystack.find(needle);
+				auto const last = haystack.rfind(needle);
+				REQUIRE(fsv::scan::find_substring(text.data(), length, needle) == std::min(first, length));
+				REQUIRE(fsv::scan::rfind_substring(text.data(), length, needle) == std::min(last, length));
+			}
+		}
+	}
+	REQUIRE(fsv::scan::find_substring(text.data(), text.size(), "abcabcabcx") == text.size());
+	REQUIRE(fsv::scan::find_substring(text.data(), 10, "") == 0);
+	REQUIRE(fsv::scan::rfind_substring(text.data(), 10, "") == 10);
+}
@@ -0,0 +1,249 @@
+#include "./sparse_view.h"
+#include "./scan.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace fsv {
+	sparse_view::sparse_view(const filtered_string_view& fsv)
+	: sparse_view(fsv, encoding::u16) {
+		// the u16 index is always built first; switch if absolute positions turn out smaller
+		auto const u32_bytes = positions16_.size() * sizeof(std::uint32_t);
+		if (length_ <= std::numeric_limits<std::uint32_t>::max() && u32_bytes < memory_usage()) {
+			positions32_.reserve(positions16_.size());
+			for (auto i = std::size_t{0}; i < positions16_.size(); ++i) {
+				positions32_.push_back(static_cast<std::uint32_t>(position(i)));
+			}
+			positions16_ = {};
+			block_starts_ = {};
+			encoding_ = encoding::u32;
+		}
+	}
+
+	sparse_view::sparse_view(const filtered_string_view& fsv, encoding enc)
+	: data_(fsv.data())
+	, length_(fsv.length())
+	, encoding_(enc) {
+		if (enc == encoding::u32 && length_ > std::numeric_limits<std::uint32_t>::max()) {
+			throw std::length_error{"sparse_view: u32 encoding cannot address " + std::to_string(length_) + " bytes"};
+		}
+
+		auto const blocks = (length_ + block_size - 1) / block_size;
+		auto emit = [this, enc](std::size_t offset) {
+			if (enc == encoding::u32) {
+				positions32_.push_back(static_cast<std::uint32_t>(offset));
+			}
+			else {
+				positions16_.push_back(static_cast<std::uint16_t>(offset % block_size));
+			}
+		};
+
+		if (enc == encoding::u16) {
+			block_starts_.reserve(blocks + 1);
+		}
+		auto masks = std::array<std::uint64_t, block_size / 64>();
+		for (auto b = std::size_t{0}; b < blocks; ++b) {
+			if (enc == encoding::u16) {
+				block_starts_.push_back(positions16_.size());
+			}
+			auto const begin = b * block_size;
+			auto const count = std::min(block_size, length_ - begin);
+			if (fsv.table()) {
+				// one classification pass per block, then only the set bits are visited
+				scan::classify(data_ + begin, count, *fsv.table(), masks.data());
+				for (auto w = std::size_t{0}; w < (count + 63) / 64; ++w) {
+					for (auto mask = masks[w]; mask != 0; mask &= mask - 1) {
+						emit(begin + w * 64 + static_cast<std::size_t>(std::countr_zero(mask)));
+					}
+				}
+			}
+			else {
+				for (auto i = begin; i < begin + count; ++i) {
+					if (fsv.predicate()(data_[i])) {
+						emit(i);
+					}
+				}
+			}
+		}
+		if (enc == encoding::u16) {
+			block_starts_.push_back(positions16_.size());
+		}
+	}
+
+	auto sparse_view::block_of(std::size_t index) const -> std::size_t {
+		auto const next = std::upper_bound(block_starts_.begin(), block_starts_.end(), index);
+		return static_cast<std::size_t>(next - block_starts_.begin()) - 1;
+	}
+
+	auto sparse_view::position(std::size_t index) const -> std::size_t {
+		if (encoding_ == encoding::u32) {
+			return positions32_[index];
+		}
+		return block_of(index) * block_size + positions16_[index];
+	}
+
+	auto sparse_view::operator[](std::size_t index) const -> const char& {
+		if (index >= size()) {
+			throw std::out_of_range{"sparse_view::operator[](" + std::to_string(index) + "): invalid index"};
+		}
+		return data_[position(index)];
+	}
+
+	sparse_view::operator std::string() const {
+		auto result = std::string();
+		result.reserve(size());
+		for (auto c : *this) {
+			result.push_back(c);
+		}
+		return result;
+	}
+
+	auto sparse_view::at(std::size_t index) const -> const char& {
+		if (index >= size()) {
+			throw std::domain_error{"sparse_view::at(" + std::to_string(index) + "): invalid index"};
+		}
+		return data_[position(index)];
+	}
+
+	auto sparse_view::size() const -> std::size_t {
+		return encoding_ == encoding::u32 ? positions32_.size() : positions16_.size();
+	}
+
+	auto sparse_view::empty() const -> bool {
+		return size() == 0;
+	}
+
+	auto sparse_view::data() const -> const char* {
+		return data_;
+	}
+
+	auto sparse_view::length() const -> std::size_t {
+		return length_;
+	}
+
+	auto sparse_view::storage() const -> encoding {
+		return encoding_;
+	}
+
+	auto sparse_view::memory_usage() const -> std::size_t {
+		return positions32_.size() * sizeof(std::uint32_t) + positions16_.size() * sizeof(std::uint16_t)
+		       + block_starts_.size() * sizeof(std::size_t);
+	}
+
+	auto operator<<(std::ostream& os, const sparse_view& sv) -> std::ostream& {
+		for (auto c : sv) {
+			os << c;
+		}
+		return os;
+	}
+
+	// iterator functions
+	auto sparse_view::begin() const -> const_iterator {
+		return const_iterator(this, 0);
+	}
+
+	auto sparse_view::end() const -> const_iterator {
+		return const_iterator(this, size());
+	}
+
+	auto sparse_view::cbegin() const -> const_iterator {
+		return begin();
+	}
+
+	auto sparse_view::cend() const -> const_iterator {
+		return end();
+	}
+
+	auto sparse_view::rbegin() const -> const_reverse_iterator {
+		return const_reverse_iterator(end());
+	}
+
+	auto sparse_view::rend() const -> const_reverse_iterator {
+		return const_reverse_iterator(begin());
+	}
+
+	// iterator class implementation
+	sparse_view::iter::iter()
+	: view_(nullptr)
+	, index_(0)
+	, block_(0) {}
+
+	sparse_view::iter::iter(const sparse_view* view, std::size_t index)
+	: view_(view)
+	, index_(index)
+	, block_(0) {
+		if (view_->encoding_ == encoding::u16 && index_ < view_->size()) {
+			block_ = view_->block_of(index_);
+		}
+	}
+
+	void sparse_view::iter::seek() {
+		if (view_->encoding_ != encoding::u16 || index_ >= view_->size()) {
+			return;
+		}
+		auto const& starts = view_->block_starts_;
+		while (starts[block_ + 1] <= index_) {
+			++block_;
+		}
+		while (starts[block_] > index_) {
+			--block_;
+		}
+	}
+
+	auto sparse_view::iter::operator*() const -> reference {
+		if (view_->encoding_ == encoding::u32) {
+			return view_->data_[view_->positions32_[index_]];
+		}
+		return view_->data_[block_ * block_size + view_->positions16_[index_]];
+	}
+
+	auto sparse_view::iter::operator++() -> iter& {
+		++index_;
+		seek();
+		return *this;
+	}
+
+	auto sparse_view::iter::operator++(int) -> iter {
+		iter temp = *this;
+		++*this;
+		return temp;
+	}
+
+	auto sparse_view::iter::operator--() -> iter& {
+		--index_;
+		seek();
+		return *this;
+	}
+
+	auto sparse_view::iter::operator--(int) -> iter {
+		iter temp = *this;
+		--*this;
+		return temp;
+	}
+
+	auto operator==(const sparse_view::iterator& lhs, const sparse_view::iterator& rhs) -> bool {
+		return lhs.index_ == rhs.index_;
+	}
+
+	auto operator!=(const sparse_view::iterator& lhs, const sparse_view::iterator& rhs) -> bool {
+		return !(lhs == rhs);
+	}
+
+	auto density(const filtered_string_view& fsv, std::size_t sample) -> double {
+		auto const count = std::min(sample, fsv.length());
+		if (count == 0) {
+			return 0.0;
+		}
+		auto const accepted = fsv.table() ? scan::count(fsv.data(), count, *fsv.table())
+		                                  : static_cast<std::size_t>(
+		                                      std::count_if(fsv.data(), fsv.data() + count, fsv.predicate()));
+		return static_cast<double>(accepted) / static_cast<double>(count);
+	}
+
+	auto prefers_sparse(const filtered_string_view& fsv) -> bool {
+		return density(fsv) < sparse_view::density_threshold;
+	}
+} // namespace fsv
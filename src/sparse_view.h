@@ -0,0 +1,108 @@
+#ifndef COMP6771_ASS2_SPARSE_VIEW_H
+#define COMP6771_ASS2_SPARSE_VIEW_H
+
+#include "./filtered_string_view.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fsv {
+	// The accepted positions of a highly selective view, stored once so that later passes touch only the
+	// characters that survived the filter instead of every raw byte.
+	//
+	// Two encodings are available:
+	//  - u16: positions relative to the start of their 64 KiB block, plus the index of each block's first
+	//         position (2 bytes per accepted character plus 8 bytes per block);
+	//  - u32: absolute 32-bit positions (4 bytes per accepted character, views under 4 GiB only).
+	class sparse_view {
+		class iter {
+		 public:
+			using iterator_category = std::bidirectional_iterator_tag;
+			using value_type = char;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = const char&;
+
+			iter();
+			iter(const sparse_view* view, std::size_t index);
+
+			auto operator*() const -> reference;
+
+			auto operator++() -> iter&;
+			auto operator++(int) -> iter;
+			auto operator--() -> iter&;
+			auto operator--(int) -> iter;
+
+			friend auto operator==(const iter&, const iter&) -> bool;
+			friend auto operator!=(const iter&, const iter&) -> bool;
+
+		 private:
+			const sparse_view* view_;
+			std::size_t index_;
+			// block containing index_, only maintained for the u16 encoding
+			std::size_t block_;
+			void seek();
+		};
+
+	 public:
+		enum class encoding { u16, u32 };
+
+		using iterator = iter;
+		using const_iterator = iter;
+		using reverse_iterator = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+		static constexpr std::size_t block_size = std::size_t{1} << 16U;
+		// views accepting less than this fraction of their bytes are worth storing sparsely
+		static constexpr double density_threshold = 0.01;
+
+		// picks whichever encoding takes less memory for this view
+		explicit sparse_view(const filtered_string_view& fsv);
+		sparse_view(const filtered_string_view& fsv, encoding enc);
+
+		auto operator[](std::size_t index) const -> const char&;
+		explicit operator std::string() const;
+
+		auto at(std::size_t index) const -> const char&;
+		auto size() const -> std::size_t;
+		auto empty() const -> bool;
+		auto data() const -> const char*;
+		auto length() const -> std::size_t;
+		auto storage() const -> encoding;
+		// bytes held by the position index
+		auto memory_usage() const -> std::size_t;
+		// raw offset of the index-th accepted character
+		auto position(std::size_t index) const -> std::size_t;
+
+		auto begin() const -> const_iterator;
+		auto end() const -> const_iterator;
+		auto cbegin() const -> const_iterator;
+		auto cend() const -> const_iterator;
+		auto rbegin() const -> const_reverse_iterator;
+		auto rend() const -> const_reverse_iterator;
+
+		friend auto operator<<(std::ostream& os, const sparse_view& sv) -> std::ostream&;
+
+	 private:
+		const char* data_;
+		std::size_t length_;
+		encoding encoding_;
+		std::vector<std::uint32_t> positions32_;
+		std::vector<std::uint16_t> positions16_;
+		// block_starts_[b] is the index of the first position in block b; one extra entry holds size()
+		std::vector<std::size_t> block_starts_;
+
+		auto block_of(std::size_t index) const -> std::size_t;
+	};
+
+	// fraction of the first sample bytes of fsv that its predicate accepts
+	auto density(const filtered_string_view& fsv, std::size_t sample = sparse_view::block_size) -> double;
+
+	// true when fsv is selective enough that a sparse_view will pay for itself
+	auto prefers_sparse(const filtered_string_view& fsv) -> bool;
+} // namespace fsv
+
+#endif // COMP6771_ASS2_SPARSE_VIEW_H
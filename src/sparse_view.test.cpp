@@ -0,0 +1,73 @@
+#include "./sparse_view.h"
+
+#include <catch2/catch.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+	// prose with a digit every 200 bytes: well under 1% dense
+	auto sparse_text(std::size_t length) -> std::string {
+		auto result = std::string(length, 'x');
+		for (auto i = std::size_t{0}; i < length; i += 200) {
+			result[i] = static_cast<char>('0' + (i / 200) % 10);
+		}
+		return result;
+	}
+} // namespace
+
+TEST_CASE("sparse_view over an empty view") {
+	auto sv = fsv::sparse_view(fsv::filtered_string_view{""});
+	REQUIRE(sv.empty());
+	REQUIRE(sv.begin() == sv.end());
+	REQUIRE(static_cast<std::string>(sv).empty());
+	REQUIRE_THROWS_AS(sv.at(0), std::domain_error);
+}
+
+TEST_CASE("sparse_view matches the filtered view in both encodings") {
+	auto const text = sparse_text(300000);
+	auto const is_digit = [](const char& c) { return c >= '0' && c <= '9'; };
+	auto const views = std::vector<fsv::filtered_string_view>{
+	    fsv::filtered_string_view{text, is_digit},
+	    fsv::filtered_string_view{text, fsv::char_class::range('0', '9')},
+	};
+	for (auto const& view : views) {
+		auto const expected = static_cast<std::string>(view);
+		for (auto const enc : {fsv::sparse_view::encoding::u16, fsv::sparse_view::encoding::u32}) {
+			auto const sv = fsv::sparse_view(view, enc);
+			REQUIRE(sv.storage() == enc);
+			REQUIRE(sv.size() == expected.size());
+			REQUIRE(static_cast<std::string>(sv) == expected);
+			REQUIRE(std::string(sv.rbegin(), sv.rend()) == std::string(expected.rbegin(), expected.rend()));
+			for (auto i = std::size_t{0}; i < expected.size(); i += 37) {
+				REQUIRE(sv[i] == expected[i]);
+				REQUIRE(sv.position(i) == i * 200);
+			}
+			REQUIRE_THROWS_AS(sv[expected.size()], std::out_of_range);
+			auto oss = std::ostringstream();
+			oss << sv;
+			REQUIRE(oss.str() == expected);
+		}
+	}
+}
+
+TEST_CASE("sparse_view picks the smaller encoding") {
+	auto const text = sparse_text(300000);
+	auto const dense = fsv::sparse_view(fsv::filtered_string_view{text, fsv::char_class::range('0', '9')});
+	REQUIRE(dense.storage() == fsv::sparse_view::encoding::u16);
+	REQUIRE(dense.memory_usage() < dense.size() * 4);
+
+	auto const lonely = std::string(300000, ' ') + "7";
+	auto const tiny = fsv::sparse_view(fsv::filtered_string_view{lonely, fsv::char_class("7")});
+	REQUIRE(tiny.storage() == fsv::sparse_view::encoding::u32);
+	REQUIRE(tiny.memory_usage() == 4);
+	REQUIRE(tiny[0] == '7');
+}
+
+TEST_CASE("density decides when to go sparse") {
+	auto const text = sparse_text(100000);
+	REQUIRE(fsv::prefers_sparse(fsv::filtered_string_view{text, fsv::char_class::range('0', '9')}));
+	REQUIRE(!fsv::prefers_sparse(fsv::filtered_string_view{text}));
+	REQUIRE(fsv::density(fsv::filtered_string_view{text}) == 1.0);
+	REQUIRE(fsv::density(fsv::filtered_string_view{""}) == 0.0);
+}
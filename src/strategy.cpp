@@ -0,0 +1,399 @@
+#include "./strategy.h"
+#include "./filtered_string_view.h"
+#include "./parallel.h"
+#include "./scan.h"
+#include "./sparse_view.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace fsv {
+	namespace {
+		auto profile_mutex = std::mutex();
+
+		// A profile that cannot be loaded leaves the defaults in place, since tuning must never stop views from
+		// working; the error is reported once, as this runs once.
+		auto initial_profile() -> strategy_profile {
+			auto const* path = std::getenv("FSV_PROFILE");
+			if (path == nullptr) {
+				return strategy_profile();
+			}
+			try {
+				return strategy_profile::load(path);
+			} catch (const std::exception& e) {
+				std::cerr << "FSV_PROFILE: " << e.what() << "; using the default profile\n";
+				return strategy_profile();
+			}
+		}
+
+		auto profile_storage() -> strategy_profile& {
+			static auto profile = initial_profile();
+			return profile;
+		}
+
+		// bumped by every set_active_profile()
+		auto profile_generation = std::atomic<std::uint64_t>(0);
+
+		// This thread's copy of the active profile, so that selecting a strategy for a short view does not
+		// take the profile mutex. It is refreshed once set_active_profile() has bumped the generation.
+		auto cached_profile() -> const strategy_profile& {
+			thread_local auto generation = std::numeric_limits<std::uint64_t>::max();
+			thread_local auto profile = strategy_profile();
+			if (auto const current = profile_generation.load(std::memory_order_acquire); current != generation) {
+				profile = active_profile();
+				generation = current;
+			}
+			return profile;
+		}
+
+		// the strategy actually usable for fsv: table-based strategies need a char_class
+		auto effective(const filtered_string_view& fsv, strategy s) -> strategy {
+			if (!fsv.table() && s != strategy::parallel) {
+				return strategy::scalar;
+			}
+			if (s == strategy::simd && !scan::vectorized()) {
+				return strategy::table;
+			}
+			return s;
+		}
+
+		template<typename F>
+		auto time_of(F fn) -> double {
+			auto best = std::numeric_limits<double>::max();
+			for (auto attempt = 0; attempt < 3; ++attempt) {
+				auto const start = std::chrono::steady_clock::now();
+				fn();
+				auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+				best = std::min(best, elapsed.count());
+			}
+			return best;
+		}
+
+		// a buffer of letters where roughly density of the bytes are digits
+		auto synthetic(std::size_t length, double density) -> std::string {
+			auto engine = std::mt19937(6771);
+			auto dist = std::uniform_real_distribution<double>(0.0, 1.0);
+			auto result = std::string(length, 'x');
+			for (auto& c : result) {
+				c = dist(engine) < density ? '7' : 'x';
+			}
+			return result;
+		}
+	} // namespace
+
+	auto to_string(strategy s) -> std::string_view {
+		switch (s) {
+		case strategy::automatic: return "automatic";
+		case strategy::scalar: return "scalar";
+		case strategy::table: return "table";
+		case strategy::simd: return "simd";
+		case strategy::sparse: return "sparse";
+		case strategy::parallel: return "parallel";
+		}
+		return "unknown";
+	}
+
+	auto strategy_profile::load(const std::string& path) -> strategy_profile {
+		auto in = std::ifstream(path);
+		if (!in) {
+			throw std::runtime_error{"strategy_profile::load(" + path + "): cannot open file"};
+		}
+		auto result = strategy_profile();
+		auto key = std::string();
+		while (in >> key) {
+			if (key.starts_with('#')) {
+				std::getline(in, key);
+			}
+			else if (key == "sample_size") {
+				in >> result.sample_size;
+			}
+			else if (key == "simd_min_length") {
+				in >> result.simd_min_length;
+			}
+			else if (key == "sparse_min_length") {
+				in >> result.sparse_min_length;
+			}
+			else if (key == "sparse_max_density") {
+				in >> result.sparse_max_density;
+			}
+			else if (key == "parallel_min_length") {
+				in >> result.parallel_min_length;
+			}
+			else {
+				throw std::runtime_error{"strategy_profile::load(" + path + "): unknown key " + key};
+			}
+		}
+		return result;
+	}
+
+	auto strategy_profile::save(const std::string& path) const -> void {
+		auto out = std::ofstream(path);
+		out << "# filtered_string_view strategy profile\n"
+		    << "sample_size " << sample_size << '\n'
+		    << "simd_min_length " << simd_min_length << '\n'
+		    << "sparse_min_length " << sparse_min_length << '\n'
+		    << "sparse_max_density " << sparse_max_density << '\n'
+		    << "parallel_min_length " << parallel_min_length << '\n';
+		if (!out) {
+			throw std::runtime_error{"strategy_profile::save(" + path + "): cannot write file"};
+		}
+	}
+
+	auto active_profile() -> strategy_profile {
+		auto const lock = std::lock_guard(profile_mutex);
+		return profile_storage();
+	}
+
+	auto set_active_profile(const strategy_profile& profile) -> void {
+		auto const lock = std::lock_guard(profile_mutex);
+		profile_storage() = profile;
+		profile_generation.fetch_add(1, std::memory_order_release);
+	}
+
+	auto select_strategy(const filtered_string_view& fsv) -> strategy {
+		return select_strategy(fsv, cached_profile());
+	}
+
+	auto select_strategy(const filtered_string_view& fsv, const strategy_profile& profile) -> strategy {
+		auto const length = fsv.length();
+		// an arbitrary predicate may keep state or not be thread-safe, so only char_class views are split
+		// across threads unless the caller asks for it with set_strategy()
+		if (!fsv.table()) {
+			return strategy::scalar;
+		}
+		if (length >= profile.parallel_min_length) {
+			return strategy::parallel;
+		}
+		if (length < profile.simd_min_length || !scan::vectorized()) {
+			return strategy::table;
+		}
+		if (length >= profile.sparse_min_length && density(fsv, profile.sample_size) < profile.sparse_max_density) {
+			return strategy::sparse;
+		}
+		return strategy::simd;
+	}
+
+	auto calibrate(const std::string& path) -> strategy_profile {
+		auto result = strategy_profile();
+		auto const cls = char_class("7");
+		auto sink = std::size_t{0};
+
+		// shortest length from which one simd count beats a table count
+		auto const mixed = synthetic(std::size_t{1} << 16U, 0.5);
+		result.simd_min_length = mixed.size();
+		for (auto length = std::size_t{16}; length < mixed.size(); length *= 2) {
+			auto const view = filtered_string_view(mixed.data(), length, cls);
+			auto const repeat = mixed.size() / length;
+			auto const table = time_of([&] {
+				for (auto i = std::size_t{0}; i < repeat; ++i) {
+					sink += kernel::count(view, strategy::table);
+				}
+			});
+			auto const simd = time_of([&] {
+				for (auto i = std::size_t{0}; i < repeat; ++i) {
+					sink += kernel::count(view, strategy::simd);
+				}
+			});
+			if (simd < table) {
+				result.simd_min_length = length;
+				break;
+			}
+		}
+
+		// densest input for which skipping rejected stretches still beats bulk classification
+		result.sparse_max_density = 0.0;
+		for (auto const d : {0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2}) {
+			auto const text = synthetic(std::size_t{1} << 18U, d);
+			auto const view = filtered_string_view(text, cls);
+			auto out = std::string();
+			auto const sparse = time_of([&] {
+				out.clear();
+				kernel::append(view, strategy::sparse, out);
+			});
+			auto const simd = time_of([&] {
+				out.clear();
+				kernel::append(view, strategy::simd, out);
+			});
+			if (sparse >= simd) {
+				break;
+			}
+			result.sparse_max_density = d;
+		}
+
+		// shortest length at which splitting the count across threads pays off
+		result.parallel_min_length = std::numeric_limits<std::size_t>::max();
+		auto const large = synthetic(std::size_t{1} << 25U, 0.5);
+		for (auto length = std::size_t{1} << 20U; length <= large.size(); length *= 2) {
+			auto const view = filtered_string_view(large.data(), length, cls);
+			auto const simd = time_of([&] { sink += kernel::count(view, strategy::simd); });
+			auto const parallel = time_of([&] { sink += kernel::count(view, strategy::parallel); });
+			if (parallel < simd) {
+				result.parallel_min_length = length;
+				break;
+			}
+		}
+
+		static_cast<void>(sink);
+		result.save(path);
+		return result;
+	}
+
+	namespace kernel {
+		auto sequential(const filtered_string_view& fsv) -> strategy {
+			if (auto const s = fsv.execution_strategy(); s != strategy::parallel) {
+				return s;
+			}
+			auto profile = cached_profile();
+			profile.parallel_min_length = std::numeric_limits<std::size_t>::max();
+			return select_strategy(fsv, profile);
+		}
+
+		auto slice(const filtered_string_view& fsv, std::size_t offset, std::size_t count) -> filtered_string_view {
+			if (fsv.table()) {
+				return filtered_string_view(fsv.data() + offset, count, *fsv.table());
+			}
+			return filtered_string_view(fsv.data() + offset, count, fsv.predicate());
+		}
+
+		auto count(const filtered_string_view& fsv, strategy s) -> std::size_t {
+			auto const data = fsv.data();
+			auto const length = fsv.length();
+			switch (effective(fsv, s)) {
+			case strategy::table: {
+				auto const& cls = *fsv.table();
+				return static_cast<std::size_t>(std::count_if(data, data + length, cls));
+			}
+			case strategy::simd:
+			case strategy::sparse: return scan::count(data, length, *fsv.table());
+			case strategy::parallel: return size(execution::par, fsv);
+			case strategy::automatic:
+			case strategy::scalar: break;
+			}
+			return static_cast<std::size_t>(std::count_if(data, data + length, fsv.predicate()));
+		}
+
+		auto append(const filtered_string_view& fsv, strategy s, std::string& out) -> void {
+			auto const data = fsv.data();
+			auto const length = fsv.length();
+			switch (effective(fsv, s)) {
+			case strategy::table: {
+				auto const& cls = *fsv.table();
+				std::copy_if(data, data + length, std::back_inserter(out), cls);
+				return;
+			}
+			case strategy::simd: {
+				// whole 64-byte blocks are copied or skipped at once; mixed blocks go bit by bit
+				auto masks = std::array<std::uint64_t, 64>();
+				for (auto offset = std::size_t{0}; offset < length; offset += 64 * masks.size()) {
+					auto const count = std::min(64 * masks.size(), length - offset);
+					scan::classify(data + offset, count, *fsv.table(), masks.data());
+					for (auto w = std::size_t{0}; w < (count + 63) / 64; ++w) {
+						auto const block = data + offset + w * 64;
+						if (masks[w] == ~std::uint64_t{0}) {
+							out.append(block, 64);
+							continue;
+						}
+						for (auto mask = masks[w]; mask != 0; mask &= mask - 1) {
+							out.push_back(block[std::countr_zero(mask)]);
+						}
+					}
+				}
+				return;
+			}
+			case strategy::sparse: {
+				auto const& cls = *fsv.table();
+				for (auto offset = scan::find_first(data, length, cls); offset < length;) {
+					auto const run = scan::find_first_not(data + offset, length - offset, cls);
+					out.append(data + offset, run);
+					offset += run;
+					offset += scan::find_first(data + offset, length - offset, cls);
+				}
+				return;
+			}
+			case strategy::parallel: append(execution::par, fsv, out); return;
+			case strategy::automatic:
+			case strategy::scalar: break;
+			}
+			std::copy_if(data, data + length, std::back_inserter(out), fsv.predicate());
+		}
+
+		auto write(const filtered_string_view& fsv, strategy s, char* out) -> char* {
+			auto const data = fsv.data();
+			auto const length = fsv.length();
+			switch (effective(fsv, s)) {
+			case strategy::table: {
+				auto const& cls = *fsv.table();
+				return std::copy_if(data, data + length, out, cls);
+			}
+			case strategy::simd: return scan::compact(data, length, *fsv.table(), out);
+			case strategy::sparse: {
+				auto const& cls = *fsv.table();
+				for (auto offset = scan::find_first(data, length, cls); offset < length;) {
+					auto const run = scan::find_first_not(data + offset, length - offset, cls);
+					out = std::copy(data + offset, data + offset + run, out);
+					offset += run;
+					offset += scan::find_first(data + offset, length - offset, cls);
+				}
+				return out;
+			}
+			case strategy::parallel: return write(fsv, sequential(fsv), out);
+			case strategy::automatic:
+			case strategy::scalar: break;
+			}
+			return std::copy_if(data, data + length, out, fsv.predicate());
+		}
+
+		auto next(const filtered_string_view& fsv, strategy s, const char* first, const char* last) -> const char* {
+			switch (effective(fsv, s)) {
+			case strategy::sparse: {
+				auto const length = static_cast<std::size_t>(last - first);
+				return first + scan::find_first(first, length, *fsv.table());
+			}
+			case strategy::table:
+			case strategy::simd: {
+				auto const& cls = *fsv.table();
+				return std::find_if(first, last, cls);
+			}
+			case strategy::parallel: return next(fsv, sequential(fsv), first, last);
+			case strategy::automatic:
+			case strategy::scalar: break;
+			}
+			return std::find_if(first, last, fsv.predicate());
+		}
+
+		block_reader::block_reader(const filtered_string_view& fsv)
+		: fsv_(fsv)
+		, in_place_(fsv.unfiltered())
+		, strategy_(in_place_ ? strategy::scalar : sequential(fsv))
+		, offset_(0) {}
+
+		auto block_reader::next() -> std::string_view {
+			if (in_place_) {
+				auto const rest = std::string_view(fsv_.data() + offset_, fsv_.length() - offset_);
+				offset_ = fsv_.length();
+				return rest;
+			}
+			while (offset_ < fsv_.length()) {
+				auto const count = std::min(block, fsv_.length() - offset_);
+				// a view of one block is written as is, sparing short keys the copy of its predicate a slice takes
+				auto const end = count == fsv_.length() ? write(fsv_, strategy_, buffer_.data())
+				                                        : write(slice(fsv_, offset_, count), strategy_, buffer_.data());
+				offset_ += count;
+				if (end != buffer_.data()) {
+					return std::string_view(buffer_.data(), static_cast<std::size_t>(end - buffer_.data()));
+				}
+			}
+			return {};
+		}
+	} // namespace kernel
+} // namespace fsv
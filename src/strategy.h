@@ -0,0 +1,163 @@
+#ifndef COMP6771_ASS2_STRATEGY_H
+#define COMP6771_ASS2_STRATEGY_H
+
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace fsv {
+	class filtered_string_view;
+
+	// How a view's characters are classified when it is counted, materialized, iterated or searched.
+	//  - scalar:   one predicate() call per byte;
+	//  - table:    one char_class lookup per byte, no std::function call;
+	//  - simd:     64 bytes classified at once by the scan kernels;
+	//  - sparse:   rejected stretches are skipped with the scan kernels' find functions;
+	//  - parallel: the buffer is split into chunks classified on several threads.
+	// Everything but scalar and parallel needs the view's predicate to be a char_class; when it is not,
+	// those strategies behave like scalar.
+	enum class strategy { automatic, scalar, table, simd, sparse, parallel };
+
+	auto to_string(strategy s) -> std::string_view;
+
+	// Thresholds used by select_strategy(). The defaults are reasonable for a modern x86-64 core;
+	// calibrate() measures better ones for the current machine.
+	struct strategy_profile {
+		// bytes sampled from the start of a view to estimate its density
+		std::size_t sample_size = 4096;
+		// views at least this long use simd rather than table
+		std::size_t simd_min_length = 128;
+		// views at least this long whose sampled density is below sparse_max_density use sparse
+		std::size_t sparse_min_length = 4096;
+		double sparse_max_density = 0.02;
+		// char_class views at least this long are split across threads; views with any other predicate
+		// only run in parallel when set_strategy(strategy::parallel) asks for it
+		std::size_t parallel_min_length = std::size_t{1} << 24U;
+
+		// reads "key value" lines as written by save(); keys that are missing keep their defaults
+		static auto load(const std::string& path) -> strategy_profile;
+		auto save(const std::string& path) const -> void;
+
+		friend auto operator==(const strategy_profile&, const strategy_profile&) -> bool = default;
+	};
+
+	// the profile used for automatic selection; initially loaded from the file named by the FSV_PROFILE
+	// environment variable if it is set, otherwise the defaults, which are also used if that file cannot be
+	// loaded
+	auto active_profile() -> strategy_profile;
+	auto set_active_profile(const strategy_profile& profile) -> void;
+
+	// picks a strategy for fsv by looking at its length, its predicate and the density of a prefix sample
+	auto select_strategy(const filtered_string_view& fsv) -> strategy;
+	auto select_strategy(const filtered_string_view& fsv, const strategy_profile& profile) -> strategy;
+
+	// times the kernels on synthetic buffers, writes the resulting profile to path and returns it
+	auto calibrate(const std::string& path) -> strategy_profile;
+
+	// the kernels behind filtered_string_view; s must not be automatic
+	namespace kernel {
+		// the view's execution_strategy(), or if that is parallel, what select_strategy() would pick otherwise
+		auto sequential(const filtered_string_view& fsv) -> strategy;
+		// the raw bytes [offset, offset + count) of fsv under the same predicate
+		auto slice(const filtered_string_view& fsv, std::size_t offset, std::size_t count) -> filtered_string_view;
+
+		auto count(const filtered_string_view& fsv, strategy s) -> std::size_t;
+		auto append(const filtered_string_view& fsv, strategy s, std::string& out) -> void;
+		// writes the accepted characters to out and returns the end of what was written
+		auto write(const filtered_string_view& fsv, strategy s, char* out) -> char*;
+		// the first accepted byte in [first, last), or last
+		auto next(const filtered_string_view& fsv, strategy s, const char* first, const char* last) -> const char*;
+
+		// The accepted characters of a view, a block of raw bytes at a time written to a buffer on the stack,
+		// or the whole buffer at once when the view is unfiltered.
+		class block_reader {
+		 public:
+			static constexpr auto block = std::size_t{4096};
+
+			explicit block_reader(const filtered_string_view& fsv);
+
+			// the next non-empty run of accepted characters, or nothing at the end of the view
+			auto next() -> std::string_view;
+
+		 private:
+			const filtered_string_view& fsv_;
+			bool in_place_;
+			strategy strategy_;
+			std::size_t offset_;
+			std::array<char, block> buffer_;
+		};
+
+		// a reader whose next() returns the whole string once
+		class string_reader {
+		 public:
+			explicit string_reader(std::string_view str)
+			: str_(str) {}
+
+			auto next() -> std::string_view {
+				return std::exchange(str_, std::string_view());
+			}
+
+		 private:
+			std::string_view str_;
+		};
+
+		// Calls fn with the runs a block_reader returns for fsv until it returns false, and returns whether it
+		// never did.
+		template<typename Fn>
+		auto for_each_block(const filtered_string_view& fsv, Fn fn) -> bool {
+			auto reader = block_reader(fsv);
+			for (auto run = reader.next(); !run.empty(); run = reader.next()) {
+				if (!fn(run)) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Orders the characters of two readers, whose next() returns the next non-empty run of them or nothing
+		// at the end. mismatch(a, b, n) is the index of the first of n characters where a and b differ, or n,
+		// and order(x, y) orders two characters that differ.
+		template<typename Left, typename Right, typename Mismatch, typename Order>
+		auto compare(Left&& left, Right&& right, Mismatch mismatch, Order order) -> std::strong_ordering {
+			auto a = std::string_view();
+			auto b = std::string_view();
+			for (;;) {
+				if (a.empty()) {
+					a = left.next();
+				}
+				if (b.empty()) {
+					b = right.next();
+				}
+				if (a.empty() || b.empty()) {
+					return !a.empty() <=> !b.empty();
+				}
+				auto const n = std::min(a.size(), b.size());
+				auto const at = mismatch(a.data(), b.data(), n);
+				if (at != n) {
+					return order(a[at], b[at]);
+				}
+				a.remove_prefix(n);
+				b.remove_prefix(n);
+			}
+		}
+
+		// the same, with characters ordered as char
+		template<typename Left, typename Right>
+		auto compare(Left&& left, Right&& right) -> std::strong_ordering {
+			auto const mismatch = [](const char* a, const char* b, std::size_t n) {
+				if (std::memcmp(a, b, n) == 0) {
+					return n;
+				}
+				return static_cast<std::size_t>(std::mismatch(a, a + n, b).first - a);
+			};
+			return compare(left, right, mismatch, [](char x, char y) { return x <=> y; });
+		}
+	} // namespace kernel
+} // namespace fsv
+
+#endif // COMP6771_ASS2_STRATEGY_H
@@ -0,0 +1,165 @@
+#include "./strategy.h"
+#include "./filtered_string_view.h"
+#include "./scan.h"
+#include "./test_text.h"
+
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+	using fsv::test::sample_text;
+
+	auto const all_strategies = std::vector<fsv::strategy>{
+	    fsv::strategy::scalar,
+	    fsv::strategy::table,
+	    fsv::strategy::simd,
+	    fsv::strategy::sparse,
+	    fsv::strategy::parallel,
+	};
+} // namespace
+
+TEST_CASE("strategy selection follows the profile") {
+	auto profile = fsv::strategy_profile();
+	profile.simd_min_length = 64;
+	profile.sparse_min_length = 1024;
+	profile.sparse_max_density = 0.05;
+	profile.parallel_min_length = 1 << 20;
+
+	auto const text = sample_text(4096);
+	auto const lonely = std::string(4096, 'x') + "7";
+	auto const digits = fsv::char_class::range('0', '9');
+
+	REQUIRE(fsv::select_strategy(fsv::filtered_string_view{text}, profile) == fsv::strategy::scalar);
+	REQUIRE(fsv::select_strategy(fsv::filtered_string_view{"a1", digits}, profile) == fsv::strategy::table);
+	if (fsv::scan::vectorized()) {
+		REQUIRE(fsv::select_strategy(fsv::filtered_string_view{text, digits}, profile) == fsv::strategy::simd);
+		REQUIRE(fsv::select_strategy(fsv::filtered_string_view{lonely, digits}, profile) == fsv::strategy::sparse);
+	}
+	profile.parallel_min_length = 1024;
+	REQUIRE(fsv::select_strategy(fsv::filtered_string_view{text, digits}, profile) == fsv::strategy::parallel);
+	// a predicate is never called from several threads unless the view opts in
+	auto calls = 0;
+	auto const counting = fsv::filtered_string_view{text, [&calls](const char&) { return ++calls % 2 == 0; }};
+	REQUIRE(fsv::select_strategy(counting, profile) == fsv::strategy::scalar);
+	auto const original = fsv::active_profile();
+	fsv::set_active_profile(profile);
+	REQUIRE(counting.size() == text.size() / 2);
+	REQUIRE(static_cast<std::size_t>(calls) == text.size());
+	fsv::set_active_profile(original);
+	REQUIRE(fsv::select_strategy(fsv::filtered_string_view{text}, profile) == fsv::strategy::scalar);
+	REQUIRE(fsv::to_string(fsv::strategy::sparse) == "sparse");
+}
+
+TEST_CASE("a view remembers the strategy selected for it") {
+	auto const text = sample_text(1 << 16);
+	auto view = fsv::filtered_string_view{text, fsv::char_class::range('0', '9')};
+	auto const first = view.execution_strategy();
+	REQUIRE(first == fsv::select_strategy(view));
+
+	// a profile that picks something else only applies once the view is reset
+	auto const original = fsv::active_profile();
+	auto profile = original;
+	profile.simd_min_length = std::size_t{1} << 30U;
+	profile.parallel_min_length = std::size_t{1} << 30U;
+	fsv::set_active_profile(profile);
+	REQUIRE(view.execution_strategy() == first);
+	auto const copy = view;
+	REQUIRE(copy.execution_strategy() == first);
+	view.set_strategy(fsv::strategy::automatic);
+	REQUIRE(view.execution_strategy() == fsv::strategy::table);
+	fsv::set_active_profile(original);
+
+	// iterators resolve the strategy on their first step, so comparing against a fresh end() is cheap
+	auto visited = std::string();
+	for (auto it = view.begin(); it != view.end(); ++it) {
+		visited += *it;
+	}
+	REQUIRE(visited == static_cast<std::string>(view));
+}
+
+TEST_CASE("every strategy gives the same results") {
+	// long enough for the parallel kernels to use more than one chunk
+	auto const text = sample_text((2 << 20) + 123);
+	auto const views = std::vector<fsv::filtered_string_view>{
+	    fsv::filtered_string_view{text, fsv::char_class::range('0', '9')},
+	    fsv::filtered_string_view{text, ~fsv::char_class(" ")},
+	    fsv::filtered_string_view{text, [](const char& c) { return c == 'w' || c == '1'; }},
+	};
+	for (auto view : views) {
+		auto expected = std::string();
+		for (auto c : text) {
+			if (view.predicate()(c)) {
+				expected.push_back(c);
+			}
+		}
+		for (auto s : all_strategies) {
+			view.set_strategy(s);
+			REQUIRE(view.execution_strategy() == s);
+			REQUIRE(view.size() == expected.size());
+			REQUIRE(static_cast<std::string>(view) == expected);
+			auto oss = std::ostringstream();
+			oss << view;
+			REQUIRE(oss.str() == expected);
+
+			auto prefix = view.table() ? fsv::filtered_string_view(text.data(), 1 << 16, *view.table())
+			                           : fsv::filtered_string_view(text.data(), 1 << 16, view.predicate());
+			prefix.set_strategy(s);
+			REQUIRE(std::string(prefix.begin(), prefix.end()) == static_cast<std::string>(prefix));
+		}
+		view.set_strategy(fsv::strategy::automatic);
+		REQUIRE(view.execution_strategy() == fsv::select_strategy(view));
+	}
+}
+
+TEST_CASE("search and comparison use the strategy set on a view") {
+	auto const text = sample_text(100000) + "needle";
+	auto view = fsv::filtered_string_view{text, ~fsv::char_class(" ")};
+	auto const expected = static_cast<std::string>(view);
+	auto const other = fsv::filtered_string_view{expected};
+	// a view set to parallel searches and compares with what it would have picked otherwise
+	auto const unsplit = fsv::scan::vectorized() ? fsv::strategy::simd : fsv::strategy::table;
+	for (auto s : all_strategies) {
+		view.set_strategy(s);
+		REQUIRE(fsv::kernel::sequential(view) == (s == fsv::strategy::parallel ? unsplit : s));
+		REQUIRE(view.find("needle") == expected.find("needle"));
+		REQUIRE(view.rfind("12word") == expected.rfind("12word"));
+		REQUIRE(view == other);
+		REQUIRE((view <=> fsv::filtered_string_view{expected + "!"}) == std::strong_ordering::less);
+	}
+}
+
+TEST_CASE("strategy profiles round-trip through a file") {
+	auto const path = std::string("fsv_profile_test.txt");
+	auto profile = fsv::strategy_profile();
+	profile.simd_min_length = 321;
+	profile.sparse_max_density = 0.125;
+	profile.save(path);
+	REQUIRE(fsv::strategy_profile::load(path) == profile);
+
+	auto const original = fsv::active_profile();
+	fsv::set_active_profile(profile);
+	REQUIRE(fsv::active_profile() == profile);
+	fsv::set_active_profile(original);
+
+	auto const calibrated = fsv::calibrate(path);
+	REQUIRE(fsv::strategy_profile::load(path) == calibrated);
+	REQUIRE(calibrated.simd_min_length > 0);
+	std::remove(path.c_str());
+	REQUIRE_THROWS_AS(fsv::strategy_profile::load(path), std::runtime_error);
+}
+
+// run by the strategy_test_bad_profile test, which points FSV_PROFILE at a file that does not exist
+TEST_CASE("a profile that cannot be loaded leaves the defaults in place", "[.][bad_profile]") {
+	REQUIRE(fsv::active_profile() == fsv::strategy_profile());
+	auto const text = sample_text(10000);
+	auto const view = fsv::filtered_string_view{text};
+	auto const digits = fsv::filtered_string_view{text, fsv::char_class::range('0', '9')};
+	REQUIRE(view.size() == text.size());
+	REQUIRE(static_cast<std::string>(view) == text);
+	REQUIRE(view == fsv::filtered_string_view{text});
+	REQUIRE(view.find("12") == 2);
+	REQUIRE(std::string(digits.begin(), digits.end()) == static_cast<std::string>(digits));
+}
@@ -0,0 +1,321 @@
+#include "./stream_reader.h"
+#include "./scan.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace fsv {
+	namespace {
+		auto round_to_pages(std::size_t bytes) -> std::size_t {
+			auto const page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+			return std::max(page, (bytes + page - 1) / page * page);
+		}
+
+		// capacity bytes of shared memory mapped twice back to back, or nullptr if that is not possible
+		auto map_mirror(std::size_t capacity) -> char* {
+			auto const fd = ::memfd_create("fsv_stream_ring", MFD_CLOEXEC);
+			if (fd < 0) {
+				return nullptr;
+			}
+			auto result = static_cast<char*>(nullptr);
+			auto const length = static_cast<off_t>(capacity);
+			auto const region = ::mmap(nullptr, 2 * capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (::ftruncate(fd, length) == 0 && region != MAP_FAILED) {
+				auto const base = static_cast<char*>(region);
+				auto const flags = MAP_SHARED | MAP_FIXED;
+				auto const first = ::mmap(base, capacity, PROT_READ | PROT_WRITE, flags, fd, 0);
+				auto const second = ::mmap(base + capacity, capacity, PROT_READ | PROT_WRITE, flags, fd, 0);
+				if (first != MAP_FAILED && second != MAP_FAILED) {
+					result = base;
+				}
+			}
+			if (result == nullptr && region != MAP_FAILED) {
+				::munmap(region, 2 * capacity);
+			}
+			::close(fd);
+			return result;
+		}
+	} // namespace
+
+	stream_filtered_reader::stream_filtered_reader(std::istream* in,
+	                                               int fd,
+	                                               filter predicate,
+	                                               stream_reader_options options)
+	: in_(in)
+	, fd_(fd)
+	, predicate_(std::move(predicate))
+	, block_size_(std::max<std::size_t>(options.block_size, 1))
+	, capacity_(round_to_pages(options.capacity))
+	, mirrored_(false)
+	, base_(nullptr)
+	, start_(0)
+	, size_(0)
+	, pending_(0)
+	, bytes_read_(0)
+	, eof_(false) {
+		if (options.mirror) {
+			base_ = map_mirror(capacity_);
+			mirrored_ = base_ != nullptr;
+		}
+		if (!mirrored_) {
+			plain_ = std::make_unique_for_overwrite<char[]>(capacity_);
+			base_ = plain_.get();
+		}
+	}
+
+	stream_filtered_reader::stream_filtered_reader(std::istream& in,
+	                                               const char_class& cls,
+	                                               stream_reader_options options)
+	: stream_filtered_reader(&in, -1, cls, options) {
+		table_ = cls;
+	}
+
+	stream_filtered_reader::stream_filtered_reader(std::istream& in, filter predicate, stream_reader_options options)
+	: stream_filtered_reader(&in, -1, std::move(predicate), options) {}
+
+	stream_filtered_reader::stream_filtered_reader(int fd, const char_class& cls, stream_reader_options options)
+	: stream_filtered_reader(nullptr, fd, cls, options) {
+		table_ = cls;
+	}
+
+	stream_filtered_reader::stream_filtered_reader(int fd, filter predicate, stream_reader_options options)
+	: stream_filtered_reader(nullptr, fd, std::move(predicate), options) {}
+
+	stream_filtered_reader::~stream_filtered_reader() {
+		if (mirrored_) {
+			::munmap(base_, 2 * capacity_);
+		}
+	}
+
+	auto stream_filtered_reader::next_token(char delimiter) -> std::optional<filtered_string_view> {
+		consume(pending_);
+		for (auto scanned = std::size_t{0};;) {
+			auto const data = base_ + start_;
+			auto const found = static_cast<const char*>(std::memchr(data + scanned, delimiter, size_ - scanned));
+			if (found != nullptr) {
+				auto const length = static_cast<std::size_t>(found - data);
+				pending_ = length + 1;
+				return view(data, length);
+			}
+			scanned = size_;
+			if (size_ == capacity_) {
+				throw std::length_error{"stream_filtered_reader::next_token: token longer than "
+				                        + std::to_string(capacity_) + " bytes"};
+			}
+			if (!refill()) {
+				if (size_ == 0) {
+					return std::nullopt;
+				}
+				pending_ = size_;
+				return view(base_ + start_, size_);
+			}
+		}
+	}
+
+	auto stream_filtered_reader::next_line() -> std::optional<filtered_string_view> {
+		return next_token('\n');
+	}
+
+	auto stream_filtered_reader::next_run() -> std::optional<std::string_view> {
+		consume(pending_);
+		for (;;) {
+			consume(find(0, true));
+			if (size_ != 0) {
+				break;
+			}
+			if (!refill()) {
+				return std::nullopt;
+			}
+		}
+		for (auto scanned = std::size_t{1};;) {
+			auto const stop = find(scanned, false);
+			if (stop < size_ || size_ == capacity_ || !refill()) {
+				pending_ = stop;
+				return std::string_view(base_ + start_, stop);
+			}
+			scanned = stop;
+		}
+	}
+
+	auto stream_filtered_reader::runs() -> run_range {
+		return run_range(this);
+	}
+
+	auto stream_filtered_reader::begin() -> iterator {
+		return iter(this);
+	}
+
+	auto stream_filtered_reader::end() -> iterator {
+		return iter();
+	}
+
+	auto stream_filtered_reader::capacity() const -> std::size_t {
+		return capacity_;
+	}
+
+	auto stream_filtered_reader::bytes_read() const -> std::size_t {
+		return bytes_read_;
+	}
+
+	auto stream_filtered_reader::consume(std::size_t count) -> void {
+		start_ += count;
+		size_ -= count;
+		pending_ = 0;
+		if (mirrored_) {
+			start_ %= capacity_;
+		}
+		else if (size_ == 0) {
+			start_ = 0;
+		}
+	}
+
+	auto stream_filtered_reader::refill() -> bool {
+		if (eof_ || size_ == capacity_) {
+			return false;
+		}
+		// a plain buffer moves the unconsumed bytes, at most one partial token, to its front once the free
+		// space after them runs short
+		if (!mirrored_ && start_ != 0 && capacity_ - start_ - size_ < block_size_) {
+			std::memmove(base_, base_ + start_, size_);
+			start_ = 0;
+		}
+		auto const room = mirrored_ ? capacity_ - size_ : capacity_ - start_ - size_;
+		auto const dest = base_ + start_ + size_;
+		auto const want = std::min(block_size_, room);
+
+		auto got = std::size_t{0};
+		if (in_ != nullptr) {
+			in_->read(dest, static_cast<std::streamsize>(want));
+			got = static_cast<std::size_t>(in_->gcount());
+		}
+		else {
+			auto result = ::read(fd_, dest, want);
+			while (result < 0 && errno == EINTR) {
+				result = ::read(fd_, dest, want);
+			}
+			if (result < 0) {
+				throw std::system_error{errno, std::system_category(), "stream_filtered_reader: read"};
+			}
+			got = static_cast<std::size_t>(result);
+		}
+		if (got == 0) {
+			eof_ = true;
+			return false;
+		}
+		size_ += got;
+		bytes_read_ += got;
+		return true;
+	}
+
+	auto stream_filtered_reader::find(std::size_t from, bool accepted) const -> std::size_t {
+		auto const data = base_ + start_;
+		if (table_) {
+			auto const length = size_ - from;
+			return from
+			       + (accepted ? scan::find_first(data + from, length, *table_)
+			                   : scan::find_first_not(data + from, length, *table_));
+		}
+		auto const found = std::find_if(data + from, data + size_, [this, accepted](const char& c) {
+			return predicate_(c) == accepted;
+		});
+		return static_cast<std::size_t>(found - data);
+	}
+
+	auto stream_filtered_reader::view(const char* data, std::size_t length) const -> filtered_string_view {
+		if (table_) {
+			return filtered_string_view(data, length, *table_);
+		}
+		return filtered_string_view(data, length, predicate_);
+	}
+
+	stream_filtered_reader::iter::iter()
+	: reader_(nullptr) {}
+
+	stream_filtered_reader::iter::iter(stream_filtered_reader* reader)
+	: reader_(reader) {
+		if (auto const run = reader_->next_run()) {
+			run_ = *run;
+		}
+		else {
+			reader_ = nullptr;
+		}
+	}
+
+	auto stream_filtered_reader::iter::operator*() const -> reference {
+		return run_.front();
+	}
+
+	auto stream_filtered_reader::iter::operator++() -> iter& {
+		run_.remove_prefix(1);
+		if (run_.empty()) {
+			*this = iter(reader_);
+		}
+		return *this;
+	}
+
+	auto stream_filtered_reader::iter::operator++(int) -> void {
+		++*this;
+	}
+
+	auto operator==(const stream_filtered_reader::iterator& lhs, const stream_filtered_reader::iterator& rhs) -> bool {
+		return lhs.reader_ == rhs.reader_ && lhs.run_.data() == rhs.run_.data();
+	}
+
+	auto operator!=(const stream_filtered_reader::iterator& lhs, const stream_filtered_reader::iterator& rhs) -> bool {
+		return !(lhs == rhs);
+	}
+
+	stream_filtered_reader::run_iter::run_iter()
+	: reader_(nullptr) {}
+
+	stream_filtered_reader::run_iter::run_iter(stream_filtered_reader* reader)
+	: reader_(reader) {
+		++*this;
+	}
+
+	auto stream_filtered_reader::run_iter::operator*() const -> reference {
+		return run_;
+	}
+
+	auto stream_filtered_reader::run_iter::operator++() -> run_iter& {
+		if (auto const run = reader_->next_run()) {
+			run_ = *run;
+		}
+		else {
+			reader_ = nullptr;
+			run_ = {};
+		}
+		return *this;
+	}
+
+	auto stream_filtered_reader::run_iter::operator++(int) -> void {
+		++*this;
+	}
+
+	auto operator==(const stream_filtered_reader::run_iterator& lhs,
+	                const stream_filtered_reader::run_iterator& rhs) -> bool {
+		return lhs.reader_ == rhs.reader_ && lhs.run_.data() == rhs.run_.data();
+	}
+
+	auto operator!=(const stream_filtered_reader::run_iterator& lhs,
+	                const stream_filtered_reader::run_iterator& rhs) -> bool {
+		return !(lhs == rhs);
+	}
+
+	stream_filtered_reader::run_range::run_range(stream_filtered_reader* reader)
+	: reader_(reader) {}
+
+	auto stream_filtered_reader::run_range::begin() const -> run_iter {
+		return run_iter(reader_);
+	}
+
+	auto stream_filtered_reader::run_range::end() const -> run_iter {
+		return run_iter();
+	}
+} // namespace fsv
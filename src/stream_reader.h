@@ -0,0 +1,153 @@
+#ifndef COMP6771_ASS2_STREAM_READER_H
+#define COMP6771_ASS2_STREAM_READER_H
+
+#include "./filtered_string_view.h"
+
+#include <cstddef>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+namespace fsv {
+	struct stream_reader_options {
+		// bytes held at once; rounded up to a whole number of pages. Bounds the memory used however long
+		// the stream is, and the longest token that can be returned.
+		std::size_t capacity = std::size_t{1} << 20U;
+		// bytes requested from the stream per read
+		std::size_t block_size = std::size_t{1} << 16U;
+		// map the ring twice back to back, so bytes wrapping past its end are still contiguous; false uses
+		// a plain buffer that moves a partial token to its front instead
+		bool mirror = true;
+	};
+
+	// A filtered view over a std::istream or file descriptor that holds only a fixed-size window of the
+	// input. Blocks are read into a ring buffer as they are consumed, so memory stays constant however long
+	// the stream is. The ring is mapped twice in a row, which makes a token that wraps around its end
+	// contiguous without copying it.
+	//
+	// Tokens, lines, runs and iteration all consume the same stream and may be mixed. A returned view or
+	// run stays valid until the next call that consumes input.
+	class stream_filtered_reader {
+		class iter {
+		 public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = char;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = const char&;
+
+			iter();
+			explicit iter(stream_filtered_reader* reader);
+
+			auto operator*() const -> reference;
+			auto operator++() -> iter&;
+			auto operator++(int) -> void;
+
+			friend auto operator==(const iter&, const iter&) -> bool;
+			friend auto operator!=(const iter&, const iter&) -> bool;
+
+		 private:
+			stream_filtered_reader* reader_;
+			std::string_view run_;
+		};
+
+		class run_iter {
+		 public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = std::string_view;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = const std::string_view&;
+
+			run_iter();
+			explicit run_iter(stream_filtered_reader* reader);
+
+			auto operator*() const -> reference;
+			auto operator++() -> run_iter&;
+			auto operator++(int) -> void;
+
+			friend auto operator==(const run_iter&, const run_iter&) -> bool;
+			friend auto operator!=(const run_iter&, const run_iter&) -> bool;
+
+		 private:
+			stream_filtered_reader* reader_;
+			std::string_view run_;
+		};
+
+	 public:
+		using iterator = iter;
+		using run_iterator = run_iter;
+
+		// maximal runs of accepted bytes, as raw spans; a run longer than the capacity arrives in pieces
+		class run_range {
+		 public:
+			explicit run_range(stream_filtered_reader* reader);
+			auto begin() const -> run_iter;
+			auto end() const -> run_iter;
+
+		 private:
+			stream_filtered_reader* reader_;
+		};
+
+		stream_filtered_reader(std::istream& in, const char_class& cls, stream_reader_options options = {});
+		stream_filtered_reader(std::istream& in, filter predicate, stream_reader_options options = {});
+		stream_filtered_reader(int fd, const char_class& cls, stream_reader_options options = {});
+		stream_filtered_reader(int fd, filter predicate, stream_reader_options options = {});
+
+		stream_filtered_reader(const stream_filtered_reader&) = delete;
+		auto operator=(const stream_filtered_reader&) -> stream_filtered_reader& = delete;
+		~stream_filtered_reader();
+
+		// the raw bytes up to the next delimiter, viewed through the reader's filter, with the delimiter
+		// consumed but not included; the bytes after the last delimiter form a final token if there are
+		// any. Throws std::length_error if a token does not fit in the capacity.
+		auto next_token(char delimiter) -> std::optional<filtered_string_view>;
+		auto next_line() -> std::optional<filtered_string_view>;
+
+		// the next maximal run of accepted bytes, or nothing at the end of the stream
+		auto next_run() -> std::optional<std::string_view>;
+		auto runs() -> run_range;
+
+		// accepted characters, one pass only
+		auto begin() -> iterator;
+		auto end() -> iterator;
+
+		auto capacity() const -> std::size_t;
+		// raw bytes read from the stream so far
+		auto bytes_read() const -> std::size_t;
+
+	 private:
+		std::istream* in_;
+		int fd_;
+		filter predicate_;
+		std::optional<char_class> table_;
+		std::size_t block_size_;
+
+		std::size_t capacity_;
+		bool mirrored_;
+		// the ring: capacity_ bytes, mapped again right after itself when mirrored_
+		char* base_;
+		std::unique_ptr<char[]> plain_;
+
+		// unconsumed bytes are [base_ + start_, base_ + start_ + size_)
+		std::size_t start_;
+		std::size_t size_;
+		// bytes of the last returned token or run, consumed on the next call
+		std::size_t pending_;
+		std::size_t bytes_read_;
+		bool eof_;
+
+		stream_filtered_reader(std::istream* in, int fd, filter predicate, stream_reader_options options);
+
+		auto consume(std::size_t count) -> void;
+		// reads one block; false at the end of the stream or when the ring is full
+		auto refill() -> bool;
+		// offset of the first accepted, or with accepted false rejected, byte in [from, size_), or size_
+		auto find(std::size_t from, bool accepted) const -> std::size_t;
+		auto view(const char* data, std::size_t length) const -> filtered_string_view;
+	};
+} // namespace fsv
+
+#endif // COMP6771_ASS2_STREAM_READER_H
@@ -0,0 +1,150 @@
+#include "./stream_reader.h"
+#include "./char_class.h"
+#include "./test_text.h"
+
+#include <catch2/catch.hpp>
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+	using fsv::test::line_text;
+
+	auto expected_lines(const std::string& text) -> std::vector<std::string> {
+		auto in = std::istringstream(text);
+		auto result = std::vector<std::string>();
+		for (auto line = std::string(); std::getline(in, line);) {
+			result.push_back(line);
+		}
+		return result;
+	}
+
+	auto options(bool mirror) -> fsv::stream_reader_options {
+		return {4096, 100, mirror};
+	}
+} // namespace
+
+TEST_CASE("stream_filtered_reader returns the same lines as std::getline") {
+	auto const text = line_text();
+	for (auto const mirror : {true, false}) {
+		auto in = std::istringstream(text);
+		auto reader = fsv::stream_filtered_reader(in, fsv::char_class::range('0', '9'), options(mirror));
+		CHECK(reader.capacity() == 4096);
+
+		auto lines = std::vector<std::string>();
+		auto digits = std::vector<std::string>();
+		while (auto const line = reader.next_line()) {
+			lines.emplace_back(line->data(), line->length());
+			digits.push_back(static_cast<std::string>(*line));
+		}
+		CHECK(lines == expected_lines(text));
+		REQUIRE(digits.size() == lines.size());
+		CHECK(digits[0] == "0");
+		CHECK(digits[1234] == "1234");
+		CHECK(digits.back() == "42");
+		CHECK(reader.bytes_read() == text.size());
+		CHECK_FALSE(reader.next_line());
+	}
+}
+
+TEST_CASE("stream_filtered_reader returns maximal runs and accepted characters") {
+	auto const text = line_text();
+	auto const is_digit = [](const char& c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; };
+	auto expected_runs = std::vector<std::string>();
+	auto expected_chars = std::string();
+	for (auto i = std::size_t{0}; i < text.size();) {
+		if (!is_digit(text[i])) {
+			++i;
+			continue;
+		}
+		auto j = i;
+		while (j < text.size() && is_digit(text[j])) {
+			++j;
+		}
+		expected_runs.push_back(text.substr(i, j - i));
+		expected_chars += expected_runs.back();
+		i = j;
+	}
+
+	for (auto const mirror : {true, false}) {
+		{
+			auto in = std::istringstream(text);
+			auto reader = fsv::stream_filtered_reader(in, fsv::char_class::range('0', '9'), options(mirror));
+			auto runs = std::vector<std::string>();
+			for (auto const run : reader.runs()) {
+				runs.emplace_back(run);
+			}
+			CHECK(runs == expected_runs);
+		}
+		{
+			auto in = std::istringstream(text);
+			auto reader = fsv::stream_filtered_reader(in, fsv::filter(is_digit), options(mirror));
+			CHECK(std::string(reader.begin(), reader.end()) == expected_chars);
+		}
+	}
+}
+
+TEST_CASE("stream_filtered_reader delivers a run longer than its capacity in pieces") {
+	auto const text = "ab" + std::string(10000, '7') + "cd";
+	auto in = std::istringstream(text);
+	auto reader = fsv::stream_filtered_reader(in, fsv::char_class::range('0', '9'), options(true));
+	auto total = std::size_t{0};
+	auto pieces = 0;
+	while (auto const run = reader.next_run()) {
+		CHECK(run->find_first_not_of('7') == std::string_view::npos);
+		total += run->size();
+		++pieces;
+	}
+	CHECK(total == 10000);
+	CHECK(pieces > 1);
+}
+
+TEST_CASE("stream_filtered_reader mixes tokens and runs on one stream") {
+	auto in = std::istringstream("a1,b22,c333\nrest 4 5");
+	auto reader = fsv::stream_filtered_reader(in, fsv::char_class::range('0', '9'));
+	CHECK(static_cast<std::string>(*reader.next_token(',')) == "1");
+	CHECK(*reader.next_run() == "22");
+	CHECK(static_cast<std::string>(*reader.next_line()) == "333");
+	CHECK(*reader.next_run() == "4");
+	CHECK(std::string(reader.begin(), reader.end()) == "5");
+	CHECK_FALSE(reader.next_run());
+}
+
+TEST_CASE("stream_filtered_reader throws if a token does not fit") {
+	auto in = std::istringstream("short\n" + std::string(5000, 'z') + "\nafter\n");
+	auto reader = fsv::stream_filtered_reader(in, fsv::char_class::range('a', 'z'), options(true));
+	CHECK(static_cast<std::string>(*reader.next_line()) == "short");
+	CHECK_THROWS_AS(reader.next_line(), std::length_error);
+}
+
+TEST_CASE("stream_filtered_reader reads a file descriptor as data arrives") {
+	auto const text = line_text();
+	int fds[2];
+	REQUIRE(::pipe(fds) == 0);
+	auto writer = std::thread([&] {
+		// small uneven writes, so reads return partial blocks
+		for (auto offset = std::size_t{0}; offset < text.size();) {
+			auto const step = std::min<std::size_t>(37 + offset % 211, text.size() - offset);
+			auto const written = ::write(fds[1], text.data() + offset, step);
+			if (written <= 0) {
+				break;
+			}
+			offset += static_cast<std::size_t>(written);
+		}
+		::close(fds[1]);
+	});
+
+	auto reader = fsv::stream_filtered_reader(fds[0], fsv::char_class::range('0', '9'), options(true));
+	auto lines = std::vector<std::string>();
+	while (auto const line = reader.next_line()) {
+		lines.emplace_back(line->data(), line->length());
+	}
+	writer.join();
+	::close(fds[0]);
+	CHECK(lines == expected_lines(text));
+}
@@ -0,0 +1,65 @@
+#ifndef COMP6771_ASS2_TEST_TEXT_H
+#define COMP6771_ASS2_TEST_TEXT_H
+
+#include <cstddef>
+#include <random>
+#include <string>
+
+// texts shared by the tests
+namespace fsv::test {
+	// words separated by spaces, with a number every seventh word
+	inline auto sample_text(std::size_t length) -> std::string {
+		auto result = std::string();
+		for (auto i = std::size_t{0}; result.size() < length; ++i) {
+			result += (i % 7 == 0) ? "  12 " : "word ";
+		}
+		result.resize(length);
+		return result;
+	}
+
+	// uniformly random bytes
+	inline auto random_text(std::size_t length, unsigned seed) -> std::string {
+		auto engine = std::mt19937(seed);
+		auto pick = std::uniform_int_distribution<int>(0, 255);
+		auto result = std::string(length, '\0');
+		for (auto& c : result) {
+			c = static_cast<char>(pick(engine));
+		}
+		return result;
+	}
+
+	// characters drawn uniformly from alphabet
+	inline auto random_text(std::size_t length, const std::string& alphabet, unsigned seed) -> std::string {
+		auto engine = std::mt19937(seed);
+		auto pick = std::uniform_int_distribution<std::size_t>(0, alphabet.size() - 1);
+		auto result = std::string(length, '\0');
+		for (auto& c : result) {
+			c = alphabet[pick(engine)];
+		}
+		return result;
+	}
+
+	// str with A-Z lowercased and every other byte left as it is
+	inline auto ascii_lower(std::string str) -> std::string {
+		for (auto& c : str) {
+			c = c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+		}
+		return str;
+	}
+
+	// numbered lines of varied length, every 300th of them 3900 bytes longer, so that lines often span the
+	// buffers readers are given; the last line has no newline
+	inline auto line_text() -> std::string {
+		auto result = std::string();
+		for (auto i = 0; i < 3000; ++i) {
+			result += "line " + std::to_string(i) + ' ' + std::string(static_cast<std::size_t>(i % 89), 'x');
+			if (i % 300 == 0) {
+				result += std::string(3900, 'y');
+			}
+			result += '\n';
+		}
+		return result + "last 42 without a newline";
+	}
+} // namespace fsv::test
+
+#endif // COMP6771_ASS2_TEST_TEXT_H
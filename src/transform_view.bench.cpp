@@ -0,0 +1,92 @@
+#include "./char_class.h"
+#include "./filtered_string_view.h"
+#include "./transform_view.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Builds letters-only lowercase strings and compares case-insensitive keys, once by materializing the filtered
+// view and lowercasing it in a second pass, and once through a transform_filtered_view.
+//
+//   transform_view_bench [megabytes] [keys]
+namespace {
+	using clock = std::chrono::steady_clock;
+
+	auto seconds_since(clock::time_point start) -> double {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	auto sample_text(std::size_t length) -> std::string {
+		auto result = std::string();
+		result.reserve(length);
+		for (auto i = std::size_t{0}; result.size() < length; ++i) {
+			result += "Header-" + std::to_string(i % 977) + ": Value With MIXED Case; q=0." + std::to_string(i % 10)
+			          + "\r\n";
+		}
+		result.resize(length);
+		return result;
+	}
+
+	auto report(const char* name, double rate, const char* unit, std::size_t checksum) -> void {
+		std::cout << std::left << std::setw(32) << name << std::right << std::setw(10) << rate << unit << "  ("
+		          << checksum << ")\n";
+	}
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+	auto const megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64;
+	auto const keys = static_cast<std::size_t>(argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000);
+	auto const text = sample_text(megabytes << 20U);
+	auto const letters = fsv::char_class::range('a', 'z') | fsv::char_class::range('A', 'Z');
+	std::cout << std::fixed << std::setprecision(1);
+
+	{
+		auto const start = clock::now();
+		auto result = static_cast<std::string>(fsv::filtered_string_view(text, letters));
+		std::transform(result.begin(), result.end(), result.begin(), fsv::char_map::to_lower());
+		report("materialize, then lowercase", static_cast<double>(text.size()) / seconds_since(start) / 1e6, " MB/s",
+		       result.size());
+	}
+	{
+		auto const start = clock::now();
+		auto const view = fsv::transform_builder(fsv::filtered_string_view(text, letters)).to_lower().build();
+		auto const result = static_cast<std::string>(view);
+		report("fused transform", static_cast<double>(text.size()) / seconds_since(start) / 1e6, " MB/s",
+		       result.size());
+	}
+
+	auto fields = std::vector<std::string>();
+	for (auto i = std::size_t{0}; i < 1000; ++i) {
+		fields.push_back(i % 2 == 0 ? "Content-Type" : "CONTENT-type");
+	}
+	auto const key = std::string("content-type");
+	{
+		auto const start = clock::now();
+		auto found = std::size_t{0};
+		for (auto i = std::size_t{0}; i < keys; ++i) {
+			auto copy = static_cast<std::string>(fsv::filtered_string_view(fields[i % fields.size()]));
+			std::transform(copy.begin(), copy.end(), copy.begin(), fsv::char_map::to_lower());
+			if (copy == key) {
+				++found;
+			}
+		}
+		report("lowercase copy per key", static_cast<double>(keys) / seconds_since(start) / 1e6, " M keys/s", found);
+	}
+	{
+		auto const lower = fsv::char_map::to_lower();
+		auto const start = clock::now();
+		auto found = std::size_t{0};
+		for (auto i = std::size_t{0}; i < keys; ++i) {
+			if (fsv::transform_filtered_view(fsv::filtered_string_view(fields[i % fields.size()]), lower) == key) {
+				++found;
+			}
+		}
+		report("transform_filtered_view", static_cast<double>(keys) / seconds_since(start) / 1e6, " M keys/s", found);
+	}
+	return 0;
+}
@@ -0,0 +1,395 @@
+#include "./transform_view.h"
+#include "./scan.h"
+#include "./strategy.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__x86_64__)
+#	include <immintrin.h>
+#endif
+
+namespace fsv {
+	namespace {
+#if defined(__x86_64__)
+		// adds delta to the bytes in [first, first + span] 32 at a time and returns how many bytes it did
+		[[gnu::target("avx2")]] auto avx2_shift(char* data,
+		                                        std::size_t length,
+		                                        unsigned char first,
+		                                        unsigned char span,
+		                                        unsigned char delta) -> std::size_t {
+			auto const low = _mm256_set1_epi8(static_cast<char>(first));
+			auto const width = _mm256_set1_epi8(static_cast<char>(span));
+			auto const add = _mm256_set1_epi8(static_cast<char>(delta));
+			auto i = std::size_t{0};
+			for (; i + 32 <= length; i += 32) {
+				auto* const at = reinterpret_cast<__m256i*>(data + i);
+				auto const x = _mm256_loadu_si256(at);
+				auto const offset = _mm256_sub_epi8(x, low);
+				auto const inside = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, width), offset);
+				_mm256_storeu_si256(at, _mm256_add_epi8(x, _mm256_and_si256(inside, add)));
+			}
+			return i;
+		}
+#endif
+	} // namespace
+
+	char_map::char_map()
+	: table_()
+	, shifted_(false)
+	, first_(0)
+	, span_(0)
+	, delta_(0)
+	, identity_(true) {
+		for (auto b = 0U; b < 256; ++b) {
+			table_[b] = static_cast<unsigned char>(b);
+		}
+	}
+
+	auto char_map::to_lower() -> char_map {
+		return translate("ABCDEFGHIJKLMNOPQRSTUVWXYZ", "abcdefghijklmnopqrstuvwxyz");
+	}
+
+	auto char_map::to_upper() -> char_map {
+		return translate("abcdefghijklmnopqrstuvwxyz", "ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+	}
+
+	auto char_map::translate(std::string_view from, std::string_view to) -> char_map {
+		if (from.size() != to.size()) {
+			throw std::domain_error{"char_map::translate(" + std::string(from) + ", " + std::string(to)
+			                        + "): lengths differ"};
+		}
+		auto result = char_map();
+		for (auto i = std::size_t{0}; i < from.size(); ++i) {
+			result.table_[static_cast<unsigned char>(from[i])] = static_cast<unsigned char>(to[i]);
+		}
+		result.analyse();
+		return result;
+	}
+
+	auto char_map::from(const std::function<char(char)>& fn) -> char_map {
+		auto result = char_map();
+		for (auto b = 0U; b < 256; ++b) {
+			result.table_[b] = static_cast<unsigned char>(fn(static_cast<char>(b)));
+		}
+		result.analyse();
+		return result;
+	}
+
+	auto char_map::operator()(char c) const -> char {
+		return static_cast<char>(table_[static_cast<unsigned char>(c)]);
+	}
+
+	auto char_map::then(const char_map& next) const -> char_map {
+		auto result = char_map();
+		for (auto b = 0U; b < 256; ++b) {
+			result.table_[b] = next.table_[table_[b]];
+		}
+		result.analyse();
+		return result;
+	}
+
+	auto char_map::preimage(const char_class& cls) const -> char_class {
+		auto result = char_class();
+		for (auto b = 0U; b < 256; ++b) {
+			if (cls.contains(static_cast<char>(table_[b]))) {
+				result.insert(static_cast<char>(b));
+			}
+		}
+		return result;
+	}
+
+	auto char_map::is_identity() const -> bool {
+		return identity_;
+	}
+
+	auto char_map::apply(char* data, std::size_t length) const -> void {
+		if (identity_) {
+			return;
+		}
+		auto i = std::size_t{0};
+#if defined(__x86_64__)
+		if (shifted_ && scan::vectorized()) {
+			i = avx2_shift(data, length, first_, span_, delta_);
+		}
+#endif
+		for (; i < length; ++i) {
+			data[i] = static_cast<char>(table_[static_cast<unsigned char>(data[i])]);
+		}
+	}
+
+	auto operator==(const char_map& lhs, const char_map& rhs) -> bool {
+		return lhs.table_ == rhs.table_;
+	}
+
+	auto char_map::analyse() -> void {
+		// the changed bytes must be one run, all moved by the same amount
+		auto changed = 0U;
+		auto last = 0U;
+		shifted_ = true;
+		for (auto b = 0U; b < 256; ++b) {
+			if (table_[b] == b) {
+				continue;
+			}
+			auto const delta = static_cast<unsigned char>(table_[b] - b);
+			if (changed == 0) {
+				first_ = static_cast<unsigned char>(b);
+				delta_ = delta;
+			}
+			else if (b != last + 1 || delta != delta_) {
+				shifted_ = false;
+			}
+			last = b;
+			++changed;
+		}
+		identity_ = changed == 0;
+		shifted_ = shifted_ && !identity_;
+		span_ = shifted_ ? static_cast<unsigned char>(last - first_) : 0;
+	}
+
+	namespace {
+		// The mapped accepted characters of a view, a block of raw bytes at a time. The buffer is small
+		// enough to live on the stack, so short keys are compared without allocating.
+		class mapped_reader {
+		 public:
+			explicit mapped_reader(const transform_filtered_view& tfv)
+			: tfv_(tfv)
+			, strategy_(kernel::sequential(tfv.view()))
+			, offset_(0)
+			, buffer_() {}
+
+			// the mapped characters of the next non-empty block, or nothing at the end of the view
+			auto next() -> std::string_view {
+				auto const& view = tfv_.view();
+				while (offset_ < view.length()) {
+					auto const count = std::min(buffer_.size(), view.length() - offset_);
+					auto const end = kernel::write(kernel::slice(view, offset_, count), strategy_, buffer_.data());
+					offset_ += count;
+					if (end != buffer_.data()) {
+						auto const size = static_cast<std::size_t>(end - buffer_.data());
+						tfv_.map().apply(buffer_.data(), size);
+						return std::string_view(buffer_.data(), size);
+					}
+				}
+				return {};
+			}
+
+		 private:
+			const transform_filtered_view& tfv_;
+			strategy strategy_;
+			std::size_t offset_;
+			std::array<char, kernel::block_reader::block> buffer_;
+		};
+
+		// raw bytes materialized per step; mapping each block right after it is written keeps it in cache
+		constexpr auto materialize_block = std::size_t{1} << 14U;
+	} // namespace
+
+	transform_filtered_view::transform_filtered_view()
+	: view_()
+	, map_() {}
+
+	transform_filtered_view::transform_filtered_view(filtered_string_view view, char_map map)
+	: view_(std::move(view))
+	, map_(std::move(map)) {}
+
+	auto transform_filtered_view::operator[](std::size_t index) const -> char {
+		return map_(view_[index]);
+	}
+
+	transform_filtered_view::operator std::string() const {
+		auto result = std::string();
+		auto const s = view_.execution_strategy();
+		if (s == strategy::parallel) {
+			// the threads each write their share; mapping afterwards costs less than giving that up
+			kernel::append(view_, s, result);
+			map_.apply(result.data(), result.size());
+			return result;
+		}
+		for (auto offset = std::size_t{0}; offset < view_.length(); offset += materialize_block) {
+			auto const count = std::min(materialize_block, view_.length() - offset);
+			auto const before = result.size();
+			result.resize(before + count);
+			auto* const first = result.data() + before;
+			auto const end = kernel::write(kernel::slice(view_, offset, count), s, first);
+			auto const size = static_cast<std::size_t>(end - first);
+			map_.apply(first, size);
+			result.resize(before + size);
+		}
+		return result;
+	}
+
+	auto transform_filtered_view::at(std::size_t index) const -> char {
+		return map_(view_.at(index));
+	}
+
+	auto transform_filtered_view::size() const -> std::size_t {
+		return view_.size();
+	}
+
+	auto transform_filtered_view::empty() const -> bool {
+		return view_.empty();
+	}
+
+	auto transform_filtered_view::view() const -> const filtered_string_view& {
+		return view_;
+	}
+
+	auto transform_filtered_view::map() const -> const char_map& {
+		return map_;
+	}
+
+	auto transform_filtered_view::begin() const -> const_iterator {
+		return iter(view_.begin(), &map_);
+	}
+
+	auto transform_filtered_view::end() const -> const_iterator {
+		return iter(view_.end(), &map_);
+	}
+
+	auto transform_filtered_view::cbegin() const -> const_iterator {
+		return begin();
+	}
+
+	auto transform_filtered_view::cend() const -> const_iterator {
+		return end();
+	}
+
+	auto transform_filtered_view::rbegin() const -> const_reverse_iterator {
+		return const_reverse_iterator(end());
+	}
+
+	auto transform_filtered_view::rend() const -> const_reverse_iterator {
+		return const_reverse_iterator(begin());
+	}
+
+	auto operator==(const transform_filtered_view& lhs, const transform_filtered_view& rhs) -> bool {
+		return kernel::compare(mapped_reader(lhs), mapped_reader(rhs)) == std::strong_ordering::equal;
+	}
+
+	auto operator<=>(const transform_filtered_view& lhs, const transform_filtered_view& rhs) -> std::strong_ordering {
+		return kernel::compare(mapped_reader(lhs), mapped_reader(rhs));
+	}
+
+	auto operator==(const transform_filtered_view& lhs, std::string_view rhs) -> bool {
+		return kernel::compare(mapped_reader(lhs), kernel::string_reader(rhs)) == std::strong_ordering::equal;
+	}
+
+	auto operator<=>(const transform_filtered_view& lhs, std::string_view rhs) -> std::strong_ordering {
+		return kernel::compare(mapped_reader(lhs), kernel::string_reader(rhs));
+	}
+
+	auto operator<<(std::ostream& os, const transform_filtered_view& tfv) -> std::ostream& {
+		auto reader = mapped_reader(tfv);
+		for (auto block = reader.next(); !block.empty(); block = reader.next()) {
+			os.write(block.data(), static_cast<std::streamsize>(block.size()));
+		}
+		return os;
+	}
+
+	transform_filtered_view::iter::iter()
+	: it_()
+	, map_(nullptr) {}
+
+	transform_filtered_view::iter::iter(filtered_string_view::const_iterator it, const char_map* map)
+	: it_(std::move(it))
+	, map_(map) {}
+
+	auto transform_filtered_view::iter::operator*() const -> reference {
+		return (*map_)(*it_);
+	}
+
+	auto transform_filtered_view::iter::operator++() -> iter& {
+		++it_;
+		return *this;
+	}
+
+	auto transform_filtered_view::iter::operator++(int) -> iter {
+		auto copy = *this;
+		++it_;
+		return copy;
+	}
+
+	auto transform_filtered_view::iter::operator--() -> iter& {
+		--it_;
+		return *this;
+	}
+
+	auto transform_filtered_view::iter::operator--(int) -> iter {
+		auto copy = *this;
+		--it_;
+		return copy;
+	}
+
+	auto operator==(const transform_filtered_view::iterator& lhs, const transform_filtered_view::iterator& rhs)
+	    -> bool {
+		return lhs.it_ == rhs.it_;
+	}
+
+	auto operator!=(const transform_filtered_view::iterator& lhs, const transform_filtered_view::iterator& rhs)
+	    -> bool {
+		return !(lhs == rhs);
+	}
+
+	transform_builder::transform_builder(filtered_string_view view)
+	: view_(std::move(view))
+	, map_() {}
+
+	auto transform_builder::keep(const char_class& cls) -> transform_builder& {
+		auto const accepted = map_.preimage(cls);
+		if (view_.table()) {
+			view_ = filtered_string_view(view_.data(), view_.length(), *view_.table() & accepted);
+		}
+		else {
+			view_ = filtered_string_view(view_.data(),
+			                             view_.length(),
+			                             [previous = view_.predicate(), accepted](const char& c) {
+				                             return previous(c) && accepted.contains(c);
+			                             });
+		}
+		return *this;
+	}
+
+	auto transform_builder::keep(filter predicate) -> transform_builder& {
+		auto previous = view_.predicate();
+		if (map_.is_identity()) {
+			// called on the buffer's own characters, so predicates that look at addresses keep working
+			view_ = filtered_string_view(view_.data(),
+			                             view_.length(),
+			                             [previous, predicate](const char& c) { return previous(c) && predicate(c); });
+		}
+		else {
+			view_ = filtered_string_view(view_.data(),
+			                             view_.length(),
+			                             [previous, predicate, map = map_](const char& c) {
+				                             return previous(c) && predicate(map(c));
+			                             });
+		}
+		return *this;
+	}
+
+	auto transform_builder::drop(const char_class& cls) -> transform_builder& {
+		return keep(~cls);
+	}
+
+	auto transform_builder::map(const char_map& m) -> transform_builder& {
+		map_ = map_.then(m);
+		return *this;
+	}
+
+	auto transform_builder::to_lower() -> transform_builder& {
+		return map(char_map::to_lower());
+	}
+
+	auto transform_builder::to_upper() -> transform_builder& {
+		return map(char_map::to_upper());
+	}
+
+	auto transform_builder::translate(std::string_view from, std::string_view to) -> transform_builder& {
+		return map(char_map::translate(from, to));
+	}
+
+	auto transform_builder::build() const -> transform_filtered_view {
+		return transform_filtered_view(view_, map_);
+	}
+} // namespace fsv
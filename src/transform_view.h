@@ -0,0 +1,154 @@
+#ifndef COMP6771_ASS2_TRANSFORM_VIEW_H
+#define COMP6771_ASS2_TRANSFORM_VIEW_H
+
+#include "./char_class.h"
+#include "./filtered_string_view.h"
+
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace fsv {
+	// A byte-to-byte map such as ASCII case folding or a translate table. A map that only adds a constant to
+	// one contiguous range of bytes, as to_lower() and to_upper() do, is applied 32 bytes at a time with AVX2
+	// where available; any other takes one table lookup per byte.
+	class char_map {
+	 public:
+		// the identity
+		char_map();
+
+		// ASCII letters only; other bytes are left alone
+		static auto to_lower() -> char_map;
+		static auto to_upper() -> char_map;
+		// maps from[i] to to[i] and leaves other bytes alone; a byte listed twice takes its last mapping.
+		// Throws std::domain_error if the lengths differ.
+		static auto translate(std::string_view from, std::string_view to) -> char_map;
+		// evaluates fn once per byte value
+		static auto from(const std::function<char(char)>& fn) -> char_map;
+
+		auto operator()(char c) const -> char;
+		// this map followed by next
+		auto then(const char_map& next) const -> char_map;
+		// the bytes that this maps into cls
+		auto preimage(const char_class& cls) const -> char_class;
+		auto is_identity() const -> bool;
+		// maps [data, data + length) in place
+		auto apply(char* data, std::size_t length) const -> void;
+
+		friend auto operator==(const char_map& lhs, const char_map& rhs) -> bool;
+
+	 private:
+		std::array<unsigned char, 256> table_;
+		// the bytes [first_, first_ + span_] are the only ones changed, all by adding delta_; span_ is unused
+		// when shifted_ is false
+		bool shifted_;
+		unsigned char first_;
+		unsigned char span_;
+		unsigned char delta_;
+		bool identity_;
+
+		auto analyse() -> void;
+	};
+
+	// A filtered view whose characters are passed through a char_map as they are read. Nothing is copied up
+	// front: iteration maps one character at a time, and materialization and comparison map each block of
+	// accepted characters right after the filter kernels write it, while it is still in cache.
+	class transform_filtered_view {
+		class iter {
+		 public:
+			// characters are produced by value, so this is only a bidirectional iterator in the C++20 sense
+			using iterator_concept = std::bidirectional_iterator_tag;
+			using iterator_category = std::input_iterator_tag;
+			using value_type = char;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = char;
+
+			iter();
+			iter(filtered_string_view::const_iterator it, const char_map* map);
+
+			auto operator*() const -> reference;
+
+			auto operator++() -> iter&;
+			auto operator++(int) -> iter;
+			auto operator--() -> iter&;
+			auto operator--(int) -> iter;
+
+			friend auto operator==(const iter&, const iter&) -> bool;
+			friend auto operator!=(const iter&, const iter&) -> bool;
+
+		 private:
+			filtered_string_view::const_iterator it_;
+			const char_map* map_;
+		};
+
+	 public:
+		using iterator = iter;
+		using const_iterator = iter;
+		using reverse_iterator = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+		transform_filtered_view();
+		transform_filtered_view(filtered_string_view view, char_map map);
+
+		auto operator[](std::size_t index) const -> char;
+		explicit operator std::string() const;
+
+		// throws std::domain_error like filtered_string_view::at()
+		auto at(std::size_t index) const -> char;
+		auto size() const -> std::size_t;
+		auto empty() const -> bool;
+		auto view() const -> const filtered_string_view&;
+		auto map() const -> const char_map&;
+
+		auto begin() const -> const_iterator;
+		auto end() const -> const_iterator;
+		auto cbegin() const -> const_iterator;
+		auto cend() const -> const_iterator;
+		auto rbegin() const -> const_reverse_iterator;
+		auto rend() const -> const_reverse_iterator;
+
+		// compare mapped characters as char, without allocating
+		friend auto operator==(const transform_filtered_view& lhs, const transform_filtered_view& rhs) -> bool;
+		friend auto operator<=>(const transform_filtered_view& lhs, const transform_filtered_view& rhs)
+		    -> std::strong_ordering;
+		friend auto operator==(const transform_filtered_view& lhs, std::string_view rhs) -> bool;
+		friend auto operator<=>(const transform_filtered_view& lhs, std::string_view rhs) -> std::strong_ordering;
+		friend auto operator<<(std::ostream& os, const transform_filtered_view& tfv) -> std::ostream&;
+
+	 private:
+		filtered_string_view view_;
+		char_map map_;
+	};
+
+	// Builds a transform_filtered_view from a view by adding filters and maps in order. A filter added after a
+	// map sees the mapped characters: a char_class filter is turned into the class of raw bytes that map into
+	// it, so it still runs on the scan kernels, while any other filter is called on the mapped character.
+	//
+	//   auto key = transform_builder(header).keep(letters).to_lower().build();
+	class transform_builder {
+	 public:
+		explicit transform_builder(filtered_string_view view);
+
+		auto keep(const char_class& cls) -> transform_builder&;
+		auto keep(filter predicate) -> transform_builder&;
+		auto drop(const char_class& cls) -> transform_builder&;
+		auto map(const char_map& m) -> transform_builder&;
+		auto to_lower() -> transform_builder&;
+		auto to_upper() -> transform_builder&;
+		auto translate(std::string_view from, std::string_view to) -> transform_builder&;
+
+		auto build() const -> transform_filtered_view;
+
+	 private:
+		filtered_string_view view_;
+		char_map map_;
+	};
+} // namespace fsv
+
+#endif // COMP6771_ASS2_TRANSFORM_VIEW_H
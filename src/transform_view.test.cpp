@@ -0,0 +1,128 @@
+#include "./transform_view.h"
+#include "./char_class.h"
+#include "./test_text.h"
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <cctype>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+	using fsv::test::ascii_lower;
+	using fsv::test::random_text;
+} // namespace
+
+TEST_CASE("char_map case folding and translation") {
+	auto const lower = fsv::char_map::to_lower();
+	REQUIRE(lower('Q') == 'q');
+	REQUIRE(lower('q') == 'q');
+	REQUIRE(lower('@') == '@');
+	REQUIRE(lower('\xC9') == '\xC9');
+	REQUIRE(fsv::char_map::to_upper()('z') == 'Z');
+	REQUIRE(fsv::char_map().is_identity());
+	REQUIRE_FALSE(lower.is_identity());
+	REQUIRE(lower.then(fsv::char_map::to_upper()) == fsv::char_map::to_upper());
+	REQUIRE(fsv::char_map::from([](char c) { return static_cast<char>(std::tolower(c)); }) == lower);
+
+	auto const rot = fsv::char_map::translate("abc", "bca");
+	REQUIRE(rot('a') == 'b');
+	REQUIRE(rot.then(rot).then(rot).is_identity());
+	REQUIRE(rot.preimage(fsv::char_class("a")) == fsv::char_class("c"));
+	REQUIRE_THROWS_AS(fsv::char_map::translate("ab", "c"), std::domain_error);
+}
+
+TEST_CASE("char_map applies shifts and tables alike") {
+	// lengths that end inside and on 32-byte blocks, for the vector and scalar parts of apply()
+	for (auto const length : {std::size_t{0}, std::size_t{31}, std::size_t{32}, std::size_t{1000}}) {
+		auto const text = random_text(length, 7);
+		auto folded = text;
+		fsv::char_map::to_lower().apply(folded.data(), folded.size());
+		REQUIRE(folded == ascii_lower(text));
+		auto shifted = text;
+		auto const digits = fsv::char_map::translate("0123456789", "ABCDEFGHIJ");
+		digits.apply(shifted.data(), shifted.size());
+		std::transform(text.begin(), text.end(), folded.begin(), digits);
+		REQUIRE(shifted == folded);
+	}
+}
+
+TEST_CASE("transform_filtered_view maps the accepted characters") {
+	auto const text = std::string("Content-Type: Text/HTML");
+	auto const view = fsv::transform_filtered_view(fsv::filtered_string_view(text, ~fsv::char_class(" -")),
+	                                               fsv::char_map::to_lower());
+	REQUIRE(static_cast<std::string>(view) == "contenttype:text/html");
+	REQUIRE(view.size() == 21);
+	REQUIRE(view[0] == 'c');
+	REQUIRE(view.at(7) == 't');
+	REQUIRE_THROWS_AS(view.at(21), std::domain_error);
+	REQUIRE(std::string(view.begin(), view.end()) == "contenttype:text/html");
+	REQUIRE(std::string(view.rbegin(), view.rend()) == "lmth/txet:epyttnetnoc");
+	auto os = std::ostringstream();
+	os << view;
+	REQUIRE(os.str() == "contenttype:text/html");
+	REQUIRE(fsv::transform_filtered_view().empty());
+	static_assert(std::bidirectional_iterator<fsv::transform_filtered_view::iterator>);
+}
+
+TEST_CASE("transform_filtered_view compares mapped characters") {
+	auto const key = [](const std::string& str) {
+		return fsv::transform_builder(fsv::filtered_string_view(str)).to_lower().build();
+	};
+	auto const a = std::string("Accept-Encoding");
+	auto const b = std::string("ACCEPT-ENCODING");
+	auto const c = std::string("accept-language");
+	REQUIRE(key(a) == key(b));
+	REQUIRE(key(a) < key(c));
+	REQUIRE(key(a) == "accept-encoding");
+	REQUIRE(key(a) != "Accept-Encoding");
+	REQUIRE((key(a) <=> "accept") == std::strong_ordering::greater);
+	REQUIRE("accept-encodinh" > key(b));
+
+	// views longer than the comparison buffer, differing in the last block only
+	auto long_a = random_text(10000, 3);
+	auto long_b = ascii_lower(long_a);
+	REQUIRE(key(long_a) == key(long_b));
+	long_b.back() = static_cast<char>(long_b.back() ^ 1);
+	REQUIRE((key(long_a) <=> key(long_b)) == (ascii_lower(long_a) <=> ascii_lower(long_b)));
+}
+
+TEST_CASE("transform_builder applies filters and maps in order") {
+	auto const text = std::string("Hello, World! 123");
+	auto const letters = fsv::char_class::range('a', 'z') | fsv::char_class::range('A', 'Z');
+	auto const view = fsv::filtered_string_view(text);
+
+	REQUIRE(static_cast<std::string>(fsv::transform_builder(view).keep(letters).to_upper().build()) == "HELLOWORLD");
+	// after to_lower() the class is tested on lowercase letters, so uppercase ones are kept too
+	REQUIRE(static_cast<std::string>(
+	            fsv::transform_builder(view).to_lower().keep(fsv::char_class::range('a', 'z')).build())
+	        == "helloworld");
+	REQUIRE(static_cast<std::string>(fsv::transform_builder(view).keep(fsv::char_class::range('a', 'z')).build())
+	        == "elloorld");
+	REQUIRE(static_cast<std::string>(
+	            fsv::transform_builder(view).translate("lo", "01").drop(fsv::char_class(" ,!")).keep([](const char& c) {
+		            return c != '0';
+	            }).build())
+	        == "He1W1rd123");
+	// the scan kernels still apply, since char_class filters stay char_class filters
+	auto const classified = fsv::filtered_string_view(text, fsv::char_class::all());
+	REQUIRE(fsv::transform_builder(classified).to_lower().keep(letters).build().view().table());
+
+	auto const predicated = fsv::filtered_string_view(text, [](const char& c) { return c != 'l'; });
+	REQUIRE(static_cast<std::string>(fsv::transform_builder(predicated).drop(fsv::char_class(" ")).to_lower().build())
+	        == "heo,word!123");
+}
+
+TEST_CASE("transform_filtered_view materializes long views in blocks") {
+	auto const text = random_text(100000, 5);
+	auto const letters = fsv::char_class::range('a', 'z') | fsv::char_class::range('A', 'Z');
+	auto const view = fsv::transform_builder(fsv::filtered_string_view(text)).keep(letters).to_lower().build();
+	auto expected = std::string();
+	std::copy_if(text.begin(), text.end(), std::back_inserter(expected), letters);
+	expected = ascii_lower(expected);
+	REQUIRE(static_cast<std::string>(view) == expected);
+	REQUIRE(view.size() == expected.size());
+	REQUIRE(view == expected);
+}
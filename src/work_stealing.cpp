@@ -0,0 +1,337 @@
+#include "./work_stealing.h"
+#include "./parallel.h"
+#include "./strategy.h"
+#include <algorithm>
+#include <bit>
+#include <string_view>
+
+namespace fsv {
+	namespace {
+		thread_local auto running_pool = static_cast<const work_stealing_pool*>(nullptr);
+
+		// true if a proper prefix of delim is also a suffix, i.e. two occurrences can overlap
+		auto self_overlapping(std::string_view delim) -> bool {
+			for (auto k = std::size_t{1}; k < delim.size(); ++k) {
+				if (delim.substr(0, k) == delim.substr(delim.size() - k)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Tokenizes raw ranges [first, last), where first starts a token and last is the end of the buffer or
+		// the start of a delimiter. Occurrences of a delimiter that cannot overlap itself are all delimiters,
+		// so any occurrence past the middle of a range is a valid place to cut it.
+		struct range_tokenizer {
+			const filtered_string_view& fsv;
+			std::string_view text;
+			std::string_view delim;
+			const token_function& fn;
+
+			auto operator()(task_context& ctx, std::size_t first, std::size_t last) const -> void {
+				for (;;) {
+					if (ctx.should_split() && last - first > 2 * delim.size()) {
+						auto const at = text.substr(0, last).find(delim, first + (last - first) / 2);
+						if (at != std::string_view::npos) {
+							auto const next = at + delim.size();
+							ctx.spawn([this, next, last](task_context& c) { (*this)(c, next, last); });
+							last = at;
+						}
+					}
+					auto const at = text.substr(0, last).find(delim, first);
+					if (at == std::string_view::npos) {
+						fn(kernel::slice(fsv, first, last - first));
+						return;
+					}
+					fn(kernel::slice(fsv, first, at - first));
+					first = at + delim.size();
+				}
+			}
+		};
+
+		// Calls fn on tokens [first, last) of a split that has already been done, for delimiters whose
+		// occurrences may overlap and so cannot be cut at without scanning from the start.
+		struct index_tokenizer {
+			const std::vector<filtered_string_view>& tokens;
+			const token_function& fn;
+
+			auto operator()(task_context& ctx, std::size_t first, std::size_t last) const -> void {
+				while (first < last) {
+					if (ctx.should_split() && last - first > 1) {
+						auto const middle = first + (last - first) / 2;
+						ctx.spawn([this, middle, last](task_context& c) { (*this)(c, middle, last); });
+						last = middle;
+					}
+					fn(tokens[first++]);
+				}
+			}
+		};
+	} // namespace
+
+	work_deque::ring::ring(std::size_t capacity)
+	: mask(capacity - 1)
+	, slots(std::make_unique<std::atomic<task*>[]>(capacity)) {}
+
+	auto work_deque::ring::get(std::int64_t i) const -> task* {
+		return slots[static_cast<std::size_t>(i) & mask].load(std::memory_order_relaxed);
+	}
+
+	auto work_deque::ring::put(std::int64_t i, task* t) -> void {
+		slots[static_cast<std::size_t>(i) & mask].store(t, std::memory_order_relaxed);
+	}
+
+	work_deque::work_deque(std::size_t capacity)
+	: top_(0)
+	, bottom_(0)
+	, ring_(nullptr) {
+		rings_.push_back(std::make_unique<ring>(std::bit_ceil(std::max<std::size_t>(capacity, 2))));
+		ring_.store(rings_.back().get(), std::memory_order_relaxed);
+	}
+
+	auto work_deque::push(task* t) -> void {
+		auto const b = bottom_.load(std::memory_order_relaxed);
+		auto const top = top_.load(std::memory_order_acquire);
+		auto r = ring_.load(std::memory_order_relaxed);
+		if (b - top > static_cast<std::int64_t>(r->mask)) {
+			auto bigger = std::make_unique<ring>((r->mask + 1) * 2);
+			for (auto i = top; i < b; ++i) {
+				bigger->put(i, r->get(i));
+			}
+			r = bigger.get();
+			rings_.push_back(std::move(bigger));
+			ring_.store(r, std::memory_order_release);
+		}
+		r->put(b, t);
+		bottom_.store(b + 1, std::memory_order_release);
+	}
+
+	auto work_deque::take() -> task* {
+		auto const b = bottom_.load(std::memory_order_relaxed) - 1;
+		auto const r = ring_.load(std::memory_order_relaxed);
+		// seq_cst store and load in place of the usual fence, so thieves and the owner agree on the order in
+		// which bottom shrank and top grew
+		bottom_.store(b, std::memory_order_seq_cst);
+		auto top = top_.load(std::memory_order_seq_cst);
+		if (top > b) {
+			bottom_.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		auto result = r->get(b);
+		if (top == b) {
+			// the last task; a thief may be taking it at the same time
+			if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				result = nullptr;
+			}
+			bottom_.store(b + 1, std::memory_order_relaxed);
+		}
+		return result;
+	}
+
+	auto work_deque::steal() -> task* {
+		auto top = top_.load(std::memory_order_seq_cst);
+		auto const b = bottom_.load(std::memory_order_seq_cst);
+		if (top >= b) {
+			return nullptr;
+		}
+		auto const result = ring_.load(std::memory_order_acquire)->get(top);
+		if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			return nullptr;
+		}
+		return result;
+	}
+
+	auto work_deque::empty() const -> bool {
+		return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+	}
+
+	work_stealing_pool::work_stealing_pool(std::size_t threads)
+	: generation_(0)
+	, active_(0)
+	, stopping_(false)
+	, pending_(0)
+	, thieves_(0)
+	, failed_(false) {
+		threads = std::max<std::size_t>(threads, 1);
+		for (auto i = std::size_t{0}; i < threads; ++i) {
+			workers_.push_back(std::make_unique<worker>());
+			workers_.back()->seed = 0x9E3779B97F4A7C15 * (i + 1);
+		}
+		for (auto i = std::size_t{1}; i < threads; ++i) {
+			threads_.emplace_back([this, i] { work(i); });
+		}
+	}
+
+	work_stealing_pool::~work_stealing_pool() {
+		{
+			auto const lock = std::lock_guard(mutex_);
+			stopping_ = true;
+		}
+		wake_.notify_all();
+		for (auto& thread : threads_) {
+			thread.join();
+		}
+	}
+
+	auto work_stealing_pool::size() const -> std::size_t {
+		return workers_.size();
+	}
+
+	auto work_stealing_pool::shared() -> work_stealing_pool& {
+		static auto pool = work_stealing_pool();
+		return pool;
+	}
+
+	auto work_stealing_pool::run(const task& root) -> void {
+		if (running_pool == this) {
+			auto inline_context = task_context(nullptr, 0);
+			root(inline_context);
+			return;
+		}
+
+		auto const lock = std::lock_guard(run_mutex_);
+		pending_.store(1);
+		failed_.store(false);
+		error_ = nullptr;
+		workers_[0]->deque.push(new task(root));
+		{
+			auto const state = std::lock_guard(mutex_);
+			active_ = threads_.size();
+			++generation_;
+		}
+		wake_.notify_all();
+		drain(0);
+
+		auto state = std::unique_lock(mutex_);
+		done_.wait(state, [this] { return active_ == 0; });
+		if (error_ != nullptr) {
+			std::rethrow_exception(error_);
+		}
+	}
+
+	auto work_stealing_pool::work(std::size_t index) -> void {
+		auto seen = std::size_t{0};
+		for (;;) {
+			{
+				auto lock = std::unique_lock(mutex_);
+				wake_.wait(lock, [this, seen] { return stopping_ || generation_ != seen; });
+				if (stopping_) {
+					return;
+				}
+				seen = generation_;
+			}
+			drain(index);
+			auto const lock = std::lock_guard(mutex_);
+			if (--active_ == 0) {
+				done_.notify_one();
+			}
+		}
+	}
+
+	auto work_stealing_pool::drain(std::size_t index) -> void {
+		running_pool = this;
+		auto searching = false;
+		while (pending_.load(std::memory_order_acquire) != 0) {
+			auto const t = find_task(index);
+			if (t == nullptr) {
+				if (!searching) {
+					searching = true;
+					thieves_.fetch_add(1, std::memory_order_relaxed);
+				}
+				std::this_thread::yield();
+				continue;
+			}
+			if (searching) {
+				searching = false;
+				thieves_.fetch_sub(1, std::memory_order_relaxed);
+			}
+			execute(index, t);
+		}
+		if (searching) {
+			thieves_.fetch_sub(1, std::memory_order_relaxed);
+		}
+		running_pool = nullptr;
+	}
+
+	auto work_stealing_pool::find_task(std::size_t index) -> task* {
+		if (auto const t = workers_[index]->deque.take(); t != nullptr) {
+			return t;
+		}
+		// xorshift picks where to start, so thieves do not all hammer the same victim
+		auto& seed = workers_[index]->seed;
+		seed ^= seed << 13U;
+		seed ^= seed >> 7U;
+		seed ^= seed << 17U;
+		auto const n = workers_.size();
+		for (auto i = std::size_t{0}; i < n; ++i) {
+			auto const victim = (seed + i) % n;
+			if (victim == index) {
+				continue;
+			}
+			if (auto const t = workers_[victim]->deque.steal(); t != nullptr) {
+				return t;
+			}
+		}
+		return nullptr;
+	}
+
+	auto work_stealing_pool::execute(std::size_t index, task* t) -> void {
+		auto const owned = std::unique_ptr<task>(t);
+		if (!failed_.load(std::memory_order_relaxed)) {
+			try {
+				auto context = task_context(this, index);
+				(*owned)(context);
+			} catch (...) {
+				auto const lock = std::lock_guard(mutex_);
+				if (error_ == nullptr) {
+					error_ = std::current_exception();
+				}
+				failed_.store(true, std::memory_order_relaxed);
+			}
+		}
+		pending_.fetch_sub(1, std::memory_order_acq_rel);
+	}
+
+	task_context::task_context(work_stealing_pool* pool, std::size_t index)
+	: pool_(pool)
+	, index_(index) {}
+
+	auto task_context::spawn(task t) -> void {
+		if (pool_ == nullptr) {
+			t(*this);
+			return;
+		}
+		pool_->pending_.fetch_add(1, std::memory_order_relaxed);
+		pool_->workers_[index_]->deque.push(new task(std::move(t)));
+	}
+
+	auto task_context::should_split() const -> bool {
+		return pool_ != nullptr && pool_->thieves_.load(std::memory_order_relaxed) != 0
+		       && pool_->workers_[index_]->deque.empty();
+	}
+
+	auto parallel_for_each_token(const filtered_string_view& fsv,
+	                             const filtered_string_view& tok,
+	                             const token_function& fn) -> void {
+		parallel_for_each_token(work_stealing_pool::shared(), fsv, tok, fn);
+	}
+
+	auto parallel_for_each_token(work_stealing_pool& pool,
+	                             const filtered_string_view& fsv,
+	                             const filtered_string_view& tok,
+	                             const token_function& fn) -> void {
+		auto const delim = std::string_view(tok.data(), tok.length());
+		if (fsv.empty() || delim.empty()) {
+			fn(fsv);
+			return;
+		}
+		if (self_overlapping(delim)) {
+			auto const tokens = split(execution::par, fsv, tok);
+			auto const tokenizer = index_tokenizer{tokens, fn};
+			pool.run([&tokenizer, &tokens](task_context& ctx) { tokenizer(ctx, 0, tokens.size()); });
+			return;
+		}
+		auto const text = std::string_view(fsv.data(), fsv.length());
+		auto const tokenizer = range_tokenizer{fsv, text, delim, fn};
+		pool.run([&tokenizer, &text](task_context& ctx) { tokenizer(ctx, 0, text.size()); });
+	}
+} // namespace fsv
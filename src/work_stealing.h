@@ -0,0 +1,141 @@
+#ifndef COMP6771_ASS2_WORK_STEALING_H
+#define COMP6771_ASS2_WORK_STEALING_H
+
+#include "./filtered_string_view.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fsv {
+	class task_context;
+	using task = std::function<void(task_context&)>;
+
+	// Chase-Lev deque of task pointers. The owning thread pushes and takes at the bottom; any other thread
+	// may steal from the top without taking a lock. The ring doubles when full; retired rings are kept until
+	// the deque is destroyed, since a thief may still be reading one.
+	class work_deque {
+	 public:
+		explicit work_deque(std::size_t capacity = 256);
+		work_deque(const work_deque&) = delete;
+		auto operator=(const work_deque&) -> work_deque& = delete;
+		~work_deque() = default;
+
+		// owner only
+		auto push(task* t) -> void;
+		// owner only; the most recently pushed task, or nullptr
+		auto take() -> task*;
+		// any thread; the oldest task, or nullptr if the deque is empty or another thread won the race
+		auto steal() -> task*;
+
+		// a snapshot; exact only when no other thread is using the deque
+		auto empty() const -> bool;
+
+	 private:
+		struct ring {
+			explicit ring(std::size_t capacity);
+			auto get(std::int64_t i) const -> task*;
+			auto put(std::int64_t i, task* t) -> void;
+
+			std::size_t mask;
+			std::unique_ptr<std::atomic<task*>[]> slots;
+		};
+
+		alignas(64) std::atomic<std::int64_t> top_;
+		alignas(64) std::atomic<std::int64_t> bottom_;
+		std::atomic<ring*> ring_;
+		std::vector<std::unique_ptr<ring>> rings_;
+	};
+
+	// Runs a tree of tasks on a fixed set of threads, each with its own work_deque. A thread runs its own
+	// tasks newest first and, when it has none, steals the oldest task of a random other thread, so large
+	// pieces of work migrate to idle threads while small ones stay local. The calling thread takes part in
+	// every run, so a pool of size n runs n - 1 workers.
+	class work_stealing_pool {
+	 public:
+		explicit work_stealing_pool(std::size_t threads = std::thread::hardware_concurrency());
+		work_stealing_pool(const work_stealing_pool&) = delete;
+		auto operator=(const work_stealing_pool&) -> work_stealing_pool& = delete;
+		~work_stealing_pool();
+
+		auto size() const -> std::size_t;
+
+		// runs root and every task spawned from it, returning once all have finished. The first exception
+		// thrown by a task is rethrown here; tasks not yet started when it is thrown are skipped. A run
+		// started from inside a task runs inline on the calling thread.
+		auto run(const task& root) -> void;
+
+		// process-wide pool sized to the hardware
+		static auto shared() -> work_stealing_pool&;
+
+	 private:
+		friend class task_context;
+
+		struct worker {
+			work_deque deque;
+			std::uint64_t seed;
+		};
+
+		std::vector<std::unique_ptr<worker>> workers_;
+		std::vector<std::thread> threads_;
+		std::mutex run_mutex_;
+
+		std::mutex mutex_;
+		std::condition_variable wake_;
+		std::condition_variable done_;
+		std::size_t generation_;
+		std::size_t active_;
+		bool stopping_;
+
+		// tasks spawned but not yet finished in the current run
+		std::atomic<std::size_t> pending_;
+		// workers currently looking for a task to steal
+		std::atomic<std::size_t> thieves_;
+		std::atomic<bool> failed_;
+		std::exception_ptr error_;
+
+		auto work(std::size_t index) -> void;
+		auto drain(std::size_t index) -> void;
+		auto execute(std::size_t index, task* t) -> void;
+		auto find_task(std::size_t index) -> task*;
+	};
+
+	// The handle a running task uses to hand work to the pool.
+	class task_context {
+	 public:
+		// queues t on this thread's deque, where it may be stolen
+		auto spawn(task t) -> void;
+		// true when this thread has nothing queued and another thread is looking for work; lazily split loops
+		// hand off half of their remaining work when this holds, and otherwise keep going alone
+		auto should_split() const -> bool;
+
+	 private:
+		friend class work_stealing_pool;
+		task_context(work_stealing_pool* pool, std::size_t index);
+
+		work_stealing_pool* pool_;
+		std::size_t index_;
+	};
+
+	using token_function = std::function<void(const filtered_string_view&)>;
+
+	// calls fn on every token of split(fsv, tok), concurrently and in no particular order. The buffer is split
+	// lazily: a thread keeps tokenizing its range until another thread runs out of work, then hands it the
+	// second half of what remains, so expensive tokens spread over the pool without a fixed partition.
+	auto parallel_for_each_token(const filtered_string_view& fsv,
+	                             const filtered_string_view& tok,
+	                             const token_function& fn) -> void;
+	auto parallel_for_each_token(work_stealing_pool& pool,
+	                             const filtered_string_view& fsv,
+	                             const filtered_string_view& tok,
+	                             const token_function& fn) -> void;
+} // namespace fsv
+
+#endif // COMP6771_ASS2_WORK_STEALING_H
@@ -0,0 +1,170 @@
+#include "./work_stealing.h"
+#include "./char_class.h"
+#include "./filtered_string_view.h"
+
+#include <algorithm>
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	// every token of a for-each call, sorted, so runs can be compared with split()
+	auto collect(fsv::work_stealing_pool& pool, const fsv::filtered_string_view& view, const std::string& delim)
+	    -> std::vector<std::string> {
+		auto mutex = std::mutex();
+		auto result = std::vector<std::string>();
+		auto const tok = fsv::filtered_string_view(delim);
+		fsv::parallel_for_each_token(pool, view, tok, [&](const fsv::filtered_string_view& t) {
+			auto const lock = std::lock_guard(mutex);
+			result.push_back(static_cast<std::string>(t));
+		});
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+	auto expected(const fsv::filtered_string_view& view, const std::string& delim) -> std::vector<std::string> {
+		auto result = std::vector<std::string>();
+		for (auto const& token : fsv::split(view, fsv::filtered_string_view(delim))) {
+			result.push_back(static_cast<std::string>(token));
+		}
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+} // namespace
+
+TEST_CASE("work_deque is LIFO for its owner and FIFO for thieves") {
+	auto deque = fsv::work_deque(2);
+	auto tasks = std::vector<fsv::task>(10);
+	for (auto& t : tasks) {
+		deque.push(&t);
+	}
+	CHECK(deque.steal() == &tasks[0]);
+	CHECK(deque.take() == &tasks[9]);
+	CHECK(deque.steal() == &tasks[1]);
+	for (auto i = 8; i >= 2; --i) {
+		CHECK(deque.take() == &tasks[static_cast<std::size_t>(i)]);
+	}
+	CHECK(deque.empty());
+	CHECK(deque.take() == nullptr);
+	CHECK(deque.steal() == nullptr);
+}
+
+TEST_CASE("work_deque hands every task out once under concurrent stealing") {
+	constexpr auto count = std::size_t{200000};
+	auto deque = fsv::work_deque(4);
+	auto tasks = std::vector<fsv::task>(count);
+	auto seen = std::vector<std::atomic<int>>(count);
+	auto done = std::atomic<bool>(false);
+	auto const record = [&](fsv::task* t) { ++seen[static_cast<std::size_t>(t - tasks.data())]; };
+
+	auto thieves = std::vector<std::thread>();
+	for (auto i = 0; i < 3; ++i) {
+		thieves.emplace_back([&] {
+			while (!done.load()) {
+				if (auto const t = deque.steal(); t != nullptr) {
+					record(t);
+				}
+			}
+		});
+	}
+	for (auto i = std::size_t{0}; i < count; ++i) {
+		deque.push(&tasks[i]);
+		if (i % 3 == 0) {
+			if (auto const t = deque.take(); t != nullptr) {
+				record(t);
+			}
+		}
+	}
+	while (auto const t = deque.take()) {
+		record(t);
+	}
+	done = true;
+	for (auto& thief : thieves) {
+		thief.join();
+	}
+	CHECK(std::all_of(seen.begin(), seen.end(), [](const std::atomic<int>& n) { return n.load() == 1; }));
+}
+
+TEST_CASE("work_stealing_pool runs every spawned task") {
+	auto pool = fsv::work_stealing_pool(4);
+	CHECK(pool.size() == 4);
+	auto leaves = std::atomic<std::size_t>(0);
+	// a binary tree of 2^12 leaves, spawned recursively
+	auto const tree = [&](auto& self, fsv::task_context& ctx, int depth) -> void {
+		if (depth == 0) {
+			++leaves;
+			return;
+		}
+		ctx.spawn([&self, depth](fsv::task_context& c) { self(self, c, depth - 1); });
+		self(self, ctx, depth - 1);
+	};
+	pool.run([&](fsv::task_context& ctx) { tree(tree, ctx, 12); });
+	CHECK(leaves.load() == 4096);
+
+	// the pool can be reused, and runs started inside a task run inline
+	auto nested = std::atomic<int>(0);
+	pool.run([&](fsv::task_context&) { pool.run([&](fsv::task_context&) { ++nested; }); });
+	CHECK(nested.load() == 1);
+}
+
+TEST_CASE("work_stealing_pool rethrows the first exception") {
+	auto pool = fsv::work_stealing_pool(3);
+	CHECK_THROWS_AS(pool.run([](fsv::task_context& ctx) {
+		for (auto i = 0; i < 100; ++i) {
+			ctx.spawn([i](fsv::task_context&) {
+				if (i == 50) {
+					throw std::runtime_error{"boom"};
+				}
+			});
+		}
+	}),
+	                std::runtime_error);
+	auto ran = std::atomic<bool>(false);
+	pool.run([&](fsv::task_context&) { ran = true; });
+	CHECK(ran.load());
+}
+
+TEST_CASE("parallel_for_each_token visits the tokens split() produces") {
+	auto pool = fsv::work_stealing_pool(4);
+	auto lines = std::string();
+	for (auto i = 0; i < 20000; ++i) {
+		lines += "row " + std::to_string(i) + (i % 13 == 0 ? "\n\n" : "\n");
+	}
+	auto const plain = fsv::filtered_string_view(lines);
+	CHECK(collect(pool, plain, "\n") == expected(plain, "\n"));
+	CHECK(collect(pool, plain, "row") == expected(plain, "row"));
+
+	auto const digits = fsv::filtered_string_view(lines, fsv::char_class::range('0', '9'));
+	CHECK(collect(pool, digits, "\n") == expected(digits, "\n"));
+
+	// delimiters that can overlap themselves are split up front
+	auto const runs = std::string(5001, 'a') + "b" + std::string(300, 'a');
+	CHECK(collect(pool, fsv::filtered_string_view(runs), "aa") == expected(fsv::filtered_string_view(runs), "aa"));
+
+	CHECK(collect(pool, fsv::filtered_string_view("x\n"), "\n") == std::vector<std::string>{"", "x"});
+	CHECK(collect(pool, fsv::filtered_string_view("abc"), "") == std::vector<std::string>{"abc"});
+}
+
+TEST_CASE("parallel_for_each_token spreads expensive tokens over the pool") {
+	auto pool = fsv::work_stealing_pool(4);
+	auto text = std::string();
+	for (auto i = 0; i < 64; ++i) {
+		text += "token,";
+	}
+	auto mutex = std::mutex();
+	auto threads = std::vector<std::thread::id>();
+	auto const view = fsv::filtered_string_view(text);
+	fsv::parallel_for_each_token(pool, view, fsv::filtered_string_view(","), [&](const auto&) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		auto const lock = std::lock_guard(mutex);
+		if (std::find(threads.begin(), threads.end(), std::this_thread::get_id()) == threads.end()) {
+			threads.push_back(std::this_thread::get_id());
+		}
+	});
+	CHECK(threads.size() > 1);
+}